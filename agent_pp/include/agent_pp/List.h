@@ -677,55 +677,79 @@ public:
 		if (t) delete t;
 	}	  
 
-	T* find(Oidx* oidptr) const {
-		Pix i = content->seek(oidptr);
+	T* find(Oidx* oidptr) const { return find(OidxView(*oidptr)); }
+
+	T* find_lower(Oidx* oidptr) const {
+		return find_lower(OidxView(*oidptr));
+	}
+
+	T* find_upper(Oidx* oidptr) const {
+		return find_upper(OidxView(*oidptr));
+	}
+
+	T* find_next(Oidx* oidptr) const {
+		return find_next(OidxView(*oidptr));
+	}
+
+	T* find_prev(Oidx* oidptr) const {
+		return find_prev(OidxView(*oidptr));
+	}
+
+	T* seek(Oidx* oidptr) const { return seek(OidxView(*oidptr)); }
+
+	/**
+	 * The following finders accept a view on an object identifier,
+	 * for example a part of an Oidx, without copying it.
+	 */
+	T* find(const OidxView& oid) const {
+		Pix i = content->seek(oid);
 		if (i) return (T*)content->contents(i);
 		return 0;
 	}
 
-	T* find_lower(Oidx* oidptr) const {
-		Pix i = content->seek_inexact(oidptr);
+	T* find_lower(const OidxView& oid) const {
+		Pix i = content->seek_inexact(oid);
 		if (!i) return 0;
 		while ((i) && (i != content->last()) &&
-		       (*content->key(i) < *oidptr))
+		       (content->key(i)->compare(oid) < 0))
 			content->next(i);
-		while ((i) && (*content->key(i) > *oidptr))
+		while ((i) && (content->key(i)->compare(oid) > 0))
 			content->prev(i);
 		
 		if (i) return (T*)content->contents(i);
 		return 0;
 	}
 
-	T* find_upper(Oidx* oidptr) const {
-		Pix i = content->seek_inexact(oidptr);
+	T* find_upper(const OidxView& oid) const {
+		Pix i = content->seek_inexact(oid);
 		if (!i) return 0;
 		while ((i) && (i != content->first()) &&
-		       (*content->key(i) > *oidptr))
+		       (content->key(i)->compare(oid) > 0))
 			content->prev(i);
-		while ((i) && (*content->key(i) < *oidptr))
+		while ((i) && (content->key(i)->compare(oid) < 0))
 			content->next(i);
 		if (i) return (T*)content->contents(i);
 		return 0;
 	}
 
-	T* find_next(Oidx* oidptr) const {
-		Pix i = content->seek(oidptr);
+	T* find_next(const OidxView& oid) const {
+		Pix i = content->seek(oid);
 		if (!i) return 0;
 		content->next(i);
 		if (i) return (T*)content->contents(i);
 		return 0;
 	}
 
-	T* find_prev(Oidx* oidptr) const {
-		Pix i = content->seek(oidptr);
+	T* find_prev(const OidxView& oid) const {
+		Pix i = content->seek(oid);
 		if (!i) return 0;
 		content->prev(i);
 		if (i) return (T*)content->contents(i);
 		return 0;
 	}
 
-	T* seek(Oidx* oidptr) const {
-		Pix i = content->seek_inexact(oidptr);
+	T* seek(const OidxView& oid) const {
+		Pix i = content->seek_inexact(oid);
 		if (i) return (T*)content->contents(i);
 		return 0;
 	}
@@ -849,13 +873,15 @@ public:
 		return 0;	
 	}
 
-	int lookup(Oidx* oidptr) {
+	int lookup(Oidx* oidptr) { return lookup(OidxView(*oidptr)); }
+
+	int lookup(const OidxView& oid) {
 		if (list) {
-			Pix i = list->content->seek_inexact(oidptr);
+			Pix i = list->content->seek_inexact(oid);
 			if (!i) return FALSE;
 			T* t = 0;
 			while ((i) && (t = (T*)list->content->contents(i)) &&
-			       (*t->key() > *oidptr)) {
+			       (t->key()->compare(oid) > 0)) {
 				list->content->prev(i);
 			}
 			if ((i) && (t)) { 
@@ -877,6 +903,330 @@ protected:
 };
 
 
+/**
+ * The OidIndex template implements an immutable, sorted index over
+ * the keys of an OidList. The sub-identifiers of all keys are copied
+ * into one contiguous buffer, so that a lookup is a single binary
+ * search without walking any tree nodes.
+ *
+ * An OidIndex is a snapshot: it has to be rebuilt (see rebuild) each
+ * time the indexed OidList is changed.
+ *
+ * @version 4.6.1
+ */
+template <class T> class OidIndex {
+public:
+	OidIndex(): items(0), offsets(0), subids(0), count(0) { }
+	~OidIndex() { clear(); }
+
+	/**
+	 * Rebuild the index from the current content of an OidList.
+	 *
+	 * @param list
+	 *    the OidList to be indexed.
+	 */
+	void rebuild(OidList<T>* list) {
+		clear();
+		count = list->size();
+		if (count == 0) return;
+		items = new T*[count];
+		offsets = new unsigned int[count+1];
+		unsigned int total = 0;
+		int n = 0;
+		OidListCursor<T> cur;
+		for (cur.init(list); ((cur.get()) && (n < count));
+		     cur.next(), n++) {
+			items[n] = cur.get();
+			offsets[n] = total;
+			total += cur.get()->key()->len();
+		}
+		count = n;
+		offsets[count] = total;
+		subids = new unsigned long[(total > 0) ? total : 1];
+		for (n = 0; n < count; n++) {
+			const Oidx* k = items[n]->key();
+			unsigned long* s = subids + offsets[n];
+			for (unsigned int i=0; i<k->len(); i++)
+				s[i] = (*k)[i];
+		}
+	}
+
+	/**
+	 * Remove all entries from the index.
+	 */
+	void clear() {
+		if (items) delete[] items;
+		if (offsets) delete[] offsets;
+		if (subids) delete[] subids;
+		items = 0;
+		offsets = 0;
+		subids = 0;
+		count = 0;
+	}
+
+	int	size() const { return count; }
+
+	/**
+	 * Get the n-th (0-based) element of the index.
+	 */
+	T*	getNth(int n) const {
+		return ((n >= 0) && (n < count)) ? items[n] : 0;
+	}
+
+	/**
+	 * Get the position of the first key greater or equal to a
+	 * given object identifier.
+	 *
+	 * @param oid
+	 *    an object identifier.
+	 * @return
+	 *    a position between 0 and size(). size() is returned if
+	 *    all keys are less than oid.
+	 */
+	int	lower_bound(const OidxView& oid) const {
+		int lo = 0;
+		int hi = count;
+		while (lo < hi) {
+			int mid = (lo + hi) >> 1;
+			if (compare(mid, oid) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	/**
+	 * Get the position of the key equal to the given object identifier.
+	 *
+	 * @return
+	 *    the position or -1 if there is no such key.
+	 */
+	int	position(const OidxView& oid) const {
+		int n = lower_bound(oid);
+		if ((n < count) && (compare(n, oid) == 0))
+			return n;
+		return -1;
+	}
+
+	T* find(const OidxView& oid) const {
+		return getNth(position(oid));
+	}
+
+	T* find_lower(const OidxView& oid) const {
+		int n = lower_bound(oid);
+		if ((n < count) && (compare(n, oid) == 0))
+			return items[n];
+		return getNth(n-1);
+	}
+
+	T* find_upper(const OidxView& oid) const {
+		return getNth(lower_bound(oid));
+	}
+
+	T* find_next(const OidxView& oid) const {
+		int n = position(oid);
+		return (n < 0) ? 0 : getNth(n+1);
+	}
+
+	T* find_prev(const OidxView& oid) const {
+		int n = position(oid);
+		return (n < 0) ? 0 : getNth(n-1);
+	}
+
+protected:
+	/**
+	 * Compare the n-th key with a given object identifier
+	 * lexicographically.
+	 *
+	 * @return
+	 *    <0 if the key is less than oid, 0 if both are equal,
+	 *    and >0 if the key is greater than oid.
+	 */
+	int compare(int n, const OidxView& oid) const {
+		const unsigned long* s = subids + offsets[n];
+		unsigned int klen = offsets[n+1] - offsets[n];
+		unsigned int olen = oid.len();
+		const unsigned long* d = oid.data();
+		unsigned int l = (klen < olen) ? klen : olen;
+		for (unsigned int i=0; i<l; i++) {
+			unsigned long o = d[i];
+			if (s[i] != o)
+				return (s[i] < o) ? -1 : 1;
+		}
+		if (klen == olen) return 0;
+		return (klen < olen) ? -1 : 1;
+	}
+
+	T**		items;
+	unsigned int*	offsets;
+	unsigned long*	subids;
+	int		count;
+
+private:
+	OidIndex(const OidIndex<T>&);
+	OidIndex<T>& operator=(const OidIndex<T>&);
+};
+
+
+/**
+ * The HashIndex template implements a hash index over items that are
+ * owned by another collection. Items are added with a hash value
+ * computed by the caller. A lookup returns all items with the same
+ * hash value, the caller has to check them for an exact match:
+ *
+ *   Pix pos;
+ *   for (T* t = index.first(h, pos); t; t = index.next(h, pos))
+ *     if (matches(t)) return t;
+ *
+ * The table is doubled when it holds more than twice as many items
+ * as buckets. The index is not synchronized.
+ *
+ * @version 4.6.1
+ */
+template <class T> class HashIndex {
+public:
+	/**
+	 * Create an empty index.
+	 *
+	 * @param initialBuckets
+	 *    the initial number of buckets (rounded up to a power of 2).
+	 */
+	HashIndex(unsigned int initialBuckets = 64): table(0), count(0) {
+		buckets = 16;
+		while (buckets < initialBuckets) buckets <<= 1;
+		table = new Node*[buckets];
+		memset(table, 0, buckets*sizeof(Node*));
+	}
+	~HashIndex() { clear(); delete[] table; }
+
+	/**
+	 * Add an item with the given hash value.
+	 */
+	void add(unsigned long hash, T* item) {
+		if (count >= (buckets << 1)) grow();
+		Node* n = new Node;
+		n->hash = hash;
+		n->item = item;
+		Node** b = &table[hash & (buckets - 1)];
+		n->next = *b;
+		*b = n;
+		count++;
+	}
+
+	/**
+	 * Remove an item from the index.
+	 *
+	 * @param hash
+	 *    the hash value the item has been added with.
+	 * @param item
+	 *    the item to remove.
+	 * @return
+	 *    TRUE if the item has been found and removed.
+	 */
+	bool remove(unsigned long hash, T* item) {
+		Node** n = &table[hash & (buckets - 1)];
+		for (; *n; n = &(*n)->next) {
+			if ((*n)->item == item) {
+				Node* victim = *n;
+				*n = victim->next;
+				delete victim;
+				count--;
+				return TRUE;
+			}
+		}
+		return FALSE;
+	}
+
+	/**
+	 * Return the first item with the given hash value and set pos
+	 * to its position.
+	 */
+	T* first(unsigned long hash, Pix& pos) const {
+		return scan(table[hash & (buckets - 1)], hash, pos);
+	}
+
+	/**
+	 * Return the next item with the given hash value after pos.
+	 */
+	T* next(unsigned long hash, Pix& pos) const {
+		if (!pos) return 0;
+		return scan(((Node*)pos)->next, hash, pos);
+	}
+
+	/**
+	 * Remove all items from the index (the items are not deleted).
+	 */
+	void clear() {
+		for (unsigned int i=0; i<buckets; i++) {
+			while (table[i]) {
+				Node* n = table[i];
+				table[i] = n->next;
+				delete n;
+			}
+		}
+		count = 0;
+	}
+
+	unsigned int	size() const { return count; }
+
+	/**
+	 * Mix the bits of a value, for example before combining it
+	 * with other values into a hash value.
+	 */
+	static unsigned long mix(unsigned long h) {
+		h ^= h >> 16;
+		h *= 0x45d9f3bUL;
+		h ^= h >> 16;
+		return h;
+	}
+
+protected:
+	struct Node {
+		unsigned long	hash;
+		T*		item;
+		Node*		next;
+	};
+
+	T* scan(Node* n, unsigned long hash, Pix& pos) const {
+		for (; n; n = n->next) {
+			if (n->hash == hash) {
+				pos = (Pix)n;
+				return n->item;
+			}
+		}
+		pos = 0;
+		return 0;
+	}
+
+	void grow() {
+		unsigned int nb = buckets << 1;
+		Node** nt = new Node*[nb];
+		memset(nt, 0, nb*sizeof(Node*));
+		for (unsigned int i=0; i<buckets; i++) {
+			while (table[i]) {
+				Node* n = table[i];
+				table[i] = n->next;
+				Node** b = &nt[n->hash & (nb - 1)];
+				n->next = *b;
+				*b = n;
+			}
+		}
+		delete[] table;
+		table = nt;
+		buckets = nb;
+	}
+
+	Node**		table;
+	unsigned int	buckets;
+	unsigned int	count;
+
+private:
+	HashIndex(const HashIndex<T>&);
+	HashIndex<T>& operator=(const HashIndex<T>&);
+};
+
+
 /**
  * This Array template implements a vector collection class. 
  * 
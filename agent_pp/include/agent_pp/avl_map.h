@@ -105,6 +105,8 @@ public:
 
   Pix			seek(OidxPtr key) const;
   Pix			seek_inexact(OidxPtr key) const;
+  Pix			seek(const OidxView& key) const;
+  Pix			seek_inexact(const OidxView& key) const;
   inline int		contains(OidxPtr key_) const;
 
   inline void		clear(); 
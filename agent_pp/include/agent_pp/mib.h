@@ -1180,6 +1180,30 @@ class AGENTPP_DECL MibTableVoter {
 				     int) { return SNMP_ERROR_SUCCESS; } 
 };
 
+/*------------------------ class MibTableIndex ------------------------*/
+
+/**
+ * The MibTableIndex class holds the index of a row of a MibTable, so
+ * that row indexes can be kept in an OidList. MibTable uses it to
+ * track changed rows.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL MibTableIndex {
+ public:
+	MibTableIndex(const Oidx& ind): index(ind) { }
+
+	OidxPtr		key() { return &index; }
+
+	Oidx		index;
+};
+
+#if !defined (AGENTPP_DECL_TEMPL_OIDLIST_MIBTABLEINDEX)
+#define AGENTPP_DECL_TEMPL_OIDLIST_MIBTABLEINDEX
+	AGENTPP_DECL_TEMPL template class AGENTPP_DECL OidList<MibTableIndex>;
+#endif
+
 /*--------------------------- class MibTable --------------------------*/
 
 struct index_info {
@@ -1408,6 +1432,37 @@ public:
 	 */
 	virtual bool		deserialize(char*, int&);
 
+	/**
+	 * Serialize the persistent rows of the receiver in a flat
+	 * layout of 32-bit words: the column count, the row count,
+	 * and for each row its index followed by the syntax, length,
+	 * and raw data of each column value. Volatile columns are
+	 * stored as Null.
+	 *
+	 * @param buf - A pointer to byte stream buffer returned.
+	 * @param sz - The size of the buffer returned.
+	 * @return TRUE if serialization was successful, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	virtual bool		serialize_image(char*&, int&);
+
+	/**
+	 * Create the rows stored by serialize_image directly from the
+	 * (mapped) image without BER decoding. Existing rows are
+	 * preserved, row_init is called for each new row.
+	 *
+	 * @param buf
+	 *    a pointer to the image data of the receiver, aligned to
+	 *    four bytes.
+	 * @param sz
+	 *    the size of the image data.
+	 * @return
+	 *    TRUE if the image could be read, FALSE if it is corrupt
+	 *    or does not match the columns of the receiver.
+	 * @since 4.6.1
+	 */
+	virtual bool		deserialize_image(const char*, int);
+
 	/**
 	 * Return the immediate successor of the greatest object identifier 
 	 * within the receiver's scope
@@ -1923,6 +1978,116 @@ public:
 	 */
 	virtual void   	reinit() { }
 
+	/**
+	 * Notify all registered nodes of changes to a row of the receiver.
+	 * If change tracking is enabled, the row index is recorded as
+	 * changed. Call this method after changing the values of a row
+	 * directly, so that the change is persisted by a MibConfigLog.
+	 *
+	 * @param index
+	 *    the index of the row changed.
+	 * @param change
+	 *    the type of the change (REMOVE, CREATE, CHANGE, or UPDATE)
+	 * @since 4.6.1
+	 */
+	virtual void		notify_change(const Oidx&, mib_change);
+
+	/**
+	 * Enable or disable change tracking. While enabled, the indexes
+	 * of rows that are added, removed, or changed by SET requests,
+	 * fire_row_changed, or notify_change are recorded until they are
+	 * taken by take_changes. Changes recorded before are discarded.
+	 * (NOT SYNCHRONIZED)
+	 *
+	 * @param enable
+	 *    TRUE to enable change tracking, FALSE to disable it.
+	 * @since 4.6.1
+	 */
+	void			set_change_tracking(bool);
+
+	/**
+	 * Check whether change tracking is enabled.
+	 *
+	 * @return
+	 *    TRUE if changed rows are recorded.
+	 * @since 4.6.1
+	 */
+	bool			is_change_tracking() const
+					{ return trackChanges; }
+
+	/**
+	 * Check whether a row has been recorded as changed.
+	 * (NOT SYNCHRONIZED)
+	 *
+	 * @param index
+	 *    a row index.
+	 * @return
+	 *    TRUE if the row with the given index has been changed since
+	 *    the changes were taken last.
+	 * @since 4.6.1
+	 */
+	bool			is_changed(const Oidx&) const;
+
+	/**
+	 * Move the indexes of the rows recorded as changed to the given
+	 * list. (NOT SYNCHRONIZED)
+	 *
+	 * @param changes
+	 *    an OidList that receives the indexes of the changed rows.
+	 * @since 4.6.1
+	 */
+	void			take_changes(OidList<MibTableIndex>&);
+
+	/**
+	 * Get the number of changes made to the receiver so far. The count
+	 * is incremented whenever rows are added, removed, or changed by
+	 * SET requests, fire_row_changed, notify_change, or clear. Objects
+	 * that cache information derived from the table's content can
+	 * compare the count to detect that their cache is stale.
+	 * Code that changes the values of existing rows directly has to
+	 * call notify_change for that row.
+	 *
+	 * @return
+	 *    the change count.
+	 * @since 4.6.1
+	 */
+	unsigned long		get_change_count() const
+					{ return changeCount; }
+
+	/**
+	 * Serialize a single row the same way serialize encodes each
+	 * row of the receiver. (NOT SYNCHRONIZED)
+	 *
+	 * @param index
+	 *    the index of a row.
+	 * @param buf
+	 *    returns a pointer to a new byte stream buffer or 0 if the
+	 *    row does not exist or is not persistent.
+	 * @param sz
+	 *    returns the size of the buffer.
+	 * @return
+	 *    FALSE if the row could not be encoded, TRUE otherwise.
+	 * @since 4.6.1
+	 */
+	virtual bool		serialize_row(const Oidx&, char*&, int&);
+
+	/**
+	 * Replace or remove a single row from a byte stream created by
+	 * serialize_row. (NOT SYNCHRONIZED)
+	 *
+	 * @param index
+	 *    the index of the row.
+	 * @param buf
+	 *    a pointer to the input byte stream, or 0 to remove the row.
+	 * @param sz
+	 *    the size of the input buffer.
+	 * @return
+	 *    TRUE if the row has been replaced or removed, FALSE if the
+	 *    byte stream could not be decoded.
+	 * @since 4.6.1
+	 */
+	virtual bool		deserialize_row(const Oidx&, char*, int);
+
 protected:
 
 	/**
@@ -2116,6 +2281,17 @@ protected:
 
 	List<MibTable>		listeners;
 	List<MibTableVoter>	voters;
+
+	bool			trackChanges;
+	OidList<MibTableIndex>	changes;
+#ifdef _THREADS
+	std::atomic<unsigned long> changeCount;
+#else
+	unsigned long		changeCount;
+#endif
+
+ private:
+	void			add_change(const Oidx&);
 };
 
 inline Oidx MibLeaf::get_oid() const
@@ -2264,6 +2440,36 @@ class AGENTPP_DECL MibConfigFormat {
      */
     virtual bool	load(MibContext*, const NS_SNMP OctetStr&) = 0;
 
+    /**
+     * Loads the persistent data in the supplied MibContext from disk
+     * when the agent is initialized by Mib::init. In contrast to load,
+     * the objects are not reset before. By default, this method calls
+     * MibContext::init_from.
+     * @param context
+     *    a pointer to the MibContext to initialize.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be loaded successfully, FALSE otherwise.
+     * @since 4.6.1
+     */
+    virtual bool	init(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Brings the persistent data of the supplied MibContext on disk
+     * up to date. This method is called by Mib::save_all and, if
+     * enabled by Mib::set_sync_on_commit, after each committed SET
+     * request. By default, this method calls save.
+     * @param context
+     *    a pointer to the MibContext to store.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be saved successfully, FALSE otherwise.
+     * @since 4.6.1
+     */
+    virtual bool	sync(MibContext*, const NS_SNMP OctetStr&);
+
     /**
      * Clone this format (needed by ArrayList template).
      */
@@ -2311,6 +2517,299 @@ class AGENTPP_DECL MibConfigBER: public MibConfigFormat {
 
 };
 
+/*---------------------- class MibConfigLogFile ---------------------*/
+
+#ifndef AGENTPP_MIB_CONFIG_LOG_SIZE
+#define AGENTPP_MIB_CONFIG_LOG_SIZE 65536
+#endif
+
+/**
+ * The MibConfigLogEntry class holds the checksum of the serialized
+ * value of a MIB object (other than a table) that a MibConfigLog has
+ * last written for it.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL MibConfigLogEntry {
+ public:
+	MibConfigLogEntry(const Oidx& o, unsigned long c): oid(o), crc(c) { }
+
+	OidxPtr		key() { return &oid; }
+
+	Oidx		oid;
+	unsigned long	crc;
+};
+
+#if !defined (AGENTPP_DECL_TEMPL_OIDLIST_MIBCONFIGLOGENTRY)
+#define AGENTPP_DECL_TEMPL_OIDLIST_MIBCONFIGLOGENTRY
+	AGENTPP_DECL_TEMPL template class AGENTPP_DECL OidList<MibConfigLogEntry>;
+#endif
+
+/**
+ * The MibConfigLogFile class holds the state of the change log that a
+ * MibConfigLog keeps for the snapshot file of a MibGroup.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL MibConfigLogFile {
+ public:
+	MibConfigLogFile(const NS_SNMP OctetStr&);
+	~MibConfigLogFile();
+
+	/**
+	 * Close the log file.
+	 */
+	void		close();
+
+	// the name of the snapshot file, the log file has the suffix ".log"
+	NS_SNMP OctetStr	fileName;
+	NS_SNMP OctetStr	logName;
+	FILE*			log;
+	unsigned long		logSize;
+	unsigned long		snapshotSize;
+	unsigned long		snapshotCRC;
+	// TRUE if the next sync needs to write a new snapshot
+	bool			compactionNeeded;
+	OidList<MibConfigLogEntry>	entries;
+};
+
+#if !defined (AGENTPP_DECL_TEMPL_LIST_MIBCONFIGLOGFILE)
+#define AGENTPP_DECL_TEMPL_LIST_MIBCONFIGLOGFILE
+	AGENTPP_DECL_TEMPL template class AGENTPP_DECL List<MibConfigLogFile>;
+#endif
+
+/*----------------------- class MibConfigLog ------------------------*/
+
+/**
+ * The MibConfigLog implements a persistent data configuration format
+ * that stores changes incrementally. The data of each persistent
+ * MibGroup is kept in a snapshot file in the format of MibConfigBER
+ * (or as an image, see MibGroup::set_image_snapshot) plus a log file
+ * (with the suffix ".log") to which sync appends a record for each
+ * changed row of a table and for each changed value of other MIB
+ * objects of the group. Each record carries a checksum and the log is
+ * flushed to stable storage after each sync, so a record that was cut
+ * short by a crash is discarded on load.
+ *
+ * When the log has grown beyond the compaction threshold and the size
+ * of the snapshot, the group is written to a new snapshot, which
+ * replaces the old one by renaming, and the log is started anew. The
+ * log refers to the checksum of the snapshot it is based on, thus a log
+ * that is older than the snapshot is ignored.
+ *
+ * The rows of tables are tracked with MibTable::set_change_tracking.
+ * Rows changed by SET requests, or added and removed through the
+ * MibTable interface are logged. Code that changes the values of a row
+ * directly has to call MibTable::notify_change for that row. Log
+ * records are replayed with the same semantics as snapshots are loaded,
+ * thus rows created before Mib::init are not overwritten.
+ *
+ * To use MibConfigLog for the persistent objects of an agent:
+ * <pre>
+ *   mib->add_config_format(2, new MibConfigLog());
+ *   mib->set_persistence_format(2);
+ *   mib->set_sync_on_commit(TRUE);
+ *   mib->init();
+ * </pre>
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL MibConfigLog: public MibConfigFormat,
+				 public ThreadManager {
+
+ public:
+
+    /**
+     * Constructor.
+     * @param compactionThreshold
+     *    the minimum size of a log file in bytes before it is compacted
+     *    into a new snapshot.
+     */
+    MibConfigLog(unsigned long compactionThreshold =
+		 AGENTPP_MIB_CONFIG_LOG_SIZE);
+
+    virtual ~MibConfigLog();
+
+    /**
+     * Writes a new snapshot for each persistent group of the supplied
+     * MibContext and removes their logs.
+     * @param context
+     *    a pointer to the MibContext to store.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be saved successfully, FALSE otherwise.
+     */
+    virtual bool	save(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Loads the persistent data in the supplied MibContext from the
+     * snapshots and logs. The logs are left in place; the next sync
+     * folds the loaded data into new snapshots before it starts new logs.
+     * @param context
+     *    a pointer to the MibContext to load.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be loaded successfully, FALSE otherwise.
+     */
+    virtual bool	load(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Loads the snapshots and replays the logs of the persistent groups
+     * of the supplied MibContext, then compacts the replayed logs and
+     * enables change tracking for the tables of these groups.
+     * @param context
+     *    a pointer to the MibContext to initialize.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be loaded successfully, FALSE otherwise.
+     */
+    virtual bool	init(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Appends the changes since the last sync to the logs of the
+     * persistent groups of the supplied MibContext and compacts
+     * logs that have grown too large.
+     * @param context
+     *    a pointer to the MibContext to store.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the changes could be saved successfully, FALSE otherwise.
+     */
+    virtual bool	sync(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Set the minimum size of a log file in bytes before it is
+     * compacted into a new snapshot. A log is compacted not before it
+     * is larger than its snapshot.
+     * @param threshold
+     *    a size in bytes.
+     */
+    void		set_compaction_threshold(unsigned long t)
+						{ compactionThreshold = t; }
+
+    /**
+     * Get the compaction threshold.
+     * @return
+     *    a size in bytes.
+     */
+    unsigned long	get_compaction_threshold() const
+						{ return compactionThreshold; }
+
+    virtual MibConfigFormat*	clone()
+			{ return new MibConfigLog(compactionThreshold); }
+
+ protected:
+
+    /**
+     * Get the log state of a group file, create it if necessary. A new
+     * state for which a log exists already needs compaction.
+     */
+    MibConfigLogFile*	get_file(const NS_SNMP OctetStr&);
+
+    /**
+     * Append the changes of a group to its log.
+     */
+    bool		append_changes(MibGroup*, MibConfigLogFile*);
+
+    /**
+     * Write a new snapshot of a group and remove its log.
+     */
+    bool		compact(MibGroup*, MibConfigLogFile*);
+
+    /**
+     * Replay the log of a group. Returns the number of records applied
+     * or -1 if there is no log that matches the snapshot.
+     */
+    int			replay(MibGroup*, MibConfigLogFile*);
+
+    /**
+     * Enable change tracking for the tables of a group and
+     * remember the values of its other objects as stored.
+     */
+    void		track(MibGroup*, MibConfigLogFile*);
+
+    unsigned long		compactionThreshold;
+    List<MibConfigLogFile>	files;
+};
+
+/*----------------------- class MibConfigImage ----------------------*/
+
+/**
+ * The MibConfigImage implements a persistent data configuration format
+ * for fast agent startup. Each persistent MibGroup is saved as an
+ * image (see MibGroup::write_image) in the same file the MibConfigBER
+ * format would use. Tables are stored as flat sequences of rows that
+ * are created directly from the memory mapped image without BER
+ * decoding.
+ *
+ * Loading recognizes both formats, thus snapshots written in BER
+ * format are still loaded and replaced by images on the next save.
+ * The groups of a context initialized or saved by this format keep
+ * writing images, also when the context saves its content on
+ * destruction.
+ *
+ * To use MibConfigImage for the persistent objects of an agent:
+ * <pre>
+ *   mib->add_config_format(3, new MibConfigImage());
+ *   mib->set_persistence_format(3);
+ *   mib->init();
+ * </pre>
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL MibConfigImage: public MibConfigFormat {
+
+ public:
+
+    MibConfigImage() { }
+
+    /**
+     * Stores the persistent data in the supplied MibContext to disk.
+     * @param context
+     *    a pointer to the MibContext to store.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if all images have been written, FALSE otherwise.
+     */
+    virtual bool	save(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Loads the persistent data in the supplied MibContext from disk.
+     * @param context
+     *    a pointer to the MibContext to load.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be loaded successfully, FALSE
+     *    otherwise.
+     */
+    virtual bool	load(MibContext*, const NS_SNMP OctetStr&);
+
+    /**
+     * Initializes the supplied MibContext from disk and enables image
+     * snapshots for its persistent groups.
+     * @param context
+     *    a pointer to the MibContext to initialize.
+     * @param path
+     *    the storage path to use.
+     * @return
+     *    TRUE if the contents could be loaded successfully, FALSE
+     *    otherwise.
+     */
+    virtual bool	init(MibContext*, const NS_SNMP OctetStr&);
+
+    virtual MibConfigFormat*	clone() { return new MibConfigImage(); }
+};
+
 
 /*--------------------------- class Mib -----------------------------*/
 
@@ -2675,10 +3174,60 @@ public:
 	virtual bool		init(); 
 
 	/**
-	 * Save all persistent MIB objects to disk.
+	 * Save all persistent MIB objects to disk. The objects are
+	 * saved by the sync method of the persistence format.
 	 */
 	virtual void		save_all();
 
+	/**
+	 * Set the config format that is used by init and save_all to load
+	 * and store persistent MIB objects in the persistent objects path.
+	 * By default, the BER format (1) is used.
+	 * NOTE: This method is not synchronized and should be called
+	 * before init.
+	 *
+	 * @param formatID
+	 *    the ID of a format registered with add_config_format.
+	 * @since 4.6.1
+	 */
+	void			set_persistence_format(unsigned int f)
+						{ persistenceFormat = f; }
+
+	/**
+	 * Get the ID of the config format used by init and save_all.
+	 *
+	 * @return
+	 *    a format ID.
+	 * @since 4.6.1
+	 */
+	unsigned int		get_persistence_format() const
+						{ return persistenceFormat; }
+
+	/**
+	 * Enable or disable syncing the persistent MIB objects of a
+	 * context after each successfully committed SET request on that
+	 * context. This is disabled by default and should only be
+	 * enabled with a persistence format that stores changes
+	 * incrementally, like MibConfigLog.
+	 *
+	 * @param enable
+	 *    TRUE to sync after each committed SET request.
+	 * @since 4.6.1
+	 */
+	void			set_sync_on_commit(bool s)
+						{ syncOnCommit = s; }
+
+	/**
+	 * Check whether persistent MIB objects are synced after each
+	 * committed SET request.
+	 *
+	 * @return
+	 *    TRUE if syncing on commit is enabled.
+	 * @since 4.6.1
+	 */
+	bool			is_sync_on_commit() const
+						{ return syncOnCommit; }
+
 	/**
 	 * Save all persistent MIB objects in the supplied format to the
 	 * supplied path.
@@ -2834,6 +3383,50 @@ public:
 	 */
 	void		       	unlock_mib();
 
+	/**
+	 * Lock the receiver's registration for lookups only. In read-mostly
+	 * mode (see set_read_mostly) any number of threads may hold this
+	 * lock concurrently, while lock_mib() waits until all of them
+	 * have released it. Otherwise, this is the same as lock_mib().
+	 *
+	 * @since 4.6.1
+	 */
+	void		       	lock_mib_shared();
+
+	/**
+	 * Release a lock acquired by lock_mib_shared().
+	 *
+	 * @since 4.6.1
+	 */
+	void		       	unlock_mib_shared();
+
+	/**
+	 * Enable or disable the read-mostly mode. In read-mostly mode,
+	 * GET, GETNEXT, and GETBULK requests look up MIB objects
+	 * concurrently. Only adding and removing MIB objects (and SET
+	 * requests) lock the registration exclusively.
+	 * Because lookups run concurrently, MibTable::update and
+	 * MibEntry::find_succ implementations must be thread-safe and must
+	 * not add or remove MIB objects.
+	 * This method must not be called after entering the agent's main
+	 * loop (i.e., after processing the first requests).
+	 *
+	 * @param enable
+	 *    TRUE to enable the read-mostly mode (default is FALSE).
+	 * @since 4.6.1
+	 */
+	void			set_read_mostly(bool enable)
+	    { readMostly = enable; }
+
+	/**
+	 * Check whether the read-mostly mode is enabled.
+	 *
+	 * @return
+	 *    TRUE if lookups may run concurrently.
+	 * @since 4.6.1
+	 */
+	bool			is_read_mostly() const { return readMostly; }
+
 	/**
 	 * Get a context.
 	 *
@@ -3169,7 +3762,9 @@ protected:
         NS_SNMP OctetStr*	       	persistent_objects_path;
 #ifdef _THREADS
 	ThreadManager			mibLock;
+	ReadWriteLock			registrationLock;
 #endif
+	bool				readMostly;
 #ifdef _SNMPv3
 	NS_SNMP OctetStr       	       	bootCounterFile;
 #ifdef _PROXY_FORWARDER
@@ -3183,6 +3778,8 @@ protected:
 #endif
 
 	Array<MibConfigFormat>		configFormats;
+	unsigned int			persistenceFormat;
+	bool				syncOnCommit;
 
  private:
 	void				construct(const NS_SNMP OctetStr&,
@@ -3202,14 +3799,40 @@ void* mib_method_routine_caller(void*);
 inline void Mib::lock_mib() 
 {
 #ifdef _THREADS
-	mibLock.start_synch();
+	if (readMostly)
+		registrationLock.write_lock();
+	else
+		mibLock.start_synch();
 #endif
 }
 
 inline void Mib::unlock_mib() 
 {
 #ifdef _THREADS
-	mibLock.end_synch();
+	if (readMostly)
+		registrationLock.write_unlock();
+	else
+		mibLock.end_synch();
+#endif
+}
+
+inline void Mib::lock_mib_shared() 
+{
+#ifdef _THREADS
+	if (readMostly)
+		registrationLock.read_lock();
+	else
+		mibLock.start_synch();
+#endif
+}
+
+inline void Mib::unlock_mib_shared() 
+{
+#ifdef _THREADS
+	if (readMostly)
+		registrationLock.read_unlock();
+	else
+		mibLock.end_synch();
 #endif
 }
 
@@ -148,7 +148,9 @@ public:
 	void			clearAll();
 
 	/**
-	 * Load the value(s) of the receiver node from a file.
+	 * Load the value(s) of the receiver node from a file. Files
+	 * written by write_image are recognized and loaded by
+	 * load_image.
 	 *
 	 * @param fname - A file name.
 	 */ 
@@ -156,11 +158,84 @@ public:
 
 	/**
 	 * Save the value(s) of the receiver node to a file.
+	 * Calls write_snapshot.
 	 *
 	 * @param fname - A file name.
 	 */
 	virtual void		save_to_file(const char*);
 
+	/**
+	 * Save the value(s) of the receiver node to a file. The data is
+	 * written to a temporary file, which replaces the given file
+	 * when it is complete. Each object is locked while it is
+	 * serialized. If image snapshots are enabled, write_image is
+	 * called instead.
+	 *
+	 * @param fname
+	 *    a file name.
+	 * @return
+	 *    TRUE if the file has been written, FALSE otherwise (the
+	 *    previous file is then left unchanged).
+	 * @since 4.6.1
+	 */
+	virtual bool		write_snapshot(const char*);
+
+	/**
+	 * Save the value(s) of the receiver node to a versioned image
+	 * file that can be mapped into memory. Each object is stored
+	 * with its object identifier and the data returned by its
+	 * serialize_image method. Like write_snapshot, the image
+	 * replaces the given file only when it is complete.
+	 *
+	 * The image uses the byte order of the host. An image written
+	 * on a host with different byte order is not loaded.
+	 *
+	 * @param fname
+	 *    a file name.
+	 * @return
+	 *    TRUE if the file has been written, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	virtual bool		write_image(const char*);
+
+	/**
+	 * Load the value(s) of the receiver node from an image file
+	 * written by write_image. The file is mapped into memory and
+	 * each object is restored by its deserialize_image method.
+	 * Objects are matched by their object identifiers, objects not
+	 * found in the image keep their values.
+	 *
+	 * @param fname
+	 *    a file name.
+	 * @return
+	 *    TRUE if the image has been loaded, FALSE if it could not be
+	 *    read or is corrupt.
+	 * @since 4.6.1
+	 */
+	virtual bool		load_image(const char*);
+
+	/**
+	 * Enable or disable image snapshots. If enabled, write_snapshot
+	 * (and thus save_to_file) writes an image by calling write_image.
+	 * The default is disabled.
+	 *
+	 * @param enable
+	 *    TRUE to write images instead of BER encoded snapshots.
+	 * @since 4.6.1
+	 */
+	void			set_image_snapshot(bool enable)
+					{ imageSnapshot = enable; }
+
+	/**
+	 * Check whether image snapshots are enabled.
+	 *
+	 * @return
+	 *    TRUE if write_snapshot writes images.
+	 * @since 4.6.1
+	 */
+	bool			is_image_snapshot() const
+					{ return imageSnapshot; }
+
 	/**
 	 * Return whether objects in this group are persistent or not.
 	 *
@@ -203,6 +278,7 @@ protected:
 	List<MibEntry>	content;
 	NS_SNMP OctetStr*      	persistencyName;
 	unsigned int	timeout;
+	bool		imageSnapshot;
 };
 
 
@@ -488,8 +564,30 @@ class AGENTPP_DECL MibContext: public ThreadManager
 					{ return content.size(); }
 
  protected:
+	/**
+	 * Get the lookup index of the receiver's content. The index is
+	 * rebuilt if MIB objects have been added or removed since it
+	 * has been built the last time. The caller has to hold the lock
+	 * of the receiver.
+	 *
+	 * @return
+	 *    a sorted index of all registered MIB objects.
+	 * @since 4.6.1
+	 */
+	const OidIndex<MibEntry>&	get_index();
+
+	/**
+	 * Mark the lookup index as outdated. Must be called whenever
+	 * the content of the receiver is changed.
+	 *
+	 * @since 4.6.1
+	 */
+	void			invalidate_index() { indexValid = FALSE; }
+
 	OidList<MibEntry>		content;
 	OidList<MibGroup>      		groups;	
+	OidIndex<MibEntry>		index;
+	bool				indexValid;
 	Oidx				contextKey;
 	NS_SNMP OctetStr		context;
 	NS_SNMP OctetStr*		persistencyPath;
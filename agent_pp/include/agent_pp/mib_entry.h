@@ -205,7 +205,8 @@ public:
 	virtual void		load_from_file(const char*);
 
 	/**
-	 * Save the value(s) of the receiver node to a file.
+	 * Save the value(s) of the receiver node to a file. The file is
+	 * replaced only after the new content has been written completely.
 	 *
 	 * @param fname - A file name.
 	 */
@@ -233,6 +234,35 @@ public:
 	 */
 	virtual bool      	deserialize(char*, int&);
 
+	/**
+	 * Serialize the value of the receiver for a memory mappable
+	 * image (see MibConfigImage). By default, the BER encoding of
+	 * serialize is used. Subclasses overriding serialize should
+	 * also override this method if they provide a faster layout.
+	 *
+	 * @param buf - A pointer to byte stream buffer returned.
+	 * @param sz - The size of the buffer returned.
+	 * @return TRUE if serialization was successful, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	virtual bool      	serialize_image(char*&, int&);
+
+	/**
+	 * Read the value of the receiver from a buffer that has been
+	 * written by serialize_image. The buffer may be a read-only
+	 * mapping of the image file. By default, deserialize is called
+	 * on a copy of the buffer.
+	 *
+	 * @param buf
+	 *    a pointer to the image data of the receiver.
+	 * @param sz
+	 *    the size of the image data.
+	 * @return
+	 *    TRUE if deserialization was successful, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	virtual bool      	deserialize_image(const char*, int);
+
 	/**
 	 * Check whether the receiver node contains any instance of a
 	 * managed object.
@@ -38,6 +38,147 @@ namespace Agentpp {
 #endif
 
 
+#ifdef _THREADS
+/*----------------------- class NotificationQueue ------------------------*/
+
+#if !defined (AGENTPP_DECL_TEMPL_LIST_RUNNABLE)
+#define AGENTPP_DECL_TEMPL_LIST_RUNNABLE
+	AGENTPP_DECL_TEMPL template class AGENTPP_DECL List<Runnable>;
+#endif
+
+/**
+ * The NotificationQueue class implements a thread that runs the tasks
+ * added to the queue one after another in the order they were added.
+ * It is used by a NotificationOriginator in asynchronous mode to send
+ * notifications in the background, while preserving their order.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL NotificationQueue: public Thread {
+ public:
+	/**
+	 * Create a queue and start its thread.
+	 *
+	 * @param maxLength
+	 *    the maximum number of tasks waiting in the queue.
+	 */
+	NotificationQueue(int maxLength = AGENTPP_MAX_QUEUED_NOTIFICATIONS);
+
+	/**
+	 * Destructor, runs the remaining tasks and stops the thread.
+	 */
+	virtual ~NotificationQueue();
+
+	/**
+	 * Run the queued tasks until the queue is destroyed.
+	 */
+	virtual void run();
+
+	/**
+	 * Add a task to the queue. The task will be deleted after its run()
+	 * method has been called.
+	 * (SYNCHRONIZED)
+	 *
+	 * @param task
+	 *    a Runnable instance.
+	 * @return
+	 *    TRUE if the task has been queued, FALSE if the queue is full. In
+	 *    that case the task has been deleted without being run.
+	 */
+	bool	add(Runnable* task);
+
+	/**
+	 * Get the number of tasks waiting in the queue.
+	 * (SYNCHRONIZED)
+	 *
+	 * @return
+	 *    the number of queued tasks.
+	 */
+	int	size();
+
+ protected:
+	List<Runnable>	pending;
+	int		length;
+	int		maxLength;
+	bool		go;
+};
+#endif
+
+/*----------------------- class NotificationRoute ------------------------*/
+
+/**
+ * A NotificationRoute describes a management target notifications are
+ * sent to. It is resolved from an active snmpTargetAddrEntry row, the
+ * snmpTargetParamsEntry row referenced by it, and the type of a
+ * snmpNotifyEntry row whose tag selects the target.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL NotificationRoute {
+ public:
+	NotificationRoute(): address(0) { }
+	~NotificationRoute() { if (address) delete address; }
+
+	int			notifyType;
+	long			targetDomain;
+	int			timeout;
+	int			retries;
+	NS_SNMP OctetStr	targetAddress;
+	NS_SNMP OctetStr	paramsName;
+	Oidx			params;
+	int			mpModel;
+	int			securityModel;
+	int			securityLevel;
+	NS_SNMP OctetStr	securityName;
+	bool			filtered;
+	NS_SNMP Address*	address;
+};
+
+/**
+ * A NotificationRouteList holds the routes a notification with a
+ * given notification OID passes the notification filters for.
+ * The routes are owned by the NotificationRoutingTable.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL NotificationRouteList {
+ public:
+	NotificationRouteList(const Oidx& o): id(o) { }
+	~NotificationRouteList() { routes.clear(); }
+
+	OidxPtr			key() { return &id; }
+
+	Oidx			id;
+	Array<NotificationRoute> routes;
+};
+
+#if !defined (AGENTPP_DECL_TEMPL_OIDLIST_NOTIFICATIONROUTELIST)
+#define AGENTPP_DECL_TEMPL_OIDLIST_NOTIFICATIONROUTELIST
+	AGENTPP_DECL_TEMPL template class AGENTPP_DECL OidList<NotificationRouteList>;
+#endif
+
+/**
+ * The NotificationRoutingTable holds all routes compiled from the
+ * SNMP-TARGET-MIB and SNMP-NOTIFICATION-MIB tables together with the
+ * sum of their change counts when they were compiled. The route lists
+ * per notification OID are added on demand.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL NotificationRoutingTable {
+ public:
+	NotificationRoutingTable(unsigned long s): stamp(s), references(0) { }
+
+	unsigned long		stamp;
+	int			references;
+	Array<NotificationRoute> routes;
+	OidList<NotificationRouteList> lists;
+};
+
 /*--------------------- class NotificationOriginator ---------------------*/
 
 /**
@@ -45,12 +186,17 @@ namespace Agentpp {
  * notifications by using the SNMP-TARGET-MIB and the SNMP-NOTIFICATION-MIB.
  * NotificationOriginator is typically used outside the main loop of an 
  * agent's request handling.
+ *
+ * The targets of a notification are looked up in a routing table that
+ * is compiled from those tables when a notification is sent after the
+ * tables have been changed (see MibTable::get_change_count).
  * 
  * @author Frank Fock
  * @version 3.5.10
  */
 
 class AGENTPP_DECL NotificationOriginator: public NotificationSender {
+	friend class QueuedNotification;
 
  public:
 	/**
@@ -152,6 +298,35 @@ class AGENTPP_DECL NotificationOriginator: public NotificationSender {
 	 *    TRUE if the operation has been successful, FALSE otherwise.
 	 */
 	/**@{ */
+	/**
+	 * Enable or disable the asynchronous mode. In asynchronous mode
+	 * generate(..) and notify(..) copy the notification into a
+	 * NotificationQueue and return immediately. The queue's thread then
+	 * sends the notification to the targets and sends informs by
+	 * SnmpRequestV3::send_async, i.e. without waiting for their
+	 * acknowledgement. Thus the returned status only tells whether the
+	 * notification could be queued. Because queued notifications are sent
+	 * by this originator, a long-lived instance has to be used.
+	 * Without thread support, notifications are always sent synchronously.
+	 *
+	 * @param async
+	 *    TRUE to enable asynchronous mode, FALSE (the default) to disable
+	 *    it. When disabling it, already queued notifications are sent
+	 *    before this method returns. The mode must not be changed while
+	 *    other threads generate notifications with this originator.
+	 * @since 4.6.1
+	 */
+	void	set_async(bool async);
+
+	/**
+	 * Check whether the asynchronous mode is enabled.
+	 *
+	 * @return
+	 *    TRUE if notifications are queued and sent in the background.
+	 * @since 4.6.1
+	 */
+	bool	is_async() const;
+
 	virtual bool add_v1_trap_destination(const NS_SNMP UdpAddress& addr,
 					     const NS_SNMP OctetStr &name,
 					     const NS_SNMP OctetStr &tag,
@@ -376,6 +551,101 @@ class AGENTPP_DECL NotificationOriginator: public NotificationSender {
 	int    generate(Vbx*, int, const Oidx&, unsigned int, 
 			const Oidx&, const NS_SNMP OctetStr&);
 
+	/**
+	 * Send a notification message to all targets selected by the
+	 * SNMP-NOTIFICATION-MIB. This is called by generate(..) directly in
+	 * synchronous mode and by the NotificationQueue in asynchronous
+	 * mode.
+	 *
+	 * @param vbs
+	 *    an array of variable bindings - the payload of the notification.
+	 * @param size
+	 *    the size of the above array.
+	 * @param id
+	 *    the trap oid which identifies the notification.
+	 * @param sysUpTime
+	 *    the timestamp to be used
+	 * @param enterprise
+	 *    the enterprise oid.
+	 * @param contextName
+	 *    the context in which the trap occured.
+	 * @return
+	 *    SNMP_ERROR_SUCCESS if the notification could be sent to all
+	 *    targets, otherwise the last error status.
+	 * @since 4.6.1
+	 */
+	int    send_notifications(Vbx*, int, const Oidx&, unsigned int,
+				  const Oidx&, const NS_SNMP OctetStr&);
+
+	/**
+	 * Get the routes for a notification from the routing table. The
+	 * routing table is compiled again, if the SNMP-TARGET-MIB or
+	 * SNMP-NOTIFICATION-MIB tables have been changed since it was
+	 * compiled. The returned table has to be given back by
+	 * release_routes.
+	 * (SYNCHRONIZED)
+	 *
+	 * @param id
+	 *    the notification OID.
+	 * @param table
+	 *    returns the routing table the returned list belongs to.
+	 * @return
+	 *    the routes the notification passes the notification filters
+	 *    for, or 0 if the MIB tables are not available.
+	 * @since 4.6.1
+	 */
+	NotificationRouteList* get_routes(const Oidx&,
+					  NotificationRoutingTable*&);
+
+	/**
+	 * Give back a routing table obtained by get_routes.
+	 * (SYNCHRONIZED)
+	 *
+	 * @param table
+	 *    a routing table.
+	 * @since 4.6.1
+	 */
+	void release_routes(NotificationRoutingTable*);
+
+	/**
+	 * Compile the routing table from the snmpTargetAddrTable,
+	 * snmpTargetParamsTable, and snmpNotifyTable.
+	 *
+	 * @param stamp
+	 *    the sum of the change counts of the tables the routes are
+	 *    compiled from (see get_routing_stamp).
+	 * @return
+	 *    a new routing table.
+	 * @since 4.6.1
+	 */
+	NotificationRoutingTable* compile_routes(unsigned long);
+
+	/**
+	 * Compile the route to the management target of a
+	 * snmpTargetAddrEntry row.
+	 *
+	 * @param row
+	 *    an active snmpTargetAddrEntry row.
+	 * @param notify
+	 *    the notification type of the snmpNotifyEntry row that selected
+	 *    the target.
+	 * @return
+	 *    a new route, or 0 if the target parameters or address are
+	 *    not valid.
+	 * @since 4.6.1
+	 */
+	NotificationRoute* compile_route(MibTableRow*, int);
+
+	/**
+	 * Get the sum of the change counts of the tables the routing table
+	 * is compiled from.
+	 *
+	 * @return
+	 *    the sum of change counts.
+	 * @since 4.6.1
+	 */
+	unsigned long get_routing_stamp();
+
 	/**
 	 * Check notification access for a management target.
 	 * Call this to validate access before sending the notificaiton.  The
@@ -386,14 +656,14 @@ class AGENTPP_DECL NotificationOriginator: public NotificationSender {
 	 * responsible to delete the target object in the
 	 * NotificationOriginatorParams object (after sending the notification).
 	 *
-	 * @param cur
-	 *    the selected entry in the snmpTargetAddrTable
+	 * @param route
+	 *    the route to the target
 	 * @param nop
 	 *    the notification originator parameters
 	 * @return
 	 *    TRUE if access is okay, FALSE otherwise
 	 */			       
-	bool check_access(ListCursor<MibTableRow>& cur, NotificationOriginatorParams& nop);
+	bool check_access(NotificationRoute* route, NotificationOriginatorParams& nop);
 
 	/**
 	 * Send a notification to a valid target.
@@ -402,21 +672,26 @@ class AGENTPP_DECL NotificationOriginator: public NotificationSender {
 	 * the vbs, size, id, timestamp, enterprise, contextName, securityName,
 	 * securityLevel, mpModel, and target parameters filled in.
 	 *
-	 * @param cur
-	 *    the selected entry in the snmpTargetAddrTable
+	 * @param route
+	 *    the route to the target, it specifies the notification type
+	 *    (trap or inform)
 	 * @param nop
 	 *    the notification originator parameters
-	 * @param notify
-	 *    specifies the notification type (trap or inform)
 	 * @return
 	 *    The result from calling SnmpRequestV3::send or
 	 *    SnmpRequest::process_trap
 	 */			       
-	int send_notify(ListCursor<MibTableRow>& cur, NotificationOriginatorParams& nop, int notify);
+	int send_notify(NotificationRoute* route, NotificationOriginatorParams& nop);
+
+	NotificationRoutingTable*	routing;
+	ThreadManager			routingLock;
 
 #ifdef _SNMPv3
 	NS_SNMP OctetStr*	localEngineID;
 #endif
+#ifdef _THREADS
+	NotificationQueue*	notificationQueue;
+#endif
 };
 #ifdef AGENTPP_NAMESPACE
 }
@@ -59,7 +59,7 @@ namespace Agentpp {
 
 // comparison : less-than -> < 0; equal -> 0; greater-than -> > 0
 #ifndef OidxPtrCMP
-#define OidxPtrCMP(a, b) ( ((*a) <= (*b))? (((*a) == (*b))? 0 : -1) : 1 )
+#define OidxPtrCMP(a, b) ((a)->compare(*(b)))
 #endif
 
 // hash function
@@ -36,6 +36,13 @@
 #define PHASE_UNDO		3
 #define PHASE_CLEANUP		4
 
+// Upper bound for the number of sub-requests a GETBULK request reserves
+// room for in advance: the smallest variable binding (sequence, one
+// byte OID, and NULL) takes 7 bytes.
+#ifndef AGENTPP_MAX_BULK_SUBREQUESTS
+#define AGENTPP_MAX_BULK_SUBREQUESTS	(MAX_SNMP_PACKET / 7)
+#endif
+
 #ifdef AGENTPP_NAMESPACE
 namespace Agentpp {
     using namespace Snmp_pp;
@@ -580,6 +587,29 @@ protected:
 
 	int	  	get_max_response_length();
 
+	/**
+	 * Make room for the given number of sub-requests in the PDU and
+	 * in the done and ready states, without changing the number of
+	 * sub-requests.
+	 *
+	 * @param count
+	 *    the number of sub-requests.
+	 * @since 4.6.1
+	 */
+	void		reserve_subrequests(int count);
+
+	/**
+	 * Change the value of a sub-request and keep the encoded length
+	 * of the variable bindings up to date.
+	 *
+	 * @param vb
+	 *    the new variable binding.
+	 * @param i
+	 *    the index of the sub-request.
+	 * @since 4.6.1
+	 */
+	void		update_vb(const Vbx& vb, int i);
+
 	Pdux*		pdu;
 	Vbx*		originalVbs;
 	int		originalSize;
@@ -589,6 +619,11 @@ protected:
 	bool*           ready;
 	int		outstanding;
 	int		size;
+	// number of allocated done and ready states (>= size)
+	int		allocated;
+	// sum of the encoded lengths of the variable bindings of a
+	// GETBULK request, -1 for other requests
+	int		vbsLength;
 
 	int		non_rep;
 	int		max_rep;
@@ -607,6 +642,10 @@ protected:
 	TargetType	target;
 #ifdef NO_FAST_MUTEXES
 	static LockQueue* lockQueue;
+#ifndef AGENTPP_USE_LOCK_QUEUE
+	// held while the request is owned by the RequestList
+	TicketLock	requestLock;
+#endif
 #endif
 };
 
@@ -780,6 +819,24 @@ public:
 	 */
 	virtual Request*		receive(int);
 
+	/**
+	 * Wait a given time for an incoming request on the given
+	 * session. Several threads may call this method concurrently,
+	 * each with its own session (see RequestReceiver).
+	 *
+	 * @param timeout
+	 *    The maximum time in seconds to wait for an incoming request.
+	 *    If timeout is 0 receive will not block, if it is <0 receive
+	 *    will wait forever.
+	 * @param session
+	 *    the Snmpx session to receive from. Error responses are sent
+	 *    through this session too.
+	 * @return A pointer to the received request or 0 if within the
+	 *         timeout period no request has been received.
+	 * @since 4.6.1
+	 */
+	virtual Request*		receive(int, Snmpx*);
+
 	/**
 	 * Return the corresponding request id of a request in the
 	 * receiver RequestList that contains the specified variable
@@ -844,6 +901,20 @@ public:
 	 */
 	virtual Request*		find_request_on_id(unsigned long);
 
+	/**
+	 * Return a pointer to the request identified by a given request id
+	 * and source address. The addresses are compared in their binary
+	 * form. (NOT SYNCHRONIZED)
+	 *
+	 * @param request_id - A request id.
+	 * @param from - The source address of the request.
+	 * @return A pointer to a Request or 0 if there is no request pending
+	 *         with the given request id from the given address.
+	 * @since 4.6.1
+	 */
+	virtual Request*		find_request(unsigned long,
+					     const NS_SNMP UdpAddress&);
+
 	/**
 	 * Answer a Request by sending the corresponding response PDU.
 	 * (SYNCHRONIZED)
@@ -952,6 +1023,29 @@ protected:
 	 *    a pointer to a Request instance.
 	 */
 	static void	null_vbs(Request* req);
+
+	/**
+	 * Add a request to the hash indexes on transaction id and
+	 * on request id plus source address.
+	 */
+	void		index_request(Request* req);
+
+	/**
+	 * Remove a request from the hash indexes.
+	 */
+	void		unindex_request(Request* req);
+
+	/**
+	 * Compute the hash value of a request id and a source address.
+	 */
+	static unsigned long	hash_source(unsigned long,
+					    const NS_SNMP UdpAddress&);
+
+	/**
+	 * Compare two addresses in their binary form (address and port).
+	 */
+	static bool	same_source(const NS_SNMP UdpAddress&,
+				    const NS_SNMP UdpAddress&);
         
 #ifdef NO_FAST_MUTEXES
 	/**
@@ -968,6 +1062,8 @@ protected:
 #endif
 
         List<Request>*		requests;
+	HashIndex<Request>	requestsByTransactionId;
+	HashIndex<Request>	requestsBySource;
 	Snmpx*			snmp;
 #ifdef _SNMPv3
         Vacm*			vacm;
@@ -985,6 +1081,60 @@ protected:
         Mib*                    mib;
 };
 
+#ifdef _THREADS
+
+/*---------------------- class RequestReceiver ----------------------*/
+
+/**
+ * A RequestReceiver thread receives requests on its own Snmpx session
+ * and hands them to Mib::process_request. When the sessions of several
+ * receivers are bound to the same port with reuse_port, the operating
+ * system spreads the incoming requests over the receiver threads, so
+ * that receiving and decoding is no longer limited to a single thread.
+ *
+ * @version 4.6.1
+ */
+
+class AGENTPP_DECL RequestReceiver: public Thread {
+ public:
+	/**
+	 * Create a receiver thread. The thread has to be started by
+	 * calling start().
+	 *
+	 * @param mib
+	 *    the Mib processing the received requests.
+	 * @param requestList
+	 *    the RequestList the requests are added to.
+	 * @param session
+	 *    the session to receive from. The receiver does not own it.
+	 */
+	RequestReceiver(Mib* mib, RequestList* requestList, Snmpx* session);
+
+	/**
+	 * Stop and join the thread.
+	 */
+	virtual ~RequestReceiver();
+
+	/**
+	 * Receive and process requests until stop() is called.
+	 */
+	virtual void	run();
+
+	/**
+	 * Let the thread terminate after its current receive timeout
+	 * of at most one second.
+	 */
+	void		stop() { running = FALSE; }
+
+ protected:
+	Mib*		mib;
+	RequestList*	requestList;
+	Snmpx*		session;
+	std::atomic<bool>	running;
+};
+
+#endif
+
 /*------------------------ class RequestID --------------------------*/
 
 /**
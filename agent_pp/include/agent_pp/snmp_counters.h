@@ -24,6 +24,10 @@
 #include <agent_pp/agent++.h>
 #include <agent_pp/snmp_pp_ext.h>
 
+#ifdef _THREADS
+#include <atomic>
+#endif
+
 #ifdef AGENTPP_NAMESPACE
 namespace Agentpp {
     using namespace Snmp_pp;
@@ -31,6 +35,61 @@ namespace Agentpp {
 
 #define SNMP_COUNTERS 29
 
+// number of shards a StatCounter is split into
+#ifndef AGENTPP_STAT_COUNTER_SHARDS
+#define AGENTPP_STAT_COUNTER_SHARDS 16
+#endif
+
+/**********************************************************************
+ *  
+ *  class StatCounter
+ * 
+ */
+
+/**
+ * The StatCounter class implements a Counter32 statistics counter that
+ * can be incremented by many threads concurrently without locking and
+ * without contending for a single cache line. Each thread increments
+ * its own shard; the shards are summed up only when the counter is read.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL StatCounter {
+
+public:
+	StatCounter() { reset(); }
+
+	/**
+	 * Increment the counter by one.
+	 */
+	void		increment();
+
+	/**
+	 * Get the value of the counter.
+	 *
+	 * @return
+	 *    the sum of all shards modulo 2^32.
+	 */
+	unsigned long	get() const;
+
+	/**
+	 * Set the counter to zero.
+	 */
+	void		reset();
+
+private:
+#ifdef _THREADS
+	// each shard occupies a cache line of its own
+	struct alignas(64) Shard {
+		std::atomic<unsigned long> value;
+	};
+	Shard		shards[AGENTPP_STAT_COUNTER_SHARDS];
+#else
+	unsigned long	value;
+#endif
+};
+
 
 
 /**********************************************************************
@@ -39,77 +98,94 @@ namespace Agentpp {
  * 
  */
 
+/**
+ * The MibIIsnmpCounters class holds the counters of the snmpGroup.
+ * Since 4.6.1, the snmpGroup leaves read their values from these
+ * counters and the request processing increments them directly,
+ * without looking up the leaves in the MIB.
+ */
 class AGENTPP_DECL MibIIsnmpCounters {
 
 public:
 	MibIIsnmpCounters();
 
-	static NS_SNMP Counter32 inPkts()	       	{ return counter_snmp[0]; }
-	static NS_SNMP Counter32 outPkts()	       	{ return counter_snmp[1]; }
-	static NS_SNMP Counter32 inBadVersions()        { return counter_snmp[2]; }
-	static NS_SNMP Counter32 inBadCommunityNames() 	{ return counter_snmp[3]; }
-	static NS_SNMP Counter32 inBadCommunityUses()  	{ return counter_snmp[4]; }
-	static NS_SNMP Counter32 inASNParseErrs()      	{ return counter_snmp[5]; }
-	static NS_SNMP Counter32 inTooBigs()	       	{ return counter_snmp[6]; }
-	static NS_SNMP Counter32 inNoSuchNames()       	{ return counter_snmp[7]; }
-	static NS_SNMP Counter32 inBadValues()	       	{ return counter_snmp[8]; }
-	static NS_SNMP Counter32 inReadOnlys()	       	{ return counter_snmp[9]; }
-	static NS_SNMP Counter32 inGenErrs()	       	{ return counter_snmp[10]; }
-	static NS_SNMP Counter32 inTotalReqVars()      	{ return counter_snmp[11]; }
-	static NS_SNMP Counter32 inTotalSetVars()      	{ return counter_snmp[12]; }
-	static NS_SNMP Counter32 inGetRequests()       	{ return counter_snmp[13]; }
-	static NS_SNMP Counter32 inGetNexts()	       	{ return counter_snmp[14]; }
-	static NS_SNMP Counter32 inSetRequests()       	{ return counter_snmp[15]; }
-	static NS_SNMP Counter32 inGetResponses()      	{ return counter_snmp[16]; }
-	static NS_SNMP Counter32 inTraps()	       	{ return counter_snmp[17]; }
-	static NS_SNMP Counter32 outTooBigs()	       	{ return counter_snmp[18]; }
-	static NS_SNMP Counter32 outNoSuchNames()      	{ return counter_snmp[19]; }
-	static NS_SNMP Counter32 outBadValues()		{ return counter_snmp[20]; }
-	static NS_SNMP Counter32 outGenErrs()	       	{ return counter_snmp[21]; }
-	static NS_SNMP Counter32 outGetRequests()      	{ return counter_snmp[22]; }
-	static NS_SNMP Counter32 outGetNexts()	       	{ return counter_snmp[23]; }
-	static NS_SNMP Counter32 outSetRequests()      	{ return counter_snmp[24]; }
-	static NS_SNMP Counter32 outGetResponses()     	{ return counter_snmp[25]; }
-	static NS_SNMP Counter32 outTraps()	       	{ return counter_snmp[26]; }
-	static NS_SNMP Counter32 silentDrops()      	{ return counter_snmp[27]; }
-	static NS_SNMP Counter32 proxyDrops()     	{ return counter_snmp[28]; }
-
-
-	static void      incInPkts()	       	{ counter_snmp[0]++; }
-	static void      incOutPkts()	       	{ counter_snmp[1]++; }
-	static void      incInBadVersions()     { counter_snmp[2]++; }
-	static void      incInBadCommunityNames()     	{ counter_snmp[3]++; }
-	static void      incInBadCommunityUses(){ counter_snmp[4]++; }
-	static void      incInASNParseErrs()   	{ counter_snmp[5]++; }
-	static void      incInTooBigs()	       	{ counter_snmp[6]++; }
-	static void      incInNoSuchNames()    	{ counter_snmp[7]++; }
-	static void      incInBadValues()       { counter_snmp[8]++; }
-	static void      incInReadOnlys()	{ counter_snmp[9]++; }
-	static void      incInGenErrs()	       	{ counter_snmp[10]++; }
-	static void      incInTotalReqVars()   	{ counter_snmp[11]++; }
-	static void      incInTotalSetVars()   	{ counter_snmp[12]++; }
-	static void      incInGetRequests()    	{ counter_snmp[13]++; }
-	static void      incInGetNexts()        { counter_snmp[14]++; }
-	static void      incInSetRequests()    	{ counter_snmp[15]++; }
-	static void      incInGetResponses()   	{ counter_snmp[16]++; }
-	static void      incInTraps()	       	{ counter_snmp[17]++; }
-	static void      incOutTooBigs()       	{ counter_snmp[18]++; }
-	static void      incOutNoSuchNames()   	{ counter_snmp[19]++; }
-	static void      incOutBadValues()      { counter_snmp[20]++; }
-	static void      incOutGenErrs()        { counter_snmp[21]++; }
-	static void      incOutGetRequests()   	{ counter_snmp[22]++; }
-	static void      incOutGetNexts()       { counter_snmp[23]++; }
-	static void      incOutSetRequests()   	{ counter_snmp[24]++; }
-	static void      incOutGetResponses()  	{ counter_snmp[25]++; }
-	static void      incOutTraps()	       	{ counter_snmp[26]++; }
-	static void      incSilentDrops()  	{ counter_snmp[27]++; }
-	static void      incProxyDrops()       	{ counter_snmp[28]++; }
+	static NS_SNMP Counter32 inPkts()	       	{ return counter_snmp[0].get(); }
+	static NS_SNMP Counter32 outPkts()	       	{ return counter_snmp[1].get(); }
+	static NS_SNMP Counter32 inBadVersions()        { return counter_snmp[2].get(); }
+	static NS_SNMP Counter32 inBadCommunityNames() 	{ return counter_snmp[3].get(); }
+	static NS_SNMP Counter32 inBadCommunityUses()  	{ return counter_snmp[4].get(); }
+	static NS_SNMP Counter32 inASNParseErrs()      	{ return counter_snmp[5].get(); }
+	static NS_SNMP Counter32 inTooBigs()	       	{ return counter_snmp[6].get(); }
+	static NS_SNMP Counter32 inNoSuchNames()       	{ return counter_snmp[7].get(); }
+	static NS_SNMP Counter32 inBadValues()	       	{ return counter_snmp[8].get(); }
+	static NS_SNMP Counter32 inReadOnlys()	       	{ return counter_snmp[9].get(); }
+	static NS_SNMP Counter32 inGenErrs()	       	{ return counter_snmp[10].get(); }
+	static NS_SNMP Counter32 inTotalReqVars()      	{ return counter_snmp[11].get(); }
+	static NS_SNMP Counter32 inTotalSetVars()      	{ return counter_snmp[12].get(); }
+	static NS_SNMP Counter32 inGetRequests()       	{ return counter_snmp[13].get(); }
+	static NS_SNMP Counter32 inGetNexts()	       	{ return counter_snmp[14].get(); }
+	static NS_SNMP Counter32 inSetRequests()       	{ return counter_snmp[15].get(); }
+	static NS_SNMP Counter32 inGetResponses()      	{ return counter_snmp[16].get(); }
+	static NS_SNMP Counter32 inTraps()	       	{ return counter_snmp[17].get(); }
+	static NS_SNMP Counter32 outTooBigs()	       	{ return counter_snmp[18].get(); }
+	static NS_SNMP Counter32 outNoSuchNames()      	{ return counter_snmp[19].get(); }
+	static NS_SNMP Counter32 outBadValues()		{ return counter_snmp[20].get(); }
+	static NS_SNMP Counter32 outGenErrs()	       	{ return counter_snmp[21].get(); }
+	static NS_SNMP Counter32 outGetRequests()      	{ return counter_snmp[22].get(); }
+	static NS_SNMP Counter32 outGetNexts()	       	{ return counter_snmp[23].get(); }
+	static NS_SNMP Counter32 outSetRequests()      	{ return counter_snmp[24].get(); }
+	static NS_SNMP Counter32 outGetResponses()     	{ return counter_snmp[25].get(); }
+	static NS_SNMP Counter32 outTraps()	       	{ return counter_snmp[26].get(); }
+	static NS_SNMP Counter32 silentDrops()      	{ return counter_snmp[27].get(); }
+	static NS_SNMP Counter32 proxyDrops()     	{ return counter_snmp[28].get(); }
+
+
+	static void      incInPkts()	       	{ counter_snmp[0].increment(); }
+	static void      incOutPkts()	       	{ counter_snmp[1].increment(); }
+	static void      incInBadVersions()     { counter_snmp[2].increment(); }
+	static void      incInBadCommunityNames()     	{ counter_snmp[3].increment(); }
+	static void      incInBadCommunityUses(){ counter_snmp[4].increment(); }
+	static void      incInASNParseErrs()   	{ counter_snmp[5].increment(); }
+	static void      incInTooBigs()	       	{ counter_snmp[6].increment(); }
+	static void      incInNoSuchNames()    	{ counter_snmp[7].increment(); }
+	static void      incInBadValues()       { counter_snmp[8].increment(); }
+	static void      incInReadOnlys()	{ counter_snmp[9].increment(); }
+	static void      incInGenErrs()	       	{ counter_snmp[10].increment(); }
+	static void      incInTotalReqVars()   	{ counter_snmp[11].increment(); }
+	static void      incInTotalSetVars()   	{ counter_snmp[12].increment(); }
+	static void      incInGetRequests()    	{ counter_snmp[13].increment(); }
+	static void      incInGetNexts()        { counter_snmp[14].increment(); }
+	static void      incInSetRequests()    	{ counter_snmp[15].increment(); }
+	static void      incInGetResponses()   	{ counter_snmp[16].increment(); }
+	static void      incInTraps()	       	{ counter_snmp[17].increment(); }
+	static void      incOutTooBigs()       	{ counter_snmp[18].increment(); }
+	static void      incOutNoSuchNames()   	{ counter_snmp[19].increment(); }
+	static void      incOutBadValues()      { counter_snmp[20].increment(); }
+	static void      incOutGenErrs()        { counter_snmp[21].increment(); }
+	static void      incOutGetRequests()   	{ counter_snmp[22].increment(); }
+	static void      incOutGetNexts()       { counter_snmp[23].increment(); }
+	static void      incOutSetRequests()   	{ counter_snmp[24].increment(); }
+	static void      incOutGetResponses()  	{ counter_snmp[25].increment(); }
+	static void      incOutTraps()	       	{ counter_snmp[26].increment(); }
+	static void      incSilentDrops()  	{ counter_snmp[27].increment(); }
+	static void      incProxyDrops()       	{ counter_snmp[28].increment(); }
 	
 	// set all counters to zero
 	static void	 reset();
 
+	/**
+	 * Get the handle of a counter, for example to increment it
+	 * directly or to back a StatCounterMibLeaf with it.
+	 *
+	 * @param nr
+	 *    the number of the counter (0 = inPkts, ..., 28 = proxyDrops),
+	 *    in the order of the accessors above.
+	 * @since 4.6.1
+	 */
+	static StatCounter* get_counter(int nr) { return &counter_snmp[nr]; }
+
 protected:
-	static unsigned long counter_snmp[];
+	static StatCounter counter_snmp[];
 };
 
 #ifdef AGENTPP_NAMESPACE
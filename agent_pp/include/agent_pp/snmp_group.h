@@ -27,6 +27,7 @@
 
 #include <agent_pp/agent++.h>
 #include <agent_pp/mib.h>
+#include <agent_pp/snmp_counters.h>
 
 
 #define oidSnmpGroup			"1.3.6.1.2.1.11"
@@ -70,205 +71,277 @@ namespace Agentpp {
 #endif
 
 
-class AGENTPP_DECL snmpInPkts: public Counter32MibLeaf {
+/**
+ * The StatCounterMibLeaf class is a Counter32MibLeaf whose value is kept
+ * by a StatCounter. Incrementing the counter through its handle needs
+ * neither a MIB lookup nor a lock. The value of the leaf is always read
+ * from the counter, by requests as well as by get_value and serialize.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL StatCounterMibLeaf: public Counter32MibLeaf {
+
+public:
+	/**
+	 * Construct a statistics counter leaf.
+	 *
+	 * @param oid
+	 *    the instance OID of the scalar (including the .0 suffix).
+	 * @param counter
+	 *    the counter providing the value. It is not deleted by the
+	 *    leaf.
+	 */
+	StatCounterMibLeaf(const Oidx& oid, StatCounter* counter):
+		Counter32MibLeaf(oid), counter(counter) { }
+
+	using MibLeaf::get_value;
+
+	/**
+	 * Return the current value of the counter.
+	 *
+	 * @return
+	 *    a variable binding with the OID of the leaf and the value of
+	 *    its StatCounter.
+	 */
+	virtual Vbx	get_value() const;
+
+	virtual bool	serialize(char*&, int&);
+	virtual void	increment() { counter->increment(); }
+
+protected:
+	StatCounter*	counter;
+};
+
+
+class AGENTPP_DECL snmpInPkts: public StatCounterMibLeaf {
 
 public:
-	snmpInPkts(): Counter32MibLeaf(oidSnmpInPkts) { }
+	snmpInPkts(): StatCounterMibLeaf(oidSnmpInPkts,
+				MibIIsnmpCounters::get_counter(0)) { }
 };
 
 
-class AGENTPP_DECL snmpOutPkts: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutPkts: public StatCounterMibLeaf {
 
 public:
-	snmpOutPkts(): Counter32MibLeaf(oidSnmpOutPkts) { }
+	snmpOutPkts(): StatCounterMibLeaf(oidSnmpOutPkts,
+				MibIIsnmpCounters::get_counter(1)) { }
 };
 
 
-class AGENTPP_DECL snmpInBadVersions: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInBadVersions: public StatCounterMibLeaf {
 
 public:
-	snmpInBadVersions(): Counter32MibLeaf(oidSnmpInBadVersions) { }
+	snmpInBadVersions(): StatCounterMibLeaf(oidSnmpInBadVersions,
+				MibIIsnmpCounters::get_counter(2)) { }
 };
 
 
-class AGENTPP_DECL snmpInBadCommunityNames: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInBadCommunityNames: public StatCounterMibLeaf {
 
 public:
-	snmpInBadCommunityNames(): Counter32MibLeaf(oidSnmpInBadCommunityNames) { }
+	snmpInBadCommunityNames(): StatCounterMibLeaf(oidSnmpInBadCommunityNames,
+				MibIIsnmpCounters::get_counter(3)) { }
 };
 
 
-class AGENTPP_DECL snmpInBadCommunityUses: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInBadCommunityUses: public StatCounterMibLeaf {
 
 public:
-	snmpInBadCommunityUses(): Counter32MibLeaf(oidSnmpInBadCommunityUses) { }
+	snmpInBadCommunityUses(): StatCounterMibLeaf(oidSnmpInBadCommunityUses,
+				MibIIsnmpCounters::get_counter(4)) { }
 };
 
 
-class AGENTPP_DECL snmpInASNParseErrs: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInASNParseErrs: public StatCounterMibLeaf {
 
 public:
-	snmpInASNParseErrs(): Counter32MibLeaf(oidSnmpInASNParseErrs) { }
+	snmpInASNParseErrs(): StatCounterMibLeaf(oidSnmpInASNParseErrs,
+				MibIIsnmpCounters::get_counter(5)) { }
 };
 
 
-class AGENTPP_DECL snmpInTooBigs: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInTooBigs: public StatCounterMibLeaf {
 
 public:
-	snmpInTooBigs(): Counter32MibLeaf(oidSnmpInTooBigs) { }
+	snmpInTooBigs(): StatCounterMibLeaf(oidSnmpInTooBigs,
+				MibIIsnmpCounters::get_counter(6)) { }
 };
 
 
-class AGENTPP_DECL snmpInNoSuchNames: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInNoSuchNames: public StatCounterMibLeaf {
 
 public:
-	snmpInNoSuchNames(): Counter32MibLeaf(oidSnmpInNoSuchNames) { }
+	snmpInNoSuchNames(): StatCounterMibLeaf(oidSnmpInNoSuchNames,
+				MibIIsnmpCounters::get_counter(7)) { }
 };
 
 
-class AGENTPP_DECL snmpInBadValues: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInBadValues: public StatCounterMibLeaf {
 
 public:
-	snmpInBadValues(): Counter32MibLeaf(oidSnmpInBadValues) { }
+	snmpInBadValues(): StatCounterMibLeaf(oidSnmpInBadValues,
+				MibIIsnmpCounters::get_counter(8)) { }
 };
 
 
-class AGENTPP_DECL snmpInReadOnlys: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInReadOnlys: public StatCounterMibLeaf {
 
 public:
-	snmpInReadOnlys(): Counter32MibLeaf(oidSnmpInReadOnlys) { }
+	snmpInReadOnlys(): StatCounterMibLeaf(oidSnmpInReadOnlys,
+				MibIIsnmpCounters::get_counter(9)) { }
 };
 
 
-class AGENTPP_DECL snmpInGenErrs: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInGenErrs: public StatCounterMibLeaf {
 
 public:
-	snmpInGenErrs(): Counter32MibLeaf(oidSnmpInGenErrs) { }
+	snmpInGenErrs(): StatCounterMibLeaf(oidSnmpInGenErrs,
+				MibIIsnmpCounters::get_counter(10)) { }
 };
 
 
-class AGENTPP_DECL snmpInTotalReqVars: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInTotalReqVars: public StatCounterMibLeaf {
 
 public:
-	snmpInTotalReqVars(): Counter32MibLeaf(oidSnmpInTotalReqVars) { }
+	snmpInTotalReqVars(): StatCounterMibLeaf(oidSnmpInTotalReqVars,
+				MibIIsnmpCounters::get_counter(11)) { }
 };
 
 
-class AGENTPP_DECL snmpInTotalSetVars: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInTotalSetVars: public StatCounterMibLeaf {
 
 public:
-	snmpInTotalSetVars(): Counter32MibLeaf(oidSnmpInTotalSetVars) { }
+	snmpInTotalSetVars(): StatCounterMibLeaf(oidSnmpInTotalSetVars,
+				MibIIsnmpCounters::get_counter(12)) { }
 };
 
 
-class AGENTPP_DECL snmpInGetRequests: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInGetRequests: public StatCounterMibLeaf {
 
 public:
-	snmpInGetRequests(): Counter32MibLeaf(oidSnmpInGetRequests) { }
+	snmpInGetRequests(): StatCounterMibLeaf(oidSnmpInGetRequests,
+				MibIIsnmpCounters::get_counter(13)) { }
 };
 
 
-class AGENTPP_DECL snmpInGetNexts: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInGetNexts: public StatCounterMibLeaf {
 
 public:
-	snmpInGetNexts(): Counter32MibLeaf(oidSnmpInGetNexts) { }
+	snmpInGetNexts(): StatCounterMibLeaf(oidSnmpInGetNexts,
+				MibIIsnmpCounters::get_counter(14)) { }
 };
 
 
-class AGENTPP_DECL snmpInSetRequests: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInSetRequests: public StatCounterMibLeaf {
 
 public:
-	snmpInSetRequests(): Counter32MibLeaf(oidSnmpInSetRequests) { }
+	snmpInSetRequests(): StatCounterMibLeaf(oidSnmpInSetRequests,
+				MibIIsnmpCounters::get_counter(15)) { }
 };
 
 
-class AGENTPP_DECL snmpInGetResponses: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInGetResponses: public StatCounterMibLeaf {
 
 public:
-	snmpInGetResponses(): Counter32MibLeaf(oidSnmpInGetResponses) { }
+	snmpInGetResponses(): StatCounterMibLeaf(oidSnmpInGetResponses,
+				MibIIsnmpCounters::get_counter(16)) { }
 };
 
 
-class AGENTPP_DECL snmpInTraps: public Counter32MibLeaf {
+class AGENTPP_DECL snmpInTraps: public StatCounterMibLeaf {
 
 public:
-	snmpInTraps(): Counter32MibLeaf(oidSnmpInTraps) { }
+	snmpInTraps(): StatCounterMibLeaf(oidSnmpInTraps,
+				MibIIsnmpCounters::get_counter(17)) { }
 };
 
 
-class AGENTPP_DECL snmpOutTooBigs: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutTooBigs: public StatCounterMibLeaf {
 
 public:
-	snmpOutTooBigs(): Counter32MibLeaf(oidSnmpOutTooBigs) { }
+	snmpOutTooBigs(): StatCounterMibLeaf(oidSnmpOutTooBigs,
+				MibIIsnmpCounters::get_counter(18)) { }
 };
 
 
-class AGENTPP_DECL snmpOutNoSuchNames: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutNoSuchNames: public StatCounterMibLeaf {
 
 public:
-	snmpOutNoSuchNames(): Counter32MibLeaf(oidSnmpOutNoSuchNames) { }
+	snmpOutNoSuchNames(): StatCounterMibLeaf(oidSnmpOutNoSuchNames,
+				MibIIsnmpCounters::get_counter(19)) { }
 };
 
 
-class AGENTPP_DECL snmpOutBadValues: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutBadValues: public StatCounterMibLeaf {
 
 public:
-	snmpOutBadValues(): Counter32MibLeaf(oidSnmpOutBadValues) { }
+	snmpOutBadValues(): StatCounterMibLeaf(oidSnmpOutBadValues,
+				MibIIsnmpCounters::get_counter(20)) { }
 };
 
 
-class AGENTPP_DECL snmpOutGenErrs: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutGenErrs: public StatCounterMibLeaf {
 
 public:
-	snmpOutGenErrs(): Counter32MibLeaf(oidSnmpOutGenErrs) { }
+	snmpOutGenErrs(): StatCounterMibLeaf(oidSnmpOutGenErrs,
+				MibIIsnmpCounters::get_counter(21)) { }
 };
 
 
-class AGENTPP_DECL snmpOutGetRequests: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutGetRequests: public StatCounterMibLeaf {
 
 public:
-	snmpOutGetRequests(): Counter32MibLeaf(oidSnmpOutGetRequests) { }
+	snmpOutGetRequests(): StatCounterMibLeaf(oidSnmpOutGetRequests,
+				MibIIsnmpCounters::get_counter(22)) { }
 };
 
 
-class AGENTPP_DECL snmpOutGetNexts: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutGetNexts: public StatCounterMibLeaf {
 
 public:
-	snmpOutGetNexts(): Counter32MibLeaf(oidSnmpOutGetNexts) { }
+	snmpOutGetNexts(): StatCounterMibLeaf(oidSnmpOutGetNexts,
+				MibIIsnmpCounters::get_counter(23)) { }
 };
 
 
-class AGENTPP_DECL snmpOutSetRequests: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutSetRequests: public StatCounterMibLeaf {
 
 public:
-	snmpOutSetRequests(): Counter32MibLeaf(oidSnmpOutSetRequests) { }
+	snmpOutSetRequests(): StatCounterMibLeaf(oidSnmpOutSetRequests,
+				MibIIsnmpCounters::get_counter(24)) { }
 };
 
 
-class AGENTPP_DECL snmpOutGetResponses: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutGetResponses: public StatCounterMibLeaf {
 
 public:
-	snmpOutGetResponses(): Counter32MibLeaf(oidSnmpOutGetResponses) { }
+	snmpOutGetResponses(): StatCounterMibLeaf(oidSnmpOutGetResponses,
+				MibIIsnmpCounters::get_counter(25)) { }
 };
 
 
-class AGENTPP_DECL snmpOutTraps: public Counter32MibLeaf {
+class AGENTPP_DECL snmpOutTraps: public StatCounterMibLeaf {
 
 public:
-	snmpOutTraps(): Counter32MibLeaf(oidSnmpOutTraps) { }
+	snmpOutTraps(): StatCounterMibLeaf(oidSnmpOutTraps,
+				MibIIsnmpCounters::get_counter(26)) { }
 };
 
-class AGENTPP_DECL snmpSilentDrops: public Counter32MibLeaf {
+class AGENTPP_DECL snmpSilentDrops: public StatCounterMibLeaf {
 
 public:
-	snmpSilentDrops(): Counter32MibLeaf(oidSnmpSilentDrops) { }
+	snmpSilentDrops(): StatCounterMibLeaf(oidSnmpSilentDrops,
+				MibIIsnmpCounters::get_counter(27)) { }
 };
 
 
-class AGENTPP_DECL snmpProxyDrops: public Counter32MibLeaf {
+class AGENTPP_DECL snmpProxyDrops: public StatCounterMibLeaf {
 
 public:
-	snmpProxyDrops(): Counter32MibLeaf(oidSnmpProxyDrops) { }
+	snmpProxyDrops(): StatCounterMibLeaf(oidSnmpProxyDrops,
+				MibIIsnmpCounters::get_counter(28)) { }
 };
 
 
@@ -291,6 +291,32 @@ class AGENTPP_DECL snmpNotifyFilterEntry: public StorageTable {
 	 */
 	bool passes_filter(const Oidx&, const Oidx&, const Vbx*, unsigned int);
 
+	/**
+	 * Checks whether a filter applies to notifications sent with the
+	 * given parameters, i.e. whether passes_filter may return FALSE
+	 * for them.
+	 *
+	 * @param target
+	 *    an object identifier representing an index value of the
+	 *    snmpTargetParamsTable.
+	 * @return
+	 *    TRUE if a filter profile with active filter rows exists for
+	 *    target, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	bool has_filter(const Oidx&);
+
+	/**
+	 * Gets the snmpNotifyFilterProfileEntry that maps parameters to
+	 * filter profiles.
+	 *
+	 * @return
+	 *    a pointer to the profile table (may be 0).
+	 * @since 4.6.1
+	 */
+	snmpNotifyFilterProfileEntry* get_profile_entry()
+				{ return _snmpNotifyFilterProfileEntry; }
+
 protected:
         snmpNotifyFilterProfileEntry* _snmpNotifyFilterProfileEntry;
 };
@@ -31,6 +31,8 @@
 #include <snmp_pp/oid.h>
 #include <snmp_pp/snmpmsg.h>
 
+#include <utility>
+
 #ifndef WIN32
 #include <sys/types.h>
 #include <sys/time.h>
@@ -49,6 +51,180 @@ namespace Agentpp {
 #endif
 
 
+class Oidx;
+
+/*--------------------------- class OidxView -------------------------*/
+
+/**
+ * The OidxView class is a non-owning, read-only view on a sequence of
+ * subidentifiers, for example on an Oidx or a part of it. Creating,
+ * copying and cutting a view never copies any subidentifiers.
+ *
+ * A view is only valid as long as the object identifier it refers to
+ * is neither modified nor destroyed.
+ *
+ * @version 4.6.1
+ */
+class AGENTPP_DECL OidxView {
+public:
+	/**
+	 * Construct an empty view.
+	 */
+	OidxView() : ptr(0), length(0) { }
+
+	/**
+	 * Construct a view on an array of subidentifiers.
+	 *
+	 * @param data - An array of subidentifiers.
+	 * @param length - The length of the array.
+	 */
+	OidxView(const unsigned long* data, unsigned int length)
+	  : ptr(data), length(length) { }
+
+	/**
+	 * Construct a view on the whole value of an object identifier.
+	 *
+	 * @param oid - An object identifier.
+	 */
+	inline OidxView(const Oidx& oid);
+
+	/**
+	 * Return the number of subidentifiers of the view.
+	 */
+	unsigned int	len() const { return length; }
+
+	/**
+	 * Return a pointer to the first subidentifier of the view.
+	 */
+	const unsigned long* data() const { return ptr; }
+
+	/**
+	 * Return the subidentifier at the given position or 0 if the
+	 * position is out of range (like Oid does).
+	 */
+	unsigned long	operator[](unsigned int index) const
+	  { return (index < length) ? ptr[index] : 0; }
+
+	/**
+	 * Return the last subidentifier of the view.
+	 *
+	 * @return A subidentifier or 0 if the view is empty.
+	 */
+	unsigned long	last() const
+	  { return (length > 0) ? ptr[length-1] : 0; }
+
+	/**
+	 * Return a view without the n leftmost subidentifiers.
+	 *
+	 * @param n - The number of subidentifiers to cut off from left side.
+	 */
+	OidxView	cut_left(unsigned int n) const
+	{
+		if (n >= length) return OidxView();
+		return OidxView(ptr + n, length - n);
+	}
+
+	/**
+	 * Return a view without the n rightmost subidentifiers.
+	 *
+	 * @param n - The number of subidentifiers to cut off from right side.
+	 */
+	OidxView	cut_right(unsigned int n) const
+	{
+		if (n >= length) return OidxView();
+		return OidxView(ptr, length - n);
+	}
+
+	/**
+	 * Compare the receiver with another view lexicographically.
+	 *
+	 * @param other - Another view.
+	 * @return <0 if the receiver is less than other, 0 if both are
+	 *         equal, and >0 if the receiver is greater than other.
+	 */
+	int		compare(const OidxView& other) const
+	{
+		unsigned int l = (length < other.length) ? length : other.length;
+		for (unsigned int i=0; i<l; i++) {
+			if (ptr[i] != other.ptr[i])
+				return (ptr[i] < other.ptr[i]) ? -1 : 1;
+		}
+		if (length == other.length) return 0;
+		return (length < other.length) ? -1 : 1;
+	}
+
+	/**
+	 * Check if the receiver is in the subtree of a given view.
+	 *
+	 * @param o - Another view.
+	 * @return TRUE if the receiver is in the subtree of o,
+	 *         FALSE otherwise.
+	 */
+	bool		in_subtree_of(const OidxView& o) const
+	{
+		if (length <= o.length) return FALSE;
+		for (unsigned int i=0; i<o.length; i++)
+			if (ptr[i] != o.ptr[i]) return FALSE;
+		return TRUE;
+	}
+
+	/**
+	 * Check if the receiver is root of a given view.
+	 *
+	 * @param o - Another view.
+	 * @return TRUE if the receiver is root of o,
+	 *         FALSE otherwise.
+	 */
+	bool		is_root_of(const OidxView& o) const
+	{
+		return o.in_subtree_of(*this);
+	}
+
+	/**
+	 * Return the view as an OctetStr. Every subidentifier is
+	 * interpreted as one char (see Oidx::as_string).
+	 *
+	 * @param withoutLength
+	 *    if TRUE there will be no preceeding subid containing
+	 *    the length of the string
+	 * @return An OctetStr.
+	 */
+	NS_SNMP OctetStr	as_string(bool withoutLength = false) const
+	{
+		unsigned int i = 0;
+		// check if the len is implied and should be ignored!
+		if (withoutLength && length > 0 && length == ptr[0] + 1)
+		    i++;    // first oid seems to be the len
+		if (i >= length) return NS_SNMP OctetStr();
+		unsigned int n = length - i;
+		unsigned char local[64];
+		unsigned char* buf = (n <= sizeof(local)) ? local : new unsigned char[n];
+		for (unsigned int j = 0; j < n; j++)
+			buf[j] = (unsigned char)ptr[i + j];
+		NS_SNMP OctetStr str(buf, n);
+		if (buf != local) delete[] buf;
+		return str;
+	}
+
+private:
+	const unsigned long*	ptr;
+	unsigned int		length;
+};
+
+inline bool operator==(const OidxView& a, const OidxView& b)
+  { return (a.len() == b.len()) && (a.compare(b) == 0); }
+inline bool operator!=(const OidxView& a, const OidxView& b)
+  { return !(a == b); }
+inline bool operator<(const OidxView& a, const OidxView& b)
+  { return a.compare(b) < 0; }
+inline bool operator<=(const OidxView& a, const OidxView& b)
+  { return a.compare(b) <= 0; }
+inline bool operator>(const OidxView& a, const OidxView& b)
+  { return a.compare(b) > 0; }
+inline bool operator>=(const OidxView& a, const OidxView& b)
+  { return a.compare(b) >= 0; }
+
+
 /*--------------------------- class Oidx -----------------------------*/
 
 /**
@@ -89,6 +265,29 @@ public:
 	 */
 	Oidx(const Oid& oid) : Oid(oid) { }
 
+	/**
+	 * Copy constructor.
+	 *
+	 * @param oid - Another object identifier.
+	 */
+	Oidx(const Oidx& oid) : Oid(oid) { }
+
+	/**
+	 * Move constructor. The source object identifier is left empty.
+	 *
+	 * @param oid - Another object identifier.
+	 * @since 4.6.1
+	 */
+	Oidx(Oidx&& oid) : Oid(std::move(oid)) { }
+
+	/**
+	 * Construct an Object Identifier from (a copy of) a view.
+	 *
+	 * @param view - A view on another object identifier.
+	 * @since 4.6.1
+	 */
+	explicit Oidx(const OidxView& view) : Oid(view.data(), view.len()) { }
+
 	/**
 	 * Destructor
 	 */
@@ -200,14 +399,44 @@ public:
 	using NS_SNMP Oid::operator = ;
 	virtual Oidx&  	operator = (unsigned long l)
 	{
-		// delete the old value
-		if ( smival.value.oid.ptr ) {
-			delete [] smival.value.oid.ptr;
-			smival.value.oid.ptr = NULL;
+		set_data(&l, 1);
+		return *this;
+	}
+
+	Oidx&		operator = (const Oidx& oid)
+	{
+		Oid::operator=(oid);
+		return *this;
+	}
+
+	Oidx&		operator = (Oidx&& oid)
+	{
+		Oid::operator=(std::move(oid));
+		return *this;
+	}
+
+	/**
+	 * Assign the subidentifiers of a view. The view may refer to
+	 * the receiver itself, for example to cut off subidentifiers
+	 * in place.
+	 *
+	 * @param view - A view on an object identifier.
+	 * @since 4.6.1
+	 */
+	Oidx&		operator = (const OidxView& view)
+	{
+		if (view.len() == 0) {
+			clear();
+		}
+		else if ((view.data() >= smival.value.oid.ptr) &&
+			 (view.data() < smival.value.oid.ptr + smival.value.oid.len)) {
+			memmove(smival.value.oid.ptr, view.data(),
+				view.len()*sizeof(SmiUINT32));
+			smival.value.oid.len = view.len();
+			m_changed = true;
 		}
-		smival.value.oid.len = 1;
-		smival.value.oid.ptr = (SmiLPUINT32)new unsigned long[1];
-		smival.value.oid.ptr[0] = l;
+		else
+			set_data(view.data(), view.len());
 		return *this;
 	}
 
@@ -222,31 +451,50 @@ public:
 	/**
 	 * Check if the receiver is in the subtree of a given oid.
 	 *
-	 * @param o - An Oidx object identifier.
+	 * @param o - An Oidx object identifier or a view on it.
 	 * @return TRUE if the receiver is in the subtree of o,
 	 *         FALSE otherwise.
 	 */
 	bool		in_subtree_of(const Oidx& o) const
 	{
-		if (len() <= o.len()) return FALSE;
-		for (unsigned int i=0; i<o.len(); i++)
-			if ((*this)[i] != o[i]) return FALSE;
-		return TRUE;
+		return OidxView(*this).in_subtree_of(OidxView(o));
+	}
+
+	bool		in_subtree_of(const OidxView& o) const
+	{
+		return OidxView(*this).in_subtree_of(o);
 	}
 
 	/**
 	 * Check if the receiver is root of a given oid.
 	 *
-	 * @param o - An Oidx object identifier.
+	 * @param o - An Oidx object identifier or a view on it.
 	 * @return TRUE if the receiver is root of o,
 	 *         FALSE otherwise.
 	 */
 	bool		is_root_of(const Oidx& o) const
 	{
-		if (len() >= o.len()) return false;
-		for (unsigned int i=0; i<len(); i++)
-			if ((*this)[i] != o[i]) return false;
-		return true;
+		return OidxView(o).in_subtree_of(*this);
+	}
+
+	bool		is_root_of(const OidxView& o) const
+	{
+		return o.in_subtree_of(*this);
+	}
+
+	/**
+	 * Compare the receiver with another object identifier
+	 * lexicographically.
+	 *
+	 * @param other
+	 *    another object identifier (or a view on a part of it).
+	 * @return <0 if the receiver is less than other, 0 if both are
+	 *    equal, and >0 if the receiver is greater than other.
+	 * @since 4.6.1
+	 */
+	int		compare(const OidxView& other) const
+	{
+		return OidxView(*this).compare(other);
 	}
 
 	/**
@@ -388,6 +636,9 @@ public:
 	}
 };
 
+inline OidxView::OidxView(const Oidx& oid)
+  : ptr(const_cast<Oidx&>(oid).oidval()->ptr), length(oid.len()) { }
+
 
 /*--------------------------- class Vbx -----------------------------*/
 
@@ -679,6 +930,17 @@ public:
 	// const redefinitions of originals:
 	Pdux&   operator+=(const NS_SNMP Vb&);
 
+	/**
+	 * Make room for the given number of variable bindings, so that
+	 * appending variable bindings up to that number does not
+	 * reallocate the variable binding array.
+	 *
+	 * @param count
+	 *    the number of variable bindings to make room for.
+	 * @since 4.6.1
+	 */
+	void    reserve(int count);
+
 	/**
 	 * Clone the receiver.
 	 *
@@ -691,6 +953,9 @@ public:
 
 /*--------------------------- class Snmpx -----------------------------*/
 
+class SnmpxBatch;
+class SnmpxDecodeArena;
+
 /**
  * The Snmpx class is a sub class of Snmp that provides additional
  * methods for sending and receiving SNMP messages.
@@ -714,9 +979,16 @@ public:
 	 * @param bind_ipv6
 	 *    Set this to true if IPv6 should be used. The default is
 	 *    IPv4.
+	 * @param reuse_port
+	 *    Set this to true to bind with SO_REUSEPORT, so that
+	 *    several sessions (one per receiving thread) can listen
+	 *    on the same port (since 4.6.1).
 	 */
-	Snmpx (int &status, unsigned short port, const bool bind_ipv6 = false)
-		: Snmp(status, port, bind_ipv6) {};
+	Snmpx (int &status, unsigned short port, const bool bind_ipv6 = false,
+	       const bool reuse_port = false)
+		: Snmp(status, port, bind_ipv6, reuse_port),
+		  batchSize(1), batch(0),
+		  decodeArena(create_decode_arena()) {};
 
 #ifdef SNMP_PP_WITH_UDPADDR
 	/**
@@ -728,10 +1000,47 @@ public:
 	 *    hold the creation status.
 	 * @param address
 	 *    an UDP address to be used for the session
+	 * @param reuse_port
+	 *    Set this to true to bind with SO_REUSEPORT (since 4.6.1).
 	 */
-	Snmpx(int& status, const NS_SNMP UdpAddress& addr): Snmp(status, addr) { }
+	Snmpx(int& status, const NS_SNMP UdpAddress& addr,
+	      const bool reuse_port = false)
+		: Snmp(status, addr, reuse_port), batchSize(1), batch(0),
+		  decodeArena(create_decode_arena()) { }
 #endif
 
+	/**
+	 * Destructor.
+	 */
+	virtual ~Snmpx();
+
+	/**
+	 * Set the maximum number of datagrams received with a single
+	 * recvmmsg() system call and sent with a single sendmmsg()
+	 * system call. Received datagrams are queued and handed out
+	 * one by one by subsequent receive calls without polling the
+	 * socket again. Responses sent concurrently by several threads
+	 * are collected and flushed together by one of them.
+	 * A size of 1 (the default) disables batching. The size has
+	 * no effect on platforms without recvmmsg()/sendmmsg().
+	 * This method must be called before the session is used for
+	 * receiving or sending.
+	 *
+	 * @param size
+	 *    the maximum number of datagrams per system call.
+	 * @since 4.6.1
+	 */
+	void set_batch_size(int size);
+
+	/**
+	 * Get the maximum number of datagrams per system call.
+	 *
+	 * @return
+	 *    the batch size, 1 if batching is disabled.
+	 * @since 4.6.1
+	 */
+	int get_batch_size() const { return batchSize; }
+
 #ifdef _SNMPv3
 	/**
 	 * Receive a SNMP PDU
@@ -839,6 +1148,61 @@ public:
 protected:
 	unsigned long ProcessizedReqId(unsigned short);
 	unsigned long MyMakeReqId();
+
+	/**
+	 * Check whether a datagram received by an earlier batch
+	 * receive is still queued for the given socket.
+	 *
+	 * @param sock
+	 *    a session socket.
+	 * @return
+	 *    TRUE if receive_datagram will not block.
+	 * @since 4.6.1
+	 */
+	bool	has_pending_datagram(SnmpSocket sock);
+
+	/**
+	 * Receive the next datagram from the given socket, either
+	 * from the batch queue or directly from the socket.
+	 *
+	 * @param sock
+	 *    a session socket.
+	 * @param buf
+	 *    a buffer of MAX_SNMP_PACKET bytes.
+	 * @param from_addr
+	 *    returns the sender's address.
+	 * @param fromlen
+	 *    returns the length of from_addr.
+	 * @return
+	 *    the length of the datagram or a value less or equal
+	 *    zero on failure.
+	 * @since 4.6.1
+	 */
+	long	receive_datagram(SnmpSocket sock, unsigned char* buf,
+				 SocketAddrType& from_addr,
+				 SocketLengthType& fromlen);
+
+	/**
+	 * Send a datagram through the given socket, batching it with
+	 * datagrams sent concurrently by other threads if possible.
+	 *
+	 * @return
+	 *    0 on success, -1 on failure.
+	 * @since 4.6.1
+	 */
+	int	send_datagram(SnmpSocket sock, unsigned char* buf, size_t len,
+			      const NS_SNMP UdpAddress& address);
+
+	/**
+	 * Create the arena incoming messages are decoded in.
+	 *
+	 * @since 4.6.1
+	 */
+	static SnmpxDecodeArena* create_decode_arena();
+
+	int		batchSize;
+	SnmpxBatch*	batch;
+	SnmpxDecodeArena* decodeArena;
 };
 
 #ifdef AGENTPP_NAMESPACE
@@ -54,6 +54,7 @@ class AGENTPP_DECL InformInfo {
 
 class AGENTPP_DECL SnmpRequest {
     friend class SnmpRequestV3;
+    friend class SnmpSessionPool;
 public:
        static int process(int, const NS_SNMP UdpAddress&, Vbx*, int& sz, Vbx*, int&,
 			  const NS_SNMP OctetStr&, const int=0, const int=0);
@@ -75,12 +76,144 @@ public:
        static int set (const NS_SNMP UdpAddress&, Vbx*, int sz, int&, const NS_SNMP OctetStr&);
 
        static int trap(NS_SNMP SnmpTarget&, Vbx*, int sz, const Oidx&, const Oidx&);
-       static void inform(NS_SNMP CTarget&, Vbx*, int sz, const Oidx&);
+       static int inform(NS_SNMP CTarget&, Vbx*, int sz, const Oidx&);
 
  protected:
        static Snmpx *get_new_snmp(Snmpx* baseSnmp, int &status);
 };
 
+
+#if !defined (AGENTPP_DECL_TEMPL_LIST_SNMPX)
+#define AGENTPP_DECL_TEMPL_LIST_SNMPX
+	AGENTPP_DECL_TEMPL template class AGENTPP_DECL List<Snmpx>;
+#endif
+
+/**
+ * The SnmpSessionPool keeps the SNMP sessions (UDP sockets) used by
+ * SnmpRequest and SnmpRequestV3 to send requests and notifications
+ * open, instead of creating and binding a new socket for each message.
+ * A session is exclusively used by the thread that acquired it until it
+ * is released again.
+ *
+ * In addition, the pool owns a long-lived session with its own poll
+ * thread that sends INFORM requests asynchronously. Retries and
+ * timeouts of those informs are scheduled by the message queue of that
+ * session, so the sender of an inform does not wait for its
+ * acknowledgement.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL SnmpSessionPool: public ThreadManager {
+
+ public:
+	/**
+	 * Create a session pool.
+	 *
+	 * @param maxIdle
+	 *    the maximum number of idle sessions kept open. If 0, each
+	 *    released session is closed.
+	 */
+	SnmpSessionPool(int maxIdle = AGENTPP_SNMP_SESSION_POOL_SIZE);
+
+	/**
+	 * Destructor, closes all idle sessions and the inform session.
+	 */
+	virtual ~SnmpSessionPool();
+
+	/**
+	 * Get the process wide session pool used by SnmpRequest and
+	 * SnmpRequestV3.
+	 *
+	 * @return
+	 *    the SnmpSessionPool instance.
+	 */
+	static SnmpSessionPool* instance();
+
+	/**
+	 * Get an idle session or open a new one if there is none.
+	 * (SYNCHRONIZED)
+	 *
+	 * @param baseSnmp
+	 *    the Snmpx instance of the agent whose listen address determines
+	 *    the address (family) a new session is bound to. May be 0.
+	 * @param status
+	 *    returns SNMP_CLASS_SUCCESS or the error occurred while opening
+	 *    a new session.
+	 * @return
+	 *    a session that must be given back by release(..). If status is
+	 *    not SNMP_CLASS_SUCCESS, the returned session (if any) has to be
+	 *    deleted by the caller.
+	 */
+	Snmpx*	acquire(Snmpx* baseSnmp, int& status);
+
+	/**
+	 * Give back a session obtained by acquire(..). If there are already
+	 * enough idle sessions, the session is closed and deleted.
+	 * (SYNCHRONIZED)
+	 *
+	 * @param snmp
+	 *    a session returned by acquire(..).
+	 */
+	void	release(Snmpx* snmp);
+
+	/**
+	 * Send an INFORM request without waiting for its acknowledgement.
+	 * The retries and timeout of the target are used. If thread
+	 * support is disabled, the inform is sent synchronously.
+	 *
+	 * @param baseSnmp
+	 *    the Snmpx instance of the agent (see acquire).
+	 * @param pdu
+	 *    the inform PDU, it is copied.
+	 * @param target
+	 *    the target of the inform, it is copied.
+	 * @return
+	 *    SNMP_CLASS_SUCCESS if the inform has been sent,
+	 *    SNMP_CLASS_RESOURCE_UNAVAIL if the maximum number of
+	 *    unacknowledged informs has been reached, or any other
+	 *    SNMP++ error code.
+	 */
+	int	send_inform(Snmpx* baseSnmp, Pdux& pdu, NS_SNMP SnmpTarget& target);
+
+	/**
+	 * Get the number of informs sent by send_inform(..) that are
+	 * neither acknowledged nor timed out yet.
+	 * (SYNCHRONIZED)
+	 *
+	 * @return
+	 *    the number of outstanding informs.
+	 */
+	int	get_pending_informs();
+
+	/**
+	 * Set the maximum number of outstanding informs.
+	 *
+	 * @param max
+	 *    the upper limit, by default AGENTPP_MAX_PENDING_INFORMS.
+	 */
+	void	set_max_pending_informs(int max) { maxPendingInforms = max; }
+
+	/**
+	 * Close all idle sessions and the inform session. Outstanding informs
+	 * are cancelled. Sessions currently in use are not affected.
+	 * (SYNCHRONIZED)
+	 */
+	void	clear();
+
+ protected:
+	static void inform_callback(int, NS_SNMP Snmp*, NS_SNMP Pdu&,
+				    NS_SNMP SnmpTarget&, void*);
+
+	List<Snmpx>	idle;
+	Snmpx*		idleBase;
+	int		maxIdle;
+	Snmpx*		informSession;
+	int		pendingInforms;
+	int		maxPendingInforms;
+};
+
+
 #ifdef _SNMPv3
 
 /**
@@ -154,6 +287,26 @@ class AGENTPP_DECL SnmpRequestV3 {
 	 */
 	static int send(Mib* mib, NS_SNMP UTarget&, Pdux&);
 
+	/**
+	 * Static method to send a notification without waiting for an
+	 * acknowledgement. Informs are sent through
+	 * SnmpSessionPool::send_inform, all other PDUs are sent like by
+	 * send(..).
+	 *
+         * @param mib
+         *    reference to a Mib instance to get the source address from and
+         *    increment SNMP counters.
+	 * @param target
+	 *    a UTarget instance denoting the target address for the request.
+	 * @param pdu
+	 *    the Pdux instance to send.
+	 * @return
+	 *    SNMP_ERROR_SUCCESS if the notification has been sent or any
+	 *    other SNMP error code on failure.
+         * @since 4.6.1
+	 */
+	static int send_async(Mib* mib, NS_SNMP UTarget&, Pdux&);
+
 	/**
 	 * Method to send a SNMP request synchronously.
 	 *
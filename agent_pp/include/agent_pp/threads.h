@@ -35,6 +35,10 @@
 #include <time.h>
 #include <sys/types.h>
 
+#ifdef _THREADS
+#include <atomic>
+#endif
+
 #include <agent_pp/List.h>
 
 
@@ -363,6 +367,16 @@ public:
 	 */
 	static  void      sleep(long millis, int nanos);
 
+	/**
+	 * Get the number of processors available to the process.
+	 *
+	 * @return
+	 *    the number of online processors, or 4 if it cannot be
+	 *    determined.
+	 * @since 4.6.1
+	 */
+	static  int       available_processors();
+
 	/**
 	 * If this thread was constructed using a separate Runnable 
 	 * run object, then that Runnable object's run method is called; 
@@ -541,7 +555,7 @@ public:
 	 * @return
 	 *    the number of threads in the pool.
 	 */
-	unsigned int size() { return taskList.size(); }
+	virtual unsigned int size() { return taskList.size(); }
 
 	/**
 	 * Get the stack size.
@@ -562,7 +576,7 @@ public:
          * be destroyed. This call does not block. Use join() after this call
          * to wait for the threads to end.
          */
-        void terminate();
+        virtual void terminate();
         
         /**
          * Wait for all threads in the pool to join, starting from first to last 
@@ -704,6 +718,157 @@ public:
  };
 
 
+ /**
+  * The TaskQueue class implements a bounded, lock-free queue of tasks
+  * that can be used by any number of producer and consumer threads
+  * concurrently. Each slot carries a sequence number that tells
+  * producers and consumers whether the slot is free or filled, thus
+  * neither add nor remove ever blocks.
+  *
+  * @version 4.6.1
+  */
+ class AGENTPP_DECL TaskQueue {
+ public:
+	/**
+	 * Create a queue.
+	 *
+	 * @param capacity
+	 *    the maximum number of tasks, rounded up to a power of 2.
+	 */
+	TaskQueue(unsigned int capacity = 1024);
+	~TaskQueue();
+
+	/**
+	 * Add a task at the end of the queue.
+	 *
+	 * @return
+	 *    FALSE if the queue is full.
+	 */
+	bool		add(Runnable*);
+
+	/**
+	 * Remove the first task from the queue.
+	 *
+	 * @return
+	 *    a task or 0 if the queue is empty.
+	 */
+	Runnable*	remove();
+
+	/**
+	 * Get the (approximate) number of queued tasks.
+	 */
+	unsigned int	size() const;
+
+ private:
+	struct Slot {
+		std::atomic<unsigned long>	sequence;
+		Runnable*			task;
+	};
+	Slot*				slots;
+	unsigned long			mask;
+	std::atomic<unsigned long>	head;
+	std::atomic<unsigned long>	tail;
+
+	TaskQueue(const TaskQueue&);
+	TaskQueue& operator=(const TaskQueue&);
+ };
+
+ class WorkStealingWorker;
+
+ /**
+  * The WorkStealingThreadPool class provides a pool of threads where
+  * each thread owns a deque of tasks. Tasks submitted by other threads
+  * are added to a shared lock-free TaskQueue; tasks submitted by a pool
+  * thread itself are pushed onto its own deque. An idle pool thread
+  * takes tasks from its own deque, then from the shared queue, and then
+  * steals from the deques of the other pool threads. Only threads that
+  * found no task at all sleep until new tasks arrive.
+  *
+  * Like QueuedThreadPool, the execute method never blocks. If the
+  * shared queue is full, tasks are kept in an overflow list.
+  *
+  * Use Mib::set_thread_pool to process requests with this pool.
+  *
+  * @version 4.6.1
+  */
+ class AGENTPP_DECL WorkStealingThreadPool : public ThreadPool {
+	friend class WorkStealingWorker;
+ public:
+	/**
+	 * Create a WorkStealingThreadPool.
+	 *
+	 * @param size
+	 *    the number of threads started for performing tasks. If
+	 *    size is less than 1, one thread per available processor
+	 *    is started.
+	 * @param queueSize
+	 *    the capacity of the shared task queue.
+	 * @param stackSize
+	 *    the stack size for each thread.
+	 */
+	WorkStealingThreadPool(int size = 0, int queueSize = 1024,
+			       int stackSize = AGENTPP_DEFAULT_STACKSIZE);
+
+	/**
+	 * Destructor will wait for termination of all threads. Tasks
+	 * that have not been started are deleted without being run.
+	 */
+	virtual ~WorkStealingThreadPool();
+
+	/**
+	 * Execute a task. The task will be deleted after call of
+	 * its run() method. This method does not block.
+	 */
+	virtual void	execute(Runnable*);
+
+	virtual bool	is_idle();
+	virtual bool	is_busy();
+	virtual unsigned int size() { return workerCount; }
+	virtual void	idle_notification() { }
+	virtual void	terminate();
+	virtual void	join();
+
+	/**
+	 * Get the (approximate) number of tasks waiting for execution.
+	 */
+	unsigned int	queue_length();
+
+	/**
+	 * Get the number of tasks a pool thread has taken from the
+	 * deque of another pool thread.
+	 */
+	unsigned long	get_steal_count() const { return steals; }
+
+	/**
+	 * Get the number of tasks that did not fit into the shared
+	 * queue and have been added to the overflow list.
+	 */
+	unsigned long	get_overflow_count() const { return overflows; }
+
+	/**
+	 * Get the number of executed tasks.
+	 */
+	unsigned long	get_executed_count() const { return executed; }
+
+ protected:
+	Runnable*	next_task(WorkStealingWorker*);
+	bool		has_task();
+	void		park();
+
+	WorkStealingWorker**		workers;
+	int				workerCount;
+	TaskQueue			shared;
+	List<Runnable>			overflow;
+	std::atomic<unsigned int>	overflowSize;
+	std::atomic<int>		sleeping;
+	std::atomic<int>		active;
+	std::atomic<unsigned long>	steals;
+	std::atomic<unsigned long>	overflows;
+	std::atomic<unsigned long>	executed;
+	std::atomic<bool>		go;
+ };
+
+
  /**
   * The TaskManager class controls the execution of tasks on
   * a Thread of a ThreadPool.
@@ -812,6 +977,89 @@ public:
 	MibMethodCall* task;
  };
 
+ /**
+  * The TicketLock class implements a lock that is not owned by the
+  * thread that acquired it. Thus, it may be released by any thread.
+  * Waiting threads are served in FIFO order: on release, the lock is
+  * handed off to the thread that has been waiting longest. The
+  * underlying mutex is held only while the lock state is changed.
+  *
+  * @version 4.6.1
+  * @since 4.6.1
+  */
+ class AGENTPP_DECL TicketLock: public Synchronized {
+ public:
+	TicketLock(): nextTicket(0), nowServing(0) { }
+
+	/**
+	 * Acquire the lock. Blocks until all threads that requested
+	 * the lock before have released it.
+	 */
+	void		acquire();
+
+	/**
+	 * Acquire the lock only if it is free and nobody is waiting for it.
+	 *
+	 * @return
+	 *    LOCKED if the lock has been acquired, BUSY otherwise.
+	 */
+	TryLockResult	try_acquire();
+
+	/**
+	 * Release the lock and hand it off to the next waiting thread
+	 * (if any). May be called from any thread.
+	 */
+	void		release();
+
+	/**
+	 * Check whether the lock is held (by any thread).
+	 */
+	bool		is_held();
+
+ protected:
+	unsigned long	nextTicket;
+	unsigned long	nowServing;
+ };
+
+ /**
+  * The ReadWriteLock class implements a lock that can be held by
+  * any number of readers or by a single writer. Writers are preferred:
+  * once a writer waits for the lock, new readers are blocked until
+  * the writer has released it. Neither side is reentrant.
+  *
+  * @version 4.6.1
+  * @since 4.6.1
+  */
+ class AGENTPP_DECL ReadWriteLock: public Synchronized {
+ public:
+	ReadWriteLock(): readers(0), waitingWriters(0), writer(FALSE) { }
+
+	/**
+	 * Acquire the shared (read) side of the lock.
+	 */
+	void		read_lock();
+
+	/**
+	 * Release the shared (read) side of the lock.
+	 */
+	void		read_unlock();
+
+	/**
+	 * Acquire the exclusive (write) side of the lock.
+	 */
+	void		write_lock();
+
+	/**
+	 * Release the exclusive (write) side of the lock.
+	 */
+	void		write_unlock();
+
+ protected:
+	int		readers;
+	int		waitingWriters;
+	bool		writer;
+ };
+
 #ifdef NO_FAST_MUTEXES 
 
  /**
@@ -62,6 +62,76 @@ class AGENTPP_DECL AgentTools {
          * @since 4.3.0
          */
         static bool             make_path(std::string);
+
+	/**
+	 * Flush the buffers of a file opened for writing and force its
+	 * content to stable storage.
+	 *
+	 * @param file
+	 *    a file opened for writing.
+	 * @return
+	 *    TRUE if the file content has been written, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	static bool		sync_file(FILE*);
+
+	/**
+	 * Replace a file by another one, for example by a temporary file
+	 * that has been completely written. On POSIX systems the file is
+	 * replaced atomically and the directory entry is synced, so that
+	 * after a crash either the old or the new file is found.
+	 *
+	 * @param from
+	 *    the name of the file that replaces the other one.
+	 * @param to
+	 *    the name of the file to be replaced.
+	 * @return
+	 *    TRUE if the file has been replaced, FALSE otherwise.
+	 * @since 4.6.1
+	 */
+	static bool		replace_file(const char*, const char*);
+
+	/**
+	 * Compute the CRC-32 (ISO 3309) checksum of a buffer.
+	 *
+	 * @param data
+	 *    a pointer to the data.
+	 * @param length
+	 *    the number of bytes of data.
+	 * @param crc
+	 *    the checksum of preceding data to continue, or 0.
+	 * @return
+	 *    the checksum.
+	 * @since 4.6.1
+	 */
+	static unsigned long	crc32(const unsigned char*, size_t,
+				      unsigned long crc = 0);
+
+	/**
+	 * Map a file read-only into memory. Where memory mapping is not
+	 * available, the file is read into a buffer instead.
+	 *
+	 * @param fname
+	 *    a file name.
+	 * @param size
+	 *    returns the size of the file.
+	 * @return
+	 *    a pointer to the file content, which has to be released by
+	 *    unmap_file, or 0 if the file could not be read or is empty.
+	 * @since 4.6.1
+	 */
+	static const char*	map_file(const char*, long&);
+
+	/**
+	 * Release a file content returned by map_file.
+	 *
+	 * @param data
+	 *    a pointer returned by map_file.
+	 * @param size
+	 *    the size returned by map_file.
+	 * @since 4.6.1
+	 */
+	static void		unmap_file(const char*, long);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
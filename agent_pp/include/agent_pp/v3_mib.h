@@ -100,6 +100,21 @@ class AGENTPP_DECL UsmUserTableStatus: public snmpRowStatus
   NS_SNMP USM *usm;
 };
 
+/**
+ * A user with passwords for UsmUserTable::addNewRows().
+ *
+ * @version 4.6.1
+ */
+struct AGENTPP_DECL UsmUserPasswords
+{
+  NS_SNMP OctetStr userName;
+  NS_SNMP OctetStr securityName;
+  int authProtocol;
+  int privProtocol;
+  NS_SNMP OctetStr authPassword;
+  NS_SNMP OctetStr privPassword;
+};
+
 /**
  * This class implements the USMUserTable as specified in RFC 3414.
  *
@@ -241,6 +256,40 @@ class AGENTPP_DECL UsmUserTable: public StorageTable
       { return addNewRow(userName, userName, authProtocol, privProtocol,
 			 authPassword, privPassword, engineID, addPassWordsToUSM); };
 
+  /**
+   * Add many users to the table and to USM.
+   *
+   * Works like calling addNewRow() with passwords for each user, but
+   * the localized keys of all users are computed in parallel, using
+   * one thread per available processor, before the rows are added.
+   * Enable the key cache of the AuthPriv object of USM
+   * (AuthPriv::enable_key_cache()) to reuse the keys after a restart.
+   *
+   * @param users
+   *    an array of users.
+   * @param count
+   *    the number of users in the array.
+   * @param engineID
+   *    the engine ID to localize the keys with.
+   * @param addPassWordsToUSM
+   *    if true, the passwords are passed to USM for engine ID discovery.
+   * @return
+   *    the number of users added.
+   * @since 4.6.1
+   */
+  int addNewRows(const UsmUserPasswords* users, int count,
+		 const NS_SNMP OctetStr& engineID,
+		 const bool addPassWordsToUSM = false);
+
+  /**
+   * Add many users to the table and to USM using the local engine ID,
+   * the passwords are added to USM.
+   *
+   * @see addNewRows(const UsmUserPasswords*, int, const OctetStr&, bool)
+   * @since 4.6.1
+   */
+  int addNewRows(const UsmUserPasswords* users, int count);
+
   /**
    * Delete a row from the table and from USM.
    *
@@ -124,6 +124,11 @@ static const char * vacmErrs[] = {
 #define view_included   1
 #define view_excluded   2
 
+// maximum number of view name resolutions cached by Vacm
+#ifndef VACM_VIEW_CACHE_SIZE
+#define VACM_VIEW_CACHE_SIZE 1024
+#endif
+
 
 class SnmpUnknownContexts;
 class SnmpUnavailableContexts;
@@ -131,9 +136,43 @@ class VacmContextTable;
 class VacmSecurityToGroupTable;
 class VacmAccessTable;
 class VacmViewTreeFamilyTable;
+class VacmViewCache;
+class VacmViewTree;
 class Mib;
 class Oidx;
 
+/**
+ * The VacmTableVersion class counts the changes of a VACM table, so
+ * that views and access decisions derived from the table's rows can
+ * be validated cheaply.
+ *
+ * @version 4.6.1
+ * @since 4.6.1
+ */
+class AGENTPP_DECL VacmTableVersion
+{
+public:
+  VacmTableVersion(): version(0) { }
+
+  /**
+   * Get the number of changes made to the table so far.
+   */
+  unsigned long get_version() const { return version; }
+
+protected:
+  /**
+   * Signal that the content of the table has changed.
+   */
+  void changed() { version++; }
+
+private:
+#ifdef _THREADS
+  std::atomic<unsigned long> version;
+#else
+  unsigned long version;
+#endif
+};
+
 
 class AGENTPP_DECL Vacm
 {
@@ -328,7 +367,22 @@ public:
   void clear();
 
  protected:
+  /**
+   * Resolve the view name for the given parameters like getViewName,
+   * but look up the result in a cache first. The cache is flushed
+   * whenever the context, security to group, or access table changes.
+   *
+   * @return VACM_viewFound on success, error codes on failure
+   * @since 4.6.1
+   */
+  int resolveViewName(const int securityModel,
+                      const NS_SNMP OctetStr &securityName,
+                      const int securityLevel, const int viewType,
+                      const NS_SNMP OctetStr &context,
+                      NS_SNMP OctetStr &viewName);
+
   ClassPointers vcp;
+  VacmViewCache* viewCache;
 };
 
 
@@ -353,13 +407,15 @@ public:
  VacmContextTable
 
  ********************************************************************/
-class AGENTPP_DECL VacmContextTable: public MibTable
+class AGENTPP_DECL VacmContextTable: public MibTable, public VacmTableVersion
 {
 
 public:
     VacmContextTable();
     ~VacmContextTable();
 
+    virtual void row_added(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_delete(MibTableRow*, const Oidx&, MibTable*);
     bool isContextSupported(const NS_SNMP OctetStr& context);
     bool addNewRow(const NS_SNMP OctetStr& context);
     void deleteRow(const NS_SNMP OctetStr& context);
@@ -367,7 +423,7 @@ public:
     /**
      * Resets the table to the state as if it was just created.
      */
-    virtual void clear() { MibTable::clear(); add_row("0"); }
+    virtual void clear() { MibTable::clear(); add_row("0"); changed(); }
 };
 
 /*********************************************************************
@@ -375,7 +431,8 @@ public:
  VacmSecurityToGroupTable
 
  ********************************************************************/
-class AGENTPP_DECL VacmSecurityToGroupTable: public StorageTable
+class AGENTPP_DECL VacmSecurityToGroupTable: public StorageTable,
+                                             public VacmTableVersion
 {
 
 public:
@@ -385,6 +442,12 @@ public:
     virtual bool ready_for_service(Vbx*, int);
     virtual bool could_ever_be_managed(const Oidx&, int&);
     virtual void row_added(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_delete(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_activated(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_deactivated(MibTableRow*, const Oidx&, MibTable*);
+    virtual int commit_set_request(Request*, int);
+    virtual void clear()    {   StorageTable::clear(); changed(); }
+    virtual void reset()    {   StorageTable::reset(); changed(); }
     bool getGroupName(const int& securiyModel,
                          const NS_SNMP OctetStr& securityName,
                          NS_SNMP OctetStr& groupName);
@@ -401,7 +464,8 @@ public:
  VacmAccessTable
 
  ********************************************************************/
-class AGENTPP_DECL VacmAccessTable: public StorageTable
+class AGENTPP_DECL VacmAccessTable: public StorageTable,
+                                    public VacmTableVersion
 {
 
 public:
@@ -411,6 +475,12 @@ public:
     virtual bool ready_for_service(Vbx*, int);
     virtual bool could_ever_be_managed(const Oidx&, int&);
     virtual void row_added(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_delete(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_activated(MibTableRow*, const Oidx&, MibTable*);
+    virtual void row_deactivated(MibTableRow*, const Oidx&, MibTable*);
+    virtual int commit_set_request(Request*, int);
+    virtual void clear()    {   StorageTable::clear(); changed(); }
+    virtual void reset()    {   StorageTable::reset(); changed(); }
     bool getViewName(const NS_SNMP OctetStr& group,
                         const NS_SNMP OctetStr& context,
                         const int securityModel,
@@ -448,8 +518,9 @@ class AGENTPP_DECL ViewNameIndex
 {
 
 public:
-    ViewNameIndex(const NS_SNMP OctetStr& vname): name(vname) {}
-    ~ViewNameIndex() { /* avoid deletion of original rows: */views.clear();}
+    ViewNameIndex(const NS_SNMP OctetStr& vname): name(vname), tree(0),
+	treeVersion(0) {}
+    ~ViewNameIndex();
 
     void add(MibTableRow* row)    {   views.add(row);}
     void remove(MibTableRow* row)    {   views.remove(row);}
@@ -457,6 +528,14 @@ public:
 
     NS_SNMP OctetStr name;
     List<MibTableRow> views;
+
+    /**
+     * The view families compiled into a subtree trie, built on demand
+     * by VacmViewTreeFamilyTable::isInMibView, and the version of the
+     * table it has been built from (since 4.6.1).
+     */
+    VacmViewTree* tree;
+    unsigned long treeVersion;
 };
 
 /*********************************************************************
@@ -469,7 +548,8 @@ public:
 AGENTPP_DECL_TEMPL template class AGENTPP_DECL List<ViewNameIndex>;
 #endif
 
-class AGENTPP_DECL VacmViewTreeFamilyTable: public StorageTable
+class AGENTPP_DECL VacmViewTreeFamilyTable: public StorageTable,
+                                            public VacmTableVersion
 {
     friend class VacmViewTreeFamilyTableStatus;
 public:
@@ -483,6 +563,7 @@ public:
     virtual void row_deactivated(MibTableRow*, const Oidx&, MibTable*);
     virtual void row_delete(MibTableRow*, const Oidx&, MibTable*);
     virtual void row_init(MibTableRow*, const Oidx&, MibTable* t=0);
+    virtual int commit_set_request(Request*, int);
     int isInMibView(const NS_SNMP OctetStr&, const Oidx&);
     bool addNewRow(const NS_SNMP OctetStr& viewName, const Oidx& subtree,
                       const NS_SNMP OctetStr& mask, const int type,
@@ -496,7 +577,47 @@ protected:
     ViewNameIndex* viewsOf(const NS_SNMP OctetStr& viewName);
     void buildViewNameIndex();
 
+    /**
+     * Add a row to the index of its view, creating the view if needed.
+     *
+     * @param viewName
+     *    the name of the view the row belongs to.
+     * @param row
+     *    a row of this table.
+     * @return
+     *    TRUE if the view has been created, FALSE if it already existed.
+     * @since 4.6.1
+     */
+    bool addToView(const NS_SNMP OctetStr& viewName, MibTableRow* row);
+
+    /**
+     * Remove a row from the index of its view.
+     *
+     * @param viewName
+     *    the name of the view the row belongs to.
+     * @param row
+     *    a row of this table.
+     * @param removeEmpty
+     *    if TRUE, the view is removed when its last row is removed.
+     * @return
+     *    FALSE if there is no view with the given name.
+     * @since 4.6.1
+     */
+    bool removeFromView(const NS_SNMP OctetStr& viewName, MibTableRow* row,
+			bool removeEmpty);
+
+    /**
+     * Compile the rows of a view into its subtree trie.
+     *
+     * @since 4.6.1
+     */
+    void compileView(ViewNameIndex* views);
+
     List<ViewNameIndex> viewNameIndex;
+#ifdef _THREADS
+    // guards viewNameIndex, the rows of each view and the compiled trees
+    ReadWriteLock treeLock;
+#endif
 };
 
 class AGENTPP_DECL VacmViewTreeFamilyTableStatus: public snmpRowStatus
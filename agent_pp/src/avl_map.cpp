@@ -131,13 +131,18 @@ OidxPtrEntryPtrAVLNode* OidxPtrEntryPtrAVLMap::pred(OidxPtrEntryPtrAVLNode* t) c
 
 
 Pix OidxPtrEntryPtrAVLMap::seek(OidxPtr  key) const
+{
+  return seek(OidxView(*key));
+}
+
+Pix OidxPtrEntryPtrAVLMap::seek(const OidxView& key) const
 {
   OidxPtrEntryPtrAVLNode* t = root;
   if (t == 0)
     return 0;
   for (;;)
   {
-    int cmp = OidxPtrCMP(key, t->item);
+    int cmp = key.compare(*t->item);
     if (cmp == 0)
       return Pix(t);
     else if (cmp < 0)
@@ -155,13 +160,18 @@ Pix OidxPtrEntryPtrAVLMap::seek(OidxPtr  key) const
 }
 
 Pix OidxPtrEntryPtrAVLMap::seek_inexact(OidxPtr  key) const
+{
+  return seek_inexact(OidxView(*key));
+}
+
+Pix OidxPtrEntryPtrAVLMap::seek_inexact(const OidxView& key) const
 {
   OidxPtrEntryPtrAVLNode* t = root;
   if (t == 0)
     return 0;
   for (;;)
   {
-    int cmp = OidxPtrCMP(key, t->item);
+    int cmp = key.compare(*t->item);
     if (cmp == 0)
       return Pix(t);
     else if (cmp < 0)
@@ -29,6 +29,7 @@
 #include <agent_pp/snmp_counters.h>
 #include <agent_pp/snmp_group.h>
 #include <agent_pp/notification_originator.h>
+#include <agent_pp/snmp_request.h>
 #include <agent_pp/vacm.h>
 #include <snmp_pp/log.h>
 
@@ -1167,6 +1168,8 @@ MibTable::MibTable(const MibTable& other): MibEntry(other.oid, other.access)
 	       sizeof(index_info)*other.index_len);
 	row_status		   = other.row_status;
 	row_timeout		   = other.row_timeout;
+	trackChanges		   = FALSE;
+	changeCount		   = 0;
 }
 
 /**
@@ -1269,6 +1272,8 @@ void MibTable::init(const Oidx& o, const index_info* istruc,
 {
 	generator.set_base(o);
 	row_status = 0;
+	trackChanges = FALSE;
+	changeCount = 0;
 	row_timeout.set_life(DEFAULT_ROW_CREATION_TIMEOUT);
 	index_len = ilen;
 	index_struc = new index_info[ilen];
@@ -1298,6 +1303,13 @@ int MibTable::size()
 
 void MibTable::clear()
 {
+	changeCount++;
+	if (trackChanges) {
+		OidListCursor<MibTableRow> cur;
+		for (cur.init(&content); cur.get(); cur.next()) {
+			add_change(cur.get()->get_index());
+		}
+	}
 	content.clearAll();
 }
 
@@ -1306,42 +1318,66 @@ MibTableRow* MibTable::get_columns()
 	return &generator;
 }
 
+/**
+ * Encode the values of a row as a sequence of variable bindings.
+ */
+static int row_to_asn1(MibTableRow* row, unsigned char*& b, int& buflen)
+{
+	int vbsz = row->size();
+	Vbx* vbs = new Vbx[vbsz];
+	row->get_vblist(vbs, vbsz);
+
+	int status = Vbx::to_asn1(vbs, vbsz, b, buflen);
+	delete[] vbs;
+	return status;
+}
+
 bool MibTable::serialize(char*& buf, int& sz)
 {
-	OctetStr stream; // reserve two bytes for the sequence header
+	// encode the rows first and copy them once, appending each
+	// row to a growing stream would copy the table once per row
+	int n = content.size();
+	unsigned char** parts = new unsigned char*[n > 0 ? n : 1];
+	int* lengths = new int[n > 0 ? n : 1];
+	int count = 0;
+	int size = 0;
+	bool ok = TRUE;
 	OidListCursor<MibTableRow> cur;
 	for (cur.init(&content); cur.get(); cur.next()) {
 		// check if row should be made persistent
 		if (!is_persistent(cur.get())) continue;
 
-		int vbsz = cur.get()->size();
-		Vbx* vbs = new Vbx[vbsz];
-		cur.get()->get_vblist(vbs, vbsz);
-
-		// set volatile values to Null
-
 		unsigned char* b = 0;
 		int buflen = 0;
-		int status = Vbx::to_asn1(vbs, vbsz, b, buflen);
-		delete[] vbs;
+		int status = row_to_asn1(cur.get(), b, buflen);
 		if (b) {
-			OctetStr add(b, buflen);
-			delete[] b;
-			stream += add;
+			parts[count] = b;
+			lengths[count++] = buflen;
+			size += buflen;
 		}
-		if (status != SNMP_CLASS_SUCCESS) return FALSE;
-	}
-	int size = stream.len();
-	buf = new char[size+10];
-	int len = size+10;
-	unsigned char* cp =
-	  asn_build_header((unsigned char*)buf,
-			   &len,
-			   (unsigned char)(ASN_SEQUENCE | ASN_CONSTRUCTOR),
-			   size);
-	memcpy(cp, stream.data(), size);
-	sz = ((size+10)-len)+stream.len();
-	return TRUE;
+		if (status != SNMP_CLASS_SUCCESS) {
+			ok = FALSE;
+			break;
+		}
+	}
+	if (ok) {
+		buf = new char[size+10];
+		int len = size+10;
+		unsigned char* cp =
+		  asn_build_header((unsigned char*)buf,
+				   &len,
+				   (unsigned char)(ASN_SEQUENCE|ASN_CONSTRUCTOR),
+				   size);
+		for (int i=0; i<count; i++) {
+			memcpy(cp, parts[i], lengths[i]);
+			cp += lengths[i];
+		}
+		sz = ((size+10)-len)+size;
+	}
+	for (int i=0; i<count; i++) delete[] parts[i];
+	delete[] parts;
+	delete[] lengths;
+	return ok;
 }
 
 
@@ -1418,6 +1454,267 @@ bool MibTable::deserialize(char* buf, int& sz)
 	return TRUE;
 }
 
+// number of 32-bit words needed for n bytes of image data
+#define IMAGE_WORDS(n)	(((n)+3)/4)
+
+/**
+ * Return a pointer to the next n words of an image buffer and enlarge
+ * the buffer if necessary.
+ */
+static unsigned int* image_reserve(char*& buf, int& capacity, int& used,
+				   int n)
+{
+	int needed = used + 4*n;
+	if (needed > capacity) {
+		int c = (capacity > 0) ? capacity*2 : 4096;
+		while (c < needed) c *= 2;
+		char* b = new char[c];
+		if (buf) {
+			memcpy(b, buf, used);
+			delete[] buf;
+		}
+		buf = b;
+		capacity = c;
+	}
+	unsigned int* wp = (unsigned int*)(buf+used);
+	used = needed;
+	return wp;
+}
+
+/**
+ * Append the syntax, length, and data of a value to an image buffer.
+ * Values that cannot be mapped are stored as Null.
+ */
+static void image_put_value(char*& buf, int& capacity, int& used,
+			    const Vbx& vb)
+{
+	const SnmpSyntax* v = vb.get_value_ptr();
+	SmiUINT32 syntax = (v) ? v->get_syntax() : sNMP_SYNTAX_NULL;
+	unsigned int* wp;
+	switch (syntax) {
+	case sNMP_SYNTAX_INT:
+		wp = image_reserve(buf, capacity, used, 3);
+		wp[1] = 4;
+		wp[2] = (unsigned int)(long)*(const SnmpInt32*)v;
+		break;
+	case sNMP_SYNTAX_CNTR32:
+	case sNMP_SYNTAX_GAUGE32:
+	case sNMP_SYNTAX_TIMETICKS:
+		wp = image_reserve(buf, capacity, used, 3);
+		wp[1] = 4;
+		wp[2] = (unsigned int)(unsigned long)*(const SnmpUInt32*)v;
+		break;
+	case sNMP_SYNTAX_CNTR64:
+		wp = image_reserve(buf, capacity, used, 4);
+		wp[1] = 8;
+		wp[2] = (unsigned int)((const Counter64*)v)->high();
+		wp[3] = (unsigned int)((const Counter64*)v)->low();
+		break;
+	case sNMP_SYNTAX_OCTETS:
+	case sNMP_SYNTAX_OPAQUE:
+	case sNMP_SYNTAX_IPADDR: {
+		OctetStr os;
+		vb.get_value(os);
+		int n = IMAGE_WORDS(os.len());
+		wp = image_reserve(buf, capacity, used, 2+n);
+		if (n > 0) wp[1+n] = 0;
+		memcpy(wp+2, os.data(), os.len());
+		wp[1] = os.len();
+		break;
+	}
+	case sNMP_SYNTAX_OID: {
+		const Oid* o = (const Oid*)v;
+		wp = image_reserve(buf, capacity, used, 2+o->len());
+		for (unsigned int i=0; i<o->len(); i++)
+			wp[2+i] = (unsigned int)(*o)[i];
+		wp[1] = 4*o->len();
+		break;
+	}
+	default:
+		syntax = sNMP_SYNTAX_NULL;
+		wp = image_reserve(buf, capacity, used, 2);
+		wp[1] = 0;
+	}
+	wp[0] = (unsigned int)syntax;
+}
+
+/**
+ * Create a value from its image data or return 0 if the value is Null
+ * or cannot be read.
+ */
+static SnmpSyntax* image_get_value(unsigned int syntax,
+				   const unsigned int* wp, unsigned int len)
+{
+	switch (syntax) {
+	case sNMP_SYNTAX_INT:
+		if (len != 4) return 0;
+		return new SnmpInt32((long)(int)wp[0]);
+	case sNMP_SYNTAX_CNTR32:
+		if (len != 4) return 0;
+		return new Counter32(wp[0]);
+	case sNMP_SYNTAX_GAUGE32:
+		if (len != 4) return 0;
+		return new Gauge32(wp[0]);
+	case sNMP_SYNTAX_TIMETICKS:
+		if (len != 4) return 0;
+		return new TimeTicks(wp[0]);
+	case sNMP_SYNTAX_CNTR64:
+		if (len != 8) return 0;
+		return new Counter64(wp[0], wp[1]);
+	case sNMP_SYNTAX_OCTETS:
+		return new OctetStr((const unsigned char*)wp, len);
+	case sNMP_SYNTAX_OPAQUE:
+		return new OpaqueStr((const unsigned char*)wp, len);
+	case sNMP_SYNTAX_IPADDR: {
+		const unsigned char* b = (const unsigned char*)wp;
+		char buffer[42];
+		if (len == 16)
+			sprintf(buffer, "%02x%02x:%02x%02x:%02x%02x:%02x%02x:"
+				"%02x%02x:%02x%02x:%02x%02x:%02x%02x",
+				b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+				b[8], b[9], b[10], b[11], b[12], b[13], b[14],
+				b[15]);
+		else if (len == 4)
+			sprintf(buffer, "%d.%d.%d.%d", b[0], b[1], b[2], b[3]);
+		else return 0;
+		return new IpAddress(buffer);
+	}
+	case sNMP_SYNTAX_OID: {
+		unsigned long subids[MAX_OID_LEN];
+		unsigned int n = len/4;
+		if ((len % 4) || (n > MAX_OID_LEN)) return 0;
+		for (unsigned int i=0; i<n; i++) subids[i] = wp[i];
+		return new Oid(subids, n);
+	}
+	}
+	return 0;
+}
+
+bool MibTable::serialize_image(char*& buf, int& sz)
+{
+	int capacity = 0;
+	int used = 0;
+	buf = 0;
+	int columns = generator.size();
+	Vbx* vbs = new Vbx[columns > 0 ? columns : 1];
+	image_reserve(buf, capacity, used, 2);
+	unsigned int rows = 0;
+	OidListCursor<MibTableRow> cur;
+	for (cur.init(&content); cur.get(); cur.next()) {
+		// check if row should be made persistent
+		if (!is_persistent(cur.get())) continue;
+
+		const Oidx& ind = cur.get()->get_index();
+		unsigned int* wp = image_reserve(buf, capacity, used,
+						 1+ind.len());
+		wp[0] = ind.len();
+		for (unsigned int i=0; i<ind.len(); i++)
+			wp[1+i] = (unsigned int)ind[i];
+
+		// volatile values are returned as Null
+		cur.get()->get_vblist(vbs, columns);
+		for (int i=0; i<columns; i++)
+			image_put_value(buf, capacity, used, vbs[i]);
+		rows++;
+	}
+	delete[] vbs;
+	unsigned int* header = (unsigned int*)buf;
+	header[0] = (unsigned int)columns;
+	header[1] = rows;
+	sz = used;
+	return TRUE;
+}
+
+bool MibTable::deserialize_image(const char* buf, int sz)
+{
+	const unsigned int* wp = (const unsigned int*)buf;
+	const unsigned int* end = wp + sz/4;
+	if ((end - wp < 2) || ((int)wp[0] != generator.size())) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibTable: deserialize_image: column count mismatch (table)(size)");
+		LOG(key()->get_printable());
+		LOG(sz);
+		LOG_END;
+		return FALSE;
+	}
+	unsigned int columns = wp[0];
+	unsigned int rows = wp[1];
+	wp += 2;
+	// a table that is empty before loading needs no duplicate check
+	bool preserve = (content.size() > 0);
+	unsigned long subids[MAX_OID_LEN];
+	for (unsigned int r=0; r<rows; r++) {
+		if ((wp >= end) || (wp[0] > MAX_OID_LEN) ||
+		    (end - wp <= (long)wp[0])) {
+			break;
+		}
+		unsigned int n = *wp++;
+		for (unsigned int i=0; i<n; i++) subids[i] = *wp++;
+		Oidx ind;
+		ind.set_data(subids, n);
+
+		MibTableRow* row = 0;
+		if ((!preserve) || (!find_index(ind))) {
+			row = new MibTableRow(generator);
+			row->set_index(ind);
+		}
+		else {
+			LOG_BEGIN(loggerModuleName, INFO_LOG | 3);
+			LOG("MibTable: deserialize_image: row exists -> not loaded (index)");
+			LOG(ind.get_printable());
+			LOG_END;
+		}
+#ifdef USE_ARRAY_TEMPLATE
+		ArrayCursor<MibLeaf> col;
+#else
+		ListCursor<MibLeaf> col;
+#endif
+		if (row) col.init(&row->row);
+		unsigned int c = 0;
+		for (; c<columns; c++) {
+			if (end - wp < 2) break;
+			unsigned int syntax = wp[0];
+			unsigned int len = wp[1];
+			wp += 2;
+			if ((unsigned long)len > 4UL*(unsigned long)(end - wp)) break;
+			if ((row) && (col.get())) {
+				MibLeaf* leaf = col.get();
+				SnmpSyntax* v = 0;
+				if (!leaf->is_volatile())
+					v = image_get_value(syntax, wp, len);
+				if ((v) && (v->get_syntax() == leaf->get_syntax()))
+					leaf->replace_value(v);
+				else if (v)
+					delete v;
+				col.next();
+			}
+			wp += IMAGE_WORDS(len);
+		}
+		if (c < columns) {
+			if (row) delete row;
+			break;
+		}
+		if (row) {
+			fire_row_changed(rowCreateAndWait, row, ind);
+			content.add(row);
+		}
+	}
+	if (wp != end) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibTable: deserialize_image: image is corrupt (table)(rows)");
+		LOG(key()->get_printable());
+		LOG(rows);
+		LOG_END;
+		return FALSE;
+	}
+	LOG_BEGIN(loggerModuleName, DEBUG_LOG | 4);
+	LOG("MibTable: deserialize_image: loaded (table)(rows)");
+	LOG(key()->get_printable());
+	LOG(rows);
+	LOG_END;
+	return TRUE;
+}
+
 
 int MibTable::set_value(Request* req, int reqind)
 {
@@ -1557,6 +1854,92 @@ int MibTable::get_row_status(MibTableRow* row)
 	}
 }
 
+bool MibTable::serialize_row(const Oidx& ind, char*& buf, int& sz)
+{
+	buf = 0;
+	sz = 0;
+	MibTableRow* row = find_index(ind);
+	if ((!row) || (!is_persistent(row))) return TRUE;
+
+	unsigned char* b = 0;
+	int buflen = 0;
+	if (row_to_asn1(row, b, buflen) != SNMP_CLASS_SUCCESS) {
+		if (b) delete[] b;
+		return FALSE;
+	}
+	buf = (char*)b;
+	sz = buflen;
+	return TRUE;
+}
+
+bool MibTable::deserialize_row(const Oidx& ind, char* buf, int sz)
+{
+	if (!buf) {
+		if (find_index(ind)) remove_row(ind);
+		return TRUE;
+	}
+	unsigned char* data = (unsigned char*)buf;
+	Vbx* vbs = 0;
+	int vbsz = 0;
+	int size = sz;
+	int status = Vbx::from_asn1(vbs, vbsz, data, size);
+	if ((status != SNMP_CLASS_SUCCESS) ||
+	    (vbsz != generator.size())) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibTable: deserialize_row: decoding error (table)(index)(col count)(status)");
+		LOG(key()->get_printable());
+		LOG(ind.get_printable());
+		LOG(vbsz);
+		LOG(status);
+		LOG_END;
+		if (vbs) delete[] vbs;
+		return FALSE;
+	}
+	if (find_index(ind)) remove_row(ind);
+	init_row(ind, vbs);
+	delete[] vbs;
+	return TRUE;
+}
+
+void MibTable::notify_change(const Oidx& ind, mib_change change)
+{
+	changeCount++;
+	if (trackChanges) add_change(ind);
+	MibEntry::notify_change(ind, change);
+}
+
+void MibTable::set_change_tracking(bool enable)
+{
+	changes.clearAll();
+	trackChanges = enable;
+}
+
+bool MibTable::is_changed(const Oidx& ind) const
+{
+	return (changes.find(OidxView(ind)) != 0);
+}
+
+void MibTable::take_changes(OidList<MibTableIndex>& list)
+{
+	OidListCursor<MibTableIndex> cur;
+	for (cur.init(&changes); cur.get(); cur.next()) {
+		if (list.find(cur.get()->key())) {
+			delete cur.get();
+		}
+		else {
+			list.add(cur.get());
+		}
+	}
+	changes.clear();
+}
+
+void MibTable::add_change(const Oidx& ind)
+{
+	if (!changes.find(OidxView(ind))) {
+		changes.add(new MibTableIndex(ind));
+	}
+}
+
 /**
  * Set the value of the snmpRowStatus object of a given row.
  *
@@ -1587,10 +1970,7 @@ int MibTable::set_row_status(MibTableRow* row, int status)
  */
 Oidx MibTable::index(const Oidx& entry_oid) const
 {
-	Oidx retval;
-	retval = entry_oid.cut_left(oid.len() + 1);
-
-	return retval;
+	return Oidx(OidxView(entry_oid).cut_left(oid.len() + 1));
 }
 
 /**
@@ -1601,10 +1981,7 @@ Oidx MibTable::index(const Oidx& entry_oid) const
  */
 Oidx MibTable::base(const Oidx& entry_oid)
 {
-	Oidx retval;
-	retval = entry_oid.cut_right(entry_oid.len() - oid.len());
-
-	return retval;
+	return Oidx(OidxView(entry_oid).cut_right(entry_oid.len() - oid.len()));
 }
 
 int MibTable::perform_voting(MibTableRow* row, int curState, int reqState)
@@ -1622,6 +1999,8 @@ int MibTable::perform_voting(MibTableRow* row, int curState, int reqState)
 
 void MibTable::fire_row_changed(int event, MibTableRow* row, const Oidx& ind)
 {
+	changeCount++;
+	if (trackChanges) add_change(ind);
 	switch (event) {
 	case rowCreateAndWait: {
 		row_init(row, ind);
@@ -1720,14 +2099,12 @@ void MibTable::remove_row(const Oidx& ind)
 
 MibTableRow* MibTable::find_index(const Oidx& ind) const
 {
-	Oidx o(ind);
-	return content.find(&o);
+	return content.find(OidxView(ind));
 }
 
 MibLeaf* MibTable::find(const Oidx& o) const
 {
-	Oidx ind = index(o);
-	MibTableRow* row = content.find(&ind);
+	MibTableRow* row = content.find(OidxView(o).cut_left(oid.len() + 1));
 	if (row) {
 		MibLeaf* leaf;
 		if ((leaf = row->get_element(o)) != 0)
@@ -1763,12 +2140,12 @@ MibLeaf* MibTable::find_next(const Oidx& o)
 			break;
 	}
 	if (!cur.get()) return 0;
-	Oidx ind = index(o);
+	OidxView ind(OidxView(o).cut_left(oid.len() + 1));
 	OidListCursor<MibTableRow> row;
 	row.init(&content);
 	// try to position the row
 	if ((ind.len() > 0) && (o > row.get()->get_nth(col)->get_oid()))
-		row.lookup(&ind);
+		row.lookup(ind);
 	for (; row.get(); row.next()) {
 		// we assume here that tables are arrays, that is every row has
 		// the same size
@@ -1862,8 +2239,7 @@ MibLeaf* MibTable::get(int n, int m)
 MibLeaf* MibTable::get_generator(const Oidx& o)
 {
 	// does oid belong to this table?
-	if ((o.len() <= oid.len()) ||
-	    (o.cut_right(o.len() - oid.len()) != oid)) return 0; // no
+	if (!oid.is_root_of(o)) return 0; // no
 
 	Oidx genOid(oid);
 	genOid += o[oid.len()];
@@ -2716,6 +3092,579 @@ bool MibConfigBER::load(MibContext* context, const NS_SNMP OctetStr& path)
 	return TRUE;
 }
 
+/*---------------------- class MibConfigFormat ----------------------*/
+
+bool MibConfigFormat::init(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	return context->init_from(path);
+}
+
+bool MibConfigFormat::sync(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	return save(context, path);
+}
+
+/*----------------------- class MibConfigLog ------------------------*/
+
+// log file header: magic, size and CRC-32 of the snapshot it is based on
+#define MIB_CONFIG_LOG_MAGIC		"AGPPLOG1"
+#define MIB_CONFIG_LOG_MAGIC_LEN	8
+#define MIB_CONFIG_LOG_HEADER_LEN	16
+// record: payload length, CRC-32 of payload, payload
+#define MIB_CONFIG_LOG_RECORD_HEADER_LEN	8
+// payload: kind, oid of the MIB object, [row index,] serialized data
+#define MIB_CONFIG_LOG_ROW		1
+#define MIB_CONFIG_LOG_ENTRY		2
+
+static unsigned char* put_ulong(unsigned char* cp, unsigned long v)
+{
+	*cp++ = (unsigned char)((v >> 24) & 0xFF);
+	*cp++ = (unsigned char)((v >> 16) & 0xFF);
+	*cp++ = (unsigned char)((v >> 8) & 0xFF);
+	*cp++ = (unsigned char)(v & 0xFF);
+	return cp;
+}
+
+static unsigned long get_ulong(const unsigned char* cp)
+{
+	return (((unsigned long)cp[0] << 24) | ((unsigned long)cp[1] << 16) |
+		((unsigned long)cp[2] << 8) | (unsigned long)cp[3]);
+}
+
+static unsigned char* put_oid(unsigned char* cp, const Oidx& o)
+{
+	*cp++ = (unsigned char)o.len();
+	for (unsigned int i=0; i<o.len(); i++) {
+		cp = put_ulong(cp, o[i]);
+	}
+	return cp;
+}
+
+static const unsigned char* get_oid(const unsigned char* cp,
+				    const unsigned char* end, Oidx& o)
+{
+	if (cp >= end) return 0;
+	unsigned int len = *cp++;
+	if (cp + 4*len > end) return 0;
+	o.clear();
+	for (unsigned int i=0; i<len; i++, cp += 4) {
+		o += get_ulong(cp);
+	}
+	return cp;
+}
+
+/**
+ * Compute size and CRC-32 of a file. A missing file has size and
+ * CRC 0.
+ */
+static void file_checksum(const char* fname, unsigned long& size,
+			  unsigned long& crc)
+{
+	size = 0;
+	crc = 0;
+	FILE* f = fopen(fname, "rb");
+	if (!f) return;
+	unsigned char buf[8192];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		crc = AgentTools::crc32(buf, n, crc);
+		size += n;
+	}
+	fclose(f);
+}
+
+static OctetStr group_file_name(MibContext* context, MibGroup* group,
+				const OctetStr& path)
+{
+	OctetStr fname(path);
+	fname += group->get_persistency_name();
+	fname += ".";
+	fname += context->get_name();
+	return fname;
+}
+
+MibConfigLogFile::MibConfigLogFile(const OctetStr& fname):
+    fileName(fname), log(0), logSize(0),
+    snapshotSize(0), snapshotCRC(0), compactionNeeded(FALSE)
+{
+	logName = fileName;
+	logName += ".log";
+}
+
+MibConfigLogFile::~MibConfigLogFile()
+{
+	close();
+}
+
+void MibConfigLogFile::close()
+{
+	if (log) {
+		fclose(log);
+		log = 0;
+	}
+}
+
+MibConfigLog::MibConfigLog(unsigned long threshold):
+    compactionThreshold(threshold)
+{
+}
+
+MibConfigLog::~MibConfigLog()
+{
+	files.clearAll();
+}
+
+MibConfigLogFile* MibConfigLog::get_file(const OctetStr& fname)
+{
+	ListCursor<MibConfigLogFile> cur;
+	for (cur.init(&files); cur.get(); cur.next()) {
+		if (cur.get()->fileName == fname) return cur.get();
+	}
+	MibConfigLogFile* file = new MibConfigLogFile(fname);
+	file_checksum(fname.get_printable(),
+		      file->snapshotSize, file->snapshotCRC);
+	// a log left by an earlier run (e.g. replayed by load) may hold
+	// changes that are not in the snapshot yet, so it is folded into
+	// a new snapshot before the first record would truncate it
+	FILE* f = fopen(file->logName.get_printable(), "rb");
+	if (f) {
+		fclose(f);
+		file->compactionNeeded = TRUE;
+	}
+	return files.add(file);
+}
+
+/**
+ * Append a record to the log of a group file, create the log if
+ * necessary.
+ */
+static bool write_record(MibConfigLogFile* file, unsigned char kind,
+			 const Oidx& oid, const Oidx* index,
+			 const char* data, int sz)
+{
+	if (!file->log) {
+		if ((file->log = fopen(file->logName.get_printable(), "wb")) == 0) {
+			LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+			LOG("MibConfigLog: cannot create log (file)");
+			LOG(file->logName.get_printable());
+			LOG_END;
+			return FALSE;
+		}
+		unsigned char header[MIB_CONFIG_LOG_HEADER_LEN];
+		memcpy(header, MIB_CONFIG_LOG_MAGIC, MIB_CONFIG_LOG_MAGIC_LEN);
+		unsigned char* cp = put_ulong(header+MIB_CONFIG_LOG_MAGIC_LEN,
+					      file->snapshotSize);
+		put_ulong(cp, file->snapshotCRC);
+		if (fwrite(header, 1, sizeof(header), file->log) !=
+		    sizeof(header)) {
+			file->close();
+			return FALSE;
+		}
+		file->logSize = sizeof(header);
+	}
+	int len = 1 + 1 + 4*oid.len() + sz;
+	if (index) len += 1 + 4*index->len();
+	unsigned char* record =
+	    new unsigned char[MIB_CONFIG_LOG_RECORD_HEADER_LEN + len];
+	unsigned char* payload = record + MIB_CONFIG_LOG_RECORD_HEADER_LEN;
+	unsigned char* cp = payload;
+	*cp++ = kind;
+	cp = put_oid(cp, oid);
+	if (index) cp = put_oid(cp, *index);
+	if (sz > 0) memcpy(cp, data, sz);
+	cp = put_ulong(record, len);
+	put_ulong(cp, AgentTools::crc32(payload, len));
+	len += MIB_CONFIG_LOG_RECORD_HEADER_LEN;
+	bool ok = (fwrite(record, 1, len, file->log) == (size_t)len);
+	delete[] record;
+	if (ok) file->logSize += len;
+	return ok;
+}
+
+void MibConfigLog::track(MibGroup* group, MibConfigLogFile* file)
+{
+	ListCursor<MibEntry> cur(group->get_content());
+	for (; cur.get(); cur.next()) {
+		MibEntry* e = cur.get();
+		if (e->is_volatile()) continue;
+		e->start_synch();
+		if (e->type() == AGENTPP_TABLE) {
+			// discards changes recorded before
+			((MibTable*)e)->set_change_tracking(TRUE);
+		}
+		else {
+			char* buf = 0;
+			int sz = 0;
+			if ((e->serialize(buf, sz)) && (buf)) {
+				unsigned long crc =
+				    AgentTools::crc32((unsigned char*)buf, sz);
+				MibConfigLogEntry* entry =
+				    file->entries.find(e->key());
+				if (entry) entry->crc = crc;
+				else file->entries.add(new MibConfigLogEntry(*e->key(),
+									   crc));
+				delete[] buf;
+			}
+		}
+		e->end_synch();
+	}
+}
+
+bool MibConfigLog::compact(MibGroup* group, MibConfigLogFile* file)
+{
+	file->close();
+	// changes made after this point are logged again by the next sync
+	track(group, file);
+	if (!group->write_snapshot(file->fileName.get_printable())) {
+		file->compactionNeeded = TRUE;
+		return FALSE;
+	}
+	remove(file->logName.get_printable());
+	file_checksum(file->fileName.get_printable(),
+		      file->snapshotSize, file->snapshotCRC);
+	file->logSize = 0;
+	file->compactionNeeded = FALSE;
+
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 3);
+	LOG("MibConfigLog: compacted log into snapshot (file)(size)");
+	LOG(file->fileName.get_printable());
+	LOG(file->snapshotSize);
+	LOG_END;
+	return TRUE;
+}
+
+bool MibConfigLog::append_changes(MibGroup* group, MibConfigLogFile* file)
+{
+	ListCursor<MibEntry> cur(group->get_content());
+	// changes of tables that are not tracked are not known
+	for (; cur.get(); cur.next()) {
+		if ((!cur.get()->is_volatile()) &&
+		    (cur.get()->type() == AGENTPP_TABLE) &&
+		    (!((MibTable*)cur.get())->is_change_tracking())) {
+			file->compactionNeeded = TRUE;
+			return TRUE;
+		}
+	}
+	bool ok = TRUE;
+	ListCursor<MibEntry> c(group->get_content());
+	for (; c.get(); c.next()) {
+		MibEntry* e = c.get();
+		if (e->is_volatile()) continue;
+		char* buf = 0;
+		int sz = 0;
+		e->start_synch();
+		if (e->type() == AGENTPP_TABLE) {
+			MibTable* table = (MibTable*)e;
+			OidList<MibTableIndex> changed;
+			table->take_changes(changed);
+			OidListCursor<MibTableIndex> c;
+			for (c.init(&changed); ((ok) && (c.get())); c.next()) {
+				ok = table->serialize_row(c.get()->index, buf, sz);
+				if (ok) {
+					ok = write_record(file, MIB_CONFIG_LOG_ROW,
+							  *e->key(), &c.get()->index,
+							  buf, sz);
+				}
+				if (buf) delete[] buf;
+				buf = 0;
+			}
+		}
+		else if ((e->serialize(buf, sz)) && (buf)) {
+			unsigned long crc = AgentTools::crc32((unsigned char*)buf, sz);
+			MibConfigLogEntry* entry = file->entries.find(e->key());
+			if ((!entry) || (entry->crc != crc)) {
+				ok = write_record(file, MIB_CONFIG_LOG_ENTRY,
+						  *e->key(), 0, buf, sz);
+				if ((ok) && (entry)) entry->crc = crc;
+				else if (ok) file->entries.add(
+				    new MibConfigLogEntry(*e->key(), crc));
+			}
+			delete[] buf;
+		}
+		e->end_synch();
+		if (!ok) break;
+	}
+	if ((ok) && (file->log)) {
+		ok = AgentTools::sync_file(file->log);
+	}
+	if (!ok) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibConfigLog: writing log failed (file)");
+		LOG(file->logName.get_printable());
+		LOG_END;
+		file->close();
+	}
+	return ok;
+}
+
+int MibConfigLog::replay(MibGroup* group, MibConfigLogFile* file)
+{
+	FILE* f = fopen(file->logName.get_printable(), "rb");
+	if (!f) return -1;
+	long size = AgentTools::file_size(f);
+	unsigned char* buf = new unsigned char[(size > 0) ? size : 1];
+	if ((size < 0) || (fread(buf, 1, size, f) != (size_t)size)) {
+		size = 0;
+	}
+	fclose(f);
+
+	if ((size < MIB_CONFIG_LOG_HEADER_LEN) ||
+	    (memcmp(buf, MIB_CONFIG_LOG_MAGIC, MIB_CONFIG_LOG_MAGIC_LEN) != 0) ||
+	    (get_ulong(buf+MIB_CONFIG_LOG_MAGIC_LEN) != file->snapshotSize) ||
+	    (get_ulong(buf+MIB_CONFIG_LOG_MAGIC_LEN+4) != file->snapshotCRC)) {
+		LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+		LOG("MibConfigLog: log does not belong to snapshot, ignored (file)");
+		LOG(file->logName.get_printable());
+		LOG_END;
+		delete[] buf;
+		return 0;
+	}
+	int n = 0;
+	const unsigned char* cp = buf + MIB_CONFIG_LOG_HEADER_LEN;
+	const unsigned char* end = buf + size;
+	while (cp + MIB_CONFIG_LOG_RECORD_HEADER_LEN <= end) {
+		unsigned long len = get_ulong(cp);
+		const unsigned char* payload = cp + MIB_CONFIG_LOG_RECORD_HEADER_LEN;
+		if ((len > (unsigned long)(end - payload)) ||
+		    (AgentTools::crc32(payload, len) != get_ulong(cp+4))) {
+			// incomplete record written before a crash
+			LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+			LOG("MibConfigLog: discarding incomplete log record (file)(offset)");
+			LOG(file->logName.get_printable());
+			LOG((long)(cp - buf));
+			LOG_END;
+			break;
+		}
+		cp = payload + len;
+
+		Oidx oid, index;
+		const unsigned char* data = get_oid(payload+1, cp, oid);
+		if ((data) && (*payload == MIB_CONFIG_LOG_ROW)) {
+			data = get_oid(data, cp, index);
+		}
+		MibEntry* e = 0;
+		ListCursor<MibEntry> c(group->get_content());
+		for (; ((data) && (c.get())); c.next()) {
+			if (*c.get()->key() == oid) {
+				e = c.get();
+				break;
+			}
+		}
+		if ((!e) || (e->is_volatile())) continue;
+
+		int sz = (int)(cp - data);
+		e->start_synch();
+		if ((*payload == MIB_CONFIG_LOG_ROW) &&
+		    (e->type() == AGENTPP_TABLE)) {
+			MibTable* table = (MibTable*)e;
+			// rows that existed before loading are not replaced,
+			// as when loading a snapshot
+			if ((!table->find_index(index)) ||
+			    (table->is_changed(index))) {
+				table->deserialize_row(index,
+						       (sz > 0) ? (char*)data : 0,
+						       sz);
+				n++;
+			}
+		}
+		else if (*payload == MIB_CONFIG_LOG_ENTRY) {
+			if (e->deserialize((char*)data, sz)) n++;
+		}
+		e->end_synch();
+	}
+	delete[] buf;
+
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
+	LOG("MibConfigLog: replayed log (file)(records)");
+	LOG(file->logName.get_printable());
+	LOG(n);
+	LOG_END;
+	return n;
+}
+
+/**
+ * Enable change tracking for the tables of the persistent groups of
+ * a context, so that rows loaded afterwards are recorded as changed.
+ */
+static void track_tables(MibContext* context)
+{
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (!cur.get()->is_persistent()) continue;
+		ListCursor<MibEntry> c(cur.get()->get_content());
+		for (; c.get(); c.next()) {
+			if ((c.get()->type() == AGENTPP_TABLE) &&
+			    (!((MibTable*)c.get())->is_change_tracking())) {
+				((MibTable*)c.get())->set_change_tracking(TRUE);
+			}
+		}
+	}
+}
+
+bool MibConfigLog::init(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+	LOG("Initializing MIB context contents from snapshots and logs (context)(path)");
+	LOG(context->get_name().get_printable());
+	LOG(path.get_printable());
+	LOG_END;
+	start_synch();
+	track_tables(context);
+	bool ok = context->init_from(path);
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (!cur.get()->is_persistent()) continue;
+		MibConfigLogFile* file =
+		    get_file(group_file_name(context, cur.get(), path));
+		file->close();
+		if (replay(cur.get(), file) >= 0) {
+			// fold the log into a new snapshot
+			ok = compact(cur.get(), file) && ok;
+		}
+		else {
+			track(cur.get(), file);
+		}
+	}
+	end_synch();
+	return ok;
+}
+
+bool MibConfigLog::load(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+	LOG("Loading MIB context contents from snapshots and logs (context)(path)");
+	LOG(context->get_name().get_printable());
+	LOG(path.get_printable());
+	LOG_END;
+	start_synch();
+	track_tables(context);
+	bool ok = context->load_from(path);
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (!cur.get()->is_persistent()) continue;
+		// the files are only read, the next sync compacts the
+		// logs into new snapshots (see get_file)
+		MibConfigLogFile file(group_file_name(context, cur.get(), path));
+		file_checksum(file.fileName.get_printable(),
+			      file.snapshotSize, file.snapshotCRC);
+		replay(cur.get(), &file);
+	}
+	end_synch();
+	return ok;
+}
+
+bool MibConfigLog::save(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+	LOG("Saving MIB context contents to snapshots (context)(path)");
+	LOG(context->get_name().get_printable());
+	LOG(path.get_printable());
+	LOG_END;
+	bool ok = TRUE;
+	start_synch();
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (!cur.get()->is_persistent()) continue;
+		OctetStr fname(group_file_name(context, cur.get(), path));
+		MibConfigLogFile* file = 0;
+		ListCursor<MibConfigLogFile> c;
+		for (c.init(&files); c.get(); c.next()) {
+			if (c.get()->fileName == fname) {
+				file = c.get();
+				break;
+			}
+		}
+		if (file) {
+			ok = compact(cur.get(), file) && ok;
+		}
+		else if (cur.get()->write_snapshot(fname.get_printable())) {
+			// a copy, changes are still logged where they belong
+			OctetStr logName(fname);
+			logName += ".log";
+			remove(logName.get_printable());
+		}
+		else ok = FALSE;
+	}
+	end_synch();
+	return ok;
+}
+
+bool MibConfigLog::sync(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	bool ok = TRUE;
+	start_synch();
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (!cur.get()->is_persistent()) continue;
+		MibConfigLogFile* file =
+		    get_file(group_file_name(context, cur.get(), path));
+		if (!file->compactionNeeded) {
+			if (!append_changes(cur.get(), file)) {
+				file->compactionNeeded = TRUE;
+			}
+			else if ((file->logSize > compactionThreshold) &&
+				 (file->logSize > file->snapshotSize)) {
+				file->compactionNeeded = TRUE;
+			}
+		}
+		if (file->compactionNeeded) {
+			ok = compact(cur.get(), file) && ok;
+		}
+	}
+	end_synch();
+	return ok;
+}
+
+/*----------------------- class MibConfigImage ----------------------*/
+
+static void enable_images(MibContext* context)
+{
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (cur.get()->is_persistent())
+			cur.get()->set_image_snapshot(TRUE);
+	}
+}
+
+bool MibConfigImage::save(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+	LOG("Saving MIB context contents as images (context)(path)");
+	LOG(context->get_name().get_printable());
+	LOG(path.get_printable());
+	LOG_END;
+	enable_images(context);
+	bool ok = TRUE;
+	OidListCursor<MibGroup> cur(context->get_groups());
+	for (; cur.get(); cur.next()) {
+		if (!cur.get()->is_persistent()) continue;
+		OctetStr fname(group_file_name(context, cur.get(), path));
+		ok = cur.get()->write_image(fname.get_printable()) && ok;
+	}
+	return ok;
+}
+
+bool MibConfigImage::load(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+	LOG("Loading MIB context contents from images (context)(path)");
+	LOG(context->get_name().get_printable());
+	LOG(path.get_printable());
+	LOG_END;
+	return context->load_from(path);
+}
+
+bool MibConfigImage::init(MibContext* context, const NS_SNMP OctetStr& path)
+{
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 1);
+	LOG("Initializing MIB context contents from images (context)(path)");
+	LOG(context->get_name().get_printable());
+	LOG(path.get_printable());
+	LOG_END;
+	enable_images(context);
+	return context->init_from(path);
+}
+
 /*--------------------------- class Mib -----------------------------*/
 
 
@@ -2772,6 +3721,8 @@ Mib::~Mib()
 	unlock_mib();
 	if (notificationSender)
 	    delete notificationSender;
+	// close pooled sessions, they may be bound to our listen address
+	SnmpSessionPool::instance()->clear();
 	if (persistent_objects_path) {
 	    delete persistent_objects_path;
 	    persistent_objects_path = 0;
@@ -2802,7 +3753,10 @@ void Mib::construct(const OctetStr& path, const OctetStr& bootCounterFilePath)
 #ifdef AGENTPP_USE_THREAD_POOL
 	threadPool = 0;
 #endif
+	readMostly = FALSE;
 	add_config_format(1, new MibConfigBER());
+	persistenceFormat = 1;
+	syncOnCommit = FALSE;
 }
 
 #ifdef _SNMPv3
@@ -2989,10 +3943,12 @@ bool Mib::init()
 	}
 #endif
 	if (is_persistency_activated()) {
+		MibConfigFormat* f = get_config_format(persistenceFormat);
 		OidListCursor<MibContext> cur;
 		lock_mib();
 		for (cur.init(&contexts); cur.get(); cur.next()) {
-			cur.get()->init_from(get_persistent_objects_path());
+			if (f) f->init(cur.get(), get_persistent_objects_path());
+			else cur.get()->init_from(get_persistent_objects_path());
 		}
 		unlock_mib();
 	}
@@ -3002,10 +3958,12 @@ bool Mib::init()
 void Mib::save_all()
 {
 	if (is_persistency_activated()) {
+		MibConfigFormat* f = get_config_format(persistenceFormat);
 		OidListCursor<MibContext> cur;
 		lock_mib();
 		for (cur.init(&contexts); cur.get(); cur.next()) {
-			cur.get()->save_to(get_persistent_objects_path());
+			if (f) f->sync(cur.get(), get_persistent_objects_path());
+			else cur.get()->save_to(get_persistent_objects_path());
 		}
 		unlock_mib();
 	}
@@ -3130,7 +4088,7 @@ int Mib::find_managing_object(MibContext* context,
 		return SNMP_ERROR_SUCCESS;
 	}
 	if ((is_leaf_node(retval)) && // for leafs we have to match without .0
-	    (oid.in_subtree_of(retval->key()->cut_right(1)))) {
+	    (oid.in_subtree_of(OidxView(*retval->key()).cut_right(1)))) {
 		return sNMP_SYNTAX_NOSUCHINSTANCE;
 	}
 	return sNMP_SYNTAX_NOSUCHOBJECT;
@@ -3283,7 +4241,7 @@ bool Mib::process_request(Request* req, int reqind)
 		Oidx tmpoid(req->get_oid(reqind));
 		int err;
 
-		lock_mib();
+		lock_mib_shared();
 		// entry not available
 #ifdef _SNMPv3
 		if ((err = find_managing_object(get_context(req->get_context()),
@@ -3293,7 +4251,7 @@ bool Mib::process_request(Request* req, int reqind)
 						tmpoid, entry, req)) != SNMP_ERROR_SUCCESS)
 #endif
 		{
-			unlock_mib();
+			unlock_mib_shared();
 			return set_exception_vb(req, reqind, err);
 		}
 #ifdef _SNMPv3
@@ -3302,18 +4260,18 @@ bool Mib::process_request(Request* req, int reqind)
                   requestList->get_vacm()->
 		  isAccessAllowed(req->viewName, tmpoid);
 		if (vacmErrorCode == VACM_notInView) {
-		    unlock_mib();
+		    unlock_mib_shared();
 		    return set_exception_vb(req, reqind,
 					    sNMP_SYNTAX_NOSUCHOBJECT);
 		}
 		else if (vacmErrorCode != VACM_accessAllowed) {
-		  unlock_mib();
+		  unlock_mib_shared();
                   req->vacmError(reqind, vacmErrorCode);
                   return FALSE;
                 }
 #endif
 		entry->start_synch();
-		unlock_mib();
+		unlock_mib_shared();
 		entry->get_request(req, reqind);
 		entry->end_synch();
 		break;
@@ -3329,7 +4287,7 @@ bool Mib::process_request(Request* req, int reqind)
 		MibEntryPtr entry;
 		Oidx tmpoid(req->get_oid(reqind));
                 Oidx nextOid;
-		lock_mib();
+		lock_mib_shared();
 #ifdef _SNMPv3
 		int vacmErrorCode = VACM_otherError;
 		do {                   
@@ -3343,7 +4301,7 @@ bool Mib::process_request(Request* req, int reqind)
 		  if (find_next(defaultContext, tmpoid, entry,
 				req, reqind, nextOid) != SNMP_ERROR_SUCCESS) {
 #endif
-			unlock_mib();
+			unlock_mib_shared();
 			return set_exception_vb(req, reqind,
 						sNMP_SYNTAX_ENDOFMIBVIEW);
 		  }
@@ -3352,7 +4310,7 @@ bool Mib::process_request(Request* req, int reqind)
                           next_access_control(req, entry, tmpoid, nextOid)) ==
 			  VACM_notInView);
                 if (vacmErrorCode != VACM_accessAllowed) {
-		  unlock_mib();
+		  unlock_mib_shared();
                   req->vacmError(reqind, vacmErrorCode);
                   return FALSE;
                 }
@@ -3397,7 +4355,7 @@ bool Mib::process_request(Request* req, int reqind)
 		// that we can answer the request
 		req->set_oid(tmpoid, reqind);
 		entry->start_synch();
-		unlock_mib();
+		unlock_mib_shared();
 		entry->get_next_request(req, reqind);
 		entry->end_synch();
 		break;
@@ -3509,8 +4467,8 @@ void Mib::proxy_request(Request* req)
 
 	}
 	if ((!proxy) || ((proxy) && (!proxy->process_request(req)))) {
-		unsigned long proxyDrops =
-                    snmpProxyDrops::incrementScalar(this, oidSnmpProxyDrops);
+		MibIIsnmpCounters::incProxyDrops();
+		unsigned long proxyDrops = MibIIsnmpCounters::proxyDrops();
 		Vbx vb(oidSnmpProxyDrops);
 		vb.set_value(proxyDrops);
 		req->get_pdu()->set_vblist(&vb, 1);
@@ -3628,6 +4586,7 @@ void Mib::process_set_request(Request* req)
 	for (int j=0; j<n; j++)
 		LOG(req->get_oid(j).get_printable());
 	LOG_END;
+	bool committed = FALSE;
 	req->phase++; // indicate PHASE_PREPARE
 	if (process_prepare_set_request(req) == SNMP_ERROR_SUCCESS) {
 		req->phase++; // indicate PHASE_COMMIT
@@ -3644,9 +4603,22 @@ void Mib::process_set_request(Request* req)
 			process_undo_set_request(req);
 			return;
 		}
+		committed = TRUE;
 	}
 	req->phase = PHASE_CLEANUP;
 	process_cleanup_set_request(req);
+
+	if ((committed) && (syncOnCommit) && (is_persistency_activated())) {
+		MibConfigFormat* f = get_config_format(persistenceFormat);
+#ifdef _SNMPv3
+		MibContext* context = get_context(req->get_context());
+#else
+		MibContext* context = defaultContext;
+#endif
+		if ((f) && (context)) {
+			f->sync(context, get_persistent_objects_path());
+		}
+	}
 }
 
 int Mib::process_prepare_set_request(Request* req)
@@ -3851,7 +4823,7 @@ void Mib::process_get_bulk_request(Request* req)
 
 		Oidx tmpoid(req->get_oid(id));
 		MibEntryPtr entry;
-		lock_mib();
+		lock_mib_shared();
                 Oidx nextOid;
 #ifdef _SNMPv3
 		int vacmErrorCode = VACM_otherError;
@@ -3866,7 +4838,7 @@ void Mib::process_get_bulk_request(Request* req)
 		  if (find_next(defaultContext, tmpoid, entry,
 				req, id, nextOid) != SNMP_ERROR_SUCCESS) {
 #endif
-			unlock_mib();
+			unlock_mib_shared();
 			Vbx vb(req->get_oid(id));
 			vb.set_syntax(sNMP_SYNTAX_ENDOFMIBVIEW);
 			req->finish(id, vb);
@@ -3878,7 +4850,7 @@ void Mib::process_get_bulk_request(Request* req)
 			  VACM_notInView);
 
                 if (vacmErrorCode != VACM_accessAllowed) {
-			unlock_mib();
+			unlock_mib_shared();
 			req->vacmError(id, vacmErrorCode);
 			return;
                 }
@@ -3923,7 +4895,7 @@ void Mib::process_get_bulk_request(Request* req)
 		// that we can answer the request
 		req->set_oid(tmpoid, id);
 		entry->start_synch();
-		unlock_mib();
+		unlock_mib_shared();
 		entry->get_next_request(req, id);
 		entry->end_synch();
 	}
@@ -3962,7 +4934,7 @@ void Mib::process_get_bulk_request(Request* req)
 			LOG(req->outstanding);
 			LOG_END;
 
-			lock_mib();
+			lock_mib_shared();
                         Oidx nextOid;
 #ifdef _SNMPv3
 			bool contin = FALSE;
@@ -3989,7 +4961,7 @@ void Mib::process_get_bulk_request(Request* req)
 				req->finish(id, vb);
 				//req->dec_outstanding();
 				if (req->finished()) {
-					unlock_mib();
+					unlock_mib_shared();
 					return;
 				}
 #ifdef _SNMPv3
@@ -3997,7 +4969,7 @@ void Mib::process_get_bulk_request(Request* req)
 				break;
 #else
 				else {
-					unlock_mib();
+					unlock_mib_shared();
 					continue;
 				}
 #endif
@@ -4008,10 +4980,10 @@ void Mib::process_get_bulk_request(Request* req)
                                                       tmpoid, nextOid)) ==
 				 VACM_notInView);
 
-			if (contin) { unlock_mib(); continue; }
+			if (contin) { unlock_mib_shared(); continue; }
 
 			if (vacmErrorCode != VACM_accessAllowed) {
-				unlock_mib();
+				unlock_mib_shared();
 				req->vacmError(id, vacmErrorCode);
 				return;
 			}
@@ -4058,7 +5030,7 @@ void Mib::process_get_bulk_request(Request* req)
 			req->set_oid(tmpoid, id);
 
 			entry->start_synch();
-			unlock_mib();
+			unlock_mib_shared();
 			entry->get_next_request(req, id);
 			entry->end_synch();
 		    }
@@ -98,22 +98,22 @@ void MibStaticTable::remove(const Oidx& o)
 
 MibStaticEntry* MibStaticTable::get(const Oidx& o, bool suffixOnly) 
 {
-	Oidx tmpoid(o);
+	OidxView tmpoid(o);
 	if (!suffixOnly) {
 		if (!oid.is_root_of(tmpoid))
 			return 0;
 		tmpoid = tmpoid.cut_left(oid.len());
 	}
-	return contents.find(&tmpoid);
+	return contents.find(tmpoid);
 }
 
 Oidx MibStaticTable::find_succ(const Oidx& o, Request*)
 {
 	start_synch();
-	Oidx tmpoid(o);
+	OidxView tmpoid(o);
 	Oidx retval;
 	if (tmpoid <= oid) {
-		tmpoid = Oidx();
+		tmpoid = OidxView();
 	}
 	else if (tmpoid.len() >= oid.len()) {
 		tmpoid = tmpoid.cut_left(oid.len());
@@ -122,9 +122,9 @@ Oidx MibStaticTable::find_succ(const Oidx& o, Request*)
 		end_synch();
 		return retval;
 	}
-	MibStaticEntry* ptr = contents.find_upper(&tmpoid);
+	MibStaticEntry* ptr = contents.find_upper(tmpoid);
 	if ((ptr) && (*ptr->key() == tmpoid)) {
-		ptr = contents.find_next(&tmpoid);
+		ptr = contents.find_next(tmpoid);
 	}
 	if (ptr) {
 		retval = oid;
@@ -136,20 +136,21 @@ Oidx MibStaticTable::find_succ(const Oidx& o, Request*)
 
 void MibStaticTable::get_request(Request* req, int ind)
 {
-	Oidx tmpoid(req->get_oid(ind));
+	Oidx reqoid(req->get_oid(ind));
+	OidxView tmpoid(reqoid);
 	if (oid.is_root_of(tmpoid)) {
 		tmpoid = tmpoid.cut_left(oid.len());
 	}
 	else {
-		Vbx vb(req->get_oid(ind));
+		Vbx vb(reqoid);
 		vb.set_syntax(sNMP_SYNTAX_NOSUCHOBJECT);
 		// error status (v1) will be set by RequestList
 		req->finish(ind, vb); 
 		return;
 	}
-	MibStaticEntry* entry = contents.find(&tmpoid);
+	MibStaticEntry* entry = contents.find(tmpoid);
 	if (!entry) {
-		Vbx vb(req->get_oid(ind));
+		Vbx vb(reqoid);
 		// TODO: This error status is just a guess, we cannot
 		// determine exactly whether it is a noSuchInstance or
 		// noSuchObject. May be a subclass could do a better 
@@ -180,19 +181,20 @@ void MibStaticTable::get_request(Request* req, int ind)
 
 void MibStaticTable::get_next_request(Request* req, int ind)
 {
-	Oidx tmpoid(req->get_oid(ind));
+	Oidx reqoid(req->get_oid(ind));
+	OidxView tmpoid(reqoid);
 	if (oid.is_root_of(tmpoid)) {
 		tmpoid = tmpoid.cut_left(oid.len());
 	}
 	else {
-		Vbx vb(req->get_oid(ind));
+		Vbx vb(reqoid);
 		vb.set_syntax(sNMP_SYNTAX_NOSUCHOBJECT);
 		// error status (v1) will be set by RequestList
 		req->finish(ind, vb); 
 	}
-	MibStaticEntry* entry = contents.find_upper(&tmpoid);
+	MibStaticEntry* entry = contents.find_upper(tmpoid);
 	if (!entry) {
-		Vbx vb(req->get_oid(ind));
+		Vbx vb(reqoid);
 		// TODO: This error status is just a guess, we cannot
 		// determine exactly whether it is a noSuchInstance or
 		// noSuchObject. May be a subclass could do a better 
@@ -32,16 +32,27 @@ static const char *loggerModuleName = "agent++.mib_context";
 
 /*--------------------------- class MibGroup --------------------------*/
 
+// image header: magic, byte order mark, version, object count, file size
+#define MIB_IMAGE_MAGIC			"AGPPIMG1"
+#define MIB_IMAGE_MAGIC_LEN		8
+#define MIB_IMAGE_HEADER_LEN		24
+#define MIB_IMAGE_BYTE_ORDER		0x01020304
+#define MIB_IMAGE_VERSION		1
+// object: OID length, OID, data size, data padded to 32-bit words
+#define MIB_IMAGE_WORDS(n)		(((n)+3)/4)
+
 MibGroup::MibGroup(const Oidx& o): MibEntry(o, NOACCESS)
 {
 	persistencyName = 0;
 	timeout = 0;
+	imageSnapshot = FALSE;
 }
 
 MibGroup::MibGroup(const Oidx& o, const OctetStr& p): MibEntry(o, NOACCESS)
 {
 	persistencyName = new OctetStr(p);
 	timeout = 0;
+	imageSnapshot = FALSE;
 }
 
 MibGroup::~MibGroup()
@@ -135,6 +146,16 @@ void MibGroup::load_from_file(const char* fname)
 		return;
 
 	size  = AgentTools::file_size(f);
+	if (size >= MIB_IMAGE_HEADER_LEN) {
+		bytes = fread(header, sizeof(char), MIB_IMAGE_MAGIC_LEN, f);
+		if ((bytes == MIB_IMAGE_MAGIC_LEN) &&
+		    (memcmp(header, MIB_IMAGE_MAGIC, MIB_IMAGE_MAGIC_LEN) == 0)) {
+			fclose(f);
+			load_image(fname);
+			return;
+		}
+		rewind(f);
+	}
         if (size <= 0) {
                 LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
                 LOG("MibGroup: No persistent data in (file)");
@@ -210,33 +231,230 @@ void MibGroup::load_from_file(const char* fname)
 }
 
 void MibGroup::save_to_file(const char* fname)
+{
+	write_snapshot(fname);
+}
+
+bool MibGroup::write_snapshot(const char* fname)
 {
 	FILE *f;
 	char *buf = 0;
 	int bytes = 0;
+	bool ok = TRUE;
 
-	if ((f = fopen(fname, "wb")) == 0) {
+	if (imageSnapshot)
+		return write_image(fname);
+
+	// write a temporary file and replace the old one when complete,
+	// so that a crash while saving does not corrupt the data
+	char* tmpname = AgentTools::make_concatenation(fname, ".tmp");
+	if ((f = fopen(tmpname, "wb")) == 0) {
                 LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
                 LOG("MibGroup: Saving to file to not possible: (file)");
-                LOG(fname);
+                LOG(tmpname);
                 LOG_END;
-		return;
+		delete [] tmpname;
+		return FALSE;
 	}
 	ListCursor<MibEntry> cur;
 	for (cur.init(&content); cur.get(); cur.next()) {
 		// skip volatile objects
 		if (cur.get()->is_volatile()) continue;
 
-		if ((cur.get()->serialize(buf, bytes)) && (buf)) {
-			fwrite(buf, sizeof(char), bytes, f);
+		cur.get()->start_synch();
+		bool serialized = cur.get()->serialize(buf, bytes);
+		cur.get()->end_synch();
+		if ((serialized) && (buf)) {
+			if ((int)fwrite(buf, sizeof(char), bytes, f) != bytes)
+				ok = FALSE;
 			delete [] buf;
 			buf = 0;
 		}
 	}
-      	fclose(f);
+	ok = AgentTools::sync_file(f) && ok;
+	ok = (fclose(f) == 0) && ok;
+	if ((ok) && (!AgentTools::replace_file(tmpname, fname))) {
+		ok = FALSE;
+	}
+	if (!ok) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibGroup: Saving to file failed (file)");
+		LOG(fname);
+		LOG_END;
+		remove(tmpname);
+	}
+	delete [] tmpname;
+	return ok;
 }
 
 
+bool MibGroup::write_image(const char* fname)
+{
+	FILE *f;
+	bool ok = TRUE;
+	unsigned int header[MIB_IMAGE_HEADER_LEN/4];
+	unsigned int entries = 0;
+	long size = MIB_IMAGE_HEADER_LEN;
+
+	char* tmpname = AgentTools::make_concatenation(fname, ".tmp");
+	if ((f = fopen(tmpname, "wb")) == 0) {
+                LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+                LOG("MibGroup: Saving image to file not possible: (file)");
+                LOG(tmpname);
+                LOG_END;
+		delete [] tmpname;
+		return FALSE;
+	}
+	// the header is written again when the object count is known
+	memset(header, 0, sizeof(header));
+	if (fwrite(header, sizeof(char), MIB_IMAGE_HEADER_LEN, f) !=
+	    MIB_IMAGE_HEADER_LEN)
+		ok = FALSE;
+
+	ListCursor<MibEntry> cur;
+	for (cur.init(&content); ((cur.get()) && (ok)); cur.next()) {
+		// skip volatile objects
+		if (cur.get()->is_volatile()) continue;
+
+		char* buf = 0;
+		int bytes = 0;
+		cur.get()->start_synch();
+		bool serialized = cur.get()->serialize_image(buf, bytes);
+		cur.get()->end_synch();
+		if ((!serialized) || (!buf)) {
+			if (buf) delete [] buf;
+			continue;
+		}
+		const Oidx* oid = cur.get()->key();
+		unsigned int words[MAX_OID_LEN+2];
+		unsigned int n = 0;
+		words[n++] = oid->len();
+		for (unsigned int i=0; i<oid->len(); i++)
+			words[n++] = (unsigned int)(*oid)[i];
+		words[n++] = (unsigned int)bytes;
+		unsigned int pad = 0;
+		int padding = 4*MIB_IMAGE_WORDS(bytes) - bytes;
+		if ((fwrite(words, sizeof(unsigned int), n, f) != n) ||
+		    ((int)fwrite(buf, sizeof(char), bytes, f) != bytes) ||
+		    ((int)fwrite(&pad, sizeof(char), padding, f) != padding))
+			ok = FALSE;
+		size += 4*n + bytes + padding;
+		entries++;
+		delete [] buf;
+	}
+	memcpy(header, MIB_IMAGE_MAGIC, MIB_IMAGE_MAGIC_LEN);
+	header[2] = MIB_IMAGE_BYTE_ORDER;
+	header[3] = MIB_IMAGE_VERSION;
+	header[4] = entries;
+	header[5] = (unsigned int)size;
+	if ((fseek(f, 0, SEEK_SET) != 0) ||
+	    (fwrite(header, sizeof(char), MIB_IMAGE_HEADER_LEN, f) !=
+	     MIB_IMAGE_HEADER_LEN))
+		ok = FALSE;
+	ok = AgentTools::sync_file(f) && ok;
+	ok = (fclose(f) == 0) && ok;
+	if ((ok) && (!AgentTools::replace_file(tmpname, fname))) {
+		ok = FALSE;
+	}
+	if (!ok) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibGroup: Saving image failed (file)");
+		LOG(fname);
+		LOG_END;
+		remove(tmpname);
+	}
+	else {
+		LOG_BEGIN(loggerModuleName, INFO_LOG | 3);
+		LOG("MibGroup: Saved image (file)(objects)(size)");
+		LOG(fname);
+		LOG(entries);
+		LOG(size);
+		LOG_END;
+	}
+	delete [] tmpname;
+	return ok;
+}
+
+bool MibGroup::load_image(const char* fname)
+{
+	long size = 0;
+	const char* data = AgentTools::map_file(fname, size);
+	if (!data) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibGroup: Cannot map image (file)");
+		LOG(fname);
+		LOG_END;
+		return FALSE;
+	}
+	const unsigned int* wp = (const unsigned int*)data;
+	const unsigned int* end = wp + size/4;
+	if ((size < MIB_IMAGE_HEADER_LEN) ||
+	    (memcmp(data, MIB_IMAGE_MAGIC, MIB_IMAGE_MAGIC_LEN) != 0) ||
+	    (wp[2] != MIB_IMAGE_BYTE_ORDER) ||
+	    (wp[3] != MIB_IMAGE_VERSION) || (wp[5] != (unsigned long)size)) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibGroup: Image has wrong version, byte order, or size (file)(size)");
+		LOG(fname);
+		LOG(size);
+		LOG_END;
+		AgentTools::unmap_file(data, size);
+		return FALSE;
+	}
+	unsigned int entries = wp[4];
+	wp += MIB_IMAGE_HEADER_LEN/4;
+	bool ok = TRUE;
+	Oidx oid;
+	unsigned long subids[MAX_OID_LEN];
+	for (unsigned int e=0; ((e<entries) && (ok)); e++) {
+		if ((wp >= end) || (wp[0] > MAX_OID_LEN) ||
+		    (end - wp < (long)wp[0]+2)) {
+			ok = FALSE;
+			break;
+		}
+		unsigned int n = *wp++;
+		for (unsigned int i=0; i<n; i++) subids[i] = *wp++;
+		oid.set_data(subids, n);
+		unsigned int bytes = *wp++;
+		if ((unsigned long)bytes > 4UL*(unsigned long)(end - wp)) {
+			ok = FALSE;
+			break;
+		}
+		MibEntry* entry = 0;
+		ListCursor<MibEntry> cur;
+		for (cur.init(&content); cur.get(); cur.next()) {
+			if (*cur.get()->key() == oid) {
+				entry = cur.get();
+				break;
+			}
+		}
+		if ((entry) && (!entry->is_volatile())) {
+			if (!entry->deserialize_image((const char*)wp, bytes)) {
+				LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+				LOG("MibGroup: Loading object from image failed (file)(oid)");
+				LOG(fname);
+				LOG(oid.get_printable());
+				LOG_END;
+			}
+		}
+		else {
+			LOG_BEGIN(loggerModuleName, WARNING_LOG | 2);
+			LOG("MibGroup: Image contains unknown or volatile object (file)(oid)");
+			LOG(fname);
+			LOG(oid.get_printable());
+			LOG_END;
+		}
+		wp += MIB_IMAGE_WORDS(bytes);
+	}
+	if (!ok) {
+		LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+		LOG("MibGroup: Image is corrupt (file)");
+		LOG(fname);
+		LOG_END;
+	}
+	AgentTools::unmap_file(data, size);
+	return ok;
+}
+
 
 /*--------------------------- class MibContext --------------------------*/
 
@@ -246,6 +464,7 @@ MibContext::MibContext()
 	context = "";
 	contextKey = Oidx::from_string(context);
 	persistencyPath = 0;
+	indexValid = FALSE;
 }
 
 MibContext::MibContext(const OctetStr& c)
@@ -253,6 +472,7 @@ MibContext::MibContext(const OctetStr& c)
 	context = c;
 	contextKey = Oidx::from_string(c);
 	persistencyPath = 0;
+	indexValid = FALSE;
 }
 
 MibContext::~MibContext()
@@ -330,11 +550,19 @@ OidxPtr MibContext::key()
 	return &contextKey;
 }
 
+const OidIndex<MibEntry>& MibContext::get_index()
+{
+	if (!indexValid) {
+		index.rebuild(&content);
+		indexValid = TRUE;
+	}
+	return index;
+}
+
 int MibContext::find(const Oidx& oid, MibEntryPtr& entry)
 TS_SYNCHRONIZED(
 {
-	Oidx tmpoid(oid);
-	MibEntry* e = content.find(&tmpoid);
+	MibEntry* e = get_index().find(oid);
 	if (!e) return sNMP_SYNTAX_NOSUCHOBJECT;
 	entry = e;
 	return SNMP_ERROR_SUCCESS;
@@ -351,8 +579,7 @@ TS_SYNCHRONIZED(
 int MibContext::find_lower(const Oidx& oid, MibEntryPtr& entry)
 TS_SYNCHRONIZED(
 {
-	Oidx tmpoid(oid);
-	MibEntry* e = content.find_lower(&tmpoid);
+	MibEntry* e = get_index().find_lower(oid);
 	if (!e) return sNMP_SYNTAX_NOSUCHOBJECT;
 	entry = e;
 	return SNMP_ERROR_SUCCESS;
@@ -361,8 +588,7 @@ TS_SYNCHRONIZED(
 int MibContext::find_upper(const Oidx& oid, MibEntryPtr& entry)
 TS_SYNCHRONIZED(
 {
-	Oidx tmpoid(oid);
-	MibEntry* e = content.find_upper(&tmpoid);
+	MibEntry* e = get_index().find_upper(oid);
 	if (!e) return sNMP_SYNTAX_NOSUCHOBJECT;
 	entry = e;
 	return SNMP_ERROR_SUCCESS;
@@ -371,8 +597,7 @@ TS_SYNCHRONIZED(
 MibEntry* MibContext::find_next(const Oidx& oid)
 TS_SYNCHRONIZED(
 {
-	Oidx tmpoid(oid);
-	return content.find_next(&tmpoid);
+	return get_index().find_next(oid);
 })
 
 OidListCursor<MibEntry>  MibContext::get_content()
@@ -430,8 +655,9 @@ MibEntry* MibContext::add(MibEntry* item)
 		groups.add(mg);
 	}
 	else {
-		return content.add(item);
+		content.add(item);
 	}
+	invalidate_index();
 	return item;
 }
 
@@ -440,7 +666,10 @@ TS_SYNCHRONIZED(
 {
 	Oidx tmpoid(oid);
 	MibEntry* victim = content.find(&tmpoid);
-	if (victim) return content.remove(victim);
+	if (victim) {
+		invalidate_index();
+		return content.remove(victim);
+	}
 	return 0;
 })
 
@@ -448,8 +677,7 @@ TS_SYNCHRONIZED(
 MibEntry* MibContext::get(const Oidx& oid)
 TS_SYNCHRONIZED(
 {
-	Oidx tmpoid(oid);
-	return content.find(&tmpoid);
+	return get_index().find(oid);
 })
 
 MibGroup* MibContext::find_group(const Oidx& oid)
@@ -471,6 +699,7 @@ TS_SYNCHRONIZED(
 				delete content.remove(v);
 		}
 		delete groups.remove(victim);
+		invalidate_index();
 		return TRUE;
 	}
 	return FALSE;
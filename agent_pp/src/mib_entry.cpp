@@ -237,12 +237,20 @@ void MibEntry::save_to_file(const char* fname)
 	int bytes;
 
 	if (serialize(buf, bytes)) {
-		if ((f = fopen(fname, "wb")) == 0) {
+		// write a temporary file and replace the old one when complete
+		char* tmpname = AgentTools::make_concatenation(fname, ".tmp");
+		if ((f = fopen(tmpname, "wb")) == 0) {
+			delete [] tmpname;
 			delete [] buf;
 			return;
 		}
-		fwrite(buf, sizeof(char), bytes, f);
-		fclose(f);
+		bool ok = ((int)fwrite(buf, sizeof(char), bytes, f) == bytes);
+		ok = AgentTools::sync_file(f) && ok;
+		ok = (fclose(f) == 0) && ok;
+		if ((!ok) || (!AgentTools::replace_file(tmpname, fname))) {
+			remove(tmpname);
+		}
+		delete [] tmpname;
 		delete [] buf;
 	}
 }
@@ -257,6 +265,22 @@ bool MibEntry::deserialize(char*, int&)
 	return FALSE;
 }
 
+bool MibEntry::serialize_image(char*& buf, int& sz)
+{
+	return serialize(buf, sz);
+}
+
+bool MibEntry::deserialize_image(const char* buf, int sz)
+{
+	// deserialize does not promise to leave its input untouched
+	char* copy = new char[sz > 0 ? sz : 1];
+	memcpy(copy, buf, sz);
+	int len = sz;
+	bool ok = deserialize(copy, len);
+	delete[] copy;
+	return ok;
+}
+
 bool MibEntry::is_volatile()
 {
 	return FALSE;
@@ -41,6 +41,105 @@ namespace Agentpp {
 
 static const char *loggerModuleName = "agent++.notification_originator";
 
+#ifdef _THREADS
+/*-------------------- class NotificationQueue -------------------------*/
+
+NotificationQueue::NotificationQueue(int max)
+{
+	maxLength = max;
+	length = 0;
+	go = TRUE;
+	start();
+}
+
+NotificationQueue::~NotificationQueue()
+{
+	lock();
+	go = FALSE;
+	notify();
+	unlock();
+	// remaining tasks are run before the thread ends
+	if (is_alive()) join();
+	pending.clearAll();
+}
+
+void NotificationQueue::run()
+{
+	lock();
+	while ((go) || (!pending.empty())) {
+		Runnable* task = pending.removeFirst();
+		if (task) {
+			length--;
+			unlock();
+			task->run();
+			delete task;
+			lock();
+		}
+		else {
+			wait();
+		}
+	}
+	unlock();
+}
+
+bool NotificationQueue::add(Runnable* task)
+{
+	lock();
+	if (length >= maxLength) {
+		unlock();
+		delete task;
+		return FALSE;
+	}
+	pending.addLast(task);
+	length++;
+	notify();
+	unlock();
+	return TRUE;
+}
+
+int NotificationQueue::size()
+{
+	lock();
+	int n = length;
+	unlock();
+	return n;
+}
+
+/**
+ * A notification copied for being sent by a NotificationQueue.
+ */
+class QueuedNotification: public Runnable {
+ public:
+	QueuedNotification(NotificationOriginator* o, Vbx* v, int s,
+			   const Oidx& i, unsigned int t, const Oidx& e,
+			   const OctetStr& c):
+	  originator(o), size(s), id(i), timestamp(t), enterprise(e),
+	  contextName(c)
+	{
+		// deep copy, the caller may delete its variable bindings
+		// before the notification is sent
+		vbs = (s > 0) ? new Vbx[s] : 0;
+		for (int j=0; j<s; j++)
+			vbs[j] = v[j];
+	}
+	virtual ~QueuedNotification() { if (vbs) delete[] vbs; }
+
+	virtual void run() {
+		originator->send_notifications(vbs, size, id, timestamp,
+					       enterprise, contextName);
+	}
+
+ private:
+	NotificationOriginator*	originator;
+	Vbx*			vbs;
+	int			size;
+	Oidx			id;
+	unsigned int		timestamp;
+	Oidx			enterprise;
+	OctetStr		contextName;
+};
+#endif
+
 /*------------------ class NotificationOriginator -----------------------*/
 
 NotificationOriginator::NotificationOriginator()
@@ -59,11 +158,22 @@ NotificationOriginator::NotificationOriginator()
         _nlmLogEntry = 0;
         v3mp = 0;
 #endif
+#ifdef _THREADS
+        notificationQueue = 0;
+#endif
+        routing = 0;
         mib = Mib::instance;        
 }
 
 NotificationOriginator::~NotificationOriginator()
 {
+#ifdef _THREADS
+	// send queued notifications while the references are valid
+	if (notificationQueue)
+		delete notificationQueue;
+#endif
+	if (routing)
+		delete routing;
 #ifdef _SNMPv3
 	if (localEngineID)
 		delete localEngineID;
@@ -94,23 +204,65 @@ int NotificationOriginator::notify(const OctetStr& context,
 	return generate(vbs, sz, oid, timestamp, Oidx(), context);
 }
 
+void NotificationOriginator::set_async(bool async)
+{
+#ifdef _THREADS
+	if ((async) && (!notificationQueue)) {
+		notificationQueue = new NotificationQueue();
+	}
+	else if ((!async) && (notificationQueue)) {
+		NotificationQueue* queue = notificationQueue;
+		notificationQueue = 0;
+		delete queue;
+	}
+#endif
+}
+
+bool NotificationOriginator::is_async() const
+{
+#ifdef _THREADS
+	return (notificationQueue != 0);
+#else
+	return FALSE;
+#endif
+}
+
 int NotificationOriginator::generate(Vbx* vbs, int size, const Oidx& id,
 				     unsigned int timestamp,
 				     const Oidx& enterprise,
 				     const OctetStr& contextName)
+{
+#ifdef _THREADS
+	NotificationQueue* queue = notificationQueue;
+	if (queue) {
+		if (!queue->add(new QueuedNotification(this, vbs, size, id,
+						       timestamp, enterprise,
+						       contextName))) {
+			LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+			LOG("NotificationOriginator: queue full, notification dropped (id)");
+			LOG(id.get_printable());
+			LOG_END;
+			return SNMP_ERROR_RESOURCE_UNAVAIL;
+		}
+		return SNMP_ERROR_SUCCESS;
+	}
+#endif
+	return send_notifications(vbs, size, id, timestamp, enterprise,
+				  contextName);
+}
+
+int NotificationOriginator::send_notifications(Vbx* vbs, int size,
+					       const Oidx& id,
+					       unsigned int timestamp,
+					       const Oidx& enterprise,
+					       const OctetStr& contextName)
 {
 	// We have to be careful here about synchronization because,
 	// we may be called after an interrupt
-	// Therefore synch everything or use synch methods like
-	// MibTable::get_rows_cloned();
-	List<MibTableRow>* typeList =
-	  get_snmp_notify_entry()->get_rows_cloned();
-	ListCursor<MibTableRow> typeCur;
-
-	List<MibTableRow>* list =
-	  get_snmp_target_addr_entry()->get_rows_cloned();
-	ListCursor<MibTableRow> cur;
-
+	// Therefore the routes are taken from a routing table that is
+	// compiled from cloned rows (see compile_routes)
+	NotificationRoutingTable* table = 0;
+	NotificationRouteList* routes = get_routes(id, table);
 
 #ifdef _SNMPv3
 	if (!localEngineID) {
@@ -135,6 +287,137 @@ int NotificationOriginator::generate(Vbx* vbs, int size, const Oidx& id,
                                         *localEngineID);
 	}
 #endif
+	if (routes) {
+		for (int i=0; i<routes->routes.size(); i++) {
+			NotificationRoute* route = routes->routes.getNth(i);
+
+			nop.target = 0;
+			if (check_access(route, nop)) {
+				int status = send_notify(route, nop);
+				if (status != SNMP_ERROR_SUCCESS)
+					totalStatus = status;
+				delete nop.target;
+			}
+		}
+	}
+	if (table)
+		release_routes(table);
+
+	return totalStatus;
+}
+
+unsigned long NotificationOriginator::get_routing_stamp()
+{
+	unsigned long stamp = 0;
+	snmpTargetAddrEntry* targetAddrEntry = get_snmp_target_addr_entry();
+	if (targetAddrEntry)
+		stamp += targetAddrEntry->get_change_count();
+	snmpTargetParamsEntry* targetParamsEntry =
+	  get_snmp_target_params_entry();
+	if (targetParamsEntry)
+		stamp += targetParamsEntry->get_change_count();
+	snmpNotifyEntry* notifyEntry = get_snmp_notify_entry();
+	if (notifyEntry)
+		stamp += notifyEntry->get_change_count();
+	snmpNotifyFilterEntry* notifyFilterEntry =
+	  get_snmp_notify_filter_entry();
+	if (notifyFilterEntry) {
+		stamp += notifyFilterEntry->get_change_count();
+		if (notifyFilterEntry->get_profile_entry())
+			stamp += notifyFilterEntry->get_profile_entry()->
+			  get_change_count();
+	}
+	return stamp;
+}
+
+NotificationRouteList* NotificationOriginator::get_routes(const Oidx& id,
+					NotificationRoutingTable*& table)
+{
+	table = 0;
+	snmpNotifyFilterEntry* notifyFilterEntry =
+	  get_snmp_notify_filter_entry();
+	if ((!get_snmp_target_addr_entry()) || (!get_snmp_notify_entry()) ||
+	    (!notifyFilterEntry))
+		return 0;
+
+	// read the stamp before the tables, a change while compiling
+	// then causes another compilation for the next notification
+	unsigned long stamp = get_routing_stamp();
+
+	routingLock.start_synch();
+	if ((routing) && (routing->stamp == stamp)) {
+		table = routing;
+		table->references++;
+	}
+	routingLock.end_synch();
+
+	if (!table) {
+		// compile without holding routingLock, the table locks
+		// are acquired while compiling
+		NotificationRoutingTable* compiled = compile_routes(stamp);
+		routingLock.start_synch();
+		NotificationRoutingTable* old = routing;
+		routing = compiled;
+		if ((old) && (old->references == 0))
+			delete old;
+		table = routing;
+		table->references++;
+		routingLock.end_synch();
+	}
+
+	routingLock.start_synch();
+	NotificationRouteList* routes = table->lists.find(OidxView(id));
+	routingLock.end_synch();
+	if (routes)
+		return routes;
+
+	// the routes of a table do not change, only the filter needs
+	// to be evaluated for a new notification OID
+	NotificationRouteList* list = new NotificationRouteList(id);
+	for (int i=0; i<table->routes.size(); i++) {
+		NotificationRoute* route = table->routes.getNth(i);
+		if ((route->filtered) &&
+		    (!notifyFilterEntry->passes_filter(route->params, id, 0, 0))) {
+			LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
+			LOG("NotificationOriginator: generate: event did not pass notification filter (trapoid)(filter)");
+			LOG(Oidx(id).get_printable());
+			LOG(route->paramsName.get_printable());
+			LOG_END;
+			continue;
+		}
+		list->routes.add(route);
+	}
+	routingLock.start_synch();
+	routes = table->lists.find(OidxView(id));
+	if (routes)
+		delete list;
+	else
+		routes = table->lists.add(list);
+	routingLock.end_synch();
+	return routes;
+}
+
+void NotificationOriginator::release_routes(NotificationRoutingTable* table)
+{
+	routingLock.start_synch();
+	table->references--;
+	if ((table != routing) && (table->references == 0))
+		delete table;
+	routingLock.end_synch();
+}
+
+NotificationRoutingTable* NotificationOriginator::compile_routes(unsigned long stamp)
+{
+	NotificationRoutingTable* table = new NotificationRoutingTable(stamp);
+
+	List<MibTableRow>* typeList =
+	  get_snmp_notify_entry()->get_rows_cloned();
+	ListCursor<MibTableRow> typeCur;
+
+	List<MibTableRow>* list =
+	  get_snmp_target_addr_entry()->get_rows_cloned();
+	ListCursor<MibTableRow> cur;
+
 	for (cur.init(list); cur.get(); cur.next()) {
 
 	  int notify = NO_TRAP;
@@ -153,13 +436,10 @@ int NotificationOriginator::generate(Vbx* vbs, int size, const Oidx& id,
 			// determine notification type
 			typeCur.get()->get_nth(1)->get_value(notify);
 
-			nop.target = 0;
-			if (check_access(cur, nop)) {
-				int status = send_notify(cur, nop, notify);
-				if (status != SNMP_ERROR_SUCCESS)
-					totalStatus = status;
-				delete nop.target;
-			}
+			NotificationRoute* route =
+			  compile_route(cur.get(), notify);
+			if (route)
+				table->routes.add(route);
 		}
 		delete[] tagstr;
 	  }
@@ -176,7 +456,67 @@ int NotificationOriginator::generate(Vbx* vbs, int size, const Oidx& id,
 	list->clearAll();
 	delete list;
 
-	return totalStatus;
+	LOG_BEGIN(loggerModuleName, DEBUG_LOG | 4);
+	LOG("NotificationOriginator: compiled routing table (stamp)(routes)");
+	LOG(stamp);
+	LOG(table->routes.size());
+	LOG_END;
+
+	return table;
+}
+
+NotificationRoute* NotificationOriginator::compile_route(MibTableRow* row,
+							 int notify)
+{
+	snmpTargetAddrParams* paramsPtr =
+	  (snmpTargetAddrParams*)row->get_nth(5);
+	OctetStr paramsStr;
+	paramsPtr->get_value(paramsStr);
+
+	snmpTargetParamsEntry* targetParamsEntry = get_snmp_target_params_entry();
+	if (!targetParamsEntry) {
+		return 0;
+	}
+	targetParamsEntry->start_synch();
+	MibTableRow* paramsRow =
+	  targetParamsEntry->find_index(Oidx::from_string(paramsStr, FALSE));
+
+	if ((!paramsRow) ||
+	    (paramsRow->get_row_status()->get() != rowActive)) {
+
+		targetParamsEntry->end_synch();
+		LOG_BEGIN(loggerModuleName, WARNING_LOG | 3);
+		LOG("NotificationOriginator: generate: target addr parameter row not found.");
+		LOG(paramsStr.get_printable());
+		LOG((paramsRow) ? "no active row found" : "missing row");
+		LOG_END;
+		return 0;
+	}
+
+	NotificationRoute* route = new NotificationRoute();
+	paramsRow->get_nth(0)->get_value(route->mpModel);
+	paramsRow->get_nth(2)->get_value(route->securityName);
+	paramsRow->get_nth(1)->get_value(route->securityModel);
+	paramsRow->get_nth(3)->get_value(route->securityLevel);
+
+	targetParamsEntry->end_synch();
+
+	route->address = get_snmp_target_addr_entry()->get_address(row);
+	if (!route->address) {
+		delete route;
+		return 0;
+	}
+	route->notifyType = notify;
+	route->targetDomain =
+	  ((snmpTargetAddrTDomain*)row->first())->get_state();
+	route->timeout = ((SnmpInt32MinMax*)row->get_nth(2))->get_state();
+	route->retries = ((SnmpInt32MinMax*)row->get_nth(3))->get_state();
+	row->get_nth(1)->get_value(route->targetAddress);
+	route->paramsName = paramsStr;
+	route->params = Oidx::from_string(paramsStr, FALSE);
+	route->filtered =
+	  get_snmp_notify_filter_entry()->has_filter(route->params);
+	return route;
 }
 
 snmpTargetAddrEntry* NotificationOriginator::get_snmp_target_addr_entry() {
@@ -256,7 +596,7 @@ v3MP* NotificationOriginator::get_v3mp() {
 #endif
 
 
-bool NotificationOriginator::check_access(ListCursor<MibTableRow>& cur,
+bool NotificationOriginator::check_access(NotificationRoute* route,
 		NotificationOriginatorParams& nop)
 {
 	Vbx*& vbs = nop.vbs;
@@ -273,55 +613,28 @@ bool NotificationOriginator::check_access(ListCursor<MibTableRow>& cur,
 	CTarget*& target = nop.target;
 #endif
 
-	  snmpTargetAddrParams* paramsPtr =
-	    (snmpTargetAddrParams*)cur.get()->get_nth(5);
-	  OctetStr paramsStr;
-	  paramsPtr->get_value(paramsStr);
-
-	  // Check whether trap oid passes filter
-	  Oidx targetOid(Oidx::from_string(paramsStr, FALSE));
-          snmpNotifyFilterEntry* notifyFilterEntry =
-                  get_snmp_notify_filter_entry();
-	  if (!notifyFilterEntry || 
-                  !notifyFilterEntry->passes_filter(targetOid, id, vbs, size)) {
-
-		LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
-		LOG("NotificationOriginator: generate: event did not pass notification filter (trapoid)(filter)");
-		LOG(Oidx(id).get_printable());
-		LOG(paramsStr.get_printable());
-		LOG_END;
-		return FALSE;
-	  }
-
-	  OctetStr targetAddress;
-	  cur.get()->get_nth(1)->get_value(targetAddress);
-
-          snmpTargetParamsEntry* targetParamsEntry = get_snmp_target_params_entry();
-          if (!targetParamsEntry) {
-              return FALSE;
-          }
-	  targetParamsEntry->start_synch();
-	  MibTableRow* paramsRow =
-	    targetParamsEntry->find_index(Oidx::from_string(paramsStr, FALSE));
-
-	  if ((!paramsRow) ||
-	      (paramsRow->get_row_status()->get() != rowActive)) {
-
-	    targetParamsEntry->end_synch();
-	    LOG_BEGIN(loggerModuleName, WARNING_LOG | 3);
-	    LOG("NotificationOriginator: generate: target addr parameter row not found.");
-	    LOG(paramsStr.get_printable());
-	    LOG((paramsRow) ? "no active row found" : "missing row");
-	    LOG_END;
-	    return FALSE;
+	  // Check whether the variable bindings pass the filter, the
+	  // notification OID has been checked when the routes were selected
+	  if ((route->filtered) && (size > 0)) {
+		snmpNotifyFilterEntry* notifyFilterEntry =
+		  get_snmp_notify_filter_entry();
+		if (!notifyFilterEntry ||
+		    !notifyFilterEntry->passes_filter(route->params, id,
+						      vbs, size)) {
+
+			LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
+			LOG("NotificationOriginator: generate: event did not pass notification filter (trapoid)(filter)");
+			LOG(Oidx(id).get_printable());
+			LOG(route->paramsName.get_printable());
+			LOG_END;
+			return FALSE;
+		}
 	  }
 
-	  paramsRow->get_nth(0)->get_value(mpModel);
-	  paramsRow->get_nth(2)->get_value(securityName);
-	  paramsRow->get_nth(1)->get_value(securityModel);
-	  paramsRow->get_nth(3)->get_value(securityLevel);
-
-	  targetParamsEntry->end_synch();
+	  mpModel = route->mpModel;
+	  securityName = route->securityName;
+	  securityModel = route->securityModel;
+	  securityLevel = route->securityLevel;
 
 	  bool accessAllowed = TRUE;
 #ifdef _SNMPv3
@@ -359,36 +672,25 @@ bool NotificationOriginator::check_access(ListCursor<MibTableRow>& cur,
 	    LOG_BEGIN(loggerModuleName, EVENT_LOG | 2);
 	    LOG("Notification not sent (reason) (addr) (params)");
 	    LOG("no access");
-	    LOG(targetAddress.get_printable());
-	    LOG(paramsStr.get_printable());
+	    LOG(route->targetAddress.get_printable());
+	    LOG(route->paramsName.get_printable());
 	    LOG_END;
 
 	    return FALSE;
 	  }
 
-	  target = 0;
-          snmpTargetAddrEntry* targetAddrEntry = get_snmp_target_addr_entry();
-          if (targetAddrEntry) {
-            Address* address =
-              targetAddrEntry->get_address(cur.get());
-            if (address) {
-    #ifdef _SNMPv3
-                  target = new UTarget(*address, securityName, securityModel);
-    #else
-                  target = new CTarget(*address, securityName, securityName);
-    #endif
-                  delete address;
-            }
-            else return FALSE;
-          }
-          else return FALSE;
+#ifdef _SNMPv3
+	  target = new UTarget(*route->address, securityName, securityModel);
+#else
+	  target = new CTarget(*route->address, securityName, securityName);
+#endif
 
 	  return TRUE;
 }
 
 
-int NotificationOriginator::send_notify(ListCursor<MibTableRow>& cur,
-		NotificationOriginatorParams& nop, int notify)
+int NotificationOriginator::send_notify(NotificationRoute* route,
+		NotificationOriginatorParams& nop)
 {
 	Vbx*& vbs = nop.vbs;
 	int& size = nop.size;
@@ -405,8 +707,8 @@ int NotificationOriginator::send_notify(ListCursor<MibTableRow>& cur,
 	CTarget*& target = nop.target;
 #endif
 
-	long targetDomain;
-	targetDomain = ((snmpTargetAddrTDomain*)cur.get()->first())->get_state();
+	int notify = route->notifyType;
+	long targetDomain = route->targetDomain;
 
 	Oidx trapoid(id);
 #ifdef _SNMPv3
@@ -479,14 +781,16 @@ int NotificationOriginator::send_notify(ListCursor<MibTableRow>& cur,
 		target->set_version(version2c);
 
 	    if (notify != TRAP) {
-		target->set_retry(((SnmpInt32MinMax*)
-				   cur.get()->get_nth(3))->get_state());
-		target->set_timeout(((SnmpInt32MinMax*)
-				     cur.get()->get_nth(2))->get_state());
+		target->set_retry(route->retries);
+		target->set_timeout(route->timeout);
 	    }
 
 #ifdef _SNMPv3
-	    status = SnmpRequestV3::send(*target, pdu);
+	    if ((notify != TRAP) && (is_async()))
+		status = SnmpRequestV3::send_async((mib) ? mib : Mib::instance,
+						   *target, pdu);
+	    else
+		status = SnmpRequestV3::send(*target, pdu);
             nlmLogEntry* logEntry = get_nlm_log_entry();
 	    if (logEntry) {
                 OctetStr ceid;
@@ -495,8 +799,12 @@ int NotificationOriginator::send_notify(ListCursor<MibTableRow>& cur,
                                    *localEngineID);
 	    }
 #else
-	    status = SnmpRequest::process_trap(*target, vbs, size, id, enterprise,
-				      (notify != TRAP));
+	    if ((notify != TRAP) && (is_async()))
+		status = SnmpRequest::inform(*target, vbs, size, id);
+	    else
+		status = SnmpRequest::process_trap(*target, vbs, size, id,
+						   enterprise,
+						   (notify != TRAP));
 #endif
 
 	    GenAddress address;
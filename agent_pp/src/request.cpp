@@ -56,13 +56,13 @@ namespace Agentpp {
 #ifdef _THREADS
             Synchronized(),
 #endif
-            pdu(0), originalVbs(0), originalSize(0), from(), done(0), ready(0), outstanding(0), size(0), non_rep(0),
-            max_rep(0), repeater(0), version(), transaction_id(0), locks()
+            pdu(0), originalVbs(0), originalSize(0), from(), done(0), ready(0), outstanding(0), size(0), allocated(0),
+            vbsLength(-1), non_rep(0), max_rep(0), repeater(0), version(), transaction_id(0), locks()
 #ifdef _SNMPv3
             , viewName(), vacm(0)
 #endif
             , target() {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         init_lock_queue();
 #endif
     }
@@ -72,13 +72,13 @@ namespace Agentpp {
 #ifdef _THREADS
             Synchronized(),
 #endif
-            pdu(0), originalVbs(0), originalSize(0), from(), done(0), ready(0), outstanding(0), size(0), non_rep(0),
-            max_rep(0), repeater(0), version(), transaction_id(0), locks()
+            pdu(0), originalVbs(0), originalSize(0), from(), done(0), ready(0), outstanding(0), size(0), allocated(0),
+            vbsLength(-1), non_rep(0), max_rep(0), repeater(0), version(), transaction_id(0), locks()
 #ifdef _SNMPv3
             , viewName(), vacm(0)
 #endif
             , target(t) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         init_lock_queue();
 #endif
         pdu = p.clone();
@@ -92,6 +92,7 @@ namespace Agentpp {
 
     void Request::init_from_pdu() {
         size = pdu->get_vb_count();
+        allocated = size;
         done = new bool[size];
         ready = new bool[size];
         originalVbs = new Vbx[size];
@@ -113,10 +114,25 @@ namespace Agentpp {
                 trim_request(non_rep);
             }
             repeater = size - non_rep;
+
+            // The response cannot hold more than max_rep repetitions
+            // and not more variable bindings than fit into the largest
+            // message, so make room for them in advance.
+            if ((repeater > 0) && (max_rep > 1)) {
+                long count = non_rep + (long) max_rep * repeater;
+                if (count > AGENTPP_MAX_BULK_SUBREQUESTS)
+                    count = AGENTPP_MAX_BULK_SUBREQUESTS;
+                reserve_subrequests((int) count);
+            }
+            vbsLength = 0;
+            for (int i = 0; i < size; i++) {
+                vbsLength += (*pdu)[i].get_asn1_length();
+            }
         } else {
             repeater = 0;
             non_rep = size;
             max_rep = 0;
+            vbsLength = -1;
         }
         // must be placed here because trim() could have decreased size!
         outstanding = size;
@@ -130,7 +146,7 @@ namespace Agentpp {
     }
 
     Request::Request(const Request &other) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         init_lock_queue();
 #endif
         pdu = other.pdu->clone();
@@ -146,6 +162,8 @@ namespace Agentpp {
             ready[j] = other.ready[j];
         }
         size = other.size;
+        allocated = other.size;
+        vbsLength = other.vbsLength;
         outstanding = other.outstanding;
         non_rep = other.non_rep;
         max_rep = other.max_rep;
@@ -169,7 +187,7 @@ namespace Agentpp {
             set_unlocked(i);
         }
         locks.clear();
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         // There may be some locks acquired on behalf of this
         // request that may block another SET request that has
         // acquired locks through the lock queue. So we notify
@@ -322,7 +340,7 @@ namespace Agentpp {
             if (!done[i]) outstanding--;
             check_exception(i, vbl);
             done[i] = TRUE;
-            pdu->set_vb(vbl, i);
+            update_vb(vbl, i);
 
             LOG_BEGIN(loggerModuleName, EVENT_LOG | 3);
                     LOG("RequestList: finished subrequest (ind)(oid)(val)(syn)");
@@ -342,10 +360,14 @@ namespace Agentpp {
         if (pdu->get_type() == sNMP_PDU_GETBULK) {
             pdu->set_vblist(originalVbs, originalSize);
             pdu->set_error_status(SNMP_ERROR_GENERAL_VB_ERR);
+            vbsLength = 0;
+            for (int i = 0; i < originalSize; i++) {
+                vbsLength += originalVbs[i].get_asn1_length();
+            }
         } else {
             if (((index >= 0) && (index < size)) && (index < originalSize)) {
                 // restore original variable binding
-                pdu->set_vb(originalVbs[index], index);
+                update_vb(originalVbs[index], index);
             }
         }
     }
@@ -478,9 +500,33 @@ namespace Agentpp {
         Vbx vb;
         pdu->get_vb(vb, i);
         vb.set_oid(o);
+        update_vb(vb, i);
+    }
+
+    void Request::update_vb(const Vbx &vb, int i) {
+        if ((vbsLength >= 0) && (i >= 0) && (i < pdu->get_vb_count())) {
+            vbsLength += vb.get_asn1_length() - (*pdu)[i].get_asn1_length();
+        }
         pdu->set_vb(vb, i);
     }
 
+    void Request::reserve_subrequests(int count) {
+        if (count <= allocated) return;
+        pdu->reserve(count);
+
+        bool *old_done = done;
+        bool *old_ready = ready;
+        done = new bool[count];
+        ready = new bool[count];
+        for (int j = 0; j < size; j++) {
+            done[j] = old_done[j];
+            ready[j] = old_ready[j];
+        }
+        delete[] old_done;
+        delete[] old_ready;
+        allocated = count;
+    }
+
 /**
  * Add a repetition row to the GETBULK request PDU.
  *
@@ -492,42 +538,36 @@ namespace Agentpp {
         int rows = (pdu->get_vb_count() - non_rep) / repeater;
         if (rows == 0) return FALSE;
 
-        if (pdu->get_asn1_length() >= get_max_response_length())
+        int maxLength = get_max_response_length();
+        if (pdu->get_asn1_length_for_vbs(vbsLength) >= maxLength)
             return FALSE;
 
-        Vbx vb;
-        for (int i = (rows - 1) * repeater + non_rep; i < (rows * repeater) + non_rep; i++) {
-
-            pdu->get_vb(vb, i);
-            *pdu += vb;
-            // check if there was room for another vb
-            // obsolete: if (pdu->get_vb_count() == sz) return FALSE;
+        // the new row starts as a copy of the last row, so check if
+        // there is room for a row of the same length
+        int first = (rows - 1) * repeater + non_rep;
+        int rowLength = 0;
+        for (int i = first; i < first + repeater; i++) {
+            rowLength += (*pdu)[i].get_asn1_length();
         }
-
-        if (pdu->get_asn1_length() > get_max_response_length()) {
-            for (int i = 0; i < repeater; i++)
-                pdu->trim();
+        if (pdu->get_asn1_length_for_vbs(vbsLength + rowLength) > maxLength)
             return FALSE;
-        }
-
-        size = pdu->get_vb_count();
-        outstanding += repeater;
-        bool *old_done = done;
-        bool *old_ready = ready;
-        done = new bool[size];
-        ready = new bool[size];
 
-        int j;
-        for (j = 0; j < size - repeater; j++) {
-            done[j] = old_done[j];
-            ready[j] = old_ready[j];
+        if (size + repeater > allocated) {
+            reserve_subrequests((allocated * 2 > size + repeater) ?
+                                allocated * 2 : size + repeater);
+        }
+        for (int i = first; i < first + repeater; i++) {
+            // the vbs array is not reallocated while appending
+            *pdu += (*pdu)[i];
         }
-        for (; j < size; j++) {
+        vbsLength += rowLength;
+
+        for (int j = size; j < size + repeater; j++) {
             done[j] = FALSE;
             ready[j] = FALSE;
         }
-        delete[] old_done;
-        delete[] old_ready;
+        size = pdu->get_vb_count();
+        outstanding += repeater;
         return TRUE;
     }
 
@@ -544,6 +584,11 @@ namespace Agentpp {
     }
 
     void Request::trim_request(int count) {
+        if ((vbsLength >= 0) && (count >= 0)) {
+            for (int i = count; i < pdu->get_vb_count(); i++) {
+                vbsLength -= (*pdu)[i].get_asn1_length();
+            }
+        }
         if (pdu->trim(pdu->get_vb_count() - count))
             size = pdu->get_vb_count();
     }
@@ -600,7 +645,7 @@ namespace Agentpp {
             locks.add(0);
         }
         if (lock_index(entry) < 0) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
             LockRequest r(entry);
             lockQueue->acquire(&r);
             r.wait();
@@ -615,7 +660,7 @@ namespace Agentpp {
                         ((MibTable *) entry)->get_listeners();
                 for (; cur->get(); cur->next()) {
                     if (lock_index(cur->get()) < 0) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
                         LockRequest r(cur->get());
                         lockQueue->acquire(&r);
                         r.wait();
@@ -643,7 +688,7 @@ namespace Agentpp {
                             ((MibTable *) entry)->get_listeners();
                     for (; cur->get(); cur->next()) {
                         if (lock_index(cur->get()) < 0) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
                             LockRequest r(cur->get());
                             lockQueue->release(&r);
                             r.wait();
@@ -654,7 +699,7 @@ namespace Agentpp {
                     }
                     delete cur;
                 }
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
                 LockRequest r(entry);
                 lockQueue->release(&r);
                 r.wait();
@@ -717,7 +762,7 @@ namespace Agentpp {
             , write_community(new OctetStr(DEFAULT_WRITE_COMMUNITY)),
               read_community(new OctetStr(DEFAULT_READ_COMMUNITY)), next_transaction_id(0),
               sourceAddressValidation(false) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         init_lock_queue();
 #endif
         mib = Mib::instance;
@@ -754,15 +799,58 @@ namespace Agentpp {
     }
 
     Request *RequestList::get_request(unsigned long rid) {
-        ListCursor<Request> cur;
-        for (cur.init(requests); cur.get(); cur.next()) {
-            if (cur.get()->get_transaction_id() == rid) {
-                return cur.get();
+        unsigned long h = HashIndex<Request>::mix(rid);
+        Pix pos;
+        for (Request *r = requestsByTransactionId.first(h, pos); r;
+             r = requestsByTransactionId.next(h, pos)) {
+            if (r->get_transaction_id() == rid) {
+                return r;
+            }
+        }
+        return 0;
+    }
+
+    Request *RequestList::find_request(unsigned long rid, const UdpAddress &from) {
+        unsigned long h = hash_source(rid, from);
+        Pix pos;
+        for (Request *r = requestsBySource.first(h, pos); r;
+             r = requestsBySource.next(h, pos)) {
+            if ((r->get_pdu()->get_request_id() == rid) &&
+                (same_source(r->from, from))) {
+                return r;
             }
         }
         return 0;
     }
 
+    unsigned long RequestList::hash_source(unsigned long rid, const UdpAddress &from) {
+        unsigned long h = rid;
+        int len = from.get_length();
+        for (int i = 0; i < len; i++) {
+            h = h * 31 + from[i];
+        }
+        return HashIndex<Request>::mix(h);
+    }
+
+    bool RequestList::same_source(const UdpAddress &a, const UdpAddress &b) {
+        int len = a.get_length();
+        if (len != b.get_length()) return FALSE;
+        for (int i = 0; i < len; i++) {
+            if (a[i] != b[i]) return FALSE;
+        }
+        return TRUE;
+    }
+
+    void RequestList::index_request(Request *req) {
+        requestsByTransactionId.add(HashIndex<Request>::mix(req->get_transaction_id()), req);
+        requestsBySource.add(hash_source(req->get_pdu()->get_request_id(), req->from), req);
+    }
+
+    void RequestList::unindex_request(Request *req) {
+        requestsByTransactionId.remove(HashIndex<Request>::mix(req->get_transaction_id()), req);
+        requestsBySource.remove(hash_source(req->get_pdu()->get_request_id(), req->from), req);
+    }
+
     Request *RequestList::find_request_on_id(unsigned long rid) {
         ListCursor<Request> cur;
         for (cur.init(requests); cur.get(); cur.next()) {
@@ -832,8 +920,7 @@ namespace Agentpp {
                     return TRUE;
                 else {
                     if (*read_community == community) {
-                        snmpInBadCommunityNames::incrementScalar(mib,
-                                                                 oidSnmpInBadCommunityNames);
+                        MibIIsnmpCounters::incInBadCommunityNames();
                     }
                     return FALSE;
                 }
@@ -852,6 +939,7 @@ namespace Agentpp {
         if (!req) return;
 
         requests->remove(req);
+        unindex_request(req);
 
 #ifdef _SNMPv3
         if (req->get_security_model() == version3) {
@@ -864,7 +952,7 @@ namespace Agentpp {
     }
 
     Synchronized::TryLockResult RequestList::trylock_request(Request *req) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         if (lockQueue) {
             LockRequest r(req);
             r.waitForLock = false;
@@ -876,30 +964,37 @@ namespace Agentpp {
                    Synchronized::LOCKED : Synchronized::BUSY;
         }
         return req->trylock();
+#elif defined(NO_FAST_MUTEXES)
+        return req->requestLock.try_acquire();
 #else
         return req->trylock();
 #endif
     }
 
     void RequestList::lock_request(Request *req) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         if (lockQueue) {
             LockRequest r(req);
             lockQueue->acquire(&r);
             r.wait();
         }
+#elif defined(NO_FAST_MUTEXES)
+        req->requestLock.acquire();
 #else
         req->lock();
 #endif
     }
 
     void RequestList::unlock_request(Request *req) {
-#ifdef NO_FAST_MUTEXES
+#ifdef AGENTPP_USE_LOCK_QUEUE
         if (lockQueue) {
             LockRequest r(req);
             lockQueue->release(&r);
             r.wait();
         }
+#elif defined(NO_FAST_MUTEXES)
+        // the request is unlocked by the thread that processed it
+        req->requestLock.release();
 #else
         req->unlock();
 #endif
@@ -912,13 +1007,14 @@ namespace Agentpp {
 
         Pdux *pdu = req->get_pdu();
 
-        Counter32MibLeaf::incrementScalar(mib, oidSnmpOutPkts);
+        MibIIsnmpCounters::incOutPkts();
 
         pdu->set_error_status(0);
         pdu->set_error_index(0);
         pdu->set_type(sNMP_PDU_RESPONSE);
 
         requests->remove(req);
+        unindex_request(req);
 
         int status;
         status = snmp->report(*pdu, req->target);
@@ -995,15 +1091,13 @@ namespace Agentpp {
                 case sNMP_SYNTAX_NOSUCHOBJECT: {
 
                     if (req->version >= version2c)
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpOutNoSuchNames);
+                        MibIIsnmpCounters::incOutNoSuchNames();
                     break;
                 }
                 case sNMP_SYNTAX_NOSUCHINSTANCE: {
 
                     if (req->version >= version2c)
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpOutBadValues);
+                        MibIIsnmpCounters::incOutBadValues();
                     break;
                 }
                 case sNMP_SYNTAX_ENDOFMIBVIEW: {
@@ -1011,11 +1105,9 @@ namespace Agentpp {
                 }
                 default:
                     if (pdu->get_type() == sNMP_PDU_SET)
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpInTotalSetVars);
+                        MibIIsnmpCounters::incInTotalSetVars();
                     else
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpInTotalReqVars);
+                        MibIIsnmpCounters::incInTotalReqVars();
             }
         }
 
@@ -1024,50 +1116,63 @@ namespace Agentpp {
             null_vbs(req);
         }
 
-        Counter32MibLeaf::incrementScalar(mib, oidSnmpOutPkts);
+        MibIIsnmpCounters::incOutPkts();
 
         switch (pdu->get_type()) {
             case sNMP_PDU_GET: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpInGetRequests);
+                MibIIsnmpCounters::incInGetRequests();
                 break;
             }
             case sNMP_PDU_GETBULK:
             case sNMP_PDU_GETNEXT: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpInGetNexts);
+                MibIIsnmpCounters::incInGetNexts();
                 break;
             }
             case sNMP_PDU_SET: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpInSetRequests);
+                MibIIsnmpCounters::incInSetRequests();
                 break;
             }
             case sNMP_PDU_V1TRAP:
             case sNMP_PDU_TRAP: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpInTraps);
+                MibIIsnmpCounters::incInTraps();
                 requests->remove(req);
+                unindex_request(req);
                 return; // do not answer traps
             }
         }
 
-        // check message length
-        if (pdu->get_asn1_length() > req->get_max_response_length()) {
+        // check message length, the vbs are measured once and then
+        // the length of trimmed vbs is subtracted
+        int maxLength = req->get_max_response_length();
+        int vbsLength = 0;
+        for (int i = 0; i < pdu->get_vb_count(); i++) {
+            vbsLength += (*pdu)[i].get_asn1_length();
+        }
+        if (pdu->get_asn1_length_for_vbs(vbsLength) > maxLength) {
 
             LOG_BEGIN(loggerModuleName, WARNING_LOG | 2);
                     LOG("RequestList: response tooBig, truncating it (rid)(tid)(to)(size)(limit)");
                     LOG(pdu->get_request_id());
                     LOG(req->get_transaction_id());
                     LOG(req->from.get_printable());
-                    LOG(pdu->get_asn1_length());
-                    LOG(req->get_max_response_length());
+                    LOG(pdu->get_asn1_length_for_vbs(vbsLength));
+                    LOG(maxLength);
             LOG_END;
 
             if (pdu->get_type() == sNMP_PDU_GETBULK) {
                 do {
-                    pdu->trim(req->get_rep());
+                    int count = pdu->get_vb_count();
+                    int rep = req->get_rep();
+                    if ((rep <= 0) || (rep > count)) break;
+                    for (int i = count - rep; i < count; i++) {
+                        vbsLength -= (*pdu)[i].get_asn1_length();
+                    }
+                    pdu->trim(rep);
                 } while ((pdu->get_vb_count() > req->get_non_rep()) &&
-                         (pdu->get_asn1_length() >
-                          req->get_max_response_length()));
+                         (pdu->get_asn1_length_for_vbs(vbsLength) >
+                          maxLength));
             }
-            if (pdu->get_asn1_length() > req->get_max_response_length()) {
+            if (pdu->get_asn1_length_for_vbs(vbsLength) > maxLength) {
                 pdu->trim(pdu->get_vb_count());
                 pdu->set_error_status(SNMP_ERROR_TOO_BIG);
             }
@@ -1075,20 +1180,20 @@ namespace Agentpp {
 
         switch (pdu->get_error_status()) {
             case SNMP_ERROR_TOO_BIG: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutTooBigs);
+                MibIIsnmpCounters::incOutTooBigs();
                 break;
             }
             case SNMP_ERROR_NO_SUCH_NAME: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutNoSuchNames);
+                MibIIsnmpCounters::incOutNoSuchNames();
                 break;
             }
             case SNMP_ERROR_BAD_VALUE: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutBadValues);
+                MibIIsnmpCounters::incOutBadValues();
                 break;
             }
             default: {
                 if (pdu->get_error_status() != SNMP_ERROR_SUCCESS)
-                    Counter32MibLeaf::incrementScalar(mib, oidSnmpOutGenErrs);
+                    MibIIsnmpCounters::incOutGenErrs();
                 break;
             }
         }
@@ -1097,6 +1202,7 @@ namespace Agentpp {
         pdu->set_type(sNMP_PDU_RESPONSE);
 
         requests->remove(req);
+        unindex_request(req);
 
 #ifdef _SNMPv3
         int status = snmp->send(*pdu, &(req->target));
@@ -1139,10 +1245,10 @@ namespace Agentpp {
                              req->target.get_version(),
                              req->target.get_readcommunity());
 #endif
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutTooBigs);
+                MibIIsnmpCounters::incOutTooBigs();
             }
         }
-        Counter32MibLeaf::incrementScalar(mib, oidSnmpOutGetResponses);
+        MibIIsnmpCounters::incOutGetResponses();
 
         LOG_BEGIN(loggerModuleName, EVENT_LOG | 2);
                 LOG("RequestList: request answered (rid)(tid)(to)(err)(send)(sz)");
@@ -1157,6 +1263,10 @@ namespace Agentpp {
 
 
     Request *RequestList::receive(int sec) {
+        return receive(sec, snmp);
+    }
+
+    Request *RequestList::receive(int sec, Snmpx *session) {
 #ifdef _SNMPv3
         if (vacm == 0) {
             LOG_BEGIN(loggerModuleName, ERROR_LOG | 0);
@@ -1182,13 +1292,13 @@ namespace Agentpp {
         Pdux pdu;
 #ifdef _SNMPv3
         UTarget target;
-        int status = snmp->receive(tvptr, pdu, target);
+        int status = session->receive(tvptr, pdu, target);
 #else
         UdpAddress   from;
         snmp_version version = version1;
         OctetStr     community;
 
-        int status = snmp->receive(tvptr, pdu, from, version, community);
+        int status = session->receive(tvptr, pdu, from, version, community);
         CTarget target(from);
         target.set_version(version);
         target.set_readcommunity(community);
@@ -1198,7 +1308,7 @@ namespace Agentpp {
 
         if (status != SNMP_CLASS_TL_FAILED)
             // do not increment incoming packets for timeouts on select
-            snmpInPkts::incrementScalar(mib, oidSnmpInPkts);
+            MibIIsnmpCounters::incInPkts();
 
         if ((status == SNMP_CLASS_SUCCESS) ||
             (status == SNMP_ERROR_TOO_BIG)) {
@@ -1281,8 +1391,7 @@ namespace Agentpp {
                                               target.get_address(),
                                               0);
 
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpInBadCommunityNames);
+                        MibIIsnmpCounters::incInBadCommunityNames();
                         return 0;
                     }
                     // use coexistence security name for proxy request
@@ -1328,7 +1437,7 @@ namespace Agentpp {
 
                 v3mp->inc_stats_invalid_msgs();
 
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpInTooBigs);
+                MibIIsnmpCounters::incInTooBigs();
 
                 LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
                         LOG("RequestList: too big SNMP PDU received (rid): ");
@@ -1341,9 +1450,9 @@ namespace Agentpp {
 
                 pdu.set_type(sNMP_PDU_RESPONSE);
 
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutPkts);
+                MibIIsnmpCounters::incOutPkts();
 
-                snmp->send(pdu, &target);
+                session->send(pdu, &target);
                 return 0;
             }
             // check for a proxy application
@@ -1388,8 +1497,7 @@ namespace Agentpp {
                     LOG_END;
                     v3mp->inc_stats_invalid_msgs();
                     v3mp->inc_stats_unknown_pdu_handlers();
-                    Counter32MibLeaf::incrementScalar(mib,
-                                                      oidSnmpInASNParseErrs);
+                    MibIIsnmpCounters::incInASNParseErrs();
                     return 0;
                 }
             }
@@ -1423,12 +1531,10 @@ namespace Agentpp {
                                 LOG(vacm->getErrorMsg(vacmErrorCode));
                         LOG_END;
 
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpOutPkts);
-                        snmp->send(pdu, &target);
+                        MibIIsnmpCounters::incOutPkts();
+                        session->send(pdu, &target);
                     } else {
-                        Counter32MibLeaf::incrementScalar(mib,
-                                                          oidSnmpInBadCommunityNames);
+                        MibIIsnmpCounters::incInBadCommunityNames();
                     }
 
                     authenticationFailure(context_name,
@@ -1449,8 +1555,8 @@ namespace Agentpp {
                             LOG(vacmErrorCode);
                     LOG_END;
 
-                    Counter32MibLeaf::incrementScalar(mib, oidSnmpOutPkts);
-                    snmp->send(pdu, &target);
+                    MibIIsnmpCounters::incOutPkts();
+                    session->send(pdu, &target);
                     return 0;
                 }
                 case VACM_noSuchContext: {
@@ -1475,7 +1581,7 @@ namespace Agentpp {
                             LOG(genAddr.get_printable());
                     LOG_END;
 
-                    snmp->report(pdu, target);
+                    session->report(pdu, target);
                     return 0;
                 }
             } //switch
@@ -1494,8 +1600,7 @@ namespace Agentpp {
                       target.get_address(),
                       0);
 
-                    Counter32MibLeaf::incrementScalar(mib,
-                            oidSnmpInBadCommunityNames);
+                    MibIIsnmpCounters::incInBadCommunityNames();
         return 0;
     }
     else
@@ -1521,13 +1626,11 @@ namespace Agentpp {
                 case SNMPv3_MP_PARSE_ERROR:
                 case SNMP_CLASS_ERROR:
                 case SNMP_CLASS_ASN1ERROR: {
-                    Counter32MibLeaf::incrementScalar(mib,
-                                                      oidSnmpInASNParseErrs);
+                    MibIIsnmpCounters::incInASNParseErrs();
                     break;
                 }
                 case SNMP_CLASS_BADVERSION: {
-                    Counter32MibLeaf::incrementScalar(mib,
-                                                      oidSnmpInBadVersions);
+                    MibIIsnmpCounters::incInBadVersions();
                     break;
                 }
                 case SNMPv3_MP_UNKNOWN_PDU_HANDLERS: {
@@ -1569,9 +1672,7 @@ namespace Agentpp {
 		}
 */
                 default:
-                    Counter32MibLeaf *incInASNParseErrs =
-                            snmpInASNParseErrs::get_instance(mib, oidSnmpInASNParseErrs);
-                    if (incInASNParseErrs) incInASNParseErrs->increment();
+                    MibIIsnmpCounters::incInASNParseErrs();
             }
         }
         return 0;
@@ -1583,13 +1684,13 @@ namespace Agentpp {
 
                 Request *dupl;
                 // ignore request, if request_id is already known
-                if (((dupl = find_request_on_id(rid)) == 0) ||
-                    (strcmp(dupl->from.get_printable(),
-                            req->from.get_printable()) != 0)) {
+                // for the same source address
+                if ((dupl = find_request(rid, req->from)) == 0) {
 
                     req->set_transaction_id(next_transaction_id++);
                     lock_request(req);
                     requests->add(req);
+                    index_request(req);
                     return req;
                 }
                 LOG_BEGIN(loggerModuleName, EVENT_LOG | 4);
@@ -1644,6 +1745,30 @@ namespace Agentpp {
         }
     }
 
+#ifdef _THREADS
+
+/*---------------------- class RequestReceiver ----------------------*/
+
+    RequestReceiver::RequestReceiver(Mib *m, RequestList *reqList,
+                                     Snmpx *s) :
+            mib(m), requestList(reqList), session(s), running(TRUE) {
+    }
+
+    RequestReceiver::~RequestReceiver() {
+        stop();
+        join();
+    }
+
+    void RequestReceiver::run() {
+        while (running) {
+            Request *req = requestList->receive(1, session);
+            if (req)
+                mib->process_request(req);
+        }
+    }
+
+#endif
+
 #ifdef AGENTPP_NAMESPACE
 }
 #endif
@@ -26,7 +26,52 @@
 using namespace Agentpp;
 #endif
 
-unsigned long MibIIsnmpCounters::counter_snmp[SNMP_COUNTERS];
+#ifdef _THREADS
+// the shard of the calling thread, assigned round robin
+static unsigned int stat_counter_shard()
+{
+	static std::atomic<unsigned int> nextShard(0);
+	static thread_local unsigned int shard =
+		nextShard.fetch_add(1, std::memory_order_relaxed) %
+		AGENTPP_STAT_COUNTER_SHARDS;
+	return shard;
+}
+#endif
+
+void StatCounter::increment()
+{
+#ifdef _THREADS
+	shards[stat_counter_shard()].value.fetch_add(1,
+				std::memory_order_relaxed);
+#else
+	value++;
+#endif
+}
+
+unsigned long StatCounter::get() const
+{
+#ifdef _THREADS
+	unsigned long sum = 0;
+	for (int i=0; i<AGENTPP_STAT_COUNTER_SHARDS; i++)
+		sum += shards[i].value.load(std::memory_order_relaxed);
+	return sum & 0xFFFFFFFFUL;
+#else
+	return value & 0xFFFFFFFFUL;
+#endif
+}
+
+void StatCounter::reset()
+{
+#ifdef _THREADS
+	for (int i=0; i<AGENTPP_STAT_COUNTER_SHARDS; i++)
+		shards[i].value.store(0, std::memory_order_relaxed);
+#else
+	value = 0;
+#endif
+}
+
+
+StatCounter MibIIsnmpCounters::counter_snmp[SNMP_COUNTERS];
 
 MibIIsnmpCounters::MibIIsnmpCounters() 
 {
@@ -37,7 +82,7 @@ MibIIsnmpCounters::MibIIsnmpCounters()
 void MibIIsnmpCounters::reset()
 {
 	for (int i=0; i<SNMP_COUNTERS; i++) 
-		counter_snmp[i] = 0;
+		counter_snmp[i].reset();
 }
 
 
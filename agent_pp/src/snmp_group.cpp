@@ -28,6 +28,26 @@ using namespace Agentpp;
 #endif
 
 
+/**
+ *  StatCounterMibLeaf
+ *
+ */
+
+Vbx StatCounterMibLeaf::get_value() const
+{
+	Vbx vb(get_oid());
+	vb.set_value(Counter32(counter->get()));
+	return vb;
+}
+
+bool StatCounterMibLeaf::serialize(char*& buf, int& sz)
+{
+	Vbx vb(get_value());
+	return (Vbx::to_asn1(&vb, 1, (unsigned char*&)buf, sz) ==
+		SNMP_CLASS_SUCCESS) ? TRUE : FALSE;
+}
+
+
 /**
  *  snmpEnableAuthenTraps
  *
@@ -300,6 +300,27 @@ bool snmpNotifyFilterEntry::passes_filter(const Oidx& target,
 	return (pass == 1);
 }	
 
+bool snmpNotifyFilterEntry::has_filter(const Oidx& target)
+{
+	_snmpNotifyFilterProfileEntry->start_synch();
+	MibTableRow* found = 
+	  _snmpNotifyFilterProfileEntry->find_index(target);
+	if (!found) {
+		_snmpNotifyFilterProfileEntry->end_synch();
+		return FALSE;
+	}
+	OctetStr profileName;
+	found->first()->get_value(profileName);
+	_snmpNotifyFilterProfileEntry->end_synch();
+
+	Oidx profileOid;
+	profileOid = Oidx::from_string(profileName);
+	List<MibTableRow>* list = get_rows_cloned(&profileOid, rowActive);
+	bool filtered = (!list->empty());
+	delete list;
+	return filtered;
+}
+
 snmp_notification_mib::snmp_notification_mib(): 
     MibGroup("1.3.6.1.6.3.13.1", "snmpNotificationMIB")
 {
@@ -85,6 +85,18 @@ Pdux& Pdux::operator+=(const Vb &vb)
 	return *this;
 }
 
+void Pdux::reserve(int count)
+{
+	if (count <= vbs_size)
+		return;
+	Vb** tmp = new Vb*[count];
+	for (int i=0; i<vb_count; i++)
+		tmp[i] = vbs[i];
+	delete[] vbs;
+	vbs = tmp;
+	vbs_size = count;
+}
+
 
 /**
   * class Vbx
@@ -622,6 +634,357 @@ Oidx OidxRange::get_upper() const { return upper; }
  *
  ****************************************************************/
 
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+#define SNMPX_USE_MMSG
+#endif
+
+// upper bound for the batch size, each slot of a queue holds a
+// buffer of MAX_SNMP_PACKET bytes
+#define SNMPX_MAX_BATCH_SIZE	64
+
+#ifdef SNMPX_USE_MMSG
+
+/*
+ * A queue of datagrams with a buffer of MAX_SNMP_PACKET bytes per
+ * slot, laid out as needed by recvmmsg() and sendmmsg().
+ */
+struct SnmpxDatagramQueue {
+  int			count;
+  int			next;
+  struct mmsghdr*	msgs;
+  struct iovec*		iov;
+  SocketAddrType*	addrs;
+  unsigned char*	data;
+
+  SnmpxDatagramQueue(): count(0), next(0), msgs(0), iov(0),
+			addrs(0), data(0) { }
+  ~SnmpxDatagramQueue()
+  {
+    delete[] msgs;
+    delete[] iov;
+    delete[] addrs;
+    delete[] data;
+  }
+
+  void init(int size)
+  {
+    msgs  = new struct mmsghdr[size];
+    iov   = new struct iovec[size];
+    addrs = new SocketAddrType[size];
+    data  = new unsigned char[size * MAX_SNMP_PACKET];
+    memset(msgs, 0, size * sizeof(struct mmsghdr));
+    for (int i=0; i<size; i++) {
+	iov[i].iov_base = data + i * MAX_SNMP_PACKET;
+	iov[i].iov_len  = MAX_SNMP_PACKET;
+	msgs[i].msg_hdr.msg_iov     = &iov[i];
+	msgs[i].msg_hdr.msg_iovlen  = 1;
+	msgs[i].msg_hdr.msg_name    = &addrs[i];
+	msgs[i].msg_hdr.msg_namelen = sizeof(SocketAddrType);
+    }
+  }
+};
+
+/*
+ * The batch state of a Snmpx session. Index 0 of the queue arrays
+ * belongs to the IPv4 session socket, index 1 to the IPv6 one.
+ * Outgoing datagrams are collected in one of two queues per socket
+ * while the other one is written to the socket by the thread that
+ * currently flushes (flat combining).
+ */
+class SnmpxBatch {
+public:
+  SnmpxBatch(int s, bool ipv4, bool ipv6): size(s)
+  {
+    bool valid[2] = { ipv4, ipv6 };
+    for (int i=0; i<2; i++) {
+	fill[i] = 0;
+	flushing[i] = false;
+	if (!valid[i])
+	  continue;
+	in[i].init(size);
+	out[i][0].init(size);
+	out[i][1].init(size);
+    }
+  }
+
+  int			size;
+  SnmpxDatagramQueue	in[2];
+  SnmpxDatagramQueue	out[2][2];
+  int			fill[2];
+  bool			flushing[2];
+#ifdef _THREADS
+  Synchronized		inLock;
+  Synchronized		outLock;
+#endif
+};
+
+/*
+ * Convert an UDP address into a socket address the way
+ * send_snmp_request does. Returns the length of the socket
+ * address or 0 if the address cannot be converted.
+ */
+static SocketLengthType to_socket_address(const UdpAddress& address,
+					  SocketAddrType& sa)
+{
+  memset(&sa, 0, sizeof(sa));
+  if (address.get_ip_version() == Address::version_ipv4)
+  {
+    struct sockaddr_in& sin = (struct sockaddr_in&)sa;
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr
+      = inet_addr(((IpAddress &)address).IpAddress::get_printable());
+    sin.sin_port = htons(address.get_port());
+    return sizeof(struct sockaddr_in);
+  }
+#ifdef SNMP_PP_IPv6
+  struct sockaddr_in6& sin6 = (struct sockaddr_in6&)sa;
+  OctetStr addrstr = ((IpAddress &)address).IpAddress::get_printable();
+  unsigned int scope = 0;
+  if (address.has_ipv6_scope())
+  {
+    scope = address.get_scope();
+    int i = addrstr.len() - 1;
+    while ((i>0) && (addrstr[i] != '%'))
+    {
+	addrstr.set_len(addrstr.len() - 1);
+	i--;
+    }
+    if (addrstr[i] == '%')
+	addrstr.set_len(addrstr.len() - 1);
+  }
+  if (inet_pton(AF_INET6, addrstr.get_printable(), &sin6.sin6_addr) <= 0)
+    return 0;
+  sin6.sin6_family = AF_INET6;
+  sin6.sin6_port = htons(address.get_port());
+  sin6.sin6_scope_id = scope;
+  return sizeof(struct sockaddr_in6);
+#else
+  return 0;
+#endif
+}
+
+/*
+ * Write all datagrams of a queue to the socket. A datagram that
+ * cannot be sent is dropped, as with a failing sendto().
+ */
+static void flush_datagrams(SnmpSocket sock, SnmpxDatagramQueue& q)
+{
+  int sent = 0;
+  while (sent < q.count)
+  {
+    int n = sendmmsg(sock, q.msgs + sent, q.count - sent, 0);
+    if ((n < 0) && (EINTR == errno))
+      continue;
+    if (n <= 0)
+    {
+      debugprintf(0, "Error sending packet: %s", strerror(errno));
+      n = 1;
+    }
+    sent += n;
+  }
+  q.count = 0;
+}
+
+#else // SNMPX_USE_MMSG
+
+class SnmpxBatch { };
+
+#endif // SNMPX_USE_MMSG
+
+/*
+ * The raw PDU of an incoming message is decoded within an arena that
+ * is kept by the session, so that decoding needs no malloc() calls
+ * once the arena has grown to the size of the largest message. The
+ * arena is reset when the message has been unloaded into the Pdux.
+ * A thread that finds the arena in use by another thread decodes
+ * with malloc() instead.
+ */
+class SnmpxDecodeArena {
+public:
+  SnmpxDecodeArena() { snmp_arena_init(&arena); }
+  ~SnmpxDecodeArena() { snmp_arena_destroy(&arena); }
+
+  struct snmp_arena	arena;
+#ifdef _THREADS
+  Synchronized		lock;
+#endif
+};
+
+/*
+ * Lends the arena of a session to a message for the lifetime
+ * of this object.
+ */
+class SnmpxDecodeArenaGuard {
+public:
+  SnmpxDecodeArenaGuard(SnmpxDecodeArena* a, SnmpMessage& msg): owner(0)
+  {
+    if (!a)
+      return;
+#ifdef _THREADS
+    if (a->lock.trylock() != Synchronized::LOCKED)
+      return;
+#endif
+    owner = a;
+    msg.set_decode_arena(&a->arena);
+  }
+  ~SnmpxDecodeArenaGuard()
+  {
+#ifdef _THREADS
+    if (owner)
+      owner->lock.unlock();
+#endif
+  }
+
+private:
+  SnmpxDecodeArena* owner;
+};
+
+SnmpxDecodeArena* Snmpx::create_decode_arena()
+{
+  return new SnmpxDecodeArena();
+}
+
+Snmpx::~Snmpx()
+{
+  delete batch;
+  delete decodeArena;
+}
+
+void Snmpx::set_batch_size(int size)
+{
+  if (size < 1)
+    size = 1;
+  else if (size > SNMPX_MAX_BATCH_SIZE)
+    size = SNMPX_MAX_BATCH_SIZE;
+  delete batch;
+  batch = 0;
+  batchSize = size;
+#ifdef SNMPX_USE_MMSG
+  if (batchSize > 1)
+    batch = new SnmpxBatch(batchSize, (iv_snmp_session != INVALID_SOCKET),
+#ifdef SNMP_PP_IPv6
+			   (iv_snmp_session_ipv6 != INVALID_SOCKET));
+#else
+			   false);
+#endif
+#endif
+}
+
+bool Snmpx::has_pending_datagram(SnmpSocket sock)
+{
+#ifdef SNMPX_USE_MMSG
+  if ((batch) && (sock != INVALID_SOCKET))
+  {
+    SnmpxDatagramQueue& q = batch->in[(sock == iv_snmp_session) ? 0 : 1];
+#ifdef _THREADS
+    Lock l(batch->inLock);
+#endif
+    return (q.next < q.count);
+  }
+#endif
+  return false;
+}
+
+long Snmpx::receive_datagram(SnmpSocket sock, unsigned char* buf,
+			     SocketAddrType& from_addr,
+			     SocketLengthType& fromlen)
+{
+  long len;
+#ifdef SNMPX_USE_MMSG
+  if (batch)
+  {
+    SnmpxDatagramQueue& q = batch->in[(sock == iv_snmp_session) ? 0 : 1];
+#ifdef _THREADS
+    Lock l(batch->inLock);
+#endif
+    if (q.next >= q.count)
+    {
+	for (int i=0; i<batch->size; i++)
+	  q.msgs[i].msg_hdr.msg_namelen = sizeof(SocketAddrType);
+	int n;
+	do
+	{
+	  // wait for the first datagram only, then take what is queued
+	  n = recvmmsg(sock, q.msgs, batch->size, MSG_WAITFORONE, 0);
+	} while (n < 0 && EINTR == errno);
+
+	q.next = 0;
+	q.count = (n > 0) ? n : 0;
+	if (n <= 0)
+	  return n;
+	debugprintf(4, "Snmpx: received %d datagrams with one call", n);
+    }
+    struct mmsghdr& m = q.msgs[q.next++];
+    len = (long)m.msg_len;
+    memcpy(buf, m.msg_hdr.msg_iov->iov_base, len);
+    memcpy(&from_addr, m.msg_hdr.msg_name, m.msg_hdr.msg_namelen);
+    fromlen = m.msg_hdr.msg_namelen;
+    return len;
+  }
+#endif
+  fromlen = sizeof(from_addr);
+  do
+  {
+    len = (long)recvfrom(sock, (char *) buf, MAX_SNMP_PACKET, 0,
+			 (struct sockaddr*)&from_addr, &fromlen);
+  } while (len < 0 && EINTR == errno);
+  return len;
+}
+
+int Snmpx::send_datagram(SnmpSocket sock, unsigned char* buf, size_t len,
+			 const UdpAddress& address)
+{
+#ifdef SNMPX_USE_MMSG
+  if ((batch) && (len <= MAX_SNMP_PACKET))
+  {
+    int s = (sock == iv_snmp_session) ? 0 : 1;
+#ifdef _THREADS
+    batch->outLock.lock();
+#endif
+    SnmpxDatagramQueue* q = &batch->out[s][batch->fill[s]];
+    SocketLengthType namelen = 0;
+    if (q->count < batch->size)
+	namelen = to_socket_address(address, q->addrs[q->count]);
+    if (namelen > 0)
+    {
+	debugprintf(1, "++ SNMP++: sending to %s:", address.get_printable());
+	debughexprintf(5, buf, SAFE_UINT_CAST(len));
+
+	struct mmsghdr& m = q->msgs[q->count++];
+	memcpy(m.msg_hdr.msg_iov->iov_base, buf, len);
+	m.msg_hdr.msg_iov->iov_len = len;
+	m.msg_hdr.msg_namelen = namelen;
+	if (!batch->flushing[s])
+	{
+	  // become the flushing thread until no more datagrams arrive
+	  batch->flushing[s] = true;
+	  while (q->count > 0)
+	  {
+	    batch->fill[s] ^= 1;
+#ifdef _THREADS
+	    batch->outLock.unlock();
+#endif
+	    flush_datagrams(sock, *q);
+#ifdef _THREADS
+	    batch->outLock.lock();
+#endif
+	    q = &batch->out[s][batch->fill[s]];
+	  }
+	  batch->flushing[s] = false;
+	}
+#ifdef _THREADS
+	batch->outLock.unlock();
+#endif
+	return 0;
+    }
+#ifdef _THREADS
+    batch->outLock.unlock();
+#endif
+  }
+#endif
+  return send_snmp_request(sock, buf, len, address);
+}
+
 
 #ifdef _SNMPv3
 int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UTarget& target)
@@ -636,6 +999,7 @@ int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UTarget& target)
   long receive_buffer_len; // len of received data
 
   SnmpMessage snmpmsg;
+  SnmpxDecodeArenaGuard arena_guard(decodeArena, snmpmsg);
 
   int nfound = 0;
   bool can_receive_ipv4 = false;
@@ -690,60 +1054,64 @@ int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UTarget& target)
 
   do
   {
+    // datagrams left from a batch receive need no polling
+    can_receive_ipv4 = has_pending_datagram(iv_snmp_session);
+#ifdef SNMP_PP_IPv6
+    can_receive_ipv6 = !can_receive_ipv4 &&
+                       has_pending_datagram(iv_snmp_session_ipv6);
+    if (!can_receive_ipv4 && !can_receive_ipv6)
+#else
+    if (!can_receive_ipv4)
+#endif
+    {
 #ifdef HAVE_POLL_SYSCALL
-    nfound = poll(readfds, nfds, timeout);
+      nfound = poll(readfds, nfds, timeout);
 
-    if (nfound == -1)
-    {
-      if (errno != EINTR)
-	return SNMP_CLASS_TL_FAILED;
-      continue;
-    }
-    else if (nfound <= 0)
-      return SNMP_CLASS_TL_FAILED;
+      if (nfound == -1)
+      {
+        if (errno != EINTR)
+	  return SNMP_CLASS_TL_FAILED;
+        continue;
+      }
+      else if (nfound <= 0)
+        return SNMP_CLASS_TL_FAILED;
 
-    if ((iv_snmp_session != INVALID_SOCKET) &&
-	(readfds[0].revents & POLLIN))
-	can_receive_ipv4 = true;
+      if ((iv_snmp_session != INVALID_SOCKET) &&
+	  (readfds[0].revents & POLLIN))
+	  can_receive_ipv4 = true;
 #ifdef SNMP_PP_IPv6
-    if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
-	(readfds[nfds-1].revents & POLLIN))
-	can_receive_ipv6 = true;
+      if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
+	  (readfds[nfds-1].revents & POLLIN))
+	  can_receive_ipv6 = true;
 #endif // SNMP_PP_IPv6
 
 #else // HAVE_POLL_SYSCALL
-    nfound = select(max_fd+1, &readfds, 0, 0, tvptr);
+      nfound = select(max_fd+1, &readfds, 0, 0, tvptr);
 
-    if (nfound == -1)
-    {
-      if (errno != EINTR)
-	return SNMP_CLASS_TL_FAILED;
-      continue;
-    }
-    else if (nfound <= 0)
-      return SNMP_CLASS_TL_FAILED;
+      if (nfound == -1)
+      {
+        if (errno != EINTR)
+	  return SNMP_CLASS_TL_FAILED;
+        continue;
+      }
+      else if (nfound <= 0)
+        return SNMP_CLASS_TL_FAILED;
 
-    if ((iv_snmp_session != INVALID_SOCKET) &&
-	(FD_ISSET(iv_snmp_session, &readfds)))
-	can_receive_ipv4 = true;
+      if ((iv_snmp_session != INVALID_SOCKET) &&
+	  (FD_ISSET(iv_snmp_session, &readfds)))
+	  can_receive_ipv4 = true;
 #ifdef SNMP_PP_IPv6
-    if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
-	(FD_ISSET(iv_snmp_session_ipv6, &readfds)))
-	can_receive_ipv6 = true;
+      if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
+	  (FD_ISSET(iv_snmp_session_ipv6, &readfds)))
+	  can_receive_ipv6 = true;
 #endif // SNMP_PP_IPv6
 #endif // HAVE_POLL_SYSCALL
+    }
 
     if (can_receive_ipv4)
     {
-	fromlen = sizeof(from_addr);
-	do
-	{
-	  receive_buffer_len = (long)recvfrom(iv_snmp_session,
-					      (char *) receive_buffer,
-					      MAX_SNMP_PACKET, 0,
-					      (struct sockaddr*)&from_addr,
-					      &fromlen);
-	} while (receive_buffer_len < 0 && EINTR == errno);
+	receive_buffer_len = receive_datagram(iv_snmp_session, receive_buffer,
+						from_addr, fromlen);
 
 	if (receive_buffer_len <= 0 )		// error or no data pending
 	  return SNMP_CLASS_TL_FAILED;
@@ -817,15 +1185,8 @@ int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UTarget& target)
 #ifdef SNMP_PP_IPv6
     if (can_receive_ipv6)
     {
-	fromlen = sizeof((from_addr));
-	do
-	{
-	  receive_buffer_len = (long)recvfrom(iv_snmp_session_ipv6,
-					      (char *) receive_buffer,
-					      MAX_SNMP_PACKET, 0,
-					      (struct sockaddr*)&from_addr,
-					      &fromlen);
-	} while (receive_buffer_len < 0 && EINTR == errno);
+	receive_buffer_len = receive_datagram(iv_snmp_session_ipv6, receive_buffer,
+						from_addr, fromlen);
 
 	if (receive_buffer_len <= 0 )		// error or no data pending
 	  return SNMP_CLASS_TL_FAILED;
@@ -915,6 +1276,7 @@ int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UdpAddress& fromaddr,
   SocketAddrType from_addr;
   SocketLengthType fromlen;
   SnmpMessage snmpmsg;
+  SnmpxDecodeArenaGuard arena_guard(decodeArena, snmpmsg);
 
   int nfound = 0;
   bool can_receive_ipv4 = false;
@@ -969,60 +1331,64 @@ int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UdpAddress& fromaddr,
 
   do
   {
+    // datagrams left from a batch receive need no polling
+    can_receive_ipv4 = has_pending_datagram(iv_snmp_session);
+#ifdef SNMP_PP_IPv6
+    can_receive_ipv6 = !can_receive_ipv4 &&
+                       has_pending_datagram(iv_snmp_session_ipv6);
+    if (!can_receive_ipv4 && !can_receive_ipv6)
+#else
+    if (!can_receive_ipv4)
+#endif
+    {
 #ifdef HAVE_POLL_SYSCALL
-    nfound = poll(readfds, nfds, timeout);
+      nfound = poll(readfds, nfds, timeout);
 
-    if (nfound == -1)
-    {
-      if (errno != EINTR)
-	return SNMP_CLASS_TL_FAILED;
-      continue;
-    }
-    else if (nfound <= 0)
-      return SNMP_CLASS_TL_FAILED;
+      if (nfound == -1)
+      {
+        if (errno != EINTR)
+	  return SNMP_CLASS_TL_FAILED;
+        continue;
+      }
+      else if (nfound <= 0)
+        return SNMP_CLASS_TL_FAILED;
 
-    if ((iv_snmp_session != INVALID_SOCKET) &&
-	(readfds[0].revents & POLLIN))
-	can_receive_ipv4 = true;
+      if ((iv_snmp_session != INVALID_SOCKET) &&
+	  (readfds[0].revents & POLLIN))
+	  can_receive_ipv4 = true;
 #ifdef SNMP_PP_IPv6
-    if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
-	(readfds[nfds-1].revents & POLLIN))
-	can_receive_ipv6 = true;
+      if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
+	  (readfds[nfds-1].revents & POLLIN))
+	  can_receive_ipv6 = true;
 #endif // SNMP_PP_IPv6
 
 #else // HAVE_POLL_SYSCALL
-    nfound = select(max_fd+1, &readfds, 0, 0, tvptr);
+      nfound = select(max_fd+1, &readfds, 0, 0, tvptr);
 
-    if (nfound == -1)
-    {
-      if (errno != EINTR)
-	return SNMP_CLASS_TL_FAILED;
-      continue;
-    }
-    else if (nfound <= 0)
-      return SNMP_CLASS_TL_FAILED;
+      if (nfound == -1)
+      {
+        if (errno != EINTR)
+	  return SNMP_CLASS_TL_FAILED;
+        continue;
+      }
+      else if (nfound <= 0)
+        return SNMP_CLASS_TL_FAILED;
 
-    if ((iv_snmp_session != INVALID_SOCKET) &&
-	(FD_ISSET(iv_snmp_session, &readfds)))
-	can_receive_ipv4 = true;
+      if ((iv_snmp_session != INVALID_SOCKET) &&
+	  (FD_ISSET(iv_snmp_session, &readfds)))
+	  can_receive_ipv4 = true;
 #ifdef SNMP_PP_IPv6
-    if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
-	(FD_ISSET(iv_snmp_session_ipv6, &readfds)))
-	can_receive_ipv6 = true;
+      if ((iv_snmp_session_ipv6 != INVALID_SOCKET) &&
+	  (FD_ISSET(iv_snmp_session_ipv6, &readfds)))
+	  can_receive_ipv6 = true;
 #endif // SNMP_PP_IPv6
 #endif // HAVE_POLL_SYSCALL
+    }
 
     if (can_receive_ipv4)
     {
-	fromlen = sizeof(from_addr);
-	do
-	{
-	  receive_buffer_len = (long)recvfrom(iv_snmp_session,
-					      (char *) receive_buffer,
-					      MAX_SNMP_PACKET, 0,
-					      (struct sockaddr*)&from_addr,
-					      &fromlen);
-	} while (receive_buffer_len < 0 && EINTR == errno);
+	receive_buffer_len = receive_datagram(iv_snmp_session, receive_buffer,
+						from_addr, fromlen);
 
 	if (receive_buffer_len <= 0 )		// error or no data pending
 	  return SNMP_CLASS_TL_FAILED;
@@ -1047,15 +1413,8 @@ int Snmpx::receive(struct timeval *tvptr, Pdux& pdu, UdpAddress& fromaddr,
 #ifdef SNMP_PP_IPv6
     if (can_receive_ipv6)
     {
-	fromlen = sizeof(from_addr);
-	do
-	{
-	  receive_buffer_len = (long) recvfrom(iv_snmp_session_ipv6,
-					       (char *) receive_buffer,
-					       MAX_SNMP_PACKET, 0,
-					       (struct sockaddr*)&from_addr,
-					       &fromlen);
-	} while (receive_buffer_len < 0 && EINTR == errno);
+	receive_buffer_len = receive_datagram(iv_snmp_session_ipv6, receive_buffer,
+						from_addr, fromlen);
 
 	if (receive_buffer_len <= 0 )		// error or no data pending
 	  return SNMP_CLASS_TL_FAILED;
@@ -1178,21 +1537,24 @@ int Snmpx::send (Pdux &pdu, SnmpTarget* target)
     return status;
 
 #ifdef _THREADS
-  smutex.start_synch();
+  // batched sends are serialized per socket by send_datagram
+  if (!batch)
+    smutex.start_synch();
 #endif
 
 #ifdef SNMP_PP_IPv6
   if (udp_address.get_ip_version() == Address::version_ipv6)
-    status = send_snmp_request(iv_snmp_session_ipv6,
-			       snmpmsg.data(), (size_t)snmpmsg.len(),
-			       udp_address);
+    status = send_datagram(iv_snmp_session_ipv6,
+			   snmpmsg.data(), (size_t)snmpmsg.len(),
+			   udp_address);
   else
 #endif
-    status = send_snmp_request(iv_snmp_session,
-			       snmpmsg.data(), (size_t)snmpmsg.len(),
-			       udp_address);
+    status = send_datagram(iv_snmp_session,
+			   snmpmsg.data(), (size_t)snmpmsg.len(),
+			   udp_address);
 #ifdef _THREADS
-  smutex.end_synch();
+  if (!batch)
+    smutex.end_synch();
 #endif
 
   if (status != 0)
@@ -1219,21 +1581,24 @@ int Snmpx::send (Pdux  &pdu,
     return status;
 
 #ifdef _THREADS
-  smutex.start_synch();
+  // batched sends are serialized per socket by send_datagram
+  if (!batch)
+    smutex.start_synch();
 #endif
 
 #ifdef SNMP_PP_IPv6
   if (udp_address.get_ip_version() == Address::version_ipv6)
-    status = send_snmp_request(iv_snmp_session_ipv6,
-			       snmpmsg.data(), (size_t)snmpmsg.len(),
-			       udp_address);
+    status = send_datagram(iv_snmp_session_ipv6,
+			   snmpmsg.data(), (size_t)snmpmsg.len(),
+			   udp_address);
   else
 #endif
-    status = send_snmp_request(iv_snmp_session,
-			       snmpmsg.data(), (size_t)snmpmsg.len(),
-			       udp_address);
+    status = send_datagram(iv_snmp_session,
+			   snmpmsg.data(), (size_t)snmpmsg.len(),
+			   udp_address);
 #ifdef _THREADS
-  smutex.end_synch();
+  if (!batch)
+    smutex.end_synch();
 #endif
 
   if (status != 0)
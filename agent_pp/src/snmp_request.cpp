@@ -35,33 +35,6 @@ static const char *loggerModuleName = "agent++.snmp_request";
 
 //------------------------------ SnmpRequest -------------------------------
 
-#ifdef _THREADS
-#ifdef _WIN32THREADS
-static void inform_caller(void* ptr)
-#else
-extern "C" {
-static void *inform_caller(void* ptr)
-#endif
-{
-	InformInfo* callInfo = (InformInfo*)ptr;
-	LOG_BEGIN(loggerModuleName, EVENT_LOG | 2);
-	LOG("SnmpRequest: inform thread started");
-	LOG_END;
-	int status;
-	status = SnmpRequest::process_trap(callInfo->target, callInfo->vbs,
-					   callInfo->sz, callInfo->oid, "", TRUE);
-	delete callInfo;
-	LOG_BEGIN(loggerModuleName, EVENT_LOG | 2);
-	LOG("SnmpRequest: inform thread finished (status)");
-	LOG(status);
-	LOG_END;
-#ifndef _WIN32THREADS
-	return 0;
-}
-#endif
-}
-#endif
-
 InformInfo::InformInfo(CTarget& t, Vbx* v, int s, const Oidx& o)
 {
 	target = t;
@@ -104,7 +77,8 @@ int SnmpRequest::process(int rtype, const UdpAddress& address,
 
 	int status;
 
-	Snmpx* snmp = get_new_snmp(
+	SnmpSessionPool* pool = SnmpSessionPool::instance();
+	Snmpx* snmp = pool->acquire(
                 Mib::instance->get_request_list()->get_snmp(), status);
 	if (status != SNMP_CLASS_SUCCESS) {
 		if (snmp) delete snmp;
@@ -138,30 +112,30 @@ int SnmpRequest::process(int rtype, const UdpAddress& address,
 		break;
 	}
 
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutPkts);
+        MibIIsnmpCounters::incOutPkts();
 	if (status != SNMP_CLASS_TIMEOUT)
-                Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpInPkts);
+                MibIIsnmpCounters::incInPkts();
 
 	switch (pdu.get_error_status()) {
 	case SNMP_ERROR_NO_SUCH_NAME: {
-                Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpInNoSuchNames);
+                MibIIsnmpCounters::incInNoSuchNames();
 		break;
 	}
 	case SNMP_ERROR_BAD_VALUE: {
-                Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpInBadValues);
+                MibIIsnmpCounters::incInBadValues();
 		break;
 	}
 	case SNMP_ERROR_TOO_BIG: {
-                Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpInTooBigs);
+                MibIIsnmpCounters::incInTooBigs();
 		break;
 	}
 	default: {
 		if (pdu.get_error_status() != SNMP_ERROR_SUCCESS)
-                    Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpInGenErrs);
+                    MibIIsnmpCounters::incInGenErrs();
 		break;
 	}
 	}
-	delete snmp;
+	pool->release(snmp);
 	for (int j=0; j < sz; j++) {
 		pdu.get_vb(out[j], j);
 	}
@@ -178,7 +152,8 @@ int SnmpRequest::process_trap(SnmpTarget& target,
 {
 	int status;
 
-	Snmpx* snmp = get_new_snmp(
+	SnmpSessionPool* pool = SnmpSessionPool::instance();
+	Snmpx* snmp = pool->acquire(
                 Mib::instance->get_request_list()->get_snmp(), status);
 	// check construction status
 
@@ -202,10 +177,10 @@ int SnmpRequest::process_trap(SnmpTarget& target,
 		status = snmp->trap(pdu, target);
 
 	if (status == SNMP_CLASS_SUCCESS) {
-                Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutPkts);
-                Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutTraps);
+                MibIIsnmpCounters::incOutPkts();
+                MibIIsnmpCounters::incOutTraps();
 	}
-	delete snmp;
+	pool->release(snmp);
 
 	return status;
 }
@@ -215,13 +190,13 @@ int SnmpRequest::process_trap(SnmpTarget& target,
 
 int SnmpRequest::get(const UdpAddress& address, Vbx* vbs, int sz, int& errind)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetRequests);
+        MibIIsnmpCounters::incOutGetRequests();
 	return process(sNMP_PDU_GET, address, vbs, sz, vbs, errind, "public");
 }
 
 int SnmpRequest::next(const UdpAddress& address, Vbx* vbs, int sz, int& errind)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetNexts);
+        MibIIsnmpCounters::incOutGetNexts();
 	return process(sNMP_PDU_GETNEXT, address, vbs, sz, vbs,
 		       errind, "public");
 }
@@ -230,7 +205,7 @@ int SnmpRequest::getbulk(const UdpAddress& address, Vbx* vbs, int& sz,
 			 Vbx* out, int& errind,
 			 const int non_repeater, const int max_reps)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetNexts);
+        MibIIsnmpCounters::incOutGetNexts();
 	return process(sNMP_PDU_GETBULK, address, vbs, sz, out,
 		       errind, "public",
 		       non_repeater, max_reps);
@@ -238,21 +213,21 @@ int SnmpRequest::getbulk(const UdpAddress& address, Vbx* vbs, int& sz,
 
 int SnmpRequest::set(const UdpAddress& address, Vbx* vbs, int sz, int& errind)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutSetRequests);
+        MibIIsnmpCounters::incOutSetRequests();
 	return process(sNMP_PDU_SET, address, vbs, sz, vbs, errind, "public");
 }
 
 int SnmpRequest::get(const UdpAddress& address, Vbx* vbs, int sz, int& errind,
 		     const OctetStr& community)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetRequests);
+        MibIIsnmpCounters::incOutGetRequests();
 	return process(sNMP_PDU_GET, address, vbs, sz, vbs, errind, community);
 }
 
 int SnmpRequest::next(const UdpAddress& address, Vbx* vbs, int sz, int& errind,
 		     const OctetStr& community)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetNexts);
+        MibIIsnmpCounters::incOutGetNexts();
 	return process(sNMP_PDU_GETNEXT, address, vbs, sz, vbs,
 		       errind, community);
 }
@@ -261,7 +236,7 @@ int SnmpRequest::getbulk(const UdpAddress& address, Vbx* vbs, int& sz,
 			 Vbx* out, int& errind, const OctetStr& community,
 			 const int non_repeater, const int max_reps)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetNexts);
+        MibIIsnmpCounters::incOutGetNexts();
 	return process(sNMP_PDU_GETBULK, address, vbs, sz, out, errind,
 		       community,
 		       non_repeater, max_reps);
@@ -270,7 +245,7 @@ int SnmpRequest::getbulk(const UdpAddress& address, Vbx* vbs, int& sz,
 int SnmpRequest::set(const UdpAddress& address, Vbx* vbs, int sz, int& errind,
 		     const OctetStr& community)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutSetRequests);
+        MibIIsnmpCounters::incOutSetRequests();
 	return process(sNMP_PDU_SET, address, vbs, sz, vbs, errind, community);
 }
 
@@ -280,31 +255,30 @@ int SnmpRequest::trap(SnmpTarget& target, Vbx* vbs, int sz,
 	return process_trap(target, vbs, sz, oid, enterprise);
 }
 
-void SnmpRequest::inform(CTarget& target, Vbx* vbs, int sz, const Oidx& oid)
+int SnmpRequest::inform(CTarget& target, Vbx* vbs, int sz, const Oidx& oid)
 {
-        Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutTraps);
-
-#ifdef _THREADS
-	InformInfo* callInfo = new InformInfo(target, vbs, sz, oid);
+	Pdux pdu;
+	for (int i=0; i<sz; i++)
+		pdu += vbs[i];
 
-#ifdef _WIN32THREADS
-	_beginthread(inform_caller, 0, callInfo);
-#else
-    static pthread_attr_t* attr = 0;
+	pdu.set_notify_timestamp(sysUpTime::get());
+	pdu.set_notify_id(oid);
+	pdu.set_notify_enterprise("");
 
-	pthread_t thread;
-	if (!attr) {
-	  attr = new pthread_attr_t;
-	  pthread_attr_init(attr);
-	  pthread_attr_setdetachstate(attr, PTHREAD_CREATE_DETACHED);
+	// the inform is acknowledged (or times out) in the background
+	int status = SnmpSessionPool::instance()->send_inform(
+                Mib::instance->get_request_list()->get_snmp(), pdu, target);
+	if (status == SNMP_CLASS_SUCCESS) {
+                MibIIsnmpCounters::incOutPkts();
+                MibIIsnmpCounters::incOutTraps();
 	}
-	pthread_create(&thread, attr,
-		       &inform_caller,
-		       (void*) callInfo);
-#endif
-#else
-	process_trap(target, vbs, sz, oid, "", TRUE);
-#endif
+	else {
+		LOG_BEGIN(loggerModuleName, WARNING_LOG | 2);
+		LOG("SnmpRequest: could not send inform (status)");
+		LOG(status);
+		LOG_END;
+	}
+	return status;
 }
 
 int SnmpRequest::gettable(const UdpAddress& address, Vbx* vbs, int sz,
@@ -323,7 +297,7 @@ int SnmpRequest::gettable(const UdpAddress& address, Vbx* vbs, int sz,
 	int err = 0;
 
 	while (err == SNMP_ERROR_SUCCESS) {
-          Counter32MibLeaf::incrementScalar(Mib::instance, oidSnmpOutGetNexts);
+          MibIIsnmpCounters::incOutGetNexts();
 	  osz = sz;
 	  err = process(sNMP_PDU_GETBULK, address, in, osz, out, errind,
 			community, 0, max_reps);
@@ -383,6 +357,155 @@ Snmpx *SnmpRequest::get_new_snmp(Snmpx* snmp, int &status)
     return snmpx;
 }
 
+//---------------------------- SnmpSessionPool -----------------------------
+
+SnmpSessionPool::SnmpSessionPool(int max)
+{
+	idleBase = 0;
+	maxIdle = max;
+	informSession = 0;
+	pendingInforms = 0;
+	maxPendingInforms = AGENTPP_MAX_PENDING_INFORMS;
+}
+
+SnmpSessionPool::~SnmpSessionPool()
+{
+	clear();
+}
+
+SnmpSessionPool* SnmpSessionPool::instance()
+{
+	// never deleted: informs may still be acknowledged while static
+	// objects are destroyed on exit
+	static SnmpSessionPool* pool = new SnmpSessionPool();
+	return pool;
+}
+
+Snmpx* SnmpSessionPool::acquire(Snmpx* baseSnmp, int& status)
+{
+	start_synch();
+	if (baseSnmp != idleBase) {
+		// sessions are bound according to the listen address of
+		// the base session, thus those of another one do not fit
+		idle.clearAll();
+		idleBase = baseSnmp;
+	}
+	Snmpx* snmp = idle.removeLast();
+	end_synch();
+	if (snmp) {
+		status = SNMP_CLASS_SUCCESS;
+		return snmp;
+	}
+	return SnmpRequest::get_new_snmp(baseSnmp, status);
+}
+
+void SnmpSessionPool::release(Snmpx* snmp)
+{
+	start_synch();
+	if (idle.size() < maxIdle) {
+		idle.addLast(snmp);
+		snmp = 0;
+	}
+	end_synch();
+	if (snmp) delete snmp;
+}
+
+int SnmpSessionPool::send_inform(Snmpx* baseSnmp, Pdux& pdu,
+				 SnmpTarget& target)
+{
+	int status = SNMP_CLASS_SUCCESS;
+#ifdef _THREADS
+	start_synch();
+	if (pendingInforms >= maxPendingInforms) {
+		end_synch();
+		LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+		LOG("SnmpSessionPool: too many pending informs, inform dropped (max)");
+		LOG(maxPendingInforms);
+		LOG_END;
+		return SNMP_CLASS_RESOURCE_UNAVAIL;
+	}
+	if (!informSession) {
+		informSession = SnmpRequest::get_new_snmp(baseSnmp, status);
+		if ((status != SNMP_CLASS_SUCCESS) ||
+		    (!informSession->start_poll_thread(100))) {
+			delete informSession;
+			informSession = 0;
+			end_synch();
+			LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+			LOG("SnmpSessionPool: cannot open inform session (status)");
+			LOG(status);
+			LOG_END;
+			return (status != SNMP_CLASS_SUCCESS) ?
+			    status : SNMP_CLASS_RESOURCE_UNAVAIL;
+		}
+	}
+	pendingInforms++;
+	// the session must not be closed by clear() while sending
+	status = informSession->inform(pdu, target, &inform_callback, this);
+	if (status != SNMP_CLASS_SUCCESS) {
+		pendingInforms--;
+	}
+	end_synch();
+#else
+	Snmpx* snmp = acquire(baseSnmp, status);
+	if (status != SNMP_CLASS_SUCCESS) {
+		if (snmp) delete snmp;
+		return status;
+	}
+	status = snmp->inform(pdu, target);
+	release(snmp);
+#endif
+	return status;
+}
+
+void SnmpSessionPool::inform_callback(int reason, Snmp*, Pdu& pdu,
+				      SnmpTarget& target, void* data)
+{
+	SnmpSessionPool* pool = (SnmpSessionPool*)data;
+
+	GenAddress address;
+	target.get_address(address);
+	if ((reason == SNMP_CLASS_ASYNC_RESPONSE) &&
+	    (pdu.get_type() == sNMP_PDU_RESPONSE)) {
+                MibIIsnmpCounters::incInPkts();
+		LOG_BEGIN(loggerModuleName, EVENT_LOG | 3);
+		LOG("SnmpSessionPool: inform acknowledged (addr)(error)");
+		LOG(address.get_printable());
+		LOG(pdu.get_error_status());
+		LOG_END;
+	}
+	else {
+		LOG_BEGIN(loggerModuleName, WARNING_LOG | 2);
+		LOG("SnmpSessionPool: inform not acknowledged (addr)(reason)(pdu type)");
+		LOG(address.get_printable());
+		LOG(reason);
+		LOG(pdu.get_type());
+		LOG_END;
+	}
+	pool->start_synch();
+	pool->pendingInforms--;
+	pool->end_synch();
+}
+
+int SnmpSessionPool::get_pending_informs()
+{
+	start_synch();
+	int n = pendingInforms;
+	end_synch();
+	return n;
+}
+
+void SnmpSessionPool::clear()
+{
+	start_synch();
+	Snmpx* snmp = informSession;
+	informSession = 0;
+	idle.clearAll();
+	end_synch();
+	// outstanding informs are called back with SNMP_CLASS_SESSION_DESTROYED
+	if (snmp) delete snmp;
+}
+
 #ifdef _SNMPv3
 
 //------------------------------ SnmpRequestV3 -------------------------------
@@ -416,8 +539,8 @@ int SnmpRequestV3::send(Mib* mib, UTarget& target, Pdux& pdu)
 {
 	int status;
 
-	Snmpx* snmp = SnmpRequest::get_new_snmp(
-                mib->get_request_list()->get_snmp(), status);
+	SnmpSessionPool* pool = SnmpSessionPool::instance();
+	Snmpx* snmp = pool->acquire(mib->get_request_list()->get_snmp(), status);
 	if (status != SNMP_CLASS_SUCCESS) {
 		if (snmp) delete snmp;
 		return status;
@@ -425,39 +548,52 @@ int SnmpRequestV3::send(Mib* mib, UTarget& target, Pdux& pdu)
 
 	switch (pdu.get_type()) {
 	case sNMP_PDU_GET: {
-		Counter32MibLeaf::incrementScalar(Mib::instance, 
-                        oidSnmpOutGetRequests);
+		MibIIsnmpCounters::incOutGetRequests();
 		status = snmp->get(pdu, target);
 		break;
 	}
     case sNMP_PDU_GETNEXT:
     case sNMP_PDU_GETBULK: {
-        Counter32MibLeaf::incrementScalar(mib, oidSnmpOutGetNexts);
+        MibIIsnmpCounters::incOutGetNexts();
         status = snmp->get_next(pdu, target);
         break;
     }
 	case sNMP_PDU_SET: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutSetRequests);
+                MibIIsnmpCounters::incOutSetRequests();
 		status = snmp->set(pdu, target);
 		break;
 	}
 	case sNMP_PDU_V1TRAP:
 	case sNMP_PDU_TRAP: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutTraps);
+                MibIIsnmpCounters::incOutTraps();
 		status = snmp->trap(pdu, target);
 		break;
 	}
 	case sNMP_PDU_INFORM: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutTraps);
+                MibIIsnmpCounters::incOutTraps();
 		status = snmp->inform(pdu, target);
 		break;
 	}
 	}
 	if (status == SNMP_CLASS_SUCCESS) {
-            Counter32MibLeaf::incrementScalar(mib, oidSnmpOutPkts);
+            MibIIsnmpCounters::incOutPkts();
         }
-	delete snmp;
+	pool->release(snmp);
+
+	return status;
+}
 
+int SnmpRequestV3::send_async(Mib* mib, UTarget& target, Pdux& pdu)
+{
+	if (pdu.get_type() != sNMP_PDU_INFORM) {
+		return send(mib, target, pdu);
+	}
+        MibIIsnmpCounters::incOutTraps();
+	int status = SnmpSessionPool::instance()->send_inform(
+                mib->get_request_list()->get_snmp(), pdu, target);
+	if (status == SNMP_CLASS_SUCCESS) {
+            MibIIsnmpCounters::incOutPkts();
+        }
 	return status;
 }
 
@@ -467,17 +603,17 @@ int SnmpRequestV3::send_request(UTarget& target, Pdux& pdu,
 	int status = SNMP_CLASS_INVALID_PDU;
 	switch (pdu.get_type()) {
 	case sNMP_PDU_GET: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutGetRequests);
+                MibIIsnmpCounters::incOutGetRequests();
 		status = snmp->get(pdu, target);
 		break;
 	}
 	case sNMP_PDU_GETNEXT: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutGetNexts);
+                MibIIsnmpCounters::incOutGetNexts();
 		status = snmp->get_next(pdu, target);
 		break;
         }
         case sNMP_PDU_GETBULK: {
-            Counter32MibLeaf::incrementScalar(mib, oidSnmpOutGetNexts);
+            MibIIsnmpCounters::incOutGetNexts();
             if (target.get_version() == version1)
                 status = snmp->get_next(pdu, target);
             else
@@ -485,24 +621,24 @@ int SnmpRequestV3::send_request(UTarget& target, Pdux& pdu,
             break;
 	}
 	case sNMP_PDU_SET: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutSetRequests);
+                MibIIsnmpCounters::incOutSetRequests();
 		status = snmp->set(pdu, target);
 		break;
 	}
 	case sNMP_PDU_V1TRAP:
 	case sNMP_PDU_TRAP: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutTraps);
+                MibIIsnmpCounters::incOutTraps();
 		status = snmp->trap(pdu, target);
 		break;
 	}
 	case sNMP_PDU_INFORM: {
-                Counter32MibLeaf::incrementScalar(mib, oidSnmpOutTraps);
+                MibIIsnmpCounters::incOutTraps();
 		status = snmp->inform(pdu, target);
 		break;
 	}
 	}
 	if (status == SNMP_CLASS_SUCCESS) {
-            Counter32MibLeaf::incrementScalar(mib, oidSnmpOutPkts);
+            MibIIsnmpCounters::incOutPkts();
         }
 	return status;
 }
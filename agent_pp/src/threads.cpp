@@ -923,6 +923,19 @@ void Thread::sleep(long millis, int nanos)
 #endif
 }
 
+int Thread::available_processors()
+{
+	int n = 0;
+#ifdef _WIN32THREADS
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	n = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (n > 0) ? n : 4;
+}
+
 void Thread::nsleep(int secs, long nanos)
 {
 #ifdef WIN32
@@ -1239,12 +1252,427 @@ void QueuedThreadPool::idle_notification()
 	ThreadPool::idle_notification();
 }
 
+/*--------------------- class TaskQueue --------------------------*/
+
+TaskQueue::TaskQueue(unsigned int capacity): head(0), tail(0)
+{
+	unsigned long n = 2;
+	while (n < capacity) n <<= 1;
+	mask = n - 1;
+	slots = new Slot[n];
+	for (unsigned long i=0; i<n; i++) {
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+		slots[i].task = 0;
+	}
+}
+
+TaskQueue::~TaskQueue()
+{
+	delete[] slots;
+}
+
+bool TaskQueue::add(Runnable* t)
+{
+	unsigned long pos = tail.load(std::memory_order_relaxed);
+	for (;;) {
+		Slot* slot = &slots[pos & mask];
+		unsigned long seq = slot->sequence.load(std::memory_order_acquire);
+		long diff = (long)seq - (long)pos;
+		if (diff == 0) {
+			// slot is free, try to claim it
+			if (tail.compare_exchange_weak(pos, pos + 1,
+						       std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+			return FALSE; // full
+		else
+			pos = tail.load(std::memory_order_relaxed);
+	}
+	Slot* slot = &slots[pos & mask];
+	slot->task = t;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return TRUE;
+}
+
+Runnable* TaskQueue::remove()
+{
+	unsigned long pos = head.load(std::memory_order_relaxed);
+	for (;;) {
+		Slot* slot = &slots[pos & mask];
+		unsigned long seq = slot->sequence.load(std::memory_order_acquire);
+		long diff = (long)seq - (long)(pos + 1);
+		if (diff == 0) {
+			// slot is filled, try to claim it
+			if (head.compare_exchange_weak(pos, pos + 1,
+						       std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+			return 0; // empty
+		else
+			pos = head.load(std::memory_order_relaxed);
+	}
+	Slot* slot = &slots[pos & mask];
+	Runnable* t = slot->task;
+	slot->sequence.store(pos + mask + 1, std::memory_order_release);
+	return t;
+}
+
+unsigned int TaskQueue::size() const
+{
+	unsigned long h = head.load(std::memory_order_relaxed);
+	unsigned long t = tail.load(std::memory_order_relaxed);
+	return (t > h) ? (unsigned int)(t - h) : 0;
+}
+
+/*--------------------- class WorkStealingWorker -------------------*/
+
+#define AGENTPP_WORKER_DEQUE_SIZE 256
+
+/**
+ * A WorkStealingWorker runs one thread of a WorkStealingThreadPool.
+ * Its deque is a bounded Chase-Lev deque: only the owning thread
+ * pushes and takes at the bottom, other threads steal from the top.
+ */
+class WorkStealingWorker : public Runnable {
+public:
+	WorkStealingWorker(WorkStealingThreadPool* p, int stackSize):
+	  pool(p), top(0), bottom(0), thread(*this)
+	{
+		for (int i=0; i<AGENTPP_WORKER_DEQUE_SIZE; i++)
+			deque[i].store(0, std::memory_order_relaxed);
+		thread.set_stack_size(stackSize);
+	}
+
+	void	start()	{ thread.start(); }
+	void	join()	{ thread.join(); }
+	void	run();
+
+	// owner only
+	bool	push(Runnable* t) {
+		long b = bottom.load(std::memory_order_relaxed);
+		long tp = top.load(std::memory_order_acquire);
+		if (b - tp >= AGENTPP_WORKER_DEQUE_SIZE) return FALSE;
+		deque[b % AGENTPP_WORKER_DEQUE_SIZE].store(t, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return TRUE;
+	}
+
+	// owner only
+	Runnable* take() {
+		long b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long tp = top.load(std::memory_order_relaxed);
+		if (tp > b) {
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return 0;
+		}
+		Runnable* t = deque[b % AGENTPP_WORKER_DEQUE_SIZE].load(std::memory_order_relaxed);
+		if (tp == b) {
+			// last task, race against thieves
+			if (!top.compare_exchange_strong(tp, tp + 1,
+							 std::memory_order_seq_cst,
+							 std::memory_order_relaxed))
+				t = 0;
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return t;
+	}
+
+	// any thread
+	Runnable* steal() {
+		long tp = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long b = bottom.load(std::memory_order_acquire);
+		if (tp >= b) return 0;
+		Runnable* t = deque[tp % AGENTPP_WORKER_DEQUE_SIZE].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(tp, tp + 1,
+						 std::memory_order_seq_cst,
+						 std::memory_order_relaxed))
+			return 0;
+		return t;
+	}
+
+	unsigned int size() const {
+		long n = bottom.load(std::memory_order_relaxed) -
+		    top.load(std::memory_order_relaxed);
+		return (n > 0) ? (unsigned int)n : 0;
+	}
+
+	WorkStealingThreadPool*	pool;
+
+protected:
+	std::atomic<Runnable*>	deque[AGENTPP_WORKER_DEQUE_SIZE];
+	std::atomic<long>	top;
+	std::atomic<long>	bottom;
+	Thread			thread;
+};
+
+// the worker running on the current thread (if any)
+static thread_local WorkStealingWorker* currentWorker = 0;
+
+void WorkStealingWorker::run()
+{
+	currentWorker = this;
+	while (pool->go.load()) {
+		Runnable* t = pool->next_task(this);
+		if (t) {
+			t->run();
+			delete t;
+			pool->executed++;
+			pool->active--;
+		}
+		else {
+			pool->park();
+		}
+	}
+	currentWorker = 0;
+}
+
+/*--------------------- class WorkStealingThreadPool --------------------*/
+
+WorkStealingThreadPool::WorkStealingThreadPool(int size, int queueSize,
+					       int stack_size):
+  ThreadPool(0, stack_size), shared(queueSize), overflowSize(0),
+  sleeping(0), active(0), steals(0), overflows(0), executed(0), go(TRUE)
+{
+	workerCount = (size > 0) ? size : Thread::available_processors();
+	workers = new WorkStealingWorker*[workerCount];
+	for (int i=0; i<workerCount; i++) {
+		workers[i] = new WorkStealingWorker(this, stack_size);
+	}
+	for (int i=0; i<workerCount; i++) {
+		workers[i]->start();
+	}
+	LOG_BEGIN(loggerModuleName, INFO_LOG | 3);
+	LOG("WorkStealingThreadPool: started (threads)");
+	LOG(workerCount);
+	LOG_END;
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+	terminate();
+	join();
+	Runnable* t;
+	for (int i=0; i<workerCount; i++) {
+		while ((t = workers[i]->steal()) != 0) delete t;
+		delete workers[i];
+	}
+	delete[] workers;
+	while ((t = shared.remove()) != 0) delete t;
+	overflow.clearAll();
+}
+
+void WorkStealingThreadPool::execute(Runnable* t)
+{
+	if (!go.load()) {
+		LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+		LOG("WorkStealingThreadPool: task ignored after termination");
+		LOG_END;
+		delete t;
+		return;
+	}
+	WorkStealingWorker* w = currentWorker;
+	if ((!w) || (w->pool != this) || (!w->push(t))) {
+		if (!shared.add(t)) {
+			lock();
+			overflow.add(t);
+			overflowSize++;
+			unlock();
+			overflows++;
+		}
+	}
+	// wake up a sleeping thread (if any), the fence pairs with park()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.load() > 0) {
+		lock();
+		notify();
+		unlock();
+	}
+}
+
+Runnable* WorkStealingThreadPool::next_task(WorkStealingWorker* w)
+{
+	// count the task as active before it leaves the queues, so that
+	// is_idle() never sees neither a queued nor an active task
+	active++;
+	Runnable* t = w->take();
+	if (!t) t = shared.remove();
+	if ((!t) && (overflowSize.load() > 0)) {
+		lock();
+		t = overflow.removeFirst();
+		if (t) overflowSize--;
+		unlock();
+	}
+	if (!t) {
+		int n = workerCount;
+		int self = 0;
+		while ((self < n) && (workers[self] != w)) self++;
+		for (int i=1; (i < n) && (!t); i++) {
+			t = workers[(self + i) % n]->steal();
+			if (t) steals++;
+		}
+	}
+	if (!t) active--;
+	return t;
+}
+
+bool WorkStealingThreadPool::has_task()
+{
+	if ((shared.size() > 0) || (overflowSize.load() > 0))
+		return TRUE;
+	for (int i=0; i<workerCount; i++) {
+		if (workers[i]->size() > 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+void WorkStealingThreadPool::park()
+{
+	lock();
+	sleeping++;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if ((go.load()) && (!has_task())) {
+		wait();
+	}
+	sleeping--;
+	unlock();
+}
+
+bool WorkStealingThreadPool::is_idle()
+{
+	return (active.load() == 0) && (!has_task());
+}
+
+bool WorkStealingThreadPool::is_busy()
+{
+	return (active.load() > 0);
+}
+
+unsigned int WorkStealingThreadPool::queue_length()
+{
+	unsigned int n = shared.size() + overflowSize.load();
+	for (int i=0; i<workerCount; i++) {
+		n += workers[i]->size();
+	}
+	return n;
+}
+
+void WorkStealingThreadPool::terminate()
+{
+	lock();
+	go = FALSE;
+	notify_all();
+	unlock();
+}
+
+void WorkStealingThreadPool::join()
+{
+	for (int i=0; i<workerCount; i++) {
+		workers[i]->join();
+	}
+}
 
 void MibTask::run()
 {
 	(task->called_class->*task->method)(task->req);       	
 }
 
+/*--------------------- class TicketLock --------------------------*/
+
+void TicketLock::acquire()
+{
+	lock();
+	unsigned long ticket = nextTicket++;
+	while (ticket != nowServing) {
+		wait();
+	}
+	unlock();
+}
+
+Synchronized::TryLockResult TicketLock::try_acquire()
+{
+	TryLockResult result = BUSY;
+	lock();
+	if (nextTicket == nowServing) {
+		nextTicket++;
+		result = LOCKED;
+	}
+	unlock();
+	return result;
+}
+
+void TicketLock::release()
+{
+	lock();
+	if (nowServing != nextTicket) {
+		nowServing++;
+		// only the thread holding the next ticket will proceed
+		notify_all();
+	}
+	else {
+		LOG_BEGIN(loggerModuleName, WARNING_LOG | 2);
+		LOG("TicketLock: release of free lock ignored (ptr)");
+		LOG((long)this);
+		LOG_END;
+	}
+	unlock();
+}
+
+bool TicketLock::is_held()
+{
+	lock();
+	bool held = (nextTicket != nowServing);
+	unlock();
+	return held;
+}
+
+/*--------------------- class ReadWriteLock --------------------------*/
+
+void ReadWriteLock::read_lock()
+{
+	lock();
+	while ((writer) || (waitingWriters > 0)) {
+		wait();
+	}
+	readers++;
+	unlock();
+}
+
+void ReadWriteLock::read_unlock()
+{
+	lock();
+	if ((--readers == 0) && (waitingWriters > 0)) {
+		notify_all();
+	}
+	unlock();
+}
+
+void ReadWriteLock::write_lock()
+{
+	lock();
+	waitingWriters++;
+	while ((writer) || (readers > 0)) {
+		wait();
+	}
+	waitingWriters--;
+	writer = TRUE;
+	unlock();
+}
+
+void ReadWriteLock::write_unlock()
+{
+	lock();
+	writer = FALSE;
+	notify_all();
+	unlock();
+}
+
 #ifdef NO_FAST_MUTEXES
 
 LockRequest::LockRequest(Synchronized* s)
@@ -22,6 +22,12 @@
 
 #include <agent_pp/tools.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef AGENTPP_NAMESPACE
 namespace Agentpp {
 #endif
@@ -84,6 +90,101 @@ bool AgentTools::make_path(std::string path)
     return result;
 }
 
+bool AgentTools::sync_file(FILE* f)
+{
+	if (fflush(f) != 0)
+		return FALSE;
+#ifdef WIN32
+	return (_commit(_fileno(f)) == 0);
+#else
+	return (fsync(fileno(f)) == 0);
+#endif
+}
+
+bool AgentTools::replace_file(const char* from, const char* to)
+{
+#ifdef WIN32
+	_unlink(to);
+#endif
+	if (rename(from, to) != 0)
+		return FALSE;
+#ifndef WIN32
+	// make the rename durable
+	std::string dir(to);
+	std::string::size_type sep = dir.find_last_of('/');
+	dir = (sep == std::string::npos) ? std::string(".") :
+	    ((sep == 0) ? std::string("/") : dir.substr(0, sep));
+	int fd = ::open(dir.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		fsync(fd);
+		::close(fd);
+	}
+#endif
+	return TRUE;
+}
+
+unsigned long AgentTools::crc32(const unsigned char* data, size_t length,
+				unsigned long crc)
+{
+	// nibble table of the reflected polynomial 0xEDB88320
+	static const unsigned long table[16] = {
+		0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+		0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+		0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+		0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+	};
+	crc = ~crc & 0xFFFFFFFFUL;
+	for (size_t i=0; i<length; i++) {
+		crc ^= data[i];
+		crc = (crc >> 4) ^ table[crc & 0x0F];
+		crc = (crc >> 4) ^ table[crc & 0x0F];
+	}
+	return ~crc & 0xFFFFFFFFUL;
+}
+
+const char* AgentTools::map_file(const char* fname, long& size)
+{
+	size = 0;
+#ifdef WIN32
+	FILE* f = fopen(fname, "rb");
+	if (!f) return 0;
+	long length = file_size(f);
+	char* data = 0;
+	if (length > 0) {
+		data = new char[length];
+		if ((long)fread(data, sizeof(char), length, f) != length) {
+			delete[] data;
+			data = 0;
+		}
+		else size = length;
+	}
+	fclose(f);
+	return data;
+#else
+	int fd = ::open(fname, O_RDONLY);
+	if (fd < 0) return 0;
+	struct stat st;
+	void* data = MAP_FAILED;
+	if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+		data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	if (data == MAP_FAILED) return 0;
+	size = (long)st.st_size;
+	return (const char*)data;
+#endif
+}
+
+void AgentTools::unmap_file(const char* data, long size)
+{
+	if (!data) return;
+#ifdef WIN32
+	delete[] data;
+#else
+	munmap((void*)data, size);
+#endif
+}
+
 /*--------------------------- class Timer --------------------------*/
 
 bool Timer::in_time()
@@ -644,26 +644,34 @@ MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
 		   authPassword, privPassword, engineID, addPassWordsToUSM);
 }
 
-MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
-				     const OctetStr& securityName,
-				     int authProtocol,
-				     int privProtocol,
-				     const OctetStr& authPassword,
-				     const OctetStr& privPassword,
-				     const OctetStr& engineID,
-				     const bool addPassWordsToUSM)
+/**
+ * Localized keys of a user, computed by localize_keys().
+ */
+struct UsmLocalizedKeys
 {
-  unsigned char privKey[SNMPv3_USM_MAX_KEY_LEN];
   unsigned char authKey[SNMPv3_USM_MAX_KEY_LEN];
-  unsigned int authKeyLength = SNMPv3_USM_MAX_KEY_LEN;
-  unsigned int privKeyLength = SNMPv3_USM_MAX_KEY_LEN;
+  unsigned int  authKeyLength;
+  unsigned char privKey[SNMPv3_USM_MAX_KEY_LEN];
+  unsigned int  privKeyLength;
+
+  void clear() { memset(this, 0, sizeof(UsmLocalizedKeys)); }
+};
+
+static bool localize_keys(USM* usm, int authProtocol, int privProtocol,
+			  const OctetStr& authPassword,
+			  const OctetStr& privPassword,
+			  const OctetStr& engineID,
+			  UsmLocalizedKeys& keys)
+{
+  keys.authKeyLength = SNMPv3_USM_MAX_KEY_LEN;
+  keys.privKeyLength = SNMPv3_USM_MAX_KEY_LEN;
 
   int res = usm->get_auth_priv()->password_to_key_auth(
                                             authProtocol,
                                             authPassword.data(),
                                             authPassword.len(),
                                             engineID.data(), engineID.len(),
-                                            authKey, &authKeyLength);
+                                            keys.authKey, &keys.authKeyLength);
   if (res != SNMPv3_USM_OK)
   {
     if (res == SNMPv3_USM_UNSUPPORTED_AUTHPROTOCOL)
@@ -680,7 +688,7 @@ MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
       LOG(res);
       LOG_END;
     }
-    return 0;
+    return FALSE;
   }
 
   res = usm->get_auth_priv()->password_to_key_priv(authProtocol,
@@ -688,7 +696,8 @@ MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
                                                privPassword.data(),
                                                privPassword.len(),
                                                engineID.data(), engineID.len(),
-                                               privKey, &privKeyLength);
+                                               keys.privKey,
+                                               &keys.privKeyLength);
   if (res != SNMPv3_USM_OK)
   {
     if (res == SNMPv3_USM_UNSUPPORTED_PRIVPROTOCOL)
@@ -707,13 +716,31 @@ MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
     }          
     return FALSE;
   }
+  return TRUE;
+}
+
+MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
+				     const OctetStr& securityName,
+				     int authProtocol,
+				     int privProtocol,
+				     const OctetStr& authPassword,
+				     const OctetStr& privPassword,
+				     const OctetStr& engineID,
+				     const bool addPassWordsToUSM)
+{
+  UsmLocalizedKeys keys;
+
+  if (!localize_keys(usm, authProtocol, privProtocol,
+		     authPassword, privPassword, engineID, keys))
+    return 0;
 
   // add User into MIB
   MibTableRow *new_row = addNewRow(engineID, userName, securityName,
 				   authProtocol,
-				   OctetStr(authKey, authKeyLength),
+				   OctetStr(keys.authKey, keys.authKeyLength),
 				   privProtocol,
-				   OctetStr(privKey, privKeyLength));
+				   OctetStr(keys.privKey, keys.privKeyLength));
+  keys.clear();
   if (!new_row)
      return 0;
 
@@ -731,6 +758,129 @@ MibTableRow *UsmUserTable::addNewRow(const OctetStr& userName,
   return new_row;
 }
 
+#ifdef _THREADS
+/**
+ * Localizes the keys for UsmUserTable::addNewRows(). All threads run
+ * the same instance and take the next user from a shared index.
+ */
+class UsmKeyLocalizer: public Runnable
+{
+ public:
+  UsmKeyLocalizer(USM* u, const UsmUserPasswords* us, UsmLocalizedKeys* k,
+		  bool* r, int n, const OctetStr& e)
+    : usm(u), users(us), keys(k), results(r), count(n), engineID(e),
+      next(0) {}
+
+  virtual void run()
+  {
+    int i;
+    while ((i = next++) < count)
+      results[i] = localize_keys(usm, users[i].authProtocol,
+				 users[i].privProtocol,
+				 users[i].authPassword,
+				 users[i].privPassword, engineID, keys[i]);
+  }
+
+ private:
+  USM* usm;
+  const UsmUserPasswords* users;
+  UsmLocalizedKeys* keys;
+  bool* results;
+  int count;
+  const OctetStr& engineID;
+  std::atomic<int> next;
+};
+#endif
+
+int UsmUserTable::addNewRows(const UsmUserPasswords* users, int count)
+{
+  OctetStr engineID(usm->get_local_engine_id());
+  return addNewRows(users, count, engineID, true);
+}
+
+int UsmUserTable::addNewRows(const UsmUserPasswords* users, int count,
+			     const OctetStr& engineID,
+			     const bool addPassWordsToUSM)
+{
+  if (!users || (count <= 0))
+    return 0;
+
+  UsmLocalizedKeys* keys = new UsmLocalizedKeys[count];
+  bool* results = new bool[count];
+
+#ifdef _THREADS
+  int threadCount = Thread::available_processors();
+  if (threadCount > count)
+    threadCount = count;
+
+  UsmKeyLocalizer localizer(usm, users, keys, results, count, engineID);
+  Thread** threads = new Thread*[threadCount];
+  for (int t = 0; t < threadCount; t++)
+  {
+    threads[t] = new Thread(localizer);
+    threads[t]->start();
+  }
+  for (int t = 0; t < threadCount; t++)
+  {
+    threads[t]->join();
+    delete threads[t];
+  }
+  delete [] threads;
+#else
+  for (int i = 0; i < count; i++)
+    results[i] = localize_keys(usm, users[i].authProtocol,
+			       users[i].privProtocol,
+			       users[i].authPassword, users[i].privPassword,
+			       engineID, keys[i]);
+#endif
+
+  int added = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (!results[i])
+    {
+      keys[i].clear();
+      continue;
+    }
+
+    MibTableRow *new_row = addNewRow(engineID, users[i].userName,
+				     users[i].securityName,
+				     users[i].authProtocol,
+				     OctetStr(keys[i].authKey,
+					      keys[i].authKeyLength),
+				     users[i].privProtocol,
+				     OctetStr(keys[i].privKey,
+					      keys[i].privKeyLength));
+    keys[i].clear();
+    if (!new_row)
+      continue;
+
+    if (addPassWordsToUSM)
+    {
+      // add passwords for user to USM for discovery
+      if (usm->add_usm_user(users[i].userName, users[i].securityName,
+			    users[i].authProtocol, users[i].privProtocol,
+			    users[i].authPassword, users[i].privPassword)
+	  != SNMPv3_USM_OK)
+      {
+	deleteRow(engineID, users[i].userName);
+	continue;
+      }
+    }
+    added++;
+  }
+  delete [] keys;
+  delete [] results;
+
+  LOG_BEGIN(loggerModuleName, INFO_LOG | 3);
+  LOG("UsmUserTable: Added users (count) (requested)");
+  LOG(added);
+  LOG(count);
+  LOG_END;
+
+  return added;
+}
+
 MibTableRow *UsmUserTable::addNewRow(const OctetStr& engineID,
 				     const OctetStr& userName,
 				     const OctetStr& securityName,
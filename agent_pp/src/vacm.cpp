@@ -48,6 +48,268 @@ const index_info       	iVacmViewTreeFamilyTable[2]	=
 { { sNMP_SYNTAX_OCTETS, FALSE, 1, 32 }, { sNMP_SYNTAX_OID, FALSE, 0, 95 } };
 const unsigned int	lVacmViewTreeFamilyTable	= 2;
 
+/*********************************************************************
+
+               VacmViewCache
+
+ ********************************************************************/
+
+#define VACM_VIEW_CACHE_BUCKETS 256
+
+/**
+ * Caches the view names resolved by Vacm for a security model, security
+ * name, security level, view type and context. The cache is tagged with
+ * the versions of the tables the view names were resolved from and
+ * flushed when it is updated with a different version.
+ */
+class VacmViewCache {
+public:
+  VacmViewCache(): count(0), version(0)
+  {
+    memset(buckets, 0, sizeof(buckets));
+  }
+  ~VacmViewCache() { flush(); }
+
+  bool lookup(unsigned long v, int securityModel, const OctetStr& securityName,
+	      int securityLevel, int viewType, const OctetStr& context,
+	      int& status, OctetStr& viewName)
+  {
+    unsigned int h = hash(securityModel, securityName, securityLevel,
+			  viewType, context);
+    bool found = FALSE;
+#ifdef _THREADS
+    lock.read_lock();
+#endif
+    if (v == version) {
+      for (Entry* e = buckets[h % VACM_VIEW_CACHE_BUCKETS]; e; e = e->next) {
+	if ((e->hash == h) && (e->securityModel == securityModel) &&
+	    (e->securityLevel == securityLevel) &&
+	    (e->viewType == viewType) &&
+	    (e->securityName == securityName) && (e->context == context)) {
+	  status = e->status;
+	  viewName = e->viewName;
+	  found = TRUE;
+	  break;
+	}
+      }
+    }
+#ifdef _THREADS
+    lock.read_unlock();
+#endif
+    return found;
+  }
+
+  void store(unsigned long v, int securityModel, const OctetStr& securityName,
+	     int securityLevel, int viewType, const OctetStr& context,
+	     int status, const OctetStr& viewName)
+  {
+    Entry* e = new Entry();
+    e->hash = hash(securityModel, securityName, securityLevel, viewType,
+		   context);
+    e->securityModel = securityModel;
+    e->securityLevel = securityLevel;
+    e->viewType = viewType;
+    e->securityName = securityName;
+    e->context = context;
+    e->status = status;
+    e->viewName = viewName;
+#ifdef _THREADS
+    lock.write_lock();
+#endif
+    if ((v != version) || (count >= VACM_VIEW_CACHE_SIZE)) {
+      flush();
+      version = v;
+    }
+    Entry** bucket = &buckets[e->hash % VACM_VIEW_CACHE_BUCKETS];
+    e->next = *bucket;
+    *bucket = e;
+    count++;
+#ifdef _THREADS
+    lock.write_unlock();
+#endif
+  }
+
+private:
+  struct Entry {
+    unsigned int hash;
+    int securityModel;
+    int securityLevel;
+    int viewType;
+    OctetStr securityName;
+    OctetStr context;
+    int status;
+    OctetStr viewName;
+    Entry* next;
+  };
+
+  void flush()
+  {
+    for (int i=0; i<VACM_VIEW_CACHE_BUCKETS; i++) {
+      while (buckets[i]) {
+	Entry* e = buckets[i];
+	buckets[i] = e->next;
+	delete e;
+      }
+    }
+    count = 0;
+  }
+
+  static unsigned int hash(int securityModel, const OctetStr& securityName,
+			   int securityLevel, int viewType,
+			   const OctetStr& context)
+  {
+    // FNV-1a
+    unsigned int h = 2166136261U;
+    h = (h ^ (unsigned int)securityModel) * 16777619U;
+    h = (h ^ (unsigned int)securityLevel) * 16777619U;
+    h = (h ^ (unsigned int)viewType) * 16777619U;
+    for (unsigned int i=0; i<securityName.len(); i++)
+      h = (h ^ securityName[i]) * 16777619U;
+    h = (h ^ 0xff) * 16777619U;
+    for (unsigned int i=0; i<context.len(); i++)
+      h = (h ^ context[i]) * 16777619U;
+    return h;
+  }
+
+  Entry*	buckets[VACM_VIEW_CACHE_BUCKETS];
+  int		count;
+  unsigned long	version;
+#ifdef _THREADS
+  ReadWriteLock lock;
+#endif
+};
+
+/*********************************************************************
+
+               VacmViewTree
+
+ ********************************************************************/
+
+/**
+ * The view tree families of a view compiled into a trie of subtree
+ * subidentifiers. Subidentifiers masked out by a family's mask are
+ * represented by a wildcard edge. Each node knows the type of the
+ * family ending there; among several families of the same length
+ * that match, the one added last wins, as in the linear search.
+ */
+class VacmViewTree {
+public:
+  VacmViewTree() { }
+
+  void add(const OidxView& subtree, const OctetStr& mask, int type,
+	   unsigned int order)
+  {
+    Node* node = &root;
+    for (unsigned int i=0; i<subtree.len(); i++) {
+      // a family matches any subidentifier where its mask bit is zero
+      bool exact = ((mask.len() <= (i/8)) ||
+		    ((mask[i/8] & (0x01 << (7 - (i % 8)))) > 0));
+      if (exact)
+	node = node->add_child(subtree[i]);
+      else {
+	if (!node->any) node->any = new Node();
+	node = node->any;
+      }
+    }
+    if ((node->type == 0) || (node->order < order)) {
+      node->type = type;
+      node->order = order;
+    }
+  }
+
+  /**
+   * Return the type of the longest family matching the given OID or 0
+   * if none matches.
+   */
+  int match(const OidxView& o) const
+  {
+    const Node* best = 0;
+    unsigned int bestDepth = 0;
+    match(&root, o, 0, best, bestDepth);
+    return (best) ? best->type : 0;
+  }
+
+private:
+  struct Node {
+    Node(): subid(0), children(0), count(0), capacity(0), any(0),
+	    type(0), order(0) { }
+    ~Node()
+    {
+      for (unsigned int i=0; i<count; i++) delete children[i];
+      delete[] children;
+      delete any;
+    }
+
+    Node* child(unsigned long id) const
+    {
+      unsigned int lo = 0, hi = count;
+      while (lo < hi) {
+	unsigned int mid = (lo + hi) / 2;
+	if (children[mid]->subid < id) lo = mid + 1;
+	else hi = mid;
+      }
+      return ((lo < count) && (children[lo]->subid == id)) ? children[lo] : 0;
+    }
+
+    Node* add_child(unsigned long id)
+    {
+      unsigned int lo = 0, hi = count;
+      while (lo < hi) {
+	unsigned int mid = (lo + hi) / 2;
+	if (children[mid]->subid < id) lo = mid + 1;
+	else hi = mid;
+      }
+      if ((lo < count) && (children[lo]->subid == id))
+	return children[lo];
+      if (count == capacity) {
+	capacity = (capacity) ? capacity*2 : 4;
+	Node** c = new Node*[capacity];
+	for (unsigned int i=0; i<count; i++) c[i] = children[i];
+	delete[] children;
+	children = c;
+      }
+      for (unsigned int i=count; i>lo; i--) children[i] = children[i-1];
+      count++;
+      children[lo] = new Node();
+      children[lo]->subid = id;
+      return children[lo];
+    }
+
+    unsigned long	subid;
+    Node**		children;	// sorted by subid
+    unsigned int	count;
+    unsigned int	capacity;
+    Node*		any;		// wildcard child
+    int			type;		// type of the family ending here or 0
+    unsigned int	order;		// position of that family in the view
+  };
+
+  void match(const Node* node, const OidxView& o, unsigned int depth,
+	     const Node*& best, unsigned int& bestDepth) const
+  {
+    if ((node->type) &&
+	((!best) || (depth > bestDepth) ||
+	 ((depth == bestDepth) && (node->order > best->order)))) {
+      best = node;
+      bestDepth = depth;
+    }
+    if (depth >= o.len())
+      return;
+    const Node* c = node->child(o[depth]);
+    if (c) match(c, o, depth+1, best, bestDepth);
+    if (node->any) match(node->any, o, depth+1, best, bestDepth);
+  }
+
+  Node root;
+};
+
+ViewNameIndex::~ViewNameIndex()
+{
+  /* avoid deletion of original rows: */
+  views.clear();
+  delete tree;
+}
+
 
 SnmpUnavailableContexts::SnmpUnavailableContexts():
   MibLeaf(oidSnmpUnavailableContexts, READONLY, new Counter32(0))
@@ -102,6 +364,16 @@ VacmContextTable::~VacmContextTable()
 
 }
 
+void VacmContextTable::row_added(MibTableRow*, const Oidx&, MibTable*)
+{
+  changed();
+}
+
+void VacmContextTable::row_delete(MibTableRow*, const Oidx&, MibTable*)
+{
+  changed();
+}
+
 bool VacmContextTable::addNewRow(const OctetStr& context)
 {
   Oidx newIndex = Oidx::from_string(context, TRUE);
@@ -111,6 +383,7 @@ bool VacmContextTable::addNewRow(const OctetStr& context)
   else {
     MibTableRow *mtr = add_row(newIndex);
     mtr->get_nth(0)->replace_value(new OctetStr(context));
+    changed();
     return TRUE;
   }
 }
@@ -190,6 +463,31 @@ void VacmSecurityToGroupTable::row_added(MibTableRow* new_row,
   ml = new_row->get_nth(1);
   o = o.cut_left(2);
   ml->set_value(o.as_string());
+  changed();
+}
+
+void VacmSecurityToGroupTable::row_delete(MibTableRow*, const Oidx&, MibTable*)
+{
+  changed();
+}
+
+void VacmSecurityToGroupTable::row_activated(MibTableRow*, const Oidx&,
+					     MibTable*)
+{
+  changed();
+}
+
+void VacmSecurityToGroupTable::row_deactivated(MibTableRow*, const Oidx&,
+					       MibTable*)
+{
+  changed();
+}
+
+int VacmSecurityToGroupTable::commit_set_request(Request* req, int ind)
+{
+  int status = StorageTable::commit_set_request(req, ind);
+  changed();
+  return status;
 }
 
 bool VacmSecurityToGroupTable::could_ever_be_managed(const Oidx& o,
@@ -271,6 +569,7 @@ bool VacmSecurityToGroupTable::addNewRow(const int securityModel,
     newRow->get_nth(2)->replace_value(new OctetStr(groupName));
     newRow->get_nth(3)->replace_value(new SnmpInt32(storageType));
     newRow->get_nth(4)->replace_value(new SnmpInt32(1));
+    changed();
 
     return TRUE;
   }
@@ -370,6 +669,29 @@ void VacmAccessTable::row_added(MibTableRow* new_row,
 
   ml = new_row->get_nth(2);
   ml->set_value(o[o.len()-1]);
+  changed();
+}
+
+void VacmAccessTable::row_delete(MibTableRow*, const Oidx&, MibTable*)
+{
+  changed();
+}
+
+void VacmAccessTable::row_activated(MibTableRow*, const Oidx&, MibTable*)
+{
+  changed();
+}
+
+void VacmAccessTable::row_deactivated(MibTableRow*, const Oidx&, MibTable*)
+{
+  changed();
+}
+
+int VacmAccessTable::commit_set_request(Request* req, int ind)
+{
+  int status = StorageTable::commit_set_request(req, ind);
+  changed();
+  return status;
 }
 
 bool VacmAccessTable::could_ever_be_managed(const Oidx& o, int& result)
@@ -413,7 +735,6 @@ bool VacmAccessTable::getViewName(const OctetStr& group,
   MibTableRow* foundRow = NULL;
 
   unsigned int groupLen = group.len();
-  Oidx ind;
 
   LOG_BEGIN(loggerModuleName, DEBUG_LOG | 7);
   LOG("Vacm: getViewName: (group) (context) (model) (level) (type)");
@@ -435,8 +756,8 @@ bool VacmAccessTable::getViewName(const OctetStr& group,
       continue;
     }
 
-    if (cur.get()->get_index()[0] == groupLen) {
-      ind = cur.get()->get_index();
+    OidxView ind(*cur.get()->key());
+    if (ind[0] == groupLen) {
 
       if (ind.cut_right(ind[ind[0]+1]+3).cut_left(1).as_string() == group) {
 
@@ -453,7 +774,7 @@ bool VacmAccessTable::getViewName(const OctetStr& group,
 #endif
              ) &&
             ((int)ind[ind.len() - 1] <= securityLevel)) {
-          OctetStr pref=OctetStr(ind.cut_left(ind[0]+2).cut_right(2).as_string());
+          OctetStr pref(ind.cut_left(ind[0]+2).cut_right(2).as_string());
           int exactMatch;
           cur.get()->get_nth(3)->get_value(exactMatch);
 
@@ -551,6 +872,7 @@ bool VacmAccessTable::addNewRow(const OctetStr& groupName,
     newRow->get_nth(6)->replace_value(new OctetStr(notifyView));
     newRow->get_nth(7)->replace_value(new SnmpInt32(storageType));
     newRow->get_nth(8)->replace_value(new SnmpInt32(1));
+    changed();
 
     return TRUE;
   }
@@ -591,17 +913,14 @@ int VacmViewTreeFamilyTableStatus::set(const Vbx& vb)
 	switch (rs) {
 	case rowNotInService: {
 	  OctetStr viewName = ((SnmpAdminString*)my_row->first())->get();
-	  ViewNameIndex* views =
-	    ((VacmViewTreeFamilyTable*)my_table)->viewsOf(viewName);
-	  if (!views) {
+	  if (!((VacmViewTreeFamilyTable*)my_table)->
+	      removeFromView(viewName, my_row, FALSE)) {
 	    LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
 	    LOG("VacmViewTreeFamilyTableStatus: internal error: view name not found (viewName)");
 	    LOG(viewName.get_printable());
 	    LOG_END;
 	  }
 	  else {
-	    views->remove(my_row);
-
 	    LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
 	    LOG("VacmViewTreeFamilyTable: (sub)view disabled (viewName)");
 	    LOG(viewName.get_printable());
@@ -611,21 +930,14 @@ int VacmViewTreeFamilyTableStatus::set(const Vbx& vb)
 	}
 	case rowActive: {
 	  OctetStr viewName = ((SnmpAdminString*)my_row->first())->get();
-	  ViewNameIndex* views =
-	    ((VacmViewTreeFamilyTable*)my_table)->viewsOf(viewName);
-	  if (!views) {
-	    views = new ViewNameIndex(viewName);
-	    views->add(my_row);
-	    ((VacmViewTreeFamilyTable*)my_table)->viewNameIndex.add(views);
-
+	  if (((VacmViewTreeFamilyTable*)my_table)->
+	      addToView(viewName, my_row)) {
 	    LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
 	    LOG("VacmViewTreeFamilyTable: adding view name (viewName)");
 	    LOG(viewName.get_printable());
 	    LOG_END;
 	  }
 	  else {
-	    views->add(my_row);
-
 	    LOG_BEGIN(loggerModuleName, INFO_LOG | 2);
 	    LOG("VacmViewTreeFamilyTable: updating view (viewName)");
 	    LOG(viewName.get_printable());
@@ -634,6 +946,7 @@ int VacmViewTreeFamilyTableStatus::set(const Vbx& vb)
 	  break;
 	}
 	}
+	((VacmViewTreeFamilyTable*)my_table)->changed();
 	return snmpRowStatus::set(vb);
 }
 
@@ -693,27 +1006,22 @@ void VacmViewTreeFamilyTable::row_added(MibTableRow* new_row,
 
   ml = new_row->get_nth(1);
   ml->set_value(o.cut_left(o[0]+2));
+  changed();
 }
 
 void VacmViewTreeFamilyTable::row_activated(MibTableRow* row,
 					    const Oidx& ind, MibTable*)
 {
     // add row to the index
-    OctetStr viewName = ((SnmpAdminString*)row->first())->get();
-
-    ViewNameIndex* views = viewsOf(viewName);
-    if (views) views->add(row);
-    else viewNameIndex.add(new ViewNameIndex(viewName))->add(row);
+    addToView(((SnmpAdminString*)row->first())->get(), row);
+    changed();
 }
 
 void VacmViewTreeFamilyTable::row_deactivated(MibTableRow* row,
 					      const Oidx& ind, MibTable*)
 {
-    ViewNameIndex* views = viewsOf(((SnmpAdminString*)row->first())->get());
-    if (views) {
-	views->remove(row);
-	if (views->isEmpty()) delete viewNameIndex.remove(views);
-    }
+    removeFromView(((SnmpAdminString*)row->first())->get(), row, TRUE);
+    changed();
 }
 
 void VacmViewTreeFamilyTable::row_delete(MibTableRow* row,
@@ -722,6 +1030,13 @@ void VacmViewTreeFamilyTable::row_delete(MibTableRow* row,
 	row_deactivated(row, ind, t);
 }
 
+int VacmViewTreeFamilyTable::commit_set_request(Request* req, int ind)
+{
+  int status = StorageTable::commit_set_request(req, ind);
+  changed();
+  return status;
+}
+
 bool VacmViewTreeFamilyTable::could_ever_be_managed(const Oidx& o,
 						       int& result)
 
@@ -745,68 +1060,80 @@ bool VacmViewTreeFamilyTable::could_ever_be_managed(const Oidx& o,
 
 int VacmViewTreeFamilyTable::isInMibView(const OctetStr& viewName, const Oidx& subtree)
 {
-  bool found = FALSE;
-  unsigned int foundSubtreeLen = 0;
-  MibTableRow* foundRow = NULL;
-  Oidx ind;
-
   LOG_BEGIN(loggerModuleName, DEBUG_LOG | 7);
   LOG("Vacm: isInMibView: (viewName) (subtree)");
   LOG(OctetStr(viewName).get_printable());
   LOG(Oid(subtree).get_printable());
   LOG_END;
 
+  // match against the compiled view, compile it first if the table
+  // has changed since
+  int type;
+#ifdef _THREADS
+  treeLock.read_lock();
+  ViewNameIndex* views = viewsOf(viewName);
+  if (!views) {
+    treeLock.read_unlock();
+    return VACM_noSuchView;
+  }
+  if ((!views->tree) || (views->treeVersion != get_version())) {
+    treeLock.read_unlock();
+    treeLock.write_lock();
+    // the view may have been removed while the lock was released
+    views = viewsOf(viewName);
+    if (!views) {
+      treeLock.write_unlock();
+      return VACM_noSuchView;
+    }
+    compileView(views);
+    type = views->tree->match(OidxView(subtree));
+    treeLock.write_unlock();
+  }
+  else {
+    type = views->tree->match(OidxView(subtree));
+    treeLock.read_unlock();
+  }
+#else
   ViewNameIndex* views = viewsOf(viewName);
-
   if (!views) return VACM_noSuchView;
+  if ((!views->tree) || (views->treeVersion != get_version()))
+    compileView(views);
+  type = views->tree->match(OidxView(subtree));
+#endif
+  if (type == view_included) {
 
+      LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
+      LOG("Vacm: isInMibView: access allowed");
+      LOG_END;
+      return VACM_accessAllowed;
+  }
+  return VACM_notInView;
+}
 
+void VacmViewTreeFamilyTable::compileView(ViewNameIndex* views)
+{
+  unsigned long version = get_version();
+  if ((views->tree) && (views->treeVersion == version))
+    return;
+  VacmViewTree* tree = new VacmViewTree();
+  unsigned int order = 0;
   ListCursor<MibTableRow> cur;
-  for (cur.init(&views->views); cur.get(); cur.next()) {
+  for (cur.init(&views->views); cur.get(); cur.next(), order++) {
 
-    ind = cur.get()->get_index();
+    OidxView ind(*cur.get()->key());
     ind = ind.cut_left(ind[0]+1);
-
-    if (ind[0] > subtree.len())
-      continue;
     ind = ind.cut_left(1);
     OctetStr mask;
     cur.get()->get_nth(2)->get_value(mask);
-    bool ok = TRUE;
-    for (unsigned int i=0; i<ind.len(); i++) {
-      if ((ind[i] != subtree[i]) && (bit(i, mask))) {
-	ok = FALSE;
-	break;
-      }
-    }
-    if (ok) {
-      if (found) { // already found one
-	if (foundSubtreeLen <= ind.len()) {
-            foundRow = cur.get();
-            foundSubtreeLen = ind.len();
-	}
-      }
-      else { // first row found
-	found = TRUE;
-	foundSubtreeLen = ind.len();
-	foundRow = cur.get();
-      }
-    }
+    int type;
+    cur.get()->get_nth(3)->get_value(type);
+    // excluded is anything but included
+    tree->add(ind, mask, (type == view_included) ? view_included :
+	      view_excluded, order);
   }
-  if (found) {
-    int tmpval;
-    foundRow->get_nth(3)->get_value(tmpval);
-    if (tmpval==1) { //included
-
-      LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
-      LOG("Vacm: isInMibView: access allowed");
-      LOG_END;
-      return VACM_accessAllowed;
-    }
-    else //excluded
-      return VACM_notInView;
-  }
-  return VACM_notInView;
+  delete views->tree;
+  views->tree = tree;
+  views->treeVersion = version;
 }
 
 bool VacmViewTreeFamilyTable::bit(unsigned int nr, OctetStr& o)
@@ -823,15 +1150,54 @@ bool VacmViewTreeFamilyTable::bit(unsigned int nr, OctetStr& o)
 void VacmViewTreeFamilyTable::buildViewNameIndex()
 {
   OidListCursor<MibTableRow> cur;
+  changed();
+#ifdef _THREADS
+  treeLock.write_lock();
+#endif
   viewNameIndex.clear();
-  OctetStr viewName;
-  for (cur.init(&content); cur.get(); cur.next()) {
+#ifdef _THREADS
+  treeLock.write_unlock();
+#endif
+  for (cur.init(&content); cur.get(); cur.next())
+    addToView(((SnmpAdminString*)cur.get()->first())->get(), cur.get());
+}
+
+bool VacmViewTreeFamilyTable::addToView(const OctetStr& viewName,
+					MibTableRow* row)
+{
+#ifdef _THREADS
+  treeLock.write_lock();
+#endif
+  bool created = FALSE;
+  ViewNameIndex* views = viewsOf(viewName);
+  if (!views) {
+    views = viewNameIndex.add(new ViewNameIndex(viewName));
+    created = TRUE;
+  }
+  views->add(row);
+#ifdef _THREADS
+  treeLock.write_unlock();
+#endif
+  return created;
+}
 
-    viewName = ((SnmpAdminString*)cur.get()->first())->get();
-    ViewNameIndex* views = viewsOf(viewName);
-    if (views) views->add(cur.get());
-    else viewNameIndex.add(new ViewNameIndex(viewName))->add(cur.get());
+bool VacmViewTreeFamilyTable::removeFromView(const OctetStr& viewName,
+					     MibTableRow* row,
+					     bool removeEmpty)
+{
+#ifdef _THREADS
+  treeLock.write_lock();
+#endif
+  ViewNameIndex* views = viewsOf(viewName);
+  if (views) {
+    views->remove(row);
+    if ((removeEmpty) && (views->isEmpty()))
+      delete viewNameIndex.remove(views);
   }
+#ifdef _THREADS
+  treeLock.write_unlock();
+#endif
+  return (views != 0);
 }
 
 
@@ -869,10 +1235,8 @@ void VacmViewTreeFamilyTable::row_init(MibTableRow* newRow, const Oidx& ind,
 		o = o.cut_left(1); // cut off length
 		OctetStr viewName(o.as_string());
 
-		ViewNameIndex* views = viewsOf(viewName);
-		if (views) views->add(newRow);
-		else viewNameIndex.add(new ViewNameIndex(viewName))->
-		       add(newRow);
+		addToView(viewName, newRow);
+		changed();
 	}
 }
 
@@ -928,6 +1292,7 @@ Vacm::Vacm()
   vcp.viewTreeFamilyTable = 0;
   vcp.snmpUnknownContexts = 0;
   vcp.snmpUnavailableContexts = 0;
+  viewCache = new VacmViewCache();
 }
 
 Vacm::Vacm(Mib& mib)
@@ -941,11 +1306,12 @@ Vacm::Vacm(Mib& mib)
   mib.add(new VacmMIB(vcp));
   mib.add(vcp.snmpUnknownContexts);
   mib.add(vcp.snmpUnavailableContexts);
+  viewCache = new VacmViewCache();
 }
 
 Vacm::~Vacm(void)
 {
-
+  delete viewCache;
 }
 
 bool Vacm::addNewContext(const OctetStr &newContext)
@@ -1019,20 +1385,11 @@ int Vacm::isAccessAllowed(const int securityModel, const OctetStr &securityName,
   LOG(o.get_printable());
   LOG_END;
 
-  if (!(vcp.contextTable->isContextSupported(context)))
-    return VACM_noSuchContext;
-
-  OctetStr groupName;
-  if (!(vcp.securityToGroupTable->getGroupName(securityModel, securityName, groupName)))
-    return VACM_noGroupName;
-
   OctetStr viewName;
-  if (!(vcp.accessTable->getViewName(groupName, context,
-                                     securityModel, securityLevel, viewType, viewName)))
-    return VACM_noAccessEntry;
-
-  if (viewName.len() == 0)
-    return VACM_noSuchView;
+  int status = resolveViewName(securityModel, securityName, securityLevel,
+                               viewType, context, viewName);
+  if (status != VACM_viewFound)
+    return status;
 
   return (vcp.viewTreeFamilyTable->isInMibView(viewName, o));
 }
@@ -1050,21 +1407,43 @@ int Vacm::getViewName(const int securityModel, const OctetStr &securityName,
   LOG(context.get_printable());
   LOG_END;
 
-  if (!(vcp.contextTable->isContextSupported(context)))
-    return VACM_noSuchContext;
-
-  OctetStr groupName;
-  if (!(vcp.securityToGroupTable->getGroupName(securityModel, securityName, groupName)))
-    return VACM_noGroupName;
-
-  if (!(vcp.accessTable->getViewName(groupName, context,
-                                     securityModel, securityLevel, viewType, viewName)))
-    return VACM_noAccessEntry;
-
-  if (viewName.len() == 0)
-    return VACM_noSuchView;
+  return resolveViewName(securityModel, securityName, securityLevel,
+                         viewType, context, viewName);
+}
 
-  return VACM_viewFound;
+int Vacm::resolveViewName(const int securityModel, const OctetStr &securityName,
+                          const int securityLevel, const int viewType,
+                          const OctetStr &context, OctetStr &viewName)
+{
+  // the tables only grow their versions, so the sum changes with
+  // every change of any of them
+  unsigned long version = vcp.contextTable->get_version() +
+    vcp.securityToGroupTable->get_version() +
+    vcp.accessTable->get_version();
+
+  int status;
+  OctetStr name;
+  if (!viewCache->lookup(version, securityModel, securityName, securityLevel,
+                         viewType, context, status, name)) {
+    OctetStr groupName;
+    if (!(vcp.contextTable->isContextSupported(context)))
+      status = VACM_noSuchContext;
+    else if (!(vcp.securityToGroupTable->getGroupName(securityModel, securityName, groupName)))
+      status = VACM_noGroupName;
+    else if (!(vcp.accessTable->getViewName(groupName, context,
+                                            securityModel, securityLevel, viewType, name)))
+      status = VACM_noAccessEntry;
+    else if (name.len() == 0)
+      status = VACM_noSuchView;
+    else
+      status = VACM_viewFound;
+
+    viewCache->store(version, securityModel, securityName, securityLevel,
+                     viewType, context, status, name);
+  }
+  if ((status == VACM_viewFound) || (status == VACM_noSuchView))
+    viewName = name;
+  return status;
 }
 
 
@@ -15,6 +15,7 @@
 
 #include <snmp_pp/oid_def.h>
 #include <snmp_pp/mp_v3.h>
+#include <snmp_pp/auth_priv.h>
 #include <snmp_pp/log.h>
 
 #ifdef SNMP_PP_NAMESPACE
@@ -99,6 +100,8 @@ void init(Mib &mib, const NS_SNMP OctetStr &engineID)
 
   // Serialize the array into an OctetStr
   OctetStr serializedData(reinterpret_cast<const unsigned char *>(floatData), sizeof(floatData));
+  // share the payload, so that requests do not copy the array
+  serializedData.share();
 
   // Add the entire array as a single MibStaticEntry
   ssg->add(MibStaticEntry("3.0", serializedData));
@@ -138,7 +141,9 @@ int main(int argc, char *argv[])
 #endif
   int status;
   Snmp::socket_startup(); // Initialize socket subsystem
-  Snmpx snmp(status, port);
+  // bind with SO_REUSEPORT, so that the receiver threads started below
+  // can listen on the same port
+  Snmpx snmp(status, port, false, true);
 
   if (status == SNMP_CLASS_SUCCESS)
   {
@@ -156,7 +161,17 @@ int main(int argc, char *argv[])
     LOG_END;
     exit(1);
   }
+  // drain queued requests with one system call instead of one per request
+  snmp.set_batch_size(16);
   mib = new Mib();
+#ifdef AGENTPP_USE_THREAD_POOL
+  // one worker per processor, idle workers steal queued requests
+  mib->set_thread_pool(new WorkStealingThreadPool());
+#endif
+#ifdef _THREADS
+  // none of our tables overrides update(), so lookups may run concurrently
+  mib->set_read_mostly(true);
+#endif
 #ifdef _SNMPv3
   unsigned int snmpEngineBoots = 0;
   OctetStr engineId(SnmpEngineID::create_engine_id(port));
@@ -185,6 +200,15 @@ int main(int argc, char *argv[])
 
   int stat;
   v3MP *v3mp = new v3MP(engineId, snmpEngineBoots, stat);
+  // reuse the localized keys of the last run, localizing is slow;
+  // the secret protecting the cached passwords is kept out of the file
+  const char *keyCacheSecret = getenv("SNMPV3_KEY_CACHE_SECRET");
+  if (keyCacheSecret && *keyCacheSecret)
+  {
+    v3mp->get_usm()->get_auth_priv()->enable_key_cache(
+      "snmpv3_keys", (const unsigned char *)keyCacheSecret,
+      (unsigned int)strlen(keyCacheSecret));
+  }
 #else
   OctetStr engineId; // not used without SNMPv3
 #endif
@@ -203,6 +227,9 @@ int main(int argc, char *argv[])
   init(*mib, engineId);
   // load persistent objects from disk
   mib->init();
+#ifdef _SNMPv3
+  v3mp->get_usm()->get_auth_priv()->save_key_cache();
+#endif
 
   reqList->set_snmp(&snmp);
 
@@ -227,10 +254,44 @@ int main(int argc, char *argv[])
   Vbx *vbs = 0;
   coldStartOid coldOid;
   NotificationOriginator no;
+  // send notifications from a background thread, so that a burst of
+  // them does not hold up request processing
+  no.set_async(true);
   UdpAddress dest("127.0.0.1/162");
   no.add_v1_trap_destination(dest, "defaultV1Trap", "v1trap", "public");
   no.generate(vbs, 0, coldOid, "", "");
 
+#ifdef _THREADS
+  // one more session and receive thread per additional processor, the
+  // kernel spreads incoming requests over the sessions on our port
+  int receiverCount = 0;
+  int maxReceivers = Thread::available_processors() - 1;
+  Snmpx **sessions = new Snmpx*[maxReceivers > 0 ? maxReceivers : 1];
+  RequestReceiver **receivers =
+    new RequestReceiver*[maxReceivers > 0 ? maxReceivers : 1];
+  while (receiverCount < maxReceivers)
+  {
+    Snmpx *session = new Snmpx(status, port, false, true);
+    if (status != SNMP_CLASS_SUCCESS)
+    {
+      LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+      LOG("main: could not open additional session on port (status)");
+      LOG(status);
+      LOG_END;
+      delete session;
+      break;
+    }
+#ifdef _SNMPv3
+    session->set_mpv3(v3mp);
+#endif
+    session->set_batch_size(16);
+    sessions[receiverCount] = session;
+    receivers[receiverCount] = new RequestReceiver(mib, reqList, session);
+    receivers[receiverCount]->start();
+    receiverCount++;
+  }
+#endif
+
   Request *req;
   while (run)
   {
@@ -246,6 +307,17 @@ int main(int argc, char *argv[])
       mib->cleanup();
     }
   }
+#ifdef _THREADS
+  for (int i = 0; i < receiverCount; i++)
+    receivers[i]->stop();
+  for (int i = 0; i < receiverCount; i++)
+  {
+    delete receivers[i];
+    delete sessions[i];
+  }
+  delete[] receivers;
+  delete[] sessions;
+#endif
   delete mib;
   Snmp::socket_cleanup(); // Shut down socket subsystem
   return 0;
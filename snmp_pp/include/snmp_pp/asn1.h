@@ -131,6 +131,33 @@ typedef unsigned char oid;
 
 typedef struct sockaddr_in  ipaddr;
 
+// Encoder for the variable bindings of a pdu that are not stored in its
+// variable list. It encodes them back to front in front of data, see
+// rbuild_vb. Returns the new start of the data or NULL on error.
+typedef unsigned char *(*snmp_vb_encoder)(void *arg,
+                                          unsigned char *data,
+                                          int *datalength);
+
+// Memory arena for decoding messages (since 3.5.2). A pdu created with
+// snmp_pdu_create_in() takes itself, its variable list, names and values
+// from the arena instead of malloc(). snmp_free_pdu() of such a pdu
+// releases all of it in one step by resetting the arena, which keeps its
+// blocks for the next message. Not thread safe, use one arena per thread.
+struct snmp_arena_block;
+struct snmp_arena {
+    struct snmp_arena_block *first;    // first block or NULL
+    struct snmp_arena_block *current;  // block to allocate from
+};
+
+#ifndef SNMP_ARENA_BLOCK_SIZE
+#define SNMP_ARENA_BLOCK_SIZE 8192
+#endif
+
+DLLOPT void snmp_arena_init(struct snmp_arena *arena);
+DLLOPT void *snmp_arena_alloc(struct snmp_arena *arena, size_t size);
+DLLOPT void snmp_arena_reset(struct snmp_arena *arena);
+DLLOPT void snmp_arena_destroy(struct snmp_arena *arena);
+
 // pdu
 struct snmp_pdu {
     int        command;      // pdu type
@@ -152,6 +179,13 @@ struct snmp_pdu {
 
     // vb list
     struct variable_list *variables;
+
+    // if set, used instead of variables to encode the vbs
+    snmp_vb_encoder vb_encoder;
+    void *vb_encoder_arg;
+
+    // if set, the pdu and its content are allocated from this arena
+    struct snmp_arena *arena;
 };
 
 // vb list
@@ -275,8 +309,62 @@ DLLOPT unsigned char *asn_build_unsigned_int64(unsigned char *data,
                                                unsigned char type,
                                                struct counter64 *cp);
 
+/*
+ * Reverse builders: encode an object in front of data, decreasing
+ * datalength (the free bytes in front of data) by its size. They return
+ * the new start of the encoded data or NULL on error. A message built
+ * back to front knows the length of each constructed object when its
+ * header is encoded and needs no temporary buffers.
+ */
+DLLOPT unsigned char *asn_rbuild_length(unsigned char *data, int *datalength,
+                                        int length);
+
+DLLOPT unsigned char *asn_rbuild_header(unsigned char *data, int *datalength,
+                                        unsigned char type, int length);
+
+DLLOPT unsigned char *asn_rbuild_int(unsigned char *data, int *datalength,
+                                     const unsigned char type,
+                                     const long *intp);
+
+inline unsigned char *asn_rbuild_int(unsigned char *data, int *datalength,
+                                     const unsigned char type,
+                                     const unsigned long *intp)
+{ return asn_rbuild_int(data, datalength, type, (const long*)intp); }
+
+DLLOPT unsigned char *asn_rbuild_unsigned_int(unsigned char *data,
+                                              int *datalength,
+                                              unsigned char type,
+                                              const unsigned long *intp);
+
+DLLOPT unsigned char *asn_rbuild_unsigned_int64(unsigned char *data,
+                                                int *datalength,
+                                                unsigned char type,
+                                                const struct counter64 *cp);
+
+DLLOPT unsigned char *asn_rbuild_string(unsigned char *data, int *datalength,
+                                        const unsigned char type,
+                                        const unsigned char *string,
+                                        const int strlength);
+
+DLLOPT unsigned char *asn_rbuild_bitstring(unsigned char *data,
+                                           int *datalength,
+                                           unsigned char type,
+                                           const unsigned char *string,
+                                           int strlength);
+
+DLLOPT unsigned char *asn_rbuild_null(unsigned char *data, int *datalength,
+                                      unsigned char type);
+
+DLLOPT unsigned char *asn_rbuild_objid(unsigned char *data, int *datalength,
+                                       unsigned char type,
+                                       const oid *objid, int objidlength);
+
 DLLOPT struct snmp_pdu *snmp_pdu_create(int command);
 
+// Create a pdu within the given arena, see struct snmp_arena.
+DLLOPT struct snmp_pdu *snmp_pdu_create_in(struct snmp_arena *arena,
+                                           int command);
+
 DLLOPT void snmp_free_pdu(struct snmp_pdu *pdu);
 
 DLLOPT int snmp_build(struct snmp_pdu *pdu,
@@ -301,6 +389,23 @@ DLLOPT unsigned char *build_data_pdu(struct snmp_pdu *pdu,
 				     unsigned char *buf, int *buf_len,
 				     unsigned char *vb_buf, int vb_buf_len);
 
+// Build the variable bindings (rbuild_vb) or the complete data pdu
+// including the variable bindings (rbuild_data_pdu) in front of data.
+// The variable bindings are taken from pdu->vb_encoder if it is set.
+DLLOPT unsigned char *rbuild_vb(struct snmp_pdu *pdu,
+                                unsigned char *data, int *datalength);
+
+DLLOPT unsigned char *rbuild_data_pdu(struct snmp_pdu *pdu,
+                                      unsigned char *data, int *datalength);
+
+DLLOPT unsigned char *snmp_rbuild_var_op(unsigned char *data,
+                                         int *datalength,
+                                         const oid *var_name,
+                                         int var_name_len,
+                                         unsigned char var_val_type,
+                                         int var_val_len,
+                                         const unsigned char *var_val);
+
 DLLOPT unsigned char *snmp_build_var_op(unsigned char *data,
                                         oid * var_name, int *var_name_len,
                                         unsigned char var_val_type,
@@ -437,6 +542,28 @@ DLLOPT unsigned char *asn1_build_scoped_pdu(
                unsigned char *contextName, long contextNameLength,
                unsigned char *data, long dataLength);
 
+/**
+ * Encode the header of a scopedPDU in front of the already encoded
+ * data (see asn1_build_scoped_pdu), for messages that are built back
+ * to front.
+ *
+ * param data              - The already encoded data
+ * param datalength        - IN: free bytes in front of data
+ *                           OUT: free bytes left in front of the result
+ * param dataLength        - The length of the data
+ * param contextEngineID   - The contextEngineID
+ * param contextEngineIDLength - The length of the contextEngineID
+ * param contextName       - The contextName
+ * param contextNameLength - The length of the contextName
+ *
+ * @return - Pointer to the first byte of the scopedPDU or
+ *           NULL if an error occured
+ */
+DLLOPT unsigned char *asn1_rbuild_scoped_pdu(
+               unsigned char *data, int *datalength, long dataLength,
+               unsigned char *contextEngineID, long contextEngineIDLength,
+               unsigned char *contextName, long contextNameLength);
+
 
 #ifdef SNMP_PP_NAMESPACE
 } // end of namespace Snmp_pp
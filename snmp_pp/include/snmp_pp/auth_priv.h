@@ -36,6 +36,8 @@
 
 #include "snmp_pp/usm_v3.h"
 
+#include <atomic>
+
 #ifdef SNMP_PP_NAMESPACE
 namespace Snmp_pp {
 #endif
@@ -57,6 +59,57 @@ namespace Snmp_pp {
 
 
 class OctetStr;
+class LocalizedKeyCache;
+
+/**
+ * Precomputed HMAC state of a localized authentication key.
+ *
+ * Holds the digest states after the inner (key XOR ipad) and outer
+ * (key XOR opad) blocks have been hashed, so that authenticating a
+ * message only needs to hash the message itself. Objects are
+ * immutable and reference counted, so they can be shared between
+ * the usmUserTable and messages in flight without copying the key.
+ * (since 3.5.2)
+ */
+class DLLOPT AuthKeyState
+{
+public:
+  AuthKeyState() : refs(1) {}
+
+  /**
+   * Add a reference to this key state.
+   */
+  void ref() const { ++refs; }
+
+  /**
+   * Release a reference, the object is deleted with the last one.
+   *
+   * @param state - the key state, may be NULL
+   */
+  static void unref(const AuthKeyState *state)
+    { if (state && (--state->refs == 0)) delete state; }
+
+  /**
+   * Compute the HMAC of the given message.
+   *
+   * @param msg     - pointer to the whole message
+   * @param msg_len - the length of the message
+   * @param digest  - buffer of at least SNMPv3_USM_MAX_KEY_LEN bytes
+   *                  that receives the full digest
+   */
+  virtual void hmac(const unsigned char *msg,
+                    const unsigned int   msg_len,
+                    unsigned char       *digest) const = 0;
+
+protected:
+  virtual ~AuthKeyState() {}
+
+private:
+  AuthKeyState(const AuthKeyState &);
+  AuthKeyState &operator=(const AuthKeyState &);
+
+  mutable std::atomic<unsigned long> refs;
+};
 
 /**
  * Abstract class for auth modules.
@@ -156,6 +209,20 @@ public:
                            unsigned char       *auth_par_ptr,
                            const int            auth_par_len) = 0;
 
+  /**
+   * Precompute the HMAC state for a localized key.
+   *
+   * @param key     - pointer to the localized key
+   * @param key_len - length of the key
+   *
+   * @return a new key state that must be released through
+   *         AuthKeyState::unref(), or NULL if the protocol does not
+   *         support precomputed states (since 3.5.2)
+   */
+  virtual AuthKeyState *new_key_state(const unsigned char * /*key*/,
+                                      const unsigned int   /*key_len*/) const
+    { return 0; }
+
   /**
    * Get the unique id of the authentication protocol.
    */
@@ -413,6 +480,9 @@ public:
   /**
    * Call the password-to-key method of the specified authentication
    * protocol.
+   *
+   * If the key cache is enabled, the key is taken from the cache
+   * or added to it.
    */
   int password_to_key_auth(const int      auth_prot,
                            const unsigned char *password,
@@ -425,6 +495,9 @@ public:
   /**
    * Call the password-to-key method of the specified privacy
    * protocol.
+   *
+   * If the key cache is enabled, the key is taken from the cache
+   * or added to it.
    */
   int password_to_key_priv(const int      auth_prot,
                            const int      priv_prot,
@@ -435,6 +508,50 @@ public:
                            unsigned char *key,
                            unsigned int  *key_len);
 
+  /**
+   * Enable the cache of localized keys.
+   *
+   * Localizing a key hashes one megabyte of the expanded password,
+   * so adding many users takes long. With the cache enabled,
+   * password_to_key_auth() and password_to_key_priv() remember the
+   * keys they computed, indexed by an HMAC of the password, keyed
+   * with the given secret, the engine id and the protocols. Existing
+   * entries are loaded from the given file, save_key_cache() writes
+   * them back.
+   *
+   * @note The file contains the localized keys in plaintext. Anyone
+   *       who can read it can use the keys for the engine ids in the
+   *       file, without knowing the passwords. save_key_cache()
+   *       creates the file readable by its owner only, keep it that
+   *       way, like the file written by USM::save_localized_users().
+   *       The secret is not stored in the file. Without it, the
+   *       passwords cannot be guessed by comparing HMAC values, so
+   *       store it somewhere else and not next to the file.
+   *
+   * @param file       - filename including path or NULL to keep the keys
+   *                     in memory only
+   * @param secret     - key of the HMAC, required if file is given
+   * @param secret_len - length of the secret
+   *
+   * @return SNMPv3_USM_OK (also if the file does not exist yet),
+   *         SNMPv3_USM_ERROR (file without secret) or
+   *         SNMPv3_USM_FILEREAD_ERROR (since 3.5.2)
+   */
+  int enable_key_cache(const char *file,
+                       const unsigned char *secret = 0,
+                       const unsigned int secret_len = 0);
+
+  /**
+   * Save the cache of localized keys into the file given to
+   * enable_key_cache(), if entries were added since it was loaded.
+   *
+   * @return SNMPv3_USM_OK, SNMPv3_USM_ERROR (cache not enabled or no
+   *         file), SNMPv3_USM_FILECREATE_ERROR,
+   *         SNMPv3_USM_FILEWRITE_ERROR or SNMPv3_USM_FILERENAME_ERROR
+   *         (since 3.5.2)
+   */
+  int save_key_cache();
+
   /**
    * Get the keyChange value for the specified keys using the given
    * authentication protocol.
@@ -533,6 +650,38 @@ public:
                    unsigned char       *auth_par_ptr,
                    const int            auth_par_len);
 
+  /**
+   * Precompute the HMAC state of a localized key.
+   *
+   * @return a new key state (release it through AuthKeyState::unref())
+   *         or NULL if the protocol is unknown or has no support for
+   *         precomputed states (since 3.5.2)
+   */
+  AuthKeyState *new_key_state(const int            auth_prot,
+                              const unsigned char *key,
+                              const unsigned int   key_len);
+
+  /**
+   * Fill in the authentication field of an outgoing message using
+   * a precomputed key state (since 3.5.2).
+   */
+  int auth_out_msg(const int            auth_prot,
+                   const AuthKeyState  *key_state,
+                   unsigned char       *msg,
+                   const int            msg_len,
+                   unsigned char       *auth_par_ptr);
+
+  /**
+   * Check the authentication field of an incoming message using
+   * a precomputed key state (since 3.5.2).
+   */
+  int auth_inc_msg(const int            auth_prot,
+                   const AuthKeyState  *key_state,
+                   unsigned char       *msg,
+                   const int            msg_len,
+                   unsigned char       *auth_par_ptr,
+                   const int            auth_par_len);
+
 private:
 
   AuthPtr *auth;   ///< Array of pointers to Auth-objects
@@ -540,6 +689,7 @@ private:
   int   auth_size; ///< current size of the auth array
   int   priv_size; ///< current size of the priv array
   pp_uint64 salt;  ///< current salt value (64 bits)
+  LocalizedKeyCache *key_cache; ///< cache of localized keys or NULL
 };
 
 /**
@@ -573,6 +723,9 @@ public:
            unsigned char       *auth_par_ptr,
            const int            auth_par_len);
 
+  AuthKeyState *new_key_state(const unsigned char *key,
+                              const unsigned int   key_len) const;
+
   int get_id() const { return SNMP_AUTHPROTOCOL_HMACMD5; };
 
   const char *get_id_string() const { return "HMAC-MD5"; };
@@ -925,6 +1078,9 @@ private:
 public:
   int get_id() const { return SNMP_AUTHPROTOCOL_HMACSHA; };
 
+  AuthKeyState *new_key_state(const unsigned char *key,
+                              const unsigned int   key_len) const;
+
   const char *get_id_string() const { return "HMAC-SHA"; };
 
   int get_auth_params_len() const { return 12; };
@@ -952,6 +1108,9 @@ private:
 public:
   int get_id() const { return SNMP_AUTHPROTOCOL_HMAC128SHA224; };
 
+  AuthKeyState *new_key_state(const unsigned char *key,
+                              const unsigned int   key_len) const;
+
   const char *get_id_string() const { return "HMAC-128-SHA-224"; };
 
   int get_auth_params_len() const { return 16; };
@@ -975,6 +1134,9 @@ class DLLOPT AuthHMAC192SHA256 : public AuthSHABase
 public:
   int get_id() const { return SNMP_AUTHPROTOCOL_HMAC192SHA256; };
 
+  AuthKeyState *new_key_state(const unsigned char *key,
+                              const unsigned int   key_len) const;
+
   const char *get_id_string() const { return "HMAC-192-SHA-256"; };
 
   int get_auth_params_len() const { return 24; };
@@ -997,6 +1159,9 @@ class DLLOPT AuthHMAC256SHA384 : public AuthSHABase
 public:
   int get_id() const { return SNMP_AUTHPROTOCOL_HMAC256SHA384; };
 
+  AuthKeyState *new_key_state(const unsigned char *key,
+                              const unsigned int   key_len) const;
+
   const char *get_id_string() const { return "HMAC-256-SHA-384"; };
 
   int get_auth_params_len() const { return 32; };
@@ -1019,6 +1184,9 @@ class DLLOPT AuthHMAC384SHA512 : public AuthSHABase
 public:
   int get_id() const { return SNMP_AUTHPROTOCOL_HMAC384SHA512; };
 
+  AuthKeyState *new_key_state(const unsigned char *key,
+                              const unsigned int   key_len) const;
+
   const char *get_id_string() const { return "HMAC-384-SHA-512"; };
 
   int get_auth_params_len() const { return 48; };
@@ -109,6 +109,12 @@ class DLLOPT CEvents: public SnmpSynchronized {
 			   const fd_set &readfds,
 			   const fd_set &writefds,
 			   const fd_set &exceptfds) = 0;
+#endif
+#ifdef HAVE_EPOLL_SYSCALL
+  // process events pending on a socket registered through
+  // CEventList::AddFd(), event sources without sockets need not
+  // override this
+  virtual int HandleEvent(const SnmpSocket /*fd*/) { return 0; };
 #endif
   // return number of outstanding messages
   virtual int GetCount() = 0;
@@ -123,7 +129,7 @@ class DLLOPT CEvents: public SnmpSynchronized {
 
 class DLLOPT CEventList: public SnmpSynchronized {
   public:
-    CEventList() : m_head(0, 0, 0), m_msgCount(0), m_done(0) {};
+    CEventList();
     ~CEventList();
 
   // add an event source to the list
@@ -154,6 +160,41 @@ class DLLOPT CEventList: public SnmpSynchronized {
 		   const fd_set &exceptfds);
 #endif
 
+#ifdef HAVE_EPOLL_SYSCALL
+  /**
+   * Register a socket of an event source with the epoll instance of
+   * this list (since 3.5.2). Events on the socket are passed to
+   * CEvents::HandleEvent() until the socket is removed again.
+   *
+   * @param fd - the socket
+   * @param events - the event source that handles the socket
+   * @return SNMP_CLASS_SUCCESS, SNMP_CLASS_ERROR if the socket is
+   *         registered by another event source or could not be added
+   *         to the epoll instance
+   */
+  int AddFd(const SnmpSocket fd, CEvents *events);
+
+  /**
+   * Remove a socket registered through AddFd(). Remove the socket
+   * before it is closed.
+   */
+  void RemoveFd(const SnmpSocket fd);
+
+  // return the number of registered sockets
+  int GetRegisteredFdCount() { return m_fdCount; };
+
+  /**
+   * Wait for events on the registered sockets.
+   *
+   * @param timeout - milliseconds to wait at most, 0 to return
+   *                  immediately, -1 to wait without timeout
+   * @param handle - if true, pass the events to the event sources,
+   *                 otherwise just wait until a socket is ready
+   * @return the number of ready sockets, 0 on timeout, -1 on error
+   */
+  int WaitEvents(const int timeout, const bool handle);
+#endif
+
   // return number of outstanding messages
   int GetCount() { return m_msgCount; };
 
@@ -187,6 +228,16 @@ class DLLOPT CEventList: public SnmpSynchronized {
     CEventListElt m_head;
     int m_msgCount;
     int m_done;
+
+#ifdef HAVE_EPOLL_SYSCALL
+    int m_epfd;                 // the epoll instance
+    CEvents **m_fdEvents;       // event source of each socket, by fd
+    int m_fdEventsSize;         // size of m_fdEvents
+    int m_fdCount;              // number of registered sockets
+    // m_fdEvents has its own lock, as event sources register their
+    // sockets while they hold their own lock
+    SnmpSynchronized m_fdLock;
+#endif
 };
 
 #ifdef SNMP_PP_NAMESPACE
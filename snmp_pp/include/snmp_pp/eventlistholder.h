@@ -74,6 +74,20 @@ class DLLOPT EventListHolder
 		     fd_set & writefds,
 		     fd_set & exceptfds);
 
+#ifdef HAVE_EPOLL_SYSCALL
+  /**
+   * Register a socket of an event queue, see CEventList::AddFd()
+   * (since 3.5.2).
+   */
+  int AddFd(const SnmpSocket fd, CEvents *events)
+    { return m_eventList.AddFd(fd, events); };
+
+  /**
+   * Remove a socket registered through AddFd() (since 3.5.2).
+   */
+  void RemoveFd(const SnmpSocket fd) { m_eventList.RemoveFd(fd); };
+#endif
+
   //---------[ Main Loop ]------------------------------------------
   /**
    * Infinite loop which blocks when there is nothing to do and handles
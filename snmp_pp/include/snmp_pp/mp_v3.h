@@ -49,6 +49,12 @@ class OctetStr;
 #ifndef MAX_ENGINE_ID_CACHE_SIZE
 #define MAX_ENGINE_ID_CACHE_SIZE    50000
 #endif
+#ifndef MAX_MP_CACHE_SIZE
+#define MAX_MP_CACHE_SIZE           10000
+#endif
+#ifndef MP_CACHE_ENTRY_LIFETIME
+#define MP_CACHE_ENTRY_LIFETIME       300
+#endif
 
 #define oidMPDGroup                  "1.3.6.1.6.3.11.2.1"
 #define oidSnmpUnknownSecurityModels "1.3.6.1.6.3.11.2.1.1.0"
@@ -234,6 +240,46 @@ class DLLOPT v3MP
   int reset_engine_id_table()
     {  return engine_id_table.reset(); };
 
+  /**
+   * Get the upper limit of the number of outstanding requests kept in
+   * the message processing cache.
+   *
+   * @return - the limit (MAX_MP_CACHE_SIZE by default)
+   */
+  int get_cache_size_limit() const
+    { return cache.get_cache_size_limit(); };
+
+  /**
+   * Set the upper limit of the number of outstanding requests kept in
+   * the message processing cache. If the cache is full, the oldest
+   * entry is dropped. Calls with a limit of 0 or less are ignored.
+   * (since 3.5.2)
+   *
+   * @param size_upper_limit - the new limit
+   */
+  void set_cache_size_limit(int size_upper_limit)
+    { cache.set_cache_size_limit(size_upper_limit); };
+
+  /**
+   * Get the number of seconds after which an entry of the message
+   * processing cache is dropped.
+   *
+   * @return - the lifetime (MP_CACHE_ENTRY_LIFETIME by default)
+   */
+  int get_cache_entry_lifetime() const
+    { return cache.get_entry_lifetime(); };
+
+  /**
+   * Set the number of seconds after which an entry of the message
+   * processing cache is dropped. The entries of requests that never
+   * got a response or were never answered are removed this way.
+   * (since 3.5.2)
+   *
+   * @param seconds - the new lifetime, 0 keeps the entries forever
+   */
+  void set_cache_entry_lifetime(int seconds)
+    { cache.set_entry_lifetime(seconds); };
+
   /**
    * Remove all occurences of this engine id from v3MP and USM.
    *
@@ -530,6 +576,11 @@ class DLLOPT v3MP
 
   /**
    * Holds cache entries for currently processed requests.
+   *
+   * The entries are hashed by message id and by request id and kept
+   * in the order they were added, so that entries older than the
+   * lifetime can be dropped and the cache does not grow beyond its
+   * size limit.
    */
   class DLLOPT Cache
   {
@@ -629,13 +680,99 @@ class DLLOPT v3MP
 
     void set_usm(USM *usm_to_use) { usm = usm_to_use; };
 
+    /**
+     * Get the upper limit of the number of entries in the cache.
+     * @return - the cache size upper limit (MAX_MP_CACHE_SIZE by default).
+     */
+    int get_cache_size_limit() const { return upper_limit_entries; }
+
+    /**
+     * Set the upper limit of the number of entries in the cache. If
+     * a new entry is added to a full cache, the oldest entry is dropped.
+     * Calls of this method with a cache size of 0 or less are ignored.
+     * @param size_upper_limit
+     *    the upper limit of the cache size (MAX_MP_CACHE_SIZE by default).
+     */
+    void set_cache_size_limit(int size_upper_limit)
+      { if (size_upper_limit > 0) upper_limit_entries = size_upper_limit; }
+
+    /**
+     * Get the number of seconds after which an entry is dropped.
+     * @return - the lifetime (MP_CACHE_ENTRY_LIFETIME by default).
+     */
+    int get_entry_lifetime() const { return entry_lifetime; }
+
+    /**
+     * Set the number of seconds after which an entry is dropped.
+     * Expired entries are removed when new entries are added.
+     * @param seconds
+     *    the lifetime of an entry, 0 or less keeps entries forever.
+     */
+    void set_entry_lifetime(int seconds)
+      { entry_lifetime = (seconds > 0 ? seconds : 0); }
+
    private:
+    struct Node_T
+    {
+      struct Entry_T entry;
+      time_t added;  ///< time the entry was added
+      int msg_next;  ///< next node in the msg id chain or -1
+      int req_next;  ///< next node in the req id chain or -1
+      int older;     ///< previous node in the age list or -1
+      int newer;     ///< next node in the age list (or free list) or -1
+    };
+
+    /**
+     * Get the oldest node with the given message id.
+     *
+     * @return - the node or -1 if not found
+     */
+    int find_msg_id(int msg_id, bool local_request) const;
+
+    /**
+     * Get the oldest node with the given request id.
+     *
+     * @return - the node or -1 if not found
+     */
+    int find_req_id(unsigned long req_id, bool local_request) const;
+
+    /**
+     * Remove the node from the chains and the age list and put it into
+     * the free list. The security state reference is NOT deleted.
+     */
+    void remove_node(int n);
+
+    /**
+     * Grow the node array and rebuild the hash chains.
+     */
+    bool resize(int new_max_entries);
+
+    /**
+     * Drop all entries added before the given time.
+     */
+    void expire(time_t now);
+
+    unsigned int msg_bucket(int msg_id, bool local_request) const
+      { return ((unsigned int)msg_id * 2654435761U
+                ^ (local_request ? 1 : 0)) & mask; }
+    unsigned int req_bucket(unsigned long req_id, bool local_request) const
+      { return ((unsigned int)(req_id ^ (req_id >> 16)) * 2654435761U
+                ^ (local_request ? 1 : 0)) & mask; }
+
 #ifdef _THREADS
     SNMP_PP_MUTABLE SnmpSynchronized lock;
 #endif
-    struct Entry_T *table; ///< whole table
+    struct Node_T *table;  ///< all nodes
+    int *msg_buckets;      ///< first node of each msg id chain or -1
+    int *req_buckets;      ///< first node of each req id chain or -1
+    unsigned int mask;     ///< number of buckets - 1
     int max_entries;       ///< the maximum number of entries
     int entries;           ///< the current amount of entries
+    int first_free;        ///< first unused node or -1
+    int oldest;            ///< oldest node or -1
+    int newest;            ///< newest node or -1
+    int upper_limit_entries; ///< the upper most number of entries to keep
+    int entry_lifetime;    ///< seconds to keep an entry, 0 for no limit
     USM *usm;
   };
 
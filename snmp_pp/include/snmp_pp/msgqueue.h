@@ -171,6 +171,8 @@ class DLLOPT CSNMPMessageQueue: public CEvents
 		     const fd_set &writefds,
 		     const fd_set &exceptfds);
 #endif
+  // receive a response on the given socket and pass it to its message
+    int HandleEvent(const SnmpSocket fd);
 
   // return number of outstanding messages
     int GetCount() { return m_msgCount; };
@@ -201,16 +203,56 @@ class DLLOPT CSNMPMessageQueue: public CEvents
       CSNMPMessage *TestId(const unsigned long uniqueId);
 
      private:
+      friend class CSNMPMessageQueue;
 
       CSNMPMessage *m_message;
       class CSNMPMessageQueueElt *m_Next;
       class CSNMPMessageQueueElt *m_previous;
+      class CSNMPMessageQueueElt *m_hashNext; // next elt in the id chain
+      int m_heapPos;                          // position in m_heap
     };
 
+    /**
+     * Number of outstanding messages on one socket. A socket is
+     * registered with the event list while messages are outstanding
+     * on it.
+     */
+    struct SocketCount
+    {
+      SnmpSocket socket;
+      int count;
+    };
+
+    // find the elt of a message by its id
+    CSNMPMessageQueueElt *FindElt(const unsigned long uniqueId) const;
+    // unlink an elt from the list, the id hash and the timeout heap
+    // and delete it
+    void RemoveElt(CSNMPMessageQueueElt *elt);
+    // grow the id hash and rechain all elts
+    void GrowBuckets();
+    unsigned int Bucket(const unsigned long uniqueId) const
+      { return (unsigned int)(uniqueId * 2654435761UL) & m_bucketMask; };
+    // restore the heap order for an elt whose send time changed
+    void HeapUpdate(CSNMPMessageQueueElt *elt);
+    bool HeapLess(const int pos1, const int pos2) const;
+    void HeapSwap(const int pos1, const int pos2);
+    // count messages per socket, (un)registering the socket
+    void AddSocket(const SnmpSocket socket);
+    void RemoveSocket(const SnmpSocket socket);
+    bool HasSocket(const SnmpSocket socket) const;
+
     CSNMPMessageQueueElt m_head;
     int m_msgCount;
     EventListHolder *my_holder;
     Snmp *m_snmpSession;
+
+    CSNMPMessageQueueElt **m_buckets;  // id hash, chained by m_hashNext
+    unsigned int m_bucketMask;         // number of buckets - 1
+    CSNMPMessageQueueElt **m_heap;     // min heap ordered by send time
+    int m_heapCapacity;                // m_msgCount elts are in use
+    SocketCount *m_sockets;            // sockets of the queued messages
+    int m_socketCount;
+    int m_socketCapacity;
 };
 
 #ifdef SNMP_PP_NAMESPACE
@@ -143,6 +143,8 @@ class DLLOPT CNotifyEventQueue: public CEvents
                      const fd_set &writefds,
                      const fd_set &exceptfds);
 #endif
+    // receive a notification on the given socket
+    int HandleEvent(const SnmpSocket fd);
     // return number of outstanding messages
     int GetCount() { return m_msgCount; };
 
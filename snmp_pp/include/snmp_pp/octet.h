@@ -203,12 +203,14 @@ class DLLOPT OctetStr: public  SnmpSyntax
   OctetStr& operator+=(const OctetStr& octet);
 
   /**
-   * Allow access as if it was an array.
+   * Allow access as if it was an array. A shared payload is copied
+   * first, so writing through the reference never changes the sharers.
    *
    * @note The given param is not checked for validity.
    */
   unsigned char &operator[](int i)
-    { m_changed = true; validity = true; return smival.value.string.ptr[i]; };
+    { if (payload) detach();
+      m_changed = true; validity = true; return smival.value.string.ptr[i]; };
 
   /**
    * Allow access as if it was an array for const OctetStr objects.
@@ -354,8 +356,51 @@ class DLLOPT OctetStr: public  SnmpSyntax
    */
   bool set_len(const unsigned long new_len);
 
+  /**
+   * Turn the value into an immutable, reference counted payload.
+   *
+   * Copies of this object (copy constructor, assignment, clone) will
+   * share the payload instead of copying the data. Use this for big
+   * values, like binary blobs, that are copied into Vb and Pdu objects
+   * for each request. Modifying a copy (set_data(), +=, set_len() to a
+   * greater length, operator[], ...) detaches it from the shared payload.
+   * The bytes returned by data() must not be changed while the payload
+   * is shared.
+   *
+   * @note This method does not copy the data.
+   *
+   * @return A reference to this object
+   */
+  OctetStr& share();
+
+  /**
+   * Check if the value is a shared payload.
+   *
+   * @return true if share() has been called on this object or on
+   *         the object it has been copied from
+   */
+  bool is_shared() const { return (payload != 0); };
+
  protected:
 
+  struct Payload;
+
+  /**
+   * Share the payload of the given octet string (which must be shared).
+   */
+  void attach(const OctetStr &octet);
+
+  /**
+   * Replace the shared payload by a private copy of its data.
+   */
+  void detach();
+
+  /**
+   * Free the data or release the shared payload. Does not reset the
+   * length of the string.
+   */
+  void release_data();
+
   enum OutputFunction
   {
       OutputFunctionDefault,
@@ -372,6 +417,7 @@ class DLLOPT OctetStr: public  SnmpSyntax
 
 
   bool validity;		         // validity boolean
+  Payload *payload;		 // shared payload or NULL
 
   static enum OutputType hex_output_type;
   static char nonprintable_char;
@@ -66,6 +66,14 @@
 namespace Snmp_pp {
 #endif
 
+/**
+ * Number of subidentifiers an Oid stores inline without allocating
+ * memory from the heap. Longer oids are held in a heap buffer.
+ */
+#ifndef SNMP_PP_OID_INLINE_LEN
+#define SNMP_PP_OID_INLINE_LEN 32
+#endif
+
 /**
  * The Object Identifier Class.
  *
@@ -86,6 +94,10 @@ namespace Snmp_pp {
  *       Oid object is modified. The functions get_printable(len) and
  *       get_printable(start, len) share the same buffer which is
  *       freed and newly allocated for each call.
+ *
+ * @note Oids with up to SNMP_PP_OID_INLINE_LEN subidentifiers are
+ *       stored within the object itself, so copying or building
+ *       such an Oid does not allocate memory from the heap.
  */
 class DLLOPT Oid : public SnmpSyntax
 {
@@ -136,12 +148,26 @@ class DLLOPT Oid : public SnmpSyntax
     // in this case the size to allocate is the same size as the source oid
     if (oid.smival.value.oid.len)
     {
-      smival.value.oid.ptr = (SmiLPUINT32) new unsigned long[oid.smival.value.oid.len];
-      if (smival.value.oid.ptr)
+      if (alloc_oid_ptr(oid.smival.value.oid.len))
         OidCopy((SmiLPOID)&(oid.smival.value.oid), (SmiLPOID)&smival.value.oid);
     }
   }
 
+  /**
+   * Move constructor. A heap buffer of the source oid is taken over,
+   * inline data is copied. The source oid is left empty.
+   *
+   * @param oid - Source Oid
+   */
+  Oid(Oid &&oid)
+    : iv_str(0), iv_part_str(0), m_changed(true)
+  {
+    smival.syntax = sNMP_SYNTAX_OID;
+    smival.value.oid.len = 0;
+    smival.value.oid.ptr = 0;
+    take_oid_ptr(oid);
+  }
+
   /**
    * Constructor from array.
    *
@@ -157,8 +183,7 @@ class DLLOPT Oid : public SnmpSyntax
 
     if (raw_oid && (oid_len > 0))
     {
-      smival.value.oid.ptr = (SmiLPUINT32) new unsigned long[oid_len];
-      if (smival.value.oid.ptr)
+      if (alloc_oid_ptr(oid_len))
       {
         smival.value.oid.len = oid_len;
         for (int i=0; i < oid_len; i++)
@@ -205,12 +230,23 @@ class DLLOPT Oid : public SnmpSyntax
       return *this;
 
     // allocate some memory for the oid
-    smival.value.oid.ptr = (SmiLPUINT32) new unsigned long[oid.smival.value.oid.len];
-    if (smival.value.oid.ptr)
+    if (alloc_oid_ptr(oid.smival.value.oid.len))
       OidCopy((SmiLPOID)&(oid.smival.value.oid), (SmiLPOID)&smival.value.oid);
     return *this;
   }
 
+  /**
+   * Move one Oid to another. The source oid is left empty.
+   */
+  Oid& operator=(Oid &&oid)
+  {
+    if (this == &oid) return *this;  // protect against assignment from self
+
+    delete_oid_ptr();
+    take_oid_ptr(oid);
+    return *this;
+  }
+
   /**
    * Return the space needed for serialization.
    */
@@ -286,8 +322,7 @@ class DLLOPT Oid : public SnmpSyntax
    */
   Oid& operator+=(const unsigned long i)
   {
-    Oid other(&i, 1);
-    (*this) += other;
+    append_oid_ptr(&i, 1);
     return *this;
   }
 
@@ -298,37 +333,10 @@ class DLLOPT Oid : public SnmpSyntax
    */
   Oid& operator+=(const Oid &o)
   {
-    SmiLPUINT32 new_oid;
-
     if (o.smival.value.oid.len == 0)
       return *this;
 
-    new_oid = (SmiLPUINT32) new unsigned long[smival.value.oid.len + o.smival.value.oid.len];
-    if (new_oid == 0)
-    {
-      delete_oid_ptr();
-      return *this;
-    }
-
-    if (smival.value.oid.ptr)
-    {
-      MEMCPY((SmiLPBYTE) new_oid,
-             (SmiLPBYTE) smival.value.oid.ptr,
-             (size_t) (smival.value.oid.len*sizeof(SmiUINT32)));
-
-      delete [] smival.value.oid.ptr;
-    }
-
-    // out with the old, in with the new...
-    smival.value.oid.ptr = new_oid;
-
-    MEMCPY((SmiLPBYTE) &new_oid[smival.value.oid.len],
-           (SmiLPBYTE) o.smival.value.oid.ptr,
-           (size_t) (o.smival.value.oid.len*sizeof(SmiUINT32)));
-
-    smival.value.oid.len += o.smival.value.oid.len;
-
-    m_changed = true;
+    append_oid_ptr(o.smival.value.oid.ptr, o.smival.value.oid.len);
     return *this;
   }
 
@@ -365,6 +373,13 @@ class DLLOPT Oid : public SnmpSyntax
    */
   SmiLPOID oidval() { return (SmiLPOID) &smival.value.oid; }
 
+  /**
+   * Get the WinSnmp oid part of a constant Oid.
+   *
+   * @return pointer to the internal oid structure.
+   */
+  const SmiOID *oidval() const { return &smival.value.oid; }
+
   /**
    * Set the data from raw form.
    *
@@ -615,11 +630,44 @@ class DLLOPT Oid : public SnmpSyntax
    */
   inline void delete_oid_ptr();
 
+  /**
+   * Free the internal oid pointer and provide storage for n
+   * subidentifiers, using the inline buffer if it is large enough.
+   * The length of the oid is set to zero.
+   *
+   * @param n - Number of subidentifiers to provide storage for
+   * @return Pointer to the new storage or NULL if allocation failed
+   */
+  inline SmiLPUINT32 alloc_oid_ptr(const unsigned long n);
+
+  /**
+   * Append n subidentifiers to the oid, growing the storage if needed.
+   *
+   * @param data - Subidentifiers to append (may point into this oid)
+   * @param n - Number of subidentifiers
+   */
+  void append_oid_ptr(const SmiUINT32 *data, const unsigned long n);
+
+  /**
+   * Take over the value of another (empty) oid, leaving it empty.
+   */
+  inline void take_oid_ptr(Oid &oid);
+
+  /**
+   * Return the number of subidentifiers that fit into the current storage.
+   */
+  unsigned long oid_capacity() const
+  {
+    return (smival.value.oid.ptr == iv_inline) ?
+      (unsigned long)SNMP_PP_OID_INLINE_LEN : smival.value.oid.len;
+  }
+
   //----[ instance variables ]
 
   SNMP_PP_MUTABLE char *iv_str;      // used for returning complete oid string
   SNMP_PP_MUTABLE char *iv_part_str; // used for returning part oid string
   SNMP_PP_MUTABLE bool m_changed;
+  SmiUINT32 iv_inline[SNMP_PP_OID_INLINE_LEN]; // storage for short oids
 };
 
 //-----------[ End Oid Class ]-------------------------------------
@@ -632,13 +680,43 @@ inline void Oid::delete_oid_ptr()
   // delete the old value
   if (smival.value.oid.ptr)
   {
-    delete [] smival.value.oid.ptr;
+    if (smival.value.oid.ptr != iv_inline)
+      delete [] smival.value.oid.ptr;
     smival.value.oid.ptr = 0;
   }
   smival.value.oid.len = 0;
   m_changed = true;
 }
 
+inline SmiLPUINT32 Oid::alloc_oid_ptr(const unsigned long n)
+{
+  delete_oid_ptr();
+  if (n <= SNMP_PP_OID_INLINE_LEN)
+    smival.value.oid.ptr = iv_inline;
+  else
+    smival.value.oid.ptr = (SmiLPUINT32) new unsigned long[n];
+  return smival.value.oid.ptr;
+}
+
+inline void Oid::take_oid_ptr(Oid &oid)
+{
+  if (oid.smival.value.oid.ptr == oid.iv_inline)
+  {
+    smival.value.oid.ptr = iv_inline;
+    MEMCPY((SmiLPBYTE) iv_inline,
+           (SmiLPBYTE) oid.iv_inline,
+           (size_t) (oid.smival.value.oid.len*sizeof(SmiUINT32)));
+  }
+  else
+    smival.value.oid.ptr = oid.smival.value.oid.ptr;
+  smival.value.oid.len = oid.smival.value.oid.len;
+  m_changed = true;
+
+  oid.smival.value.oid.ptr = 0;
+  oid.smival.value.oid.len = 0;
+  oid.m_changed = true;
+}
+
 #ifdef SNMP_PP_NAMESPACE
 } // end of namespace Snmp_pp
 #endif 
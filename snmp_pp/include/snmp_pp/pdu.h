@@ -475,6 +475,17 @@ class DLLOPT Pdu
    */
   int get_asn1_length() const;
 
+  /**
+   * Return the length of the encoded pdu, if its vbs are encoded
+   * with the given length (since 3.5.2). This allows callers that
+   * keep track of the length of the vbs while adding or changing
+   * them to check the pdu length without encoding all vbs again.
+   *
+   * @param vbs_length - The sum of Vb::get_asn1_length() of all vbs
+   * @note this method will not work for v1 traps.
+   */
+  int get_asn1_length_for_vbs(const int vbs_length) const;
+
   /**
    * Clear the Pdu contents (destruct and construct in one go)
    */
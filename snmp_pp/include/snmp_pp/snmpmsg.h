@@ -82,7 +82,8 @@ class DLLOPT SnmpMessage
  public:
 
   // construct a SnmpMessage object
-  SnmpMessage() : bufflen(MAX_SNMP_PACKET), valid_flag(false) {};
+  SnmpMessage()
+    : bufflen(MAX_SNMP_PACKET), valid_flag(false), decode_arena(0) {};
 	// load up using a Pdu, community and SNMP version
 	// performs ASN.1 serialization
 	// result status returned
@@ -163,11 +164,21 @@ class DLLOPT SnmpMessage
 	// check validity
 	unsigned long len() const { return bufflen; };
 
+	/**
+	 * Decode the raw PDU within the given arena in unload(). The
+	 * arena is reset before unload() returns, so it can be used
+	 * again for the next message (since 3.5.2).
+	 *
+	 * @param arena - the arena to use or 0 to use malloc()
+	 */
+	void set_decode_arena(struct snmp_arena *arena) { decode_arena = arena; };
+
 protected:
 
 	unsigned char databuff[MAX_SNMP_PACKET];
 	unsigned int bufflen;
 	bool valid_flag;
+	struct snmp_arena *decode_arena;
 };
 
 #ifdef SNMP_PP_NAMESPACE
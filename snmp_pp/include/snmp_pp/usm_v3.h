@@ -38,6 +38,8 @@
 #include "snmp_pp/octet.h"
 #include "snmp_pp/address.h"
 
+#include <atomic>
+
 #ifdef SNMP_PP_NAMESPACE
 namespace Snmp_pp {
 #endif
@@ -176,6 +178,7 @@ class SnmpTarget;
 class Pdu;
 
 struct UsmKeyUpdate;
+class AuthKeyState;
 
 struct UsmUserTableEntry {
   unsigned char *usmUserEngineID;     long int usmUserEngineIDLength;
@@ -183,6 +186,7 @@ struct UsmUserTableEntry {
   unsigned char *usmUserSecurityName; long int usmUserSecurityNameLength;
   long int  usmUserAuthProtocol;
   unsigned char *usmUserAuthKey;      long int usmUserAuthKeyLength;
+  const AuthKeyState *usmUserAuthKeyState; ///< precomputed HMAC (since 3.5.2)
   long int  usmUserPrivProtocol;
   unsigned char *usmUserPrivKey;      long int usmUserPrivKeyLength;
 };
@@ -193,6 +197,7 @@ struct UsmUser {
   unsigned char *securityName; long int securityNameLength;
   long int  authProtocol;
   unsigned char *authKey;      long int authKeyLength;
+  const AuthKeyState *authKeyState; ///< precomputed HMAC (since 3.5.2)
   long int  privProtocol;
   unsigned char *privKey;      long int privKeyLength;
 };
@@ -716,7 +721,7 @@ public:
    * @return - usmStatsUnsupportedSecLevels
    */
   unsigned long get_stats_unsupported_sec_levels() const
-    { return usmStatsUnsupportedSecLevels; };
+    { return usmStatsUnsupportedSecLevels.load(std::memory_order_relaxed); };
 
   /**
    * Get the number of received messages outside time window
@@ -724,7 +729,7 @@ public:
    * @return - usmStatsNotInTimeWindows
    */
   unsigned long get_stats_not_in_time_windows() const
-    { return usmStatsNotInTimeWindows; };
+    { return usmStatsNotInTimeWindows.load(std::memory_order_relaxed); };
 
   /**
    * Get the number of received messages with a unknown userName
@@ -732,7 +737,7 @@ public:
    * @return - usmStatsUnknownUserNames
    */
   unsigned long get_stats_unknown_user_names() const
-    { return usmStatsUnknownUserNames; };
+    { return usmStatsUnknownUserNames.load(std::memory_order_relaxed); };
 
   /**
    * Get the number of received messages with a unknown engineID
@@ -740,7 +745,7 @@ public:
    * @return - usmStatsUnknownEngineIDs
    */
   unsigned long get_stats_unknown_engine_ids() const
-    { return usmStatsUnknownEngineIDs; };
+    { return usmStatsUnknownEngineIDs.load(std::memory_order_relaxed); };
 
   /**
    * Get the number of received messages with a wrong digest
@@ -748,7 +753,7 @@ public:
    * @return - usmStatsWrongDigests
    */
   unsigned long get_stats_wrong_digests() const
-    { return usmStatsWrongDigests; };
+    { return usmStatsWrongDigests.load(std::memory_order_relaxed); };
 
   /**
    * Get the number of received messages with decryption errors
@@ -756,7 +761,7 @@ public:
    * @return - usmStatsDecryptionErrors
    */
   unsigned long get_stats_decryption_errors() const
-    { return usmStatsDecryptionErrors; };
+    { return usmStatsDecryptionErrors.load(std::memory_order_relaxed); };
 
   //@{
   /**
@@ -1075,13 +1080,13 @@ private:
   // 0: don't accept messages from hosts with a unknown engine id
   bool discovery_mode;
 
-   // MIB Counters
-   unsigned int usmStatsUnsupportedSecLevels;
-   unsigned int usmStatsNotInTimeWindows;
-   unsigned int usmStatsUnknownUserNames;
-   unsigned int usmStatsUnknownEngineIDs;
-   unsigned int usmStatsWrongDigests;
-   unsigned int usmStatsDecryptionErrors;
+   // MIB Counters, incremented without locking by concurrent threads
+   std::atomic<unsigned int> usmStatsUnsupportedSecLevels;
+   std::atomic<unsigned int> usmStatsNotInTimeWindows;
+   std::atomic<unsigned int> usmStatsUnknownUserNames;
+   std::atomic<unsigned int> usmStatsUnknownEngineIDs;
+   std::atomic<unsigned int> usmStatsWrongDigests;
+   std::atomic<unsigned int> usmStatsDecryptionErrors;
 
    // the instance of AuthPriv
    AuthPriv *auth_priv;
@@ -86,6 +86,14 @@ typedef void (*snmp_callback)(int reason, Snmp *session,
  */
 bool setCloseOnExecFlag(SnmpSocket fd);
 
+/**
+ * Set the SO_REUSEPORT option on the given socket.
+ * @param fd - The socket
+ * @return true on success, false on failure or if the platform
+ *         does not support SO_REUSEPORT
+ */
+bool setReusePortFlag(SnmpSocket fd);
+
 //------------[ SNMP Class Def ]---------------------------------------------
 //
 /**
@@ -127,9 +135,13 @@ class DLLOPT Snmp: public SnmpSynchronized
    * @param bind_ipv6
    *    Set this to true if IPv6 should be used. The default is
    *    IPv4.
+   * @param reuse_port
+   *    Set this to true to bind with SO_REUSEPORT, so that several
+   *    sessions can listen on the same port and the operating system
+   *    distributes incoming datagrams among them (since 3.5.2).
    */
   Snmp(int &status, const unsigned short port = 0,
-       const bool bind_ipv6 = false);
+       const bool bind_ipv6 = false, const bool reuse_port = false);
 
   /**
    * Construct a new SNMP session using the given UDP address.
@@ -140,8 +152,10 @@ class DLLOPT Snmp: public SnmpSynchronized
    *    hold the creation status.
    * @param addr
    *    an UDP address to be used for the session
+   * @param reuse_port
+   *    Set this to true to bind with SO_REUSEPORT (since 3.5.2).
    */
-  Snmp(int &status, const UdpAddress &addr);
+  Snmp(int &status, const UdpAddress &addr, const bool reuse_port = false);
 
   /**
    * Construct a new SNMP session using the given UDP addresses.
@@ -601,7 +615,8 @@ protected:
    * Common init function used by constructors.
    */
   void init(int& status, IpAddress*[2],
-            const unsigned short port_v4, const unsigned short port_v6);
+            const unsigned short port_v4, const unsigned short port_v6,
+            const bool reuse_port = false);
 
   /**
    * Set the notify timestamp of a trap pdu if the user did not set it.
@@ -354,6 +354,16 @@ class DLLOPT Vb
   SnmpSyntax* clone_value() const
       { return ((iv_vb_value) ? iv_vb_value->clone() : 0); };
 
+  /**
+   * Get the value without copying it.
+   *
+   * @note The returned pointer is only valid as long as the Vb is
+   *       not modified.
+   *
+   * @return a pointer to the value or NULL if the Vb has no value.
+   */
+  const SnmpSyntax* get_value_ptr() const { return iv_vb_value; };
+
 
   //-----[ misc]--------------------------------------------------------
 
@@ -1005,6 +1005,310 @@ unsigned char *asn_build_unsigned_int64(unsigned char *data,
 }
 
 
+/*
+ * Reverse builders
+ *
+ *  The asn_rbuild_* functions encode an object in front of "data", so
+ *  that a message can be encoded from its last byte towards its first
+ *  one. The length of a constructed object is then known when its
+ *  header is encoded and its contents do not have to be staged in a
+ *  temporary buffer. Each one encodes the same type as the
+ *  corresponding asn_build_* function.
+ *
+ *  On entry, datalength is input as the number of free bytes in front
+ *   of "data".  On exit, it is reduced by the size of the object.
+ *
+ *  Returns a pointer to the first byte of this object (i.e. the new
+ *   start of the encoded data).
+ *  Returns NULL on any error.
+ */
+
+/*
+ * asn_length_length - returns the number of bytes needed to encode
+ *  the given length (see asn_build_length).
+ */
+static int asn_length_length(int length)
+{
+  if (length < 0x80)     return 1;
+  if (length <= 0xFF)    return 2;
+  if (length <= 0xFFFF)  return 3;
+  if (length <= 0xFFFFFF)  return 4;
+  return 5;
+}
+
+unsigned char *asn_rbuild_length(unsigned char *data,
+                                 int *datalength,
+                                 int length)
+{
+  int size = asn_length_length(length);
+
+  if (*datalength < size) {
+    ASNERROR("build_length");
+    return NULL;
+  }
+  *datalength -= size;
+  if (size == 1) {
+    *--data = (unsigned char)length;
+    return data;
+  }
+  for (int i = 1; i < size; i++, length >>= 8)
+    *--data = (unsigned char)(length & 0xFF);
+  *--data = (unsigned char)((size - 1) | ASN_LONG_LEN);
+  return data;
+}
+
+unsigned char *asn_rbuild_header(unsigned char *data,
+                                 int *datalength,
+                                 unsigned char type,
+                                 int length)
+{
+  data = asn_rbuild_length(data, datalength, length);
+  if (data == NULL)     return NULL;
+  if (*datalength < 1)  return NULL;
+  (*datalength)--;
+  *--data = type;
+  return data;
+}
+
+unsigned char *asn_rbuild_int(unsigned char *data, int *datalength,
+                              const unsigned char type,
+                              const long *intp)
+{
+  unsigned char *end = data;
+  long integer = *intp;
+  bool more;
+
+  // least significant byte first, until the remaining bytes are
+  // covered by the sign bit of the last byte
+  do {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = (unsigned char)(integer & 0xFF);
+    more = ((integer < -128) || (integer > 127));
+    integer >>= 8;
+  } while (more);
+
+  return asn_rbuild_header(data, datalength, type, SAFE_INT_CAST(end - data));
+}
+
+unsigned char *asn_rbuild_unsigned_int(unsigned char *data, int *datalength,
+                                       unsigned char type,
+                                       const unsigned long *intp)
+{
+  unsigned char *end = data;
+  // as asn_build_unsigned_int, encode the lower 32 bits only
+  unsigned long u_integer = *intp & 0xFFFFFFFFul;
+
+  do {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = (unsigned char)(u_integer & 0xFF);
+    u_integer >>= 8;
+  } while (u_integer);
+
+  // add a null byte if the MSB is set
+  if (*data & 0x80) {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = 0;
+  }
+  return asn_rbuild_header(data, datalength, type, SAFE_INT_CAST(end - data));
+}
+
+unsigned char *asn_rbuild_unsigned_int64(unsigned char *data, int *datalength,
+                                         unsigned char type,
+                                         const struct counter64 *cp)
+{
+  unsigned char *end = data;
+  unsigned long low = cp->low & 0xFFFFFFFFul;
+  unsigned long high = cp->high & 0xFFFFFFFFul;
+
+  do {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = (unsigned char)(low & 0xFF);
+    low = (low >> 8) | ((high & 0xFF) << 24);
+    high >>= 8;
+  } while (low || high);
+
+  // add a null byte if the MSB is set
+  if (*data & 0x80) {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = 0;
+  }
+  return asn_rbuild_header(data, datalength, type, SAFE_INT_CAST(end - data));
+}
+
+unsigned char *asn_rbuild_string(unsigned char *data, int *datalength,
+                                 const unsigned char type,
+                                 const unsigned char *string,
+                                 const int strlength)
+{
+  if (*datalength < strlength) return NULL;
+  *datalength -= strlength;
+  data -= strlength;
+  if (strlength > 0)
+    memcpy(data, string, strlength);
+  return asn_rbuild_header(data, datalength, type, strlength);
+}
+
+unsigned char *asn_rbuild_bitstring(unsigned char *data, int *datalength,
+                                    unsigned char type,
+                                    const unsigned char *string,
+                                    int strlength)
+{
+  if (strlength < 1 || *string > 7) {
+    ASNERROR("Building invalid bitstring");
+    return NULL;
+  }
+  return asn_rbuild_string(data, datalength, type, string, strlength);
+}
+
+unsigned char *asn_rbuild_null(unsigned char *data, int *datalength,
+                               unsigned char type)
+{
+  return asn_rbuild_header(data, datalength, type, 0);
+}
+
+/*
+ * asn_rbuild_subid - encodes a sub-identifier in front of data,
+ *  see asn_build_subid.
+ */
+static unsigned char *asn_rbuild_subid(unsigned long subid,
+                                       unsigned char *data, int *datalength)
+{
+  if (*datalength < 1) return NULL;
+  (*datalength)--;
+  *--data = (unsigned char)(subid & 0x7F);
+  for (subid >>= 7; subid != 0; subid >>= 7) {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = (unsigned char)((subid & 0x7F) | ASN_BIT8);
+  }
+  return data;
+}
+
+unsigned char *asn_rbuild_objid(unsigned char *data, int *datalength,
+                                unsigned char type,
+                                const oid *objid, int objidlength)
+{
+  unsigned char *end = data;
+
+  if (objidlength > MAX_OID_LEN) {
+    ASNERROR("Too many sub-identifiers.");
+    objidlength = MAX_OID_LEN;
+  }
+  if (objidlength < 2) {
+    if (*datalength < 1) return NULL;
+    (*datalength)--;
+    *--data = 0;
+  }
+  else {
+    for (int i = objidlength - 1; (i >= 2) && data; i--)
+      data = asn_rbuild_subid(objid[i], data, datalength);
+    if (data)
+      data = asn_rbuild_subid(objid[1] + (objid[0] * 40), data, datalength);
+    if (data == NULL) return NULL;
+  }
+  return asn_rbuild_header(data, datalength, type, SAFE_INT_CAST(end - data));
+}
+
+
+// ---------------------------[ decode arena ]-----------------------------
+
+struct snmp_arena_block {
+    struct snmp_arena_block *next;
+    size_t size;  // usable bytes
+    size_t used;  // allocated bytes
+};
+
+// all allocations are aligned to the size of this union
+union snmp_arena_align {
+    long l;
+    double d;
+    void *p;
+    struct counter64 c;
+};
+
+#define SNMP_ARENA_ALIGN_UP(n) \
+  (((n) + sizeof(snmp_arena_align) - 1) & ~(sizeof(snmp_arena_align) - 1))
+
+#define SNMP_ARENA_BLOCK_DATA(b) \
+  ((unsigned char *)(b) + SNMP_ARENA_ALIGN_UP(sizeof(struct snmp_arena_block)))
+
+void snmp_arena_init(struct snmp_arena *arena)
+{
+  arena->first = NULL;
+  arena->current = NULL;
+}
+
+void *snmp_arena_alloc(struct snmp_arena *arena, size_t size)
+{
+  size = SNMP_ARENA_ALIGN_UP(size ? size : 1);
+
+  // the blocks behind current are unused since the last reset
+  struct snmp_arena_block *b = arena->current;
+  struct snmp_arena_block *last = b;
+  while (b && (b->used + size > b->size))
+  {
+    last = b;
+    b = b->next;
+  }
+  if (!b)
+  {
+    size_t block_size = SNMP_ARENA_BLOCK_SIZE;
+    if (block_size < size)
+      block_size = size;
+    b = (struct snmp_arena_block *)
+          malloc(SNMP_ARENA_ALIGN_UP(sizeof(struct snmp_arena_block))
+                 + block_size);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->size = block_size;
+    b->used = 0;
+    if (!arena->first)
+      arena->first = b;
+    else
+    {
+      while (last->next) last = last->next;
+      last->next = b;
+    }
+  }
+  arena->current = b;
+
+  void *ptr = SNMP_ARENA_BLOCK_DATA(b) + b->used;
+  b->used += size;
+  return ptr;
+}
+
+void snmp_arena_reset(struct snmp_arena *arena)
+{
+  for (struct snmp_arena_block *b = arena->first; b; b = b->next)
+    b->used = 0;
+  arena->current = arena->first;
+}
+
+void snmp_arena_destroy(struct snmp_arena *arena)
+{
+  struct snmp_arena_block *b = arena->first;
+  while (b)
+  {
+    struct snmp_arena_block *next = b->next;
+    free(b);
+    b = next;
+  }
+  snmp_arena_init(arena);
+}
+
+// allocate memory for a part of the pdu
+static void *pdu_malloc(struct snmp_pdu *pdu, size_t size)
+{
+  if (pdu->arena)
+    return snmp_arena_alloc(pdu->arena, size);
+  return malloc(size);
+}
+
 // create a pdu
 struct snmp_pdu *snmp_pdu_create(int command)
 {
@@ -1022,13 +1326,30 @@ struct snmp_pdu *snmp_pdu_create(int command)
   pdu->enterprise = NULL;
   pdu->enterprise_length = 0;
   pdu->variables = NULL;
+  pdu->vb_encoder = NULL;
+  pdu->vb_encoder_arg = NULL;
+  pdu->arena = NULL;
+  return pdu;
+}
+
+// create a pdu within an arena
+struct snmp_pdu *snmp_pdu_create_in(struct snmp_arena *arena, int command)
+{
+  struct snmp_pdu *pdu;
+
+  pdu = (struct snmp_pdu *)snmp_arena_alloc(arena, sizeof(struct snmp_pdu));
+  if (!pdu) return pdu;
+  memset((char *)pdu, 0, sizeof(struct snmp_pdu));
+  pdu->command = command;
+  pdu->arena = arena;
   return pdu;
 }
 
 // free content and clear pointers
 void clear_pdu(struct snmp_pdu *pdu, bool clear_all)
 {
-  struct variable_list *vp = pdu->variables;
+  // the content of an arena pdu is released with the arena
+  struct variable_list *vp = (pdu->arena ? NULL : pdu->variables);
   while (vp)
   {
     if (vp->name) free((char *)vp->name);  // free the oid part
@@ -1038,9 +1359,11 @@ void clear_pdu(struct snmp_pdu *pdu, bool clear_all)
     free((char *)ovp);     // free up vb itself
   }
   pdu->variables = NULL;
+  pdu->vb_encoder = NULL;
+  pdu->vb_encoder_arg = NULL;
 
   // if enterprise free it up
-  if (pdu->enterprise)
+  if (pdu->enterprise && !pdu->arena)
     free((char *)pdu->enterprise);
   pdu->enterprise = NULL;
 
@@ -1064,6 +1387,11 @@ void clear_pdu(struct snmp_pdu *pdu, bool clear_all)
 // free a pdu
 void snmp_free_pdu(struct snmp_pdu *pdu)
 {
+  if (pdu->arena)
+  {
+    snmp_arena_reset(pdu->arena); // releases the pdu and its content
+    return;
+  }
   clear_pdu(pdu); // clear and free content
   free(pdu);   // free up pdu itself
 }
@@ -1079,7 +1407,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
 
   // if we don't have a vb list ,create one
   if (pdu->variables == NULL)
-    pdu->variables = vars = (struct variable_list *)malloc(sizeof(struct variable_list));
+    pdu->variables = vars = (struct variable_list *)pdu_malloc(pdu, sizeof(struct variable_list));
   else
   {
     // we have one, find the end
@@ -1087,7 +1415,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
     while (vars->next_variable) vars = vars->next_variable;
 
     // create a new one
-    vars->next_variable = (struct variable_list *)malloc(sizeof(struct variable_list));
+    vars->next_variable = (struct variable_list *)pdu_malloc(pdu, sizeof(struct variable_list));
     // bump ptr
     vars = vars->next_variable;
   }
@@ -1096,7 +1424,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
   vars->next_variable = NULL;
 
   // hook in the Oid portion
-  vars->name = (oid *)malloc(name_length * sizeof(oid));
+  vars->name = (oid *)pdu_malloc(pdu, name_length * sizeof(oid));
 
   memcpy((char *)vars->name,(char *)name, name_length * sizeof(oid));
   vars->name_length = name_length;
@@ -1122,7 +1450,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
     case sNMP_SYNTAX_IPADDR:
       {
 	vars->type = (unsigned char) smival->syntax;
-	vars->val.string = (unsigned char *)malloc((unsigned)smival->value.string.len);
+	vars->val.string = (unsigned char *)pdu_malloc(pdu, (unsigned)smival->value.string.len);
 	vars->val_len = (int) smival->value.string.len;
 	memcpy((unsigned char *) vars->val.string,
 		(unsigned char *) smival->value.string.ptr,
@@ -1135,7 +1463,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
       {
 	vars->type = (unsigned char) smival->syntax;
         vars->val_len = (int) smival->value.oid.len * sizeof(oid);
-	vars->val.objid = (oid *)malloc((unsigned)vars->val_len);
+	vars->val.objid = (oid *)pdu_malloc(pdu, (unsigned)vars->val_len);
 	memcpy((unsigned long *)vars->val.objid,
 	       (unsigned long *)smival->value.oid.ptr,
 	       (unsigned) vars->val_len);
@@ -1151,7 +1479,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
       {
 	long templong;
 	vars->type = (unsigned char) smival->syntax;
-	vars->val.integer = (long *)malloc(sizeof(long));
+	vars->val.integer = (long *)pdu_malloc(pdu, sizeof(long));
 	vars->val_len = sizeof(long);
 	templong = (long) smival->value.uNumber;
 	memcpy((long*) vars->val.integer,
@@ -1164,7 +1492,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
       {
 	long templong;
 	vars->type = (unsigned char) smival->syntax;
-	vars->val.integer = (long *)malloc(sizeof(long));
+	vars->val.integer = (long *)pdu_malloc(pdu, sizeof(long));
 	vars->val_len = sizeof(long);
 	templong = (long) smival->value.sNumber;
 	memcpy((long*) vars->val.integer,
@@ -1177,7 +1505,7 @@ void snmp_add_var(struct snmp_pdu *pdu,
     case sNMP_SYNTAX_CNTR64:
       {
 	vars->type = (unsigned char) smival->syntax;
-	vars->val.counter64 = (struct counter64 *)malloc(sizeof(struct counter64));
+	vars->val.counter64 = (struct counter64 *)pdu_malloc(pdu, sizeof(struct counter64));
 	vars->val_len = sizeof(struct counter64);
 	memcpy((struct counter64*) vars->val.counter64,
 		(SmiLPCNTR64) &(smival->value.hNumber),
@@ -1189,59 +1517,38 @@ void snmp_add_var(struct snmp_pdu *pdu,
 
 }
 
-// build the authentication, works for v1 or v2c
-static unsigned char *snmp_auth_build(unsigned char *data,
-				      int *length,
-				      const long int version,
-				      const unsigned char *community,
-				      const int community_len,
-				      const int messagelen)
-{
-  // 5 is 3 octets for version and 2 for community header + len
-  // This assumes that community will not be longer than 0x7f chars.
-  data = asn_build_sequence(data, length, ASN_SEQ_CON,
-			    messagelen + community_len + 5);
-  if (data == NULL) { 
-    ASNERROR("buildheader");
-    return NULL;
-  }
-  data = asn_build_int(data, length, ASN_UNI_PRIM | ASN_INTEGER, &version);
-  if (data == NULL) {
-    ASNERROR("buildint");
-    return NULL;
-  }
-
-  data = asn_build_string(data, length, ASN_UNI_PRIM | ASN_OCTET_STR,
-			  community, community_len);
-  if (data == NULL) {
-    ASNERROR("buildstring");
-    return NULL;
-  }
-
-  return data;
-}
-
+// Space for an encoded variable name and a value that is not a string
+// (strings are copied directly into the target buffer). At most
+// MAX_OID_LEN sub-identifiers of up to five bytes are encoded for an OID.
+#define SNMP_VAR_OP_BUFFER_LEN (2 * (MAX_OID_LEN * 5 + 8))
 
-// build a variable binding
-unsigned char * snmp_build_var_op(unsigned char *data,
-				  oid * var_name,
-				  int *var_name_len,
-				  unsigned char var_val_type,
-				  int var_val_len,
-				  unsigned char *var_val,
-				  int *listlength)
+/*
+ * build_var_op_content - encodes the name and the value of a variable
+ *  binding into buffer (which must have SNMP_VAR_OP_BUFFER_LEN bytes).
+ *  For string values only the header of the value is encoded, the
+ *  string itself is returned in payload and payload_len.
+ *
+ *  Returns the number of bytes encoded or -1 on any error.
+ */
+static int build_var_op_content(unsigned char *buffer,
+                                oid *var_name, int *var_name_len,
+                                unsigned char var_val_type,
+                                int var_val_len, unsigned char *var_val,
+                                const unsigned char **payload,
+                                int *payload_len)
 {
-  int valueLen;
-  Buffer<unsigned char> buffer(MAX_SNMP_PACKET);
-  unsigned char *buffer_pos = buffer.get_ptr();
-  int bufferLen = MAX_SNMP_PACKET;
+  unsigned char *buffer_pos = buffer;
+  int bufferLen = SNMP_VAR_OP_BUFFER_LEN;
+
+  *payload = 0;
+  *payload_len = 0;
 
   buffer_pos = asn_build_objid(buffer_pos, &bufferLen,
 			       ASN_UNI_PRIM | ASN_OBJECT_ID,
 			       var_name, *var_name_len);
   if (buffer_pos == NULL) {
     ASNERROR("build_var_op: build_objid failed");
-    return NULL;
+    return -1;
   }
 
   // based on the type...
@@ -1250,7 +1557,7 @@ unsigned char * snmp_build_var_op(unsigned char *data,
     if (var_val_len != sizeof(long))
     {
       ASNERROR("build_var_op: Illegal size of integer");
-      return NULL;
+      return -1;
     }
     buffer_pos = asn_build_int(buffer_pos, &bufferLen,
                                var_val_type, (long *)var_val);
@@ -1263,7 +1570,7 @@ unsigned char * snmp_build_var_op(unsigned char *data,
     if (var_val_len != sizeof(unsigned long))
     {
       ASNERROR("build_var_op: Illegal size of unsigned integer");
-      return NULL;
+      return -1;
     }
     buffer_pos = asn_build_unsigned_int(buffer_pos, &bufferLen,
                                         var_val_type, (unsigned long *)var_val);
@@ -1273,19 +1580,28 @@ unsigned char * snmp_build_var_op(unsigned char *data,
     if (var_val_len != sizeof(counter64))
     {
       ASNERROR("build_var_op: Illegal size of counter64");
-      return NULL;
+      return -1;
     }
     buffer_pos = asn_build_unsigned_int64(buffer_pos, &bufferLen,
                                           var_val_type,
                                           (struct counter64 *)var_val);
     break;
 
+  case ASN_BIT_STR:
+    if (var_val_len < 1 || *var_val > 7) {
+      ASNERROR("Building invalid bitstring");
+      return -1;
+    }
+    // fall through
   case ASN_OCTET_STR:
   case SMI_IPADDRESS:
   case SMI_OPAQUE:
   case SMI_NSAP:
-    buffer_pos = asn_build_string(buffer_pos, &bufferLen, var_val_type,
-                                  var_val, var_val_len);
+    // the string is not copied here, see snmp_build_var_op
+    buffer_pos = asn_build_header(buffer_pos, &bufferLen, var_val_type,
+                                  var_val_len);
+    *payload = var_val;
+    *payload_len = var_val_len;
     break;
 
   case ASN_OBJECT_ID:
@@ -1297,11 +1613,6 @@ unsigned char * snmp_build_var_op(unsigned char *data,
     buffer_pos = asn_build_null(buffer_pos, &bufferLen, var_val_type);
     break;
 
-  case ASN_BIT_STR:
-    buffer_pos = asn_build_bitstring(buffer_pos, &bufferLen, var_val_type,
-                                     var_val, var_val_len);
-    break;
-
   case SNMP_NOSUCHOBJECT:
   case SNMP_NOSUCHINSTANCE:
   case SNMP_ENDOFMIBVIEW:
@@ -1310,27 +1621,53 @@ unsigned char * snmp_build_var_op(unsigned char *data,
 
   default:
     ASNERROR("build_var_op: wrong type");
-    return NULL;
+    return -1;
   }
   if (buffer_pos == NULL) {
     ASNERROR("build_var_op: value build failed");
-    return NULL;
+    return -1;
   }
+  return SAFE_INT_CAST(buffer_pos - buffer);
+}
 
-  valueLen = SAFE_INT_CAST(buffer_pos - buffer.get_ptr());
+// build a variable binding
+unsigned char * snmp_build_var_op(unsigned char *data,
+				  oid * var_name,
+				  int *var_name_len,
+				  unsigned char var_val_type,
+				  int var_val_len,
+				  unsigned char *var_val,
+				  int *listlength)
+{
+  unsigned char buffer[SNMP_VAR_OP_BUFFER_LEN];
+  const unsigned char *payload;
+  int payloadLen;
+
+  int valueLen = build_var_op_content(buffer, var_name, var_name_len,
+                                      var_val_type, var_val_len, var_val,
+                                      &payload, &payloadLen);
+  if (valueLen < 0)
+    return NULL;
 
-  data = asn_build_sequence(data, listlength, ASN_SEQ_CON, valueLen);
+  data = asn_build_sequence(data, listlength, ASN_SEQ_CON,
+                            valueLen + payloadLen);
 
-  if(data == NULL || *listlength < valueLen)
+  if(data == NULL || *listlength < valueLen + payloadLen)
   {
     ASNERROR("build_var_op");
     data = NULL;
   }
   else
   {
-    memcpy(data, buffer.get_ptr(), valueLen);
+    // the string value is copied only once: from its owner to data
+    memcpy(data, buffer, valueLen);
     data += valueLen;
-    (*listlength)-=valueLen;
+    if (payloadLen > 0)
+    {
+      memcpy(data, payload, payloadLen);
+      data += payloadLen;
+    }
+    (*listlength) -= valueLen + payloadLen;
   }
   return data;
 }
@@ -1339,11 +1676,31 @@ unsigned char * snmp_build_var_op(unsigned char *data,
 unsigned char *build_vb(struct snmp_pdu *pdu,
 			unsigned char *buf, int *buf_len)
 {
-  Buffer<unsigned char> tmp_buf(MAX_SNMP_PACKET);
-  unsigned char *cp = tmp_buf.get_ptr();
+  unsigned char buffer[SNMP_VAR_OP_BUFFER_LEN];
+  const unsigned char *payload;
+  int payloadLen;
+  unsigned char *cp;
   struct   variable_list *vp;
-  int vb_length;
-  int length = MAX_SNMP_PACKET;
+  int vb_length = 0;
+
+  // compute the length of the encoded varbinds, so that they can
+  // be encoded directly behind the header into buf
+  for(vp = pdu->variables; vp; vp = vp->next_variable)
+  {
+    int len = build_var_op_content(buffer, vp->name, &vp->name_length,
+                                   vp->type, vp->val_len,
+                                   (unsigned char *)vp->val.string,
+                                   &payload, &payloadLen);
+    if (len < 0) return 0;
+    len += payloadLen;
+    vb_length += 1 + asn_length_length(len) + len;
+    if (vb_length > *buf_len) return 0;
+  }
+
+  // encode the length of encoded varbinds into buf
+  cp = asn_build_header(buf, buf_len, ASN_SEQ_CON, vb_length);
+  if (cp == NULL) return 0;
+  if (*buf_len < vb_length) return 0;
 
   // build varbinds into packet buffer
   for(vp = pdu->variables; vp; vp = vp->next_variable)
@@ -1351,80 +1708,226 @@ unsigned char *build_vb(struct snmp_pdu *pdu,
     cp = snmp_build_var_op(cp, vp->name, &vp->name_length,
 			    vp->type, vp->val_len,
 			    (unsigned char *)vp->val.string,
-			    &length);
+			    buf_len);
     if (cp == NULL) return 0;
   }
-  vb_length = SAFE_INT_CAST(cp - tmp_buf.get_ptr());
-  *buf_len -= vb_length;
-  if (*buf_len <= 0) return 0;
+  return cp;
+}
 
-  // encode the length of encoded varbinds into buf
-  cp = asn_build_header(buf, buf_len, ASN_SEQ_CON, vb_length);
-  if (cp == NULL) return 0;
+// build a variable binding in front of data (see asn_rbuild_int)
+unsigned char *snmp_rbuild_var_op(unsigned char *data, int *datalength,
+                                  const oid *var_name, int var_name_len,
+                                  unsigned char var_val_type,
+                                  int var_val_len,
+                                  const unsigned char *var_val)
+{
+  int end = *datalength;
+
+  // value first, then the name and the header of the sequence
+  switch(var_val_type) {
+  case ASN_INTEGER:
+    if (var_val_len != sizeof(long))
+    {
+      ASNERROR("build_var_op: Illegal size of integer");
+      return NULL;
+    }
+    data = asn_rbuild_int(data, datalength, var_val_type,
+                          (const long *)var_val);
+    break;
+
+  case SMI_GAUGE:
+  case SMI_COUNTER:
+  case SMI_TIMETICKS:
+  case SMI_UINTEGER:
+    if (var_val_len != sizeof(unsigned long))
+    {
+      ASNERROR("build_var_op: Illegal size of unsigned integer");
+      return NULL;
+    }
+    data = asn_rbuild_unsigned_int(data, datalength, var_val_type,
+                                   (const unsigned long *)var_val);
+    break;
+
+  case SMI_COUNTER64:
+    if (var_val_len != sizeof(counter64))
+    {
+      ASNERROR("build_var_op: Illegal size of counter64");
+      return NULL;
+    }
+    data = asn_rbuild_unsigned_int64(data, datalength, var_val_type,
+                                     (const struct counter64 *)var_val);
+    break;
+
+  case ASN_BIT_STR:
+    data = asn_rbuild_bitstring(data, datalength, var_val_type,
+                                var_val, var_val_len);
+    break;
+
+  case ASN_OCTET_STR:
+  case SMI_IPADDRESS:
+  case SMI_OPAQUE:
+  case SMI_NSAP:
+    data = asn_rbuild_string(data, datalength, var_val_type,
+                             var_val, var_val_len);
+    break;
+
+  case ASN_OBJECT_ID:
+    data = asn_rbuild_objid(data, datalength, var_val_type,
+                            (const oid *)var_val, var_val_len / sizeof(oid));
+    break;
+
+  case ASN_NULL:
+  case SNMP_NOSUCHOBJECT:
+  case SNMP_NOSUCHINSTANCE:
+  case SNMP_ENDOFMIBVIEW:
+    data = asn_rbuild_null(data, datalength, var_val_type);
+    break;
+
+  default:
+    ASNERROR("build_var_op: wrong type");
+    return NULL;
+  }
+  if (data == NULL) {
+    ASNERROR("build_var_op: value build failed");
+    return NULL;
+  }
 
-  // copy varbinds from packet behind header in buf
-  memcpy(cp, tmp_buf.get_ptr(), vb_length);
+  data = asn_rbuild_objid(data, datalength, ASN_UNI_PRIM | ASN_OBJECT_ID,
+                          var_name, var_name_len);
+  if (data == NULL) {
+    ASNERROR("build_var_op: build_objid failed");
+    return NULL;
+  }
 
-  return (cp + vb_length);
+  data = asn_rbuild_header(data, datalength, ASN_SEQ_CON, end - *datalength);
+  if (data == NULL) {
+    ASNERROR("build_var_op");
+    return NULL;
+  }
+  return data;
 }
 
-unsigned char *build_data_pdu(struct snmp_pdu *pdu,
-			      unsigned char *buf, int *buf_len,
-			      unsigned char *vb_buf, int vb_buf_len)
+// reverse the order of the variable bindings of a pdu
+static void reverse_variables(struct snmp_pdu *pdu)
 {
-  Buffer<unsigned char> tmp_buf(MAX_SNMP_PACKET);
-  unsigned char *cp = tmp_buf.get_ptr();
-  int totallength;
-  int length = MAX_SNMP_PACKET;
+  struct variable_list *prev = 0;
+  struct variable_list *vp = pdu->variables;
+  while (vp)
+  {
+    struct variable_list *next = vp->next_variable;
+    vp->next_variable = prev;
+    prev = vp;
+    vp = next;
+  }
+  pdu->variables = prev;
+}
+
+unsigned char *rbuild_vb(struct snmp_pdu *pdu,
+                         unsigned char *data, int *datalength)
+{
+  int end = *datalength;
+
+  if (pdu->vb_encoder)
+  {
+    data = pdu->vb_encoder(pdu->vb_encoder_arg, data, datalength);
+    if (data == NULL) return NULL;
+
+    return asn_rbuild_header(data, datalength, ASN_SEQ_CON, end - *datalength);
+  }
+
+  // the list is single linked, so it is reversed for encoding
+  // the last variable binding first and restored afterwards
+  reverse_variables(pdu);
+  for (struct variable_list *vp = pdu->variables; vp && data;
+       vp = vp->next_variable)
+  {
+    data = snmp_rbuild_var_op(data, datalength, vp->name, vp->name_length,
+                              vp->type, vp->val_len, vp->val.string);
+  }
+  reverse_variables(pdu);
+  if (data == NULL) return NULL;
+
+  return asn_rbuild_header(data, datalength, ASN_SEQ_CON, end - *datalength);
+}
 
-  // build data of pdu into tmp_buf
+// build the fields in front of the variable bindings of a pdu
+static unsigned char *rbuild_pdu_fields(struct snmp_pdu *pdu,
+                                        unsigned char *data, int *datalength)
+{
   if (pdu->command != TRP_REQ_MSG)
   {
-    // request id
-    cp = asn_build_int(cp, &length, ASN_UNI_PRIM | ASN_INTEGER, &pdu->reqid);
-    if (cp == NULL) return 0;
+    // error index
+    data = asn_rbuild_int(data, datalength, ASN_UNI_PRIM | ASN_INTEGER,
+                          &pdu->errindex);
+    if (data == NULL) return 0;
 
     // error status
-    cp = asn_build_int(cp, &length, ASN_UNI_PRIM | ASN_INTEGER, &pdu->errstat);
-    if (cp == NULL) return 0;
+    data = asn_rbuild_int(data, datalength, ASN_UNI_PRIM | ASN_INTEGER,
+                          &pdu->errstat);
+    if (data == NULL) return 0;
 
-    // error index
-    cp = asn_build_int(cp, &length, ASN_UNI_PRIM | ASN_INTEGER, &pdu->errindex);
-    if (cp == NULL) return 0;
-  }
-  else
-  { // this is a trap message
-    // enterprise
-    cp = asn_build_objid(cp, &length, ASN_UNI_PRIM | ASN_OBJECT_ID,
-			  (oid *)pdu->enterprise, pdu->enterprise_length);
-    if (cp == NULL) return 0;
+    // request id
+    return asn_rbuild_int(data, datalength, ASN_UNI_PRIM | ASN_INTEGER,
+                          &pdu->reqid);
+  }
+
+  // this is a trap message
+  // timestamp
+  data = asn_rbuild_unsigned_int(data, datalength, SMI_TIMETICKS, &pdu->time);
+  if (data == NULL) return 0;
+
+  long dummy = pdu->specific_type;
+  // specific trap
+  data = asn_rbuild_int(data, datalength, ASN_UNI_PRIM | ASN_INTEGER, &dummy);
+  if (data == NULL) return 0;
+
+  dummy = pdu->trap_type;
+  // generic trap
+  data = asn_rbuild_int(data, datalength, ASN_UNI_PRIM | ASN_INTEGER, &dummy);
+  if (data == NULL) return 0;
+
+  // agent-addr ; must be IPADDRESS changed by Frank Fock
+  data = asn_rbuild_string(data, datalength, SMI_IPADDRESS,
+                           (unsigned char *)&pdu->agent_addr.sin_addr.s_addr,
+                           sizeof(pdu->agent_addr.sin_addr.s_addr));
+  if (data == NULL) return 0;
+
+  // enterprise
+  return asn_rbuild_objid(data, datalength, ASN_UNI_PRIM | ASN_OBJECT_ID,
+                          (oid *)pdu->enterprise, pdu->enterprise_length);
+}
 
-    // agent-addr ; must be IPADDRESS changed by Frank Fock
-    cp = asn_build_string(cp, &length, SMI_IPADDRESS,
-			  (unsigned char *)&pdu->agent_addr.sin_addr.s_addr,
-			  sizeof(pdu->agent_addr.sin_addr.s_addr));
-    if (cp == NULL) return 0;
+unsigned char *rbuild_data_pdu(struct snmp_pdu *pdu,
+                               unsigned char *data, int *datalength)
+{
+  int end = *datalength;
 
-    long dummy = pdu->trap_type;
-    // generic trap
-    cp = asn_build_int(cp, &length, ASN_UNI_PRIM | ASN_INTEGER, &dummy);
-    if (cp == NULL) return 0;
+  data = rbuild_vb(pdu, data, datalength);
+  if (data == NULL) return 0;
 
-    dummy = pdu->specific_type;
-    // specific trap
-    cp = asn_build_int(cp, &length, ASN_UNI_PRIM | ASN_INTEGER, &dummy);
-    if (cp == NULL) return 0;
+  data = rbuild_pdu_fields(pdu, data, datalength);
+  if (data == NULL) return 0;
 
-    // timestamp
-    cp = asn_build_unsigned_int(cp, &length, SMI_TIMETICKS, &pdu->time);
-    if (cp == NULL) return 0;
-  }
+  return asn_rbuild_header(data, datalength,
+                           (unsigned char)pdu->command, end - *datalength);
+}
 
-  if (length < vb_buf_len) return 0;
+unsigned char *build_data_pdu(struct snmp_pdu *pdu,
+			      unsigned char *buf, int *buf_len,
+			      unsigned char *vb_buf, int vb_buf_len)
+{
+  // the fields of a pdu fit into the buffer used for a variable binding
+  unsigned char fields[SNMP_VAR_OP_BUFFER_LEN];
+  int length = SNMP_VAR_OP_BUFFER_LEN;
+  unsigned char *cp;
+  int totallength;
+
+  // build data of pdu into the end of fields
+  cp = rbuild_pdu_fields(pdu, fields + SNMP_VAR_OP_BUFFER_LEN, &length);
+  if (cp == NULL) return 0;
 
-  // save relative position of varbinds
-  int vb_rel_pos = SAFE_INT_CAST(cp - tmp_buf.get_ptr());
-  totallength = SAFE_INT_CAST(cp - tmp_buf.get_ptr()) + vb_buf_len;
+  int fields_len = SNMP_VAR_OP_BUFFER_LEN - length;
+  totallength = fields_len + vb_buf_len;
 
   // build header for datapdu into buf
   cp = asn_build_header(buf, buf_len,
@@ -1433,8 +1936,8 @@ unsigned char *build_data_pdu(struct snmp_pdu *pdu,
   if (*buf_len < totallength) return 0;
 
   // copy data behind header
-  memcpy(cp, tmp_buf.get_ptr(), totallength - vb_buf_len);
-  memcpy((char *)cp + vb_rel_pos, (char *)vb_buf, vb_buf_len);
+  memcpy(cp, fields + length, fields_len);
+  memcpy((char *)cp + fields_len, (char *)vb_buf, vb_buf_len);
   *buf_len -= totallength;
   return (cp + totallength);
 }
@@ -1445,36 +1948,37 @@ int snmp_build(struct snmp_pdu	*pdu,
                const long version,
                const unsigned char* community, const int community_len)
 {
-  Buffer<unsigned char> buf(MAX_SNMP_PACKET);
-  unsigned char  *cp;
-  int	     length;
-  int	 totallength;
-
-  // encode vbs with header into packet
-  length = *out_length;
-  cp = build_vb(pdu, packet, &length);
-  if (cp == 0) return -1;
-  totallength = SAFE_INT_CAST(cp - packet);
-  if (totallength >= *out_length) return -1;
-
-  // encode datadpu into buf
-  length = MAX_SNMP_PACKET;
-  cp = build_data_pdu(pdu, buf.get_ptr(), &length,
-		      packet, totallength);
-  if (cp == 0) return -1;
-  totallength = SAFE_INT_CAST(cp - buf.get_ptr());
-  if (totallength >= *out_length) return -1;
+  // encode the message back to front into the end of packet
+  unsigned char *cp = packet + *out_length;
+  int length = *out_length;
 
-  // build SNMP header
-  length = *out_length;
-  cp = snmp_auth_build(packet, &length, version,
-			community, community_len, totallength);
+  cp = rbuild_data_pdu(pdu, cp, &length);
   if (cp == NULL) return -1;
-  if ((*out_length - (cp - packet)) < totallength) return -1;
 
-  // copy data
-  memcpy(cp, buf.get_ptr(), totallength);
-  totallength += SAFE_INT_CAST(cp - packet);
+  // build SNMP header
+  cp = asn_rbuild_string(cp, &length, ASN_UNI_PRIM | ASN_OCTET_STR,
+                         community, community_len);
+  if (cp == NULL) {
+    ASNERROR("buildstring");
+    return -1;
+  }
+
+  cp = asn_rbuild_int(cp, &length, ASN_UNI_PRIM | ASN_INTEGER, &version);
+  if (cp == NULL) {
+    ASNERROR("buildint");
+    return -1;
+  }
+
+  cp = asn_rbuild_header(cp, &length, ASN_SEQ_CON, *out_length - length);
+  if (cp == NULL) {
+    ASNERROR("buildheader");
+    return -1;
+  }
+
+  // move the message to the start of packet
+  int totallength = *out_length - length;
+  if (cp != packet)
+    memmove(packet, cp, totallength);
   *out_length = totallength;
 
   return 0;
@@ -1580,9 +2084,9 @@ int snmp_parse_vb(struct snmp_pdu *pdu, unsigned char *&data, int &data_len)
   pdu->variables = NULL;
   while(data_len > 0) {
     if (pdu->variables == NULL) {
-      pdu->variables = vp = (struct variable_list *)malloc(sizeof(struct variable_list));
+      pdu->variables = vp = (struct variable_list *)pdu_malloc(pdu, sizeof(struct variable_list));
     } else {
-      vp->next_variable = (struct variable_list *)malloc(sizeof(struct variable_list));
+      vp->next_variable = (struct variable_list *)pdu_malloc(pdu, sizeof(struct variable_list));
       vp = vp->next_variable;
     }
     vp->next_variable = NULL;
@@ -1593,7 +2097,7 @@ int snmp_parse_vb(struct snmp_pdu *pdu, unsigned char *&data, int &data_len)
 			      &vp->val_len, &var_val, &data_len);
     if (data == NULL)
       return SNMP_CLASS_ASN1ERROR;
-    op = (oid *)malloc((unsigned)vp->name_length * sizeof(oid));
+    op = (oid *)pdu_malloc(pdu, (unsigned)vp->name_length * sizeof(oid));
 
     memcpy((char *)op, (char *)objid, vp->name_length * sizeof(oid));
     vp->name = op;
@@ -1601,7 +2105,7 @@ int snmp_parse_vb(struct snmp_pdu *pdu, unsigned char *&data, int &data_len)
     len = MAX_SNMP_PACKET;
     switch((short)vp->type) {
     case ASN_INTEGER:
-      vp->val.integer = (long *)malloc(sizeof(long));
+      vp->val.integer = (long *)pdu_malloc(pdu, sizeof(long));
       vp->val_len = sizeof(long);
       asn_parse_int(var_val, &len, &vp->type, vp->val.integer);
       break;
@@ -1610,13 +2114,13 @@ int snmp_parse_vb(struct snmp_pdu *pdu, unsigned char *&data, int &data_len)
     case SMI_GAUGE:
     case SMI_TIMETICKS:
     case SMI_UINTEGER:
-      vp->val.integer = (long *)malloc(sizeof(long));
+      vp->val.integer = (long *)pdu_malloc(pdu, sizeof(long));
       vp->val_len = sizeof(long);
       asn_parse_unsigned_int(var_val, &len, &vp->type, vp->val.integer);
       break;
 
     case SMI_COUNTER64:
-      vp->val.counter64 = (struct counter64 *)malloc(sizeof(struct counter64));
+      vp->val.counter64 = (struct counter64 *)pdu_malloc(pdu, sizeof(struct counter64));
       vp->val_len = sizeof(struct counter64);
       asn_parse_unsigned_int64(var_val, &len, &vp->type,
 			       vp->val.counter64);
@@ -1626,7 +2130,7 @@ int snmp_parse_vb(struct snmp_pdu *pdu, unsigned char *&data, int &data_len)
     case SMI_IPADDRESS:
     case SMI_OPAQUE:
     case SMI_NSAP:
-      vp->val.string = (unsigned char *)malloc((unsigned)vp->val_len);
+      vp->val.string = (unsigned char *)pdu_malloc(pdu, (unsigned)vp->val_len);
       asn_parse_string(var_val, &len, &vp->type, vp->val.string, &vp->val_len);
       break;
 
@@ -1634,7 +2138,7 @@ int snmp_parse_vb(struct snmp_pdu *pdu, unsigned char *&data, int &data_len)
       vp->val_len = ASN_MAX_NAME_LEN;
       asn_parse_objid(var_val, &len, &vp->type, objid, &vp->val_len);
       //vp->val_len *= sizeof(oid);
-      vp->val.objid = (oid *)malloc((unsigned)vp->val_len * sizeof(oid));
+      vp->val.objid = (oid *)pdu_malloc(pdu, (unsigned)vp->val_len * sizeof(oid));
 
       memcpy((char *)vp->val.objid,
 	     (char *)objid,
@@ -1688,7 +2192,7 @@ int snmp_parse_data_pdu(snmp_pdu *pdu, unsigned char *&data, int &length)
 			   objid, &pdu->enterprise_length);
     if (data == NULL) return SNMP_CLASS_ASN1ERROR;
 
-    pdu->enterprise = (oid *)malloc(pdu->enterprise_length * sizeof(oid));
+    pdu->enterprise = (oid *)pdu_malloc(pdu, pdu->enterprise_length * sizeof(oid));
 
     memcpy((char *)pdu->enterprise,(char *)objid,
 	   pdu->enterprise_length * sizeof(oid));
@@ -1936,8 +2440,6 @@ unsigned char *asn1_build_scoped_pdu(
                    unsigned char *contextName, long contextNameLength,
                    unsigned char *data, long dataLength)
 {
-  Buffer<unsigned char> buffer(MAX_SNMP_PACKET);
-  unsigned char *bufPtr = buffer.get_ptr();
   unsigned char *outBufPtr = outBuf;
 
   LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
@@ -1946,9 +2448,33 @@ unsigned char *asn1_build_scoped_pdu(
   LOG(OctetStr(contextName, contextNameLength).get_printable());
   LOG_END;
 
-  bufPtr = asn_build_string(bufPtr, max_len, ASN_UNI_PRIM | ASN_OCTET_STR,
-                            contextEngineID, contextEngineIDLength);
-  if (!bufPtr)
+  // the length of the sequence is known in advance, so the
+  // contents are encoded directly behind its header
+  long bufLength =
+    1 + asn_length_length((int)contextEngineIDLength) + contextEngineIDLength +
+    1 + asn_length_length((int)contextNameLength) + contextNameLength +
+    dataLength;
+
+  LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
+  LOG("ASN1: Encoding scoped PDU sequence (len)");
+  LOG(bufLength);
+  LOG_END;
+
+  outBufPtr = asn_build_sequence(outBufPtr, max_len, ASN_SEQ_CON,
+                                 (int)bufLength);
+  if (!outBufPtr)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("ASN1: Error encoding scopedPDU sequence");
+    LOG_END;
+
+    return 0;
+  }
+
+  outBufPtr = asn_build_string(outBufPtr, max_len,
+                               ASN_UNI_PRIM | ASN_OCTET_STR,
+                               contextEngineID, contextEngineIDLength);
+  if (!outBufPtr)
   {
     LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
     LOG("ASN1: Error encoding contextEngineID");
@@ -1957,9 +2483,10 @@ unsigned char *asn1_build_scoped_pdu(
     return 0;
   }
 
-  bufPtr = asn_build_string(bufPtr, max_len, ASN_UNI_PRIM | ASN_OCTET_STR,
-                            contextName, contextNameLength);
-  if (!bufPtr)
+  outBufPtr = asn_build_string(outBufPtr, max_len,
+                               ASN_UNI_PRIM | ASN_OCTET_STR,
+                               contextName, contextNameLength);
+  if (!outBufPtr)
   {
     LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
     LOG("ASN1: Error encoding contextName");
@@ -1968,38 +2495,84 @@ unsigned char *asn1_build_scoped_pdu(
     return 0;
   }
 
-  long bufLength = SAFE_INT_CAST(bufPtr - buffer.get_ptr());
+  if (*max_len < dataLength)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("ASN1: Error encoding scopedPDU data");
+    LOG_END;
+
+    return 0;
+  }
+  memcpy(outBufPtr, data, dataLength);
+  outBufPtr += dataLength;
+  *max_len -= dataLength;
 
-  memcpy((char *)bufPtr, (char *)data, dataLength);
-  bufLength += dataLength;
+#ifdef __DEBUG
+  LOG_BEGIN(loggerModuleName, DEBUG_LOG | 15);
+  LOG("ASN1: Result of build_scoped_pdu (len) (data)");
+  LOG(outBufPtr - outBuf);
+  LOG(OctetStr(outBuf, outBufPtr - outBuf).get_printable_hex());
+  LOG_END;
+#endif
+
+  return outBufPtr;
+}
+
+// Encode the scopedPDU header in front of the already encoded data.
+unsigned char *asn1_rbuild_scoped_pdu(
+                   unsigned char *data, int *datalength, long dataLength,
+                   unsigned char *contextEngineID, long contextEngineIDLength,
+                   unsigned char *contextName, long contextNameLength)
+{
+  int end = *datalength + (int)dataLength;
 
   LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
-  LOG("ASN1: Encoding scoped PDU sequence (len)");
-  LOG(bufLength);
+  LOG("ASN1: coding (context engine id) (context name)");
+  LOG(OctetStr(contextEngineID, contextEngineIDLength).get_printable());
+  LOG(OctetStr(contextName, contextNameLength).get_printable());
   LOG_END;
 
-  outBufPtr = asn_build_sequence(outBufPtr, max_len, ASN_SEQ_CON, bufLength);
-  if (!outBufPtr)
+  data = asn_rbuild_string(data, datalength, ASN_UNI_PRIM | ASN_OCTET_STR,
+                           contextName, contextNameLength);
+  if (!data)
   {
     LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
-    LOG("ASN1: Error encoding scopedPDU sequence");
+    LOG("ASN1: Error encoding contextName");
     LOG_END;
 
     return 0;
   }
 
-  memcpy(outBufPtr, buffer.get_ptr(), bufLength);
-  outBufPtr += bufLength;
+  data = asn_rbuild_string(data, datalength, ASN_UNI_PRIM | ASN_OCTET_STR,
+                           contextEngineID, contextEngineIDLength);
+  if (!data)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("ASN1: Error encoding contextEngineID");
+    LOG_END;
+
+    return 0;
+  }
+
+  data = asn_rbuild_header(data, datalength, ASN_SEQ_CON, end - *datalength);
+  if (!data)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("ASN1: Error encoding scopedPDU sequence");
+    LOG_END;
+
+    return 0;
+  }
 
 #ifdef __DEBUG
   LOG_BEGIN(loggerModuleName, DEBUG_LOG | 15);
-  LOG("ASN1: Result of build_scoped_pdu (len) (data)");
-  LOG(outBufPtr - outBuf);
-  LOG(OctetStr(outBuf, outBufPtr - outBuf).get_printable_hex());
+  LOG("ASN1: Result of rbuild_scoped_pdu (len) (data)");
+  LOG(end - *datalength);
+  LOG(OctetStr(data, end - *datalength).get_printable_hex());
   LOG_END;
 #endif
 
-  return outBufPtr;
+  return data;
 }
 
 #ifdef SNMP_PP_NAMESPACE
@@ -37,10 +37,15 @@
 
 // Use DES, AES, SHA and MD5 from openssl
 #ifdef _USE_OPENSSL
+// The precomputed HMAC key states use the low level digest contexts,
+// as EVP contexts cannot be copied without allocating memory.
+#define OPENSSL_SUPPRESS_DEPRECATED
 #include <openssl/des.h>
 #include <openssl/aes.h>
 #include <openssl/evp.h>
 #include <openssl/err.h>
+#include <openssl/md5.h>
+#include <openssl/sha.h>
 #if OPENSSL_VERSION_NUMBER >= 0x30000000
 #include <openssl/provider.h> // needed since OpenSSL 3.0
 #endif
@@ -68,9 +73,17 @@
 #include "snmp_pp/snmperrs.h"
 #include "snmp_pp/address.h"
 #include "snmp_pp/log.h"
+#include "snmp_pp/reentrant.h"
 
 #include <memory>
 
+#include <fcntl.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #ifdef SNMP_PP_NAMESPACE
 namespace Snmp_pp {
 #endif
@@ -291,6 +304,646 @@ typedef des_key_schedule      DESCBCType;
 
 #endif // _USE_OPENSSL
 
+/*-----------------[ precomputed HMAC key states ]------------------*/
+
+#if !defined(_USE_OPENSSL) || !defined(OPENSSL_NO_DEPRECATED_3_0)
+#define SNMP_PP_HMAC_KEY_STATES
+#endif
+
+#ifdef SNMP_PP_HMAC_KEY_STATES
+
+/*
+ * Digest traits for HmacKeyState: the hash state must be a plain
+ * struct that can be copied by assignment.
+ */
+#ifdef _USE_OPENSSL
+
+#define HMAC_DIGEST(name, ctx, prefix, blk, len)                         \
+struct name                                                              \
+{                                                                        \
+  typedef ctx State;                                                     \
+  enum { block_size = blk, hash_len = len };                             \
+  static void init(State *s) { prefix##_Init(s); }                       \
+  static void update(State *s, const unsigned char *p, unsigned int l)   \
+    { prefix##_Update(s, p, l); }                                        \
+  static void final(State *s, unsigned char *digest)                     \
+    { prefix##_Final(digest, s); }                                       \
+}
+
+HMAC_DIGEST(HmacMD5,    MD5_CTX,    MD5,    64,  16);
+HMAC_DIGEST(HmacSHA1,   SHA_CTX,    SHA1,   64,  20);
+HMAC_DIGEST(HmacSHA224, SHA256_CTX, SHA224, 64,  28);
+HMAC_DIGEST(HmacSHA256, SHA256_CTX, SHA256, 64,  32);
+HMAC_DIGEST(HmacSHA384, SHA512_CTX, SHA384, 128, 48);
+HMAC_DIGEST(HmacSHA512, SHA512_CTX, SHA512, 128, 64);
+
+#undef HMAC_DIGEST
+
+#else // _USE_OPENSSL
+
+struct HmacMD5
+{
+  typedef MD5HashStateType State;
+  enum { block_size = 64, hash_len = 16 };
+  static void init(State *s) { MD5_INIT(s); }
+  static void update(State *s, const unsigned char *p, unsigned int l)
+    { MD5_PROCESS(s, p, l); }
+  static void final(State *s, unsigned char *digest) { MD5_DONE(s, digest); }
+};
+
+struct HmacSHA1
+{
+  typedef SHAHashStateType State;
+  enum { block_size = 64, hash_len = 20 };
+  static void init(State *s) { SHA1_INIT(s); }
+  static void update(State *s, const unsigned char *p, unsigned int l)
+    { SHA1_PROCESS(s, p, l); }
+  static void final(State *s, unsigned char *digest) { SHA1_DONE(s, digest); }
+};
+
+#endif // _USE_OPENSSL
+
+/*
+ * HMAC key state with the digest states after the inner and outer
+ * pad blocks. hmac() copies them to the stack, so no memory is
+ * allocated per message and the object can be used concurrently.
+ */
+template <class Digest>
+class HmacKeyState : public AuthKeyState
+{
+public:
+  HmacKeyState(const unsigned char *key, const unsigned int key_len)
+  {
+    unsigned char pad[Digest::block_size];
+    unsigned int i;
+
+    memset(pad, 0x36, sizeof(pad));
+    for (i = 0; i < key_len; ++i)
+      pad[i] ^= key[i];
+    Digest::init(&inner);
+    Digest::update(&inner, pad, sizeof(pad));
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (i = 0; i < key_len; ++i)
+      pad[i] ^= key[i];
+    Digest::init(&outer);
+    Digest::update(&outer, pad, sizeof(pad));
+
+    memset(pad, 0, sizeof(pad));
+  }
+
+  void hmac(const unsigned char *msg,
+            const unsigned int   msg_len,
+            unsigned char       *digest) const
+  {
+    typename Digest::State state = inner;
+
+    Digest::update(&state, msg, msg_len);
+    Digest::final(&state, digest);
+
+    state = outer;
+    Digest::update(&state, digest, Digest::hash_len);
+    Digest::final(&state, digest);
+
+    memset(&state, 0, sizeof(state));
+  }
+
+protected:
+  ~HmacKeyState()
+  {
+    memset(&inner, 0, sizeof(inner));
+    memset(&outer, 0, sizeof(outer));
+  }
+
+private:
+  typename Digest::State inner;
+  typename Digest::State outer;
+};
+
+template <class Digest>
+AuthKeyState *new_hmac_key_state(const unsigned char *key,
+                                 const unsigned int   key_len,
+                                 const unsigned int   needed_key_len)
+{
+  if (!key || (key_len < needed_key_len))
+    return 0;
+
+  return new HmacKeyState<Digest>(key, needed_key_len);
+}
+
+#endif // SNMP_PP_HMAC_KEY_STATES
+
+/*-----------------[ cache of localized keys ]------------------*/
+
+#define KEY_CACHE_MIN_BUCKETS 64
+#define KEY_CACHE_SALT_LEN    8
+#define KEY_CACHE_LINE_LEN    1024
+#define KEY_CACHE_TYPE_AUTH   'A'
+#define KEY_CACHE_TYPE_PRIV   'P'
+
+struct LocalizedKeyCacheEntry
+{
+  LocalizedKeyCacheEntry *next;
+  unsigned int  hash;
+  char          type;        ///< KEY_CACHE_TYPE_AUTH or KEY_CACHE_TYPE_PRIV
+  int           auth_prot;
+  int           priv_prot;   ///< SNMP_PRIVPROTOCOL_NONE for auth keys
+  unsigned char engine_id[MAXLENGTH_ENGINEID];
+  unsigned int  engine_id_len;
+  unsigned char digest[SNMPv3_USM_MAX_KEY_LEN]; ///< HMAC of the password
+  unsigned int  digest_len;
+  unsigned char key[SNMPv3_USM_MAX_KEY_LEN];
+  unsigned int  key_len;
+};
+
+/**
+ * Hash table of localized keys used by AuthPriv::password_to_key_auth()
+ * and AuthPriv::password_to_key_priv().
+ */
+class LocalizedKeyCache : public SnmpSynchronized
+{
+public:
+  LocalizedKeyCache(const char *file, const pp_uint64 initial_salt,
+                    const unsigned char *secret,
+                    const unsigned int secret_len);
+  ~LocalizedKeyCache();
+
+  /**
+   * Compute the HMAC of the salt and the password, keyed with the
+   * secret given to the constructor, that identifies the password in
+   * the cache. The secret is not stored in the file, so the password
+   * cannot be guessed from the file alone.
+   */
+  void password_digest(const Auth *a,
+                       const unsigned char *password,
+                       const unsigned int   password_len,
+                       unsigned char *digest, unsigned int *digest_len);
+
+  /**
+   * Copy a cached key into the given buffer.
+   *
+   * @param key_len - IN: length of the buffer, OUT: length of the key
+   * @return true if the key was found
+   */
+  bool lookup(const LocalizedKeyCacheEntry &k,
+              unsigned char *key, unsigned int *key_len);
+
+  /**
+   * Add the key to the cache, if no key with the same index exists.
+   */
+  void insert(const LocalizedKeyCacheEntry &k,
+              const unsigned char *key, const unsigned int key_len);
+
+  int load(AuthPriv *ap);
+  int save(AuthPriv *ap);
+
+  const char *get_file() const { return file_name; }
+
+private:
+  static unsigned int hash_of(const LocalizedKeyCacheEntry &k);
+  static bool same_index(const LocalizedKeyCacheEntry &a,
+                         const LocalizedKeyCacheEntry &b);
+  void add(LocalizedKeyCacheEntry *e);
+  void clear();
+
+  char *file_name;
+  unsigned char salt[KEY_CACHE_SALT_LEN];
+  unsigned char *secret;
+  unsigned int secret_len;
+  LocalizedKeyCacheEntry **buckets;
+  unsigned int bucket_count;
+  unsigned int entries;
+  bool modified;
+};
+
+LocalizedKeyCache::LocalizedKeyCache(const char *file,
+                                     const pp_uint64 initial_salt,
+                                     const unsigned char *secret_value,
+                                     const unsigned int secret_value_len)
+  : file_name(0), secret(0), secret_len(0), buckets(0),
+    bucket_count(KEY_CACHE_MIN_BUCKETS), entries(0), modified(false)
+{
+  if (file)
+  {
+    file_name = new char[strlen(file) + 1];
+    strcpy(file_name, file);
+  }
+  memcpy(salt, &initial_salt, KEY_CACHE_SALT_LEN);
+  if (secret_value && secret_value_len)
+  {
+    secret = new unsigned char[secret_value_len];
+    memcpy(secret, secret_value, secret_value_len);
+    secret_len = secret_value_len;
+  }
+
+  buckets = new LocalizedKeyCacheEntry*[bucket_count];
+  memset(buckets, 0, bucket_count * sizeof(LocalizedKeyCacheEntry*));
+}
+
+LocalizedKeyCache::~LocalizedKeyCache()
+{
+  clear();
+  delete [] buckets;
+  if (file_name) delete [] file_name;
+  if (secret)
+  {
+    memset(secret, 0, secret_len);
+    delete [] secret;
+  }
+}
+
+void LocalizedKeyCache::clear()
+{
+  for (unsigned int i = 0; i < bucket_count; ++i)
+  {
+    while (buckets[i])
+    {
+      LocalizedKeyCacheEntry *e = buckets[i];
+      buckets[i] = e->next;
+      memset(e, 0, sizeof(LocalizedKeyCacheEntry));
+      delete e;
+    }
+  }
+  entries = 0;
+}
+
+void LocalizedKeyCache::password_digest(const Auth *a,
+                                        const unsigned char *password,
+                                        const unsigned int   password_len,
+                                        unsigned char *digest,
+                                        unsigned int  *digest_len)
+{
+  // HMAC (RFC 2104), SHA-384 and SHA-512 use 128 byte blocks
+  const unsigned int hash_len = a->get_hash_len();
+  const unsigned int block_len = (hash_len > 32) ? 128 : 64;
+  unsigned char k[128];
+  unsigned char inner[SNMPv3_USM_MAX_KEY_LEN];
+
+  memset(k, 0, sizeof(k));
+  if (secret_len > block_len)
+    a->hash(secret, secret_len, k);
+  else if (secret_len)
+    memcpy(k, secret, secret_len);
+
+  Buffer<unsigned char> buf(block_len + KEY_CACHE_SALT_LEN + password_len +
+                            SNMPv3_USM_MAX_KEY_LEN);
+  unsigned char *ptr = buf.get_ptr();
+
+  for (unsigned int i = 0; i < block_len; ++i)
+    ptr[i] = k[i] ^ 0x36;
+  {
+    SnmpSynchronize auto_lock(*this);
+    memcpy(ptr + block_len, salt, KEY_CACHE_SALT_LEN);
+  }
+  memcpy(ptr + block_len + KEY_CACHE_SALT_LEN, password, password_len);
+  a->hash(ptr, block_len + KEY_CACHE_SALT_LEN + password_len, inner);
+
+  for (unsigned int j = 0; j < block_len; ++j)
+    ptr[j] = k[j] ^ 0x5c;
+  memcpy(ptr + block_len, inner, hash_len);
+  a->hash(ptr, block_len + hash_len, digest);
+  *digest_len = hash_len;
+
+  buf.clear();
+  memset(k, 0, sizeof(k));
+  memset(inner, 0, sizeof(inner));
+}
+
+unsigned int LocalizedKeyCache::hash_of(const LocalizedKeyCacheEntry &k)
+{
+  // FNV-1a
+  unsigned int h = 2166136261U;
+  h = (h ^ (unsigned char)k.type) * 16777619U;
+  h = (h ^ (unsigned int)k.auth_prot) * 16777619U;
+  h = (h ^ (unsigned int)k.priv_prot) * 16777619U;
+  for (unsigned int i = 0; i < k.engine_id_len; ++i)
+    h = (h ^ k.engine_id[i]) * 16777619U;
+  for (unsigned int j = 0; j < k.digest_len; ++j)
+    h = (h ^ k.digest[j]) * 16777619U;
+  return h;
+}
+
+bool LocalizedKeyCache::same_index(const LocalizedKeyCacheEntry &a,
+                                   const LocalizedKeyCacheEntry &b)
+{
+  return ((a.type == b.type) &&
+          (a.auth_prot == b.auth_prot) && (a.priv_prot == b.priv_prot) &&
+          (a.engine_id_len == b.engine_id_len) &&
+          (a.digest_len == b.digest_len) &&
+          (memcmp(a.engine_id, b.engine_id, a.engine_id_len) == 0) &&
+          (memcmp(a.digest, b.digest, a.digest_len) == 0));
+}
+
+bool LocalizedKeyCache::lookup(const LocalizedKeyCacheEntry &k,
+                               unsigned char *key, unsigned int *key_len)
+{
+  unsigned int h = hash_of(k);
+  SnmpSynchronize auto_lock(*this);
+
+  for (LocalizedKeyCacheEntry *e = buckets[h % bucket_count]; e; e = e->next)
+  {
+    if ((e->hash == h) && same_index(*e, k))
+    {
+      if (e->key_len > *key_len)
+        return false;
+      memcpy(key, e->key, e->key_len);
+      *key_len = e->key_len;
+      return true;
+    }
+  }
+  return false;
+}
+
+void LocalizedKeyCache::add(LocalizedKeyCacheEntry *e)
+{
+  // Table is locked by caller
+  if (entries >= bucket_count)
+  {
+    unsigned int new_count = bucket_count * 4;
+    LocalizedKeyCacheEntry **tmp = new LocalizedKeyCacheEntry*[new_count];
+    memset(tmp, 0, new_count * sizeof(LocalizedKeyCacheEntry*));
+    for (unsigned int i = 0; i < bucket_count; ++i)
+    {
+      while (buckets[i])
+      {
+        LocalizedKeyCacheEntry *move = buckets[i];
+        buckets[i] = move->next;
+        move->next = tmp[move->hash % new_count];
+        tmp[move->hash % new_count] = move;
+      }
+    }
+    delete [] buckets;
+    buckets = tmp;
+    bucket_count = new_count;
+  }
+  e->next = buckets[e->hash % bucket_count];
+  buckets[e->hash % bucket_count] = e;
+  entries++;
+}
+
+void LocalizedKeyCache::insert(const LocalizedKeyCacheEntry &k,
+                               const unsigned char *key,
+                               const unsigned int key_len)
+{
+  if ((key_len > SNMPv3_USM_MAX_KEY_LEN) ||
+      (k.engine_id_len > MAXLENGTH_ENGINEID))
+    return;
+
+  unsigned int h = hash_of(k);
+  SnmpSynchronize auto_lock(*this);
+
+  for (LocalizedKeyCacheEntry *e = buckets[h % bucket_count]; e; e = e->next)
+    if ((e->hash == h) && same_index(*e, k))
+      return; // added by a concurrent call
+
+  LocalizedKeyCacheEntry *e = new LocalizedKeyCacheEntry(k);
+  e->hash = h;
+  memcpy(e->key, key, key_len);
+  e->key_len = key_len;
+  add(e);
+  modified = true;
+}
+
+int LocalizedKeyCache::save(AuthPriv *ap)
+{
+  char tmp_file_name[MAXLENGTH_FILENAME];
+  bool failed = false;
+
+  if (!file_name)
+    return SNMPv3_USM_ERROR;
+
+  SnmpSynchronize auto_lock(*this);
+
+  if (!modified)
+    return SNMPv3_USM_OK;
+
+  LOG_BEGIN(loggerModuleName, INFO_LOG | 4);
+  LOG("AuthPriv: Saving localized key cache (file) (entries)");
+  LOG(file_name);
+  LOG(entries);
+  LOG_END;
+
+  snprintf(tmp_file_name, MAXLENGTH_FILENAME, "%s.tmp", file_name);
+
+  // only the owner may read the keys, a left over tmp file is removed
+  // first, as it is not opened if it exists
+  FILE *file_out = 0;
+#ifdef WIN32
+  _unlink(tmp_file_name);
+  int fd = _open(tmp_file_name, _O_CREAT | _O_EXCL | _O_WRONLY | _O_TEXT,
+                 _S_IREAD | _S_IWRITE);
+  if (fd >= 0)
+  {
+    file_out = _fdopen(fd, "w");
+    if (!file_out) _close(fd);
+  }
+#else
+  unlink(tmp_file_name);
+  int fd = open(tmp_file_name, O_CREAT | O_EXCL | O_WRONLY, 0600);
+  if (fd >= 0)
+  {
+    // the mode given to open is restricted by the umask only
+    if (fchmod(fd, 0600) == 0)
+      file_out = fdopen(fd, "w");
+    if (!file_out) close(fd);
+  }
+#endif
+  if (!file_out)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("AuthPriv: could not create tmpfile");
+    LOG(tmp_file_name);
+    LOG_END;
+
+    return SNMPv3_USM_FILECREATE_ERROR;
+  }
+
+  // first line: salt, then one entry per line:
+  // type auth-protocol priv-protocol engine-id password-hash key
+  char engine_id[2 * MAXLENGTH_ENGINEID + 1];
+  char digest[2 * SNMPv3_USM_MAX_KEY_LEN + 1];
+  char key[2 * SNMPv3_USM_MAX_KEY_LEN + 1];
+
+  encodeString(salt, KEY_CACHE_SALT_LEN, key);
+  key[2 * KEY_CACHE_SALT_LEN] = 0;
+  if (fprintf(file_out, "%s\n", key) < 0)
+    failed = true;
+
+  for (unsigned int i = 0; (i < bucket_count) && !failed; ++i)
+  {
+    for (LocalizedKeyCacheEntry *e = buckets[i]; e; e = e->next)
+    {
+      const Auth *a = ap->get_auth(e->auth_prot);
+      const Priv *p = 0;
+      if (e->type == KEY_CACHE_TYPE_PRIV)
+        p = ap->get_priv(e->priv_prot);
+      if (!a || ((e->type == KEY_CACHE_TYPE_PRIV) && !p))
+        continue; // protocol was removed
+
+      encodeString(e->engine_id, e->engine_id_len, engine_id);
+      engine_id[2 * e->engine_id_len] = 0;
+      encodeString(e->digest, e->digest_len, digest);
+      digest[2 * e->digest_len] = 0;
+      encodeString(e->key, e->key_len, key);
+      key[2 * e->key_len] = 0;
+
+      if (fprintf(file_out, "%c %s %s %s %s %s\n", e->type,
+                  a->get_id_string(), p ? p->get_id_string() : "none",
+                  engine_id, digest, key) < 0)
+      {
+        failed = true;
+        break;
+      }
+    }
+  }
+  memset(key, 0, sizeof(key));
+
+  if (fclose(file_out) != 0)
+    failed = true;
+
+  if (failed)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("AuthPriv: Failed to write localized key cache.");
+    LOG_END;
+
+#ifdef WIN32
+    _unlink(tmp_file_name);
+#else
+    unlink(tmp_file_name);
+#endif
+    return SNMPv3_USM_FILEWRITE_ERROR;
+  }
+#ifdef WIN32
+  _unlink(file_name);
+#endif
+  if (rename(tmp_file_name, file_name))
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("AuthPriv: Could not rename file (from) (to)");
+    LOG(tmp_file_name);
+    LOG(file_name);
+    LOG_END;
+
+    return SNMPv3_USM_FILERENAME_ERROR;
+  }
+  modified = false;
+  return SNMPv3_USM_OK;
+}
+
+int LocalizedKeyCache::load(AuthPriv *ap)
+{
+  if (!file_name)
+    return SNMPv3_USM_OK;
+
+  FILE *file_in = fopen(file_name, "r");
+  if (!file_in)
+  {
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 4);
+    LOG("AuthPriv: No localized key cache yet (file)");
+    LOG(file_name);
+    LOG_END;
+
+    return SNMPv3_USM_OK;
+  }
+
+  SnmpSynchronize auto_lock(*this);
+
+  char line[KEY_CACHE_LINE_LEN];
+  char decoded[KEY_CACHE_LINE_LEN / 2];
+  bool failed = false;
+  unsigned int lines = 0;
+
+  while (fgets(line, KEY_CACHE_LINE_LEN, file_in))
+  {
+    size_t len = strlen(line);
+    if ((len == 0) || (line[len - 1] != '\n'))
+    { failed = true; break; }
+    line[--len] = 0;
+
+    if (lines++ == 0)
+    {
+      // the salt, the cache must be empty before it is changed
+      if ((len != 2 * KEY_CACHE_SALT_LEN) || entries)
+      { failed = true; break; }
+      decodeString((unsigned char*)line, SAFE_INT_CAST(len), decoded);
+      memcpy(salt, decoded, KEY_CACHE_SALT_LEN);
+      continue;
+    }
+
+    char *fields[6];
+    int n = 0;
+    char *pos = line;
+    while ((n < 6) && pos)
+    {
+      fields[n++] = pos;
+      pos = strchr(pos, ' ');
+      if (pos) *pos++ = 0;
+    }
+    if ((n != 6) || pos || (strlen(fields[0]) != 1))
+    { failed = true; break; }
+
+    LocalizedKeyCacheEntry k;
+    memset(&k, 0, sizeof(k));
+    k.type = fields[0][0];
+    k.auth_prot = ap->get_auth_id(fields[1]);
+    k.priv_prot = SNMP_PRIVPROTOCOL_NONE;
+    if (k.type == KEY_CACHE_TYPE_PRIV)
+      k.priv_prot = ap->get_priv_id(fields[2]);
+    else if (k.type != KEY_CACHE_TYPE_AUTH)
+    { failed = true; break; }
+    if ((k.auth_prot < 0) || (k.priv_prot < 0))
+      continue; // protocol not available
+
+    size_t engine_id_len = strlen(fields[3]);
+    size_t digest_len = strlen(fields[4]);
+    size_t key_len = strlen(fields[5]);
+    if ((engine_id_len > 2 * MAXLENGTH_ENGINEID) ||
+        (digest_len > 2 * SNMPv3_USM_MAX_KEY_LEN) ||
+        (key_len > 2 * SNMPv3_USM_MAX_KEY_LEN))
+    { failed = true; break; }
+
+    decodeString((unsigned char*)fields[3], SAFE_INT_CAST(engine_id_len),
+                 decoded);
+    k.engine_id_len = SAFE_UINT_CAST(engine_id_len / 2);
+    memcpy(k.engine_id, decoded, k.engine_id_len);
+    decodeString((unsigned char*)fields[4], SAFE_INT_CAST(digest_len),
+                 decoded);
+    k.digest_len = SAFE_UINT_CAST(digest_len / 2);
+    memcpy(k.digest, decoded, k.digest_len);
+    decodeString((unsigned char*)fields[5], SAFE_INT_CAST(key_len), decoded);
+
+    LocalizedKeyCacheEntry *e = new LocalizedKeyCacheEntry(k);
+    e->hash = hash_of(k);
+    e->key_len = SAFE_UINT_CAST(key_len / 2);
+    memcpy(e->key, decoded, e->key_len);
+    add(e);
+  }
+  memset(line, 0, sizeof(line));
+  memset(decoded, 0, sizeof(decoded));
+  fclose(file_in);
+
+  if (failed)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("AuthPriv: Failed to read localized key cache (file) (line)");
+    LOG(file_name);
+    LOG(lines);
+    LOG_END;
+
+    clear();
+    return SNMPv3_USM_FILEREAD_ERROR;
+  }
+
+  LOG_BEGIN(loggerModuleName, INFO_LOG | 4);
+  LOG("AuthPriv: Loaded localized key cache (file) (entries)");
+  LOG(file_name);
+  LOG(entries);
+  LOG_END;
+
+  return SNMPv3_USM_OK;
+}
+
 
 // 3DES key extension used by two classes
 int des3_extend_short_key(const unsigned char * /* password */,
@@ -351,6 +1004,7 @@ int des3_extend_short_key(const unsigned char * /* password */,
 
 
 AuthPriv::AuthPriv(int &construct_state)
+  : key_cache(0)
 {
   auth = new AuthPtr[10];
   priv = new PrivPtr[10];
@@ -506,6 +1160,9 @@ AuthPriv::~AuthPriv()
 
   delete [] auth;
   delete [] priv;
+
+  if (key_cache)
+    delete key_cache;
 }
 
 int AuthPriv::add_auth(Auth *new_auth)
@@ -815,10 +1472,28 @@ int AuthPriv::password_to_key_auth(const int            auth_prot,
   if (!a)
     return SNMPv3_USM_UNSUPPORTED_AUTHPROTOCOL;
 
+  LocalizedKeyCacheEntry index;
+  if (key_cache && (engine_id_len <= MAXLENGTH_ENGINEID))
+  {
+    index.type = KEY_CACHE_TYPE_AUTH;
+    index.auth_prot = auth_prot;
+    index.priv_prot = SNMP_PRIVPROTOCOL_NONE;
+    memcpy(index.engine_id, engine_id, engine_id_len);
+    index.engine_id_len = engine_id_len;
+    key_cache->password_digest(a, password, password_len,
+                               index.digest, &index.digest_len);
+    if (key_cache->lookup(index, key, key_len))
+      return SNMPv3_USM_OK;
+  }
+
   int res = a->password_to_key(password, password_len,
                                engine_id, engine_id_len,
                                key, key_len);
 
+  if (key_cache && (engine_id_len <= MAXLENGTH_ENGINEID) &&
+      (res == SNMPv3_USM_OK))
+    key_cache->insert(index, key, *key_len);
+
   return res;
 }
 
@@ -861,10 +1536,25 @@ int AuthPriv::password_to_key_priv(const int            auth_prot,
   if (min_key_len > max_key_len)
     return SNMPv3_USM_ERROR; // TODO: better error code!
 
-  int res = password_to_key_auth(auth_prot,
-                                 password, password_len,
-                                 engine_id, engine_id_len,
-                                 key, key_len);
+  LocalizedKeyCacheEntry index;
+  if (key_cache && (engine_id_len <= MAXLENGTH_ENGINEID))
+  {
+    index.type = KEY_CACHE_TYPE_PRIV;
+    index.auth_prot = auth_prot;
+    index.priv_prot = priv_prot;
+    memcpy(index.engine_id, engine_id, engine_id_len);
+    index.engine_id_len = engine_id_len;
+    key_cache->password_digest(a, password, password_len,
+                               index.digest, &index.digest_len);
+    if (key_cache->lookup(index, key, key_len))
+      return SNMPv3_USM_OK;
+  }
+
+  // do not use password_to_key_auth(), the key must not be cached as
+  // an authentication key
+  int res = a->password_to_key(password, password_len,
+                               engine_id, engine_id_len,
+                               key, key_len);
   if (res != SNMPv3_USM_OK)
     return res;
 
@@ -881,9 +1571,42 @@ int AuthPriv::password_to_key_priv(const int            auth_prot,
   /* make sure key length is valid */
   p->fix_key_len(*key_len);
 
+  if (key_cache && (engine_id_len <= MAXLENGTH_ENGINEID))
+    key_cache->insert(index, key, *key_len);
+
   return SNMPv3_USM_OK;
 }
 
+int AuthPriv::enable_key_cache(const char *file,
+                               const unsigned char *secret,
+                               const unsigned int secret_len)
+{
+  if (file && (!secret || (secret_len == 0)))
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("AuthPriv: Key cache file needs a secret (file)");
+    LOG(file);
+    LOG_END;
+
+    return SNMPv3_USM_ERROR;
+  }
+
+  if (key_cache)
+    delete key_cache;
+
+  key_cache = new LocalizedKeyCache(file, salt, secret, secret_len);
+
+  return key_cache->load(this);
+}
+
+int AuthPriv::save_key_cache()
+{
+  if (!key_cache)
+    return SNMPv3_USM_ERROR;
+
+  return key_cache->save(this);
+}
+
 
 
 
@@ -1139,6 +1862,99 @@ int AuthPriv::auth_inc_msg(const int            auth_prot,
   return a->auth_inc_msg(key, msg, msg_len, auth_par_ptr, auth_par_len);
 }
 
+AuthKeyState *AuthPriv::new_key_state(const int            auth_prot,
+                                      const unsigned char *key,
+                                      const unsigned int   key_len)
+{
+  Auth *a = get_auth(auth_prot);
+
+  if (!a)
+    return 0;
+
+  return a->new_key_state(key, key_len);
+}
+
+int AuthPriv::auth_out_msg(const int            auth_prot,
+                           const AuthKeyState  *key_state,
+                           unsigned char       *msg,
+                           const int            msg_len,
+                           unsigned char       *auth_par_ptr)
+{
+  if (auth_prot == SNMP_AUTHPROTOCOL_NONE)
+    return SNMPv3_USM_UNSUPPORTED_SECURITY_LEVEL;
+
+  Auth *a = get_auth(auth_prot);
+
+  if (!a)
+    return SNMPv3_USM_UNSUPPORTED_AUTHPROTOCOL;
+
+  if (!key_state)
+    return SNMPv3_USM_ERROR;
+
+  int auth_par_len = a->get_auth_params_len();
+  unsigned char digest[SNMPv3_USM_MAX_KEY_LEN];
+
+  memset(auth_par_ptr, 0, auth_par_len);
+  key_state->hmac(msg, msg_len, digest);
+  memcpy(auth_par_ptr, digest, auth_par_len);
+  memset(digest, 0, sizeof(digest));
+
+  return SNMPv3_USM_OK;
+}
+
+int AuthPriv::auth_inc_msg(const int            auth_prot,
+                           const AuthKeyState  *key_state,
+                           unsigned char       *msg,
+                           const int            msg_len,
+                           unsigned char       *auth_par_ptr,
+                           const int            auth_par_len)
+{
+  if (auth_prot == SNMP_AUTHPROTOCOL_NONE)
+    return SNMPv3_USM_UNSUPPORTED_SECURITY_LEVEL;
+
+  Auth *a = get_auth(auth_prot);
+
+  if (!a)
+    return SNMPv3_USM_UNSUPPORTED_AUTHPROTOCOL;
+
+  if (auth_par_len != a->get_auth_params_len())
+  {
+    debugprintf(4, "%s illegal digest length (%d), authentication FAILED.",
+                a->get_id_string(), auth_par_len);
+    return SNMPv3_USM_AUTHENTICATION_FAILURE;
+  }
+
+  unsigned char receivedDigest[SNMPv3_AP_MAXLENGTH_AUTHPARAM];
+
+  /* Save received digest */
+  memcpy(receivedDigest, auth_par_ptr, auth_par_len);
+
+  if (SNMPv3_USM_OK != auth_out_msg(auth_prot, key_state,
+                                    msg, msg_len, auth_par_ptr))
+  {
+    /* copy digest back into message and return error */
+    memcpy(auth_par_ptr, receivedDigest, auth_par_len);
+    debugprintf(4, "%s authentication FAILED (1).", a->get_id_string());
+    return SNMPv3_USM_AUTHENTICATION_FAILURE;
+  }
+
+  // fully compare digest to received digest to avoid timing attacks
+  unsigned char diff = 0;
+  for (int i=0; i < auth_par_len; ++i)
+    diff |= auth_par_ptr[i] ^ receivedDigest[i];
+
+  if (diff)
+  {
+    /* copy digest back into message and return error */
+    memcpy(auth_par_ptr, receivedDigest, auth_par_len);
+    debugprintf(4, "%s authentication FAILED.", a->get_id_string());
+    return SNMPv3_USM_AUTHENTICATION_FAILURE;
+  }
+
+  debugprintf(4, "%s authentication OK.", a->get_id_string());
+  return SNMPv3_USM_OK;
+}
+
 /* ========================================================== */
 
 /* ----------------------- AuthMD5 ---------------------------------------*/
@@ -1334,6 +2150,17 @@ int AuthMD5::auth_inc_msg(const unsigned char *key,
   return SNMPv3_USM_OK;
 }
 
+AuthKeyState *AuthMD5::new_key_state(const unsigned char *key,
+                                     const unsigned int   key_len) const
+{
+#ifdef SNMP_PP_HMAC_KEY_STATES
+  return new_hmac_key_state<HmacMD5>(key, key_len, 16);
+#else
+  (void)key; (void)key_len;
+  return 0;
+#endif
+}
+
 /* ========================= PRIV ================================*/
 
 /* ----------------------- PrivDES ---------------------------------------*/
@@ -2662,6 +3489,17 @@ AuthSHABase::Hasher *AuthSHA::get_hasher() const
   return new HasherSHA1();
 }
 
+AuthKeyState *AuthSHA::new_key_state(const unsigned char *key,
+                                     const unsigned int   key_len) const
+{
+#ifdef SNMP_PP_HMAC_KEY_STATES
+  return new_hmac_key_state<HmacSHA1>(key, key_len, 20);
+#else
+  (void)key; (void)key_len;
+  return 0;
+#endif
+}
+
 #if defined(_USE_OPENSSL)
 
 class AuthHMAC128SHA224::Hasher224 : public AuthSHABase::Hasher
@@ -2698,6 +3536,17 @@ AuthSHABase::Hasher *AuthHMAC128SHA224::get_hasher() const
   return new Hasher224();
 }
 
+AuthKeyState *AuthHMAC128SHA224::new_key_state(const unsigned char *key,
+                                               const unsigned int   key_len) const
+{
+#ifdef SNMP_PP_HMAC_KEY_STATES
+  return new_hmac_key_state<HmacSHA224>(key, key_len, 28);
+#else
+  (void)key; (void)key_len;
+  return 0;
+#endif
+}
+
 
 class AuthHMAC192SHA256::Hasher256 : public Hasher
 {
@@ -2734,6 +3583,17 @@ AuthSHABase::Hasher *AuthHMAC192SHA256::get_hasher() const
   return new Hasher256();
 }
 
+AuthKeyState *AuthHMAC192SHA256::new_key_state(const unsigned char *key,
+                                               const unsigned int   key_len) const
+{
+#ifdef SNMP_PP_HMAC_KEY_STATES
+  return new_hmac_key_state<HmacSHA256>(key, key_len, 32);
+#else
+  (void)key; (void)key_len;
+  return 0;
+#endif
+}
+
 
 class AuthHMAC256SHA384::Hasher384 : public Hasher
 {
@@ -2770,6 +3630,17 @@ AuthSHABase::Hasher *AuthHMAC256SHA384::get_hasher() const
   return new Hasher384();
 }
 
+AuthKeyState *AuthHMAC256SHA384::new_key_state(const unsigned char *key,
+                                               const unsigned int   key_len) const
+{
+#ifdef SNMP_PP_HMAC_KEY_STATES
+  return new_hmac_key_state<HmacSHA384>(key, key_len, 48);
+#else
+  (void)key; (void)key_len;
+  return 0;
+#endif
+}
+
 
 
 class AuthHMAC384SHA512::Hasher512 : public Hasher
@@ -2805,6 +3676,17 @@ AuthSHABase::Hasher *AuthHMAC384SHA512::get_hasher() const
   return new Hasher512();
 }
 
+AuthKeyState *AuthHMAC384SHA512::new_key_state(const unsigned char *key,
+                                               const unsigned int   key_len) const
+{
+#ifdef SNMP_PP_HMAC_KEY_STATES
+  return new_hmac_key_state<HmacSHA512>(key, key_len, 64);
+#else
+  (void)key; (void)key_len;
+  return 0;
+#endif
+}
+
 #endif // defined(_USE_OPENSSL)
 
 
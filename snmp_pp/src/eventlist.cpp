@@ -68,11 +68,19 @@ char event_list_version[]="@(#) SNMP++ $Id$";
 #include "snmp_pp/msgqueue.h"		// queue for holding snmp event sources
 #include "snmp_pp/notifyqueue.h"	// queue for holding trap callbacks
 #include "snmp_pp/snmperrs.h"
+#include "snmp_pp/log.h"
 
 #ifdef SNMP_PP_NAMESPACE
 namespace Snmp_pp {
 #endif
 
+#ifdef HAVE_EPOLL_SYSCALL
+static const char *loggerModuleName = "snmp++.eventlist";
+
+// number of events fetched with one epoll_wait() call
+#define EVENTLIST_MAX_EPOLL_EVENTS 64
+#endif
+
 //----[ CSNMPMessageQueueElt class ]--------------------------------------
 
 CEventList::CEventListElt::CEventListElt(CEvents *events,
@@ -96,6 +104,23 @@ CEventList::CEventListElt::~CEventListElt()
 
 //----[ CEventList class ]--------------------------------------
 
+CEventList::CEventList()
+  : m_head(0, 0, 0), m_msgCount(0), m_done(0)
+{
+#ifdef HAVE_EPOLL_SYSCALL
+  m_fdEvents = 0;
+  m_fdEventsSize = 0;
+  m_fdCount = 0;
+  m_epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epfd < 0)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("EventList: Could not create epoll instance (errno)");
+    LOG(errno);
+    LOG_END;
+  }
+#endif
+}
 
 CEventList::~CEventList()
 {
@@ -106,6 +131,13 @@ CEventList::~CEventList()
   while ((leftOver = m_head.GetNext()))
     delete leftOver;
   unlock();
+
+#ifdef HAVE_EPOLL_SYSCALL
+  // the event sources have removed their sockets while being deleted
+  if (m_epfd >= 0)
+    close(m_epfd);
+  delete [] m_fdEvents;
+#endif
 }
 
 CEvents * CEventList::AddEntry(CEvents *events) REENTRANT ({
@@ -230,6 +262,119 @@ int CEventList::HandleEvents(const int maxfds,
 
 #endif // HAVE_POLL_SYSCALL
 
+#ifdef HAVE_EPOLL_SYSCALL
+
+int CEventList::AddFd(const SnmpSocket fd, CEvents *events)
+{
+  if ((fd < 0) || (m_epfd < 0))
+    return SNMP_CLASS_ERROR;
+
+  SnmpSynchronize _synchronize(m_fdLock);
+
+  if (fd >= m_fdEventsSize)
+  {
+    int newSize = m_fdEventsSize ? m_fdEventsSize : 64;
+    while (newSize <= fd)
+      newSize *= 2;
+
+    CEvents **newFdEvents = new CEvents*[newSize];
+    if (m_fdEventsSize)
+      memcpy(newFdEvents, m_fdEvents, m_fdEventsSize * sizeof(CEvents*));
+    memset(newFdEvents + m_fdEventsSize, 0,
+	   (newSize - m_fdEventsSize) * sizeof(CEvents*));
+    delete [] m_fdEvents;
+    m_fdEvents = newFdEvents;
+    m_fdEventsSize = newSize;
+  }
+
+  if (m_fdEvents[fd])
+  {
+    if (m_fdEvents[fd] == events)
+      return SNMP_CLASS_SUCCESS;
+
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("EventList: Socket is already registered by another event source (fd)");
+    LOG(fd);
+    LOG_END;
+    return SNMP_CLASS_ERROR;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+  if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+  {
+    LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+    LOG("EventList: Could not add socket to epoll instance (fd) (errno)");
+    LOG(fd);
+    LOG(errno);
+    LOG_END;
+    return SNMP_CLASS_ERROR;
+  }
+  m_fdEvents[fd] = events;
+  m_fdCount++;
+
+  LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
+  LOG("EventList: Registered socket (fd) (count)");
+  LOG(fd);
+  LOG(m_fdCount);
+  LOG_END;
+
+  return SNMP_CLASS_SUCCESS;
+}
+
+void CEventList::RemoveFd(const SnmpSocket fd)
+{
+  SnmpSynchronize _synchronize(m_fdLock);
+
+  if ((fd < 0) || (fd >= m_fdEventsSize) || !m_fdEvents[fd])
+    return;
+
+  struct epoll_event ev; // ignored, but must not be NULL for old kernels
+  memset(&ev, 0, sizeof(ev));
+  epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, &ev);
+  m_fdEvents[fd] = 0;
+  m_fdCount--;
+
+  LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
+  LOG("EventList: Removed socket (fd) (count)");
+  LOG(fd);
+  LOG(m_fdCount);
+  LOG_END;
+}
+
+int CEventList::WaitEvents(const int timeout, const bool handle)
+{
+  struct epoll_event events[EVENTLIST_MAX_EPOLL_EVENTS];
+
+  if (m_epfd < 0)
+    return -1;
+
+  int nfound = epoll_wait(m_epfd, events,
+			  handle ? EVENTLIST_MAX_EPOLL_EVENTS : 1, timeout);
+  if ((nfound <= 0) || !handle)
+    return nfound;
+
+  for (int i = 0; i < nfound; i++)
+  {
+    SnmpSocket fd = events[i].data.fd;
+    CEvents *fdEvents = 0;
+
+    m_fdLock.lock();
+    if (fd < m_fdEventsSize)
+      fdEvents = m_fdEvents[fd];
+    m_fdLock.unlock();
+
+    // the socket may have been removed by an earlier event of this loop
+    if (fdEvents)
+      fdEvents->HandleEvent(fd);
+  }
+  return nfound;
+}
+
+#endif // HAVE_EPOLL_SYSCALL
+
 int CEventList::DoRetries(const msec &sendtime) REENTRANT ({
 
   CEventListElt *msgEltPtr = m_head.GetNext();
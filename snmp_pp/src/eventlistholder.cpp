@@ -200,6 +200,72 @@ int EventListHolder::SNMPProcessEvents(const int max_block_milliseconds)
   return status;
 }
 
+#elif defined(HAVE_EPOLL_SYSCALL)
+
+// Pull all available events out of their sockets - do not block
+int EventListHolder::SNMPProcessPendingEvents()
+{
+  int nfound = 0;
+  msec now(0, 0);
+  int status;
+
+  pevents_mutex.lock();
+
+  do
+  {
+    // the sockets are registered by the event queues, so there
+    // is nothing to set up before asking for ready sockets
+    nfound = m_eventList.WaitEvents(0, true);
+
+    now.refresh();
+  } while (nfound > 0);
+
+  // go through the message queue and resend any messages
+  // which are past the timeout.
+  status = m_eventList.DoRetries(now);
+
+  pevents_mutex.unlock();
+
+  return status;
+}
+
+//---------[ Process Events ]------------------------------------------
+// Block until an event shows up - then handle the event(s)
+int EventListHolder::SNMPProcessEvents(const int max_block_milliseconds)
+{
+  struct timeval fd_timeout;
+  int timeout;
+  msec now; // automatically calls msec::refresh()
+  msec sendTime;
+
+  m_eventList.GetNextTimeout(sendTime);
+  now.GetDelta(sendTime, fd_timeout);
+
+  if ((max_block_milliseconds > 0) &&
+      ((fd_timeout.tv_sec > max_block_milliseconds / 1000) ||
+       ((fd_timeout.tv_sec == max_block_milliseconds / 1000) &&
+	(fd_timeout.tv_usec > (max_block_milliseconds % 1000) * 1000))))
+  {
+    fd_timeout.tv_sec = max_block_milliseconds / 1000;
+    fd_timeout.tv_usec = (max_block_milliseconds % 1000) * 1000;
+  }
+
+  /* Prevent endless sleep in case no fd is open */
+  if ((m_eventList.GetRegisteredFdCount() == 0) && (fd_timeout.tv_sec > 5))
+    fd_timeout.tv_sec = 5; /* sleep at max 5.99 seconds */
+
+  if (fd_timeout.tv_sec >= INT_MAX / 1000)
+    timeout = -1; // no timeout pending
+  else
+    timeout = fd_timeout.tv_sec * 1000 + fd_timeout.tv_usec / 1000;
+
+  // level triggered: the ready sockets are reported again
+  // when SNMPProcessPendingEvents() handles them
+  m_eventList.WaitEvents(timeout, false);
+
+  return SNMPProcessPendingEvents();
+}
+
 #else
 
 int EventListHolder::SNMPProcessPendingEvents()
@@ -340,21 +340,18 @@ bool v3MP::EngineIdTable::initialize_table(const int size)
 // ===============================[ Cache ]==================================
 
 v3MP::Cache::Cache()
+  : table(0), msg_buckets(0), req_buckets(0), mask(0),
+    max_entries(0), entries(0), first_free(-1), oldest(-1), newest(-1),
+    upper_limit_entries(MAX_MP_CACHE_SIZE),
+    entry_lifetime(MP_CACHE_ENTRY_LIFETIME), usm(0)
 {
   // init cache
-  table = new struct Entry_T[5];
-  if (!table)
+  if (!resize(8))
   {
     LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
     LOG("v3MP::Cache: could not create empty table.");
     LOG_END;
-
-    max_entries = 0;
   }
-  else
-    max_entries = 5;
-
-  entries = 0;
 }
 
 v3MP::Cache::~Cache()
@@ -369,13 +366,144 @@ v3MP::Cache::~Cache()
       LOG_END;
     }
 
-    for (int i = 0; i < entries; i++)
-      usm->delete_sec_state_reference(table[i].sec_state_ref);
+    for (int n = oldest; n >= 0; n = table[n].newer)
+      usm->delete_sec_state_reference(table[n].entry.sec_state_ref);
     entries = 0;
     delete [] table;
     table = 0;
     max_entries = 0;
   }
+  if (msg_buckets) delete [] msg_buckets;
+  if (req_buckets) delete [] req_buckets;
+  msg_buckets = req_buckets = 0;
+}
+
+// Grow the node array, node numbers do not change.
+bool v3MP::Cache::resize(int new_max_entries)
+{
+  unsigned int size = 16;
+  while (size < (unsigned int)new_max_entries)
+    size <<= 1;
+
+  struct Node_T *tmp = new struct Node_T[new_max_entries];
+  int *tmp_msg = new int[size];
+  int *tmp_req = new int[size];
+  if (!tmp || !tmp_msg || !tmp_req)
+  {
+    if (tmp)     delete [] tmp;
+    if (tmp_msg) delete [] tmp_msg;
+    if (tmp_req) delete [] tmp_req;
+    return false;
+  }
+
+  for (int i = 0; i < max_entries; i++)
+    tmp[i] = table[i];
+  // link the new nodes into the free list
+  for (int i = new_max_entries - 1; i >= max_entries; i--)
+  {
+    tmp[i].newer = first_free;
+    first_free = i;
+  }
+
+  if (table)       delete [] table;
+  if (msg_buckets) delete [] msg_buckets;
+  if (req_buckets) delete [] req_buckets;
+  table = tmp;
+  msg_buckets = tmp_msg;
+  req_buckets = tmp_req;
+  mask = size - 1;
+  max_entries = new_max_entries;
+
+  // rebuild the chains in the order the entries were added
+  for (unsigned int b = 0; b < size; b++)
+    msg_buckets[b] = req_buckets[b] = -1;
+  for (int n = newest; n >= 0; n = table[n].older)
+  {
+    unsigned int b = msg_bucket(table[n].entry.msg_id,
+                                table[n].entry.local_request);
+    table[n].msg_next = msg_buckets[b];
+    msg_buckets[b] = n;
+
+    b = req_bucket(table[n].entry.req_id, table[n].entry.local_request);
+    table[n].req_next = req_buckets[b];
+    req_buckets[b] = n;
+  }
+  return true;
+}
+
+int v3MP::Cache::find_msg_id(int msg_id, bool local_request) const
+{
+  for (int n = msg_buckets[msg_bucket(msg_id, local_request)];
+       n >= 0; n = table[n].msg_next)
+    if ((table[n].entry.msg_id == msg_id) &&
+        (table[n].entry.local_request == local_request))
+      return n;
+  return -1;
+}
+
+int v3MP::Cache::find_req_id(unsigned long req_id, bool local_request) const
+{
+  for (int n = req_buckets[req_bucket(req_id, local_request)];
+       n >= 0; n = table[n].req_next)
+    if ((table[n].entry.req_id == req_id) &&
+        (table[n].entry.local_request == local_request))
+      return n;
+  return -1;
+}
+
+void v3MP::Cache::remove_node(int n)
+{
+  struct Entry_T &e = table[n].entry;
+
+  int *link = &msg_buckets[msg_bucket(e.msg_id, e.local_request)];
+  while (*link != n)
+    link = &table[*link].msg_next;
+  *link = table[n].msg_next;
+
+  link = &req_buckets[req_bucket(e.req_id, e.local_request)];
+  while (*link != n)
+    link = &table[*link].req_next;
+  *link = table[n].req_next;
+
+  if (table[n].older >= 0)
+    table[table[n].older].newer = table[n].newer;
+  else
+    oldest = table[n].newer;
+  if (table[n].newer >= 0)
+    table[table[n].newer].older = table[n].older;
+  else
+    newest = table[n].older;
+
+  // release the strings, the node is reused later
+  e.sec_engine_id.clear();
+  e.sec_name.clear();
+  e.context_engine_id.clear();
+  e.context_name.clear();
+  e.sec_state_ref = 0;
+
+  table[n].newer = first_free;
+  first_free = n;
+  entries--;
+}
+
+// Drop all entries that were added before now - lifetime.
+void v3MP::Cache::expire(time_t now)
+{
+  if (entry_lifetime <= 0)
+    return;
+
+  while ((oldest >= 0) && (table[oldest].added + entry_lifetime <= now))
+  {
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 6);
+    LOG("v3MP::Cache: Dropping expired entry (msg id) (req id) (type)");
+    LOG(table[oldest].entry.msg_id);
+    LOG(table[oldest].entry.req_id);
+    LOG(table[oldest].entry.local_request ? "local" : "remote");
+    LOG_END;
+
+    usm->delete_sec_state_reference(table[oldest].entry.sec_state_ref);
+    remove_node(oldest);
+  }
 }
 
 // Add an entry to the cache.
@@ -402,16 +530,19 @@ int v3MP::Cache::add_entry(int msg_id, unsigned long req_id,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++)
-    if ((table[i].msg_id == msg_id) &&
-        (table[i].req_id == req_id) &&
-        (table[i].local_request == local_request) &&
-        (table[i].sec_engine_id == sec_engine_id) &&
-        (table[i].sec_model == sec_model) &&
-        (table[i].sec_name == sec_name) &&
-        (table[i].sec_level == sec_level) &&
-        (table[i].context_engine_id == context_engine_id) &&
-        (table[i].context_name == context_name))
+  for (int n = msg_buckets[msg_bucket(msg_id, local_request)];
+       n >= 0; n = table[n].msg_next)
+  {
+    const struct Entry_T &e = table[n].entry;
+    if ((e.msg_id == msg_id) &&
+        (e.req_id == req_id) &&
+        (e.local_request == local_request) &&
+        (e.sec_engine_id == sec_engine_id) &&
+        (e.sec_model == sec_model) &&
+        (e.sec_name == sec_name) &&
+        (e.sec_level == sec_level) &&
+        (e.context_engine_id == context_engine_id) &&
+        (e.context_name == context_name))
     {
       LOG_BEGIN(loggerModuleName, WARNING_LOG | 3);
       LOG("v3MP::Cache: Dont add doubled entry (msg id) (req id)");
@@ -421,36 +552,70 @@ int v3MP::Cache::add_entry(int msg_id, unsigned long req_id,
 
       return SNMPv3_MP_DOUBLED_MESSAGE;
     }
+  }
 
-  table[entries].msg_id            = msg_id;
-  table[entries].req_id            = req_id;
-  table[entries].local_request     = local_request;
-  table[entries].sec_engine_id     = sec_engine_id;
-  table[entries].sec_model         = sec_model;
-  table[entries].sec_name          = sec_name;
-  table[entries].sec_level         = sec_level;
-  table[entries].context_engine_id = context_engine_id;
-  table[entries].context_name      = context_name;
-  table[entries].sec_state_ref     = sec_state_ref;
-  table[entries].error_code        = error_code;
+  time_t now;
+  time(&now);
+  expire(now);
 
-  entries++;
-  if (entries == max_entries)
+  if (entries >= upper_limit_entries)
   {
-    // resize Table
-    struct Entry_T *tmp;
-    tmp = new struct Entry_T[2 * max_entries];
-    if (!tmp)
+    LOG_BEGIN(loggerModuleName, WARNING_LOG | 3);
+    LOG("v3MP::Cache: upper limit reached, dropping oldest entry (msg id) (req id) (limit)");
+    LOG(table[oldest].entry.msg_id);
+    LOG(table[oldest].entry.req_id);
+    LOG(upper_limit_entries);
+    LOG_END;
+
+    while ((entries >= upper_limit_entries) && (oldest >= 0))
     {
-      entries--;
-      return SNMPv3_MP_ERROR;
+      usm->delete_sec_state_reference(table[oldest].entry.sec_state_ref);
+      remove_node(oldest);
     }
-    for (int i=0; i<entries;i++)
-      tmp[i] = table[i];
-    delete [] table;
-    table = tmp;
-    max_entries *= 2;
   }
+
+  if ((first_free < 0) && !resize(2 * max_entries))
+    return SNMPv3_MP_ERROR;
+
+  int *tail = &msg_buckets[msg_bucket(msg_id, local_request)];
+  while (*tail >= 0)
+    tail = &table[*tail].msg_next;
+
+  int n = first_free;
+  first_free = table[n].newer;
+
+  struct Entry_T &e = table[n].entry;
+  e.msg_id            = msg_id;
+  e.req_id            = req_id;
+  e.local_request     = local_request;
+  e.sec_engine_id     = sec_engine_id;
+  e.sec_model         = sec_model;
+  e.sec_name          = sec_name;
+  e.sec_level         = sec_level;
+  e.context_engine_id = context_engine_id;
+  e.context_name      = context_name;
+  e.sec_state_ref     = sec_state_ref;
+  e.error_code        = error_code;
+  table[n].added      = now;
+
+  // append to the chains, so the oldest entry is found first
+  table[n].msg_next = -1;
+  *tail = n;
+  table[n].req_next = -1;
+  tail = &req_buckets[req_bucket(req_id, local_request)];
+  while (*tail >= 0)
+    tail = &table[*tail].req_next;
+  *tail = n;
+
+  table[n].older = newest;
+  table[n].newer = -1;
+  if (newest >= 0)
+    table[newest].newer = n;
+  else
+    oldest = n;
+  newest = n;
+
+  entries++;
   return SNMPv3_MP_OK;
 }
 
@@ -462,34 +627,21 @@ int v3MP::Cache::get_entry(int msg_id, bool local_request, int *error_code,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i < entries; i++)
+  int n = find_msg_id(msg_id, local_request);
+  if (n >= 0)
   {
-    if ((msg_id == table[i].msg_id) &&
-        (local_request == table[i].local_request))
-    {
-      *error_code = table[i].error_code;
-      *sec_state_ref = table[i].sec_state_ref;
-      entries--;
-
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
-      LOG("v3MP::Cache: Found entry (n) (msg id) (type)");
-      LOG(i);
-      LOG(msg_id);
-      LOG(local_request ? "local" : "remote");
-      LOG_END;
-
-      if (entries > i)
-      {
-        table[i] = table[entries];
+    *error_code = table[n].entry.error_code;
+    *sec_state_ref = table[n].entry.sec_state_ref;
+
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
+    LOG("v3MP::Cache: Found entry (n) (msg id) (type)");
+    LOG(n);
+    LOG(msg_id);
+    LOG(local_request ? "local" : "remote");
+    LOG_END;
 
-	LOG_BEGIN(loggerModuleName, INFO_LOG | 10);
-	LOG("v3MP::Cache: Moving entry (from) (to)");
-	LOG(entries);
-	LOG(i);
-	LOG_END;
-      }
-      return SNMPv3_MP_OK;
-    }
+    remove_node(n);
+    return SNMPv3_MP_OK;
   }
 
   LOG_BEGIN(loggerModuleName, WARNING_LOG | 5);
@@ -508,31 +660,20 @@ void v3MP::Cache::delete_entry(unsigned long req_id, bool local_request)
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i<entries; i++)
-    if ((table[i].req_id == req_id) &&
-        (table[i].local_request == local_request))
-    {
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
-      LOG("v3MP::Cache: Delete unprocessed entry (n) (req id) (type)");
-      LOG(i);
-      LOG(req_id);
-      LOG(local_request ? "local" : "remote");
-      LOG_END;
-
-      usm->delete_sec_state_reference(table[i].sec_state_ref);
-      entries--;
-      if (entries > i)
-      {
-        table[i] = table[entries];
+  int n = find_req_id(req_id, local_request);
+  if (n >= 0)
+  {
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
+    LOG("v3MP::Cache: Delete unprocessed entry (n) (req id) (type)");
+    LOG(n);
+    LOG(req_id);
+    LOG(local_request ? "local" : "remote");
+    LOG_END;
 
-	LOG_BEGIN(loggerModuleName, INFO_LOG | 10);
-	LOG("v3MP::Cache: Moving entry (from) (to)");
-	LOG(entries);
-	LOG(i);
-	LOG_END;
-      }
-      return;
-    }
+    usm->delete_sec_state_reference(table[n].entry.sec_state_ref);
+    remove_node(n);
+    return;
+  }
 
   LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
   LOG("v3MP::Cache: Entry to delete not found (req id) (type)");
@@ -551,31 +692,22 @@ void v3MP::Cache::delete_entry(unsigned long req_id, int msg_id,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i<entries; i++)
-    if ((table[i].req_id == req_id) &&
-	(table[i].msg_id == msg_id) &&
-        (table[i].local_request == local_request))
+  for (int n = msg_buckets[msg_bucket(msg_id, local_request)];
+       n >= 0; n = table[n].msg_next)
+    if ((table[n].entry.req_id == req_id) &&
+	(table[n].entry.msg_id == msg_id) &&
+        (table[n].entry.local_request == local_request))
     {
       LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
       LOG("v3MP::Cache: Delete unprocessed entry (n) (req id) (msg id) (type)");
-      LOG(i);
+      LOG(n);
       LOG(req_id);
       LOG(msg_id);
       LOG(local_request ? "local" : "remote");
       LOG_END;
 
-      usm->delete_sec_state_reference(table[i].sec_state_ref);
-      entries--;
-      if (entries > i)
-      {
-        table[i] = table[entries];
-
-        LOG_BEGIN(loggerModuleName, INFO_LOG | 10);
-        LOG("v3MP::Cache: Moving entry (from) (to)");
-        LOG(entries);
-        LOG(i);
-        LOG_END;
-      }
+      usm->delete_sec_state_reference(table[n].entry.sec_state_ref);
+      remove_node(n);
       return;
     }
 
@@ -595,43 +727,21 @@ int v3MP::Cache::get_entry(int searchedID, bool local_request,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i < entries; i++)
-    if ((table[i].msg_id == searchedID) &&
-        (table[i].local_request == local_request))
-    {
-      res->msg_id            = table[i].msg_id;
-      res->req_id            = table[i].req_id;
-      res->local_request     = table[i].local_request;
-      res->sec_engine_id     = table[i].sec_engine_id;
-      res->sec_model         = table[i].sec_model;
-      res->sec_name          = table[i].sec_name;
-      res->sec_level         = table[i].sec_level;
-      res->context_engine_id = table[i].context_engine_id;
-      res->context_name      = table[i].context_name;
-      res->sec_state_ref     = table[i].sec_state_ref;
-      res->error_code        = table[i].error_code;
-
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
-      LOG("v3MP::Cache: Found entry (n) (msg id) (type)");
-      LOG(i);
-      LOG(searchedID);
-      LOG(local_request ? "local" : "remote");
-      LOG_END;
-
-      entries--;
+  int n = find_msg_id(searchedID, local_request);
+  if (n >= 0)
+  {
+    *res = table[n].entry;
 
-      if (entries > i)
-      {
-        table[i] = table[entries];
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 8);
+    LOG("v3MP::Cache: Found entry (n) (msg id) (type)");
+    LOG(n);
+    LOG(searchedID);
+    LOG(local_request ? "local" : "remote");
+    LOG_END;
 
-	LOG_BEGIN(loggerModuleName, INFO_LOG | 10);
-	LOG("v3MP::Cache: Moving entry (from) (to)");
-	LOG(entries);
-	LOG(i);
-	LOG_END;
-      }
-      return SNMPv3_MP_OK;
-    }
+    remove_node(n);
+    return SNMPv3_MP_OK;
+  }
 
   LOG_BEGIN(loggerModuleName, WARNING_LOG | 5);
   LOG("v3MP::Cache: Entry not found (msg id) (type)");
@@ -1313,13 +1423,11 @@ int v3MP::snmp_build(struct snmp_pdu *pdu,
 		     const OctetStr &contextName)
 {
   Buffer<unsigned char> scopedPDU(MAX_SNMP_PACKET);
-  unsigned char *scopedPDUPtr = scopedPDU.get_ptr();
+  unsigned char *scopedPDUPtr;
   unsigned char globalData[MAXLENGTH_GLOBALDATA];
   int globalDataLength = MAXLENGTH_GLOBALDATA;
-  int scopedPDULength, maxLen = *out_length;
-  Buffer<unsigned char> buf(MAX_SNMP_PACKET);
-  unsigned char *bufPtr = buf.get_ptr();
-  long bufLength = 0, rc;
+  int scopedPDULength, maxLen;
+  long rc;
   int msgID;
   int cachedErrorCode = SNMPv3_MP_OK;
   struct SecurityStateReference *securityStateReference = NULL;
@@ -1384,24 +1492,15 @@ int v3MP::snmp_build(struct snmp_pdu *pdu,
   LOG(contextName.get_printable());
   LOG_END;
 
-  // encode vb in buf
-  scopedPDUPtr = build_vb(pdu, scopedPDUPtr, &maxLen);
+  // encode the scopedPDU back to front into the end of scopedPDU,
+  // so that the lengths of the vbs and the pdu are known without
+  // copying them
+  scopedPDULength = (*out_length < MAX_SNMP_PACKET) ?
+                     *out_length : MAX_SNMP_PACKET;
+  maxLen = scopedPDULength;
+  scopedPDUPtr = rbuild_data_pdu(pdu, scopedPDU.get_ptr() + scopedPDULength,
+                                 &maxLen);
   if (!scopedPDUPtr)
-  {
-    LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
-    LOG("v3MP: Error encoding vbs into buffer");
-    LOG_END;
-
-    return SNMPv3_MP_BUILD_ERROR;
-  }
-  scopedPDULength = SAFE_INT_CAST(scopedPDUPtr - scopedPDU.get_ptr());
-
-  //build dataPDU in buf
-  maxLen = *out_length;
-  scopedPDUPtr = scopedPDU.get_ptr();
-  bufPtr = build_data_pdu(pdu, bufPtr, &maxLen, scopedPDUPtr, scopedPDULength);
-
-  if (!bufPtr)
   {
     LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
     LOG("v3MP: Error encoding data pdu into buffer");
@@ -1410,16 +1509,12 @@ int v3MP::snmp_build(struct snmp_pdu *pdu,
     return SNMPv3_MP_BUILD_ERROR;
   }
 
-  bufLength = SAFE_INT_CAST(bufPtr - buf.get_ptr());
-
   //  serialize scopedPDU
-  maxLen = *out_length;
-  scopedPDUPtr = asn1_build_scoped_pdu(scopedPDUPtr, &maxLen,
-				       contextEngineID.data(),
-				       contextEngineID.len(),
-				       contextName.data(), contextName.len(),
-				       buf.get_ptr(), bufLength);
-
+  scopedPDUPtr = asn1_rbuild_scoped_pdu(scopedPDUPtr, &maxLen,
+                                        scopedPDULength - maxLen,
+                                        contextEngineID.data(),
+                                        contextEngineID.len(),
+                                        contextName.data(), contextName.len());
   if (!scopedPDUPtr)
   {
     LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
@@ -1429,7 +1524,7 @@ int v3MP::snmp_build(struct snmp_pdu *pdu,
     return SNMPv3_MP_BUILD_ERROR;
   }
 
-  scopedPDULength = SAFE_INT_CAST(scopedPDUPtr - scopedPDU.get_ptr());
+  scopedPDULength -= maxLen;
 
   // build msgGlobalData
   unsigned char *globalDataPtr = (unsigned char *)&globalData;
@@ -1482,7 +1577,7 @@ int v3MP::snmp_build(struct snmp_pdu *pdu,
                              (use_own_engine_id ?
                                         own_engine_id_oct : securityEngineID),
                              securityName, securityLevel,
-                             scopedPDU.get_ptr(), scopedPDULength,
+                             scopedPDUPtr, scopedPDULength,
                              securityStateReference, packet, out_length);
 
       if ( rc == SNMPv3_USM_OK ) {
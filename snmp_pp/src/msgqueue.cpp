@@ -304,7 +304,8 @@ CSNMPMessageQueue::CSNMPMessageQueueElt::CSNMPMessageQueueElt(
                                            CSNMPMessage *message,
                                            CSNMPMessageQueueElt *next,
                                            CSNMPMessageQueueElt *previous):
-  m_message(message), m_Next(next), m_previous(previous)
+  m_message(message), m_Next(next), m_previous(previous),
+  m_hashNext(0), m_heapPos(-1)
 {
   /* Finish insertion into doubly linked list */
   if (m_Next)     m_Next->m_previous = this;
@@ -330,9 +331,20 @@ CSNMPMessage *CSNMPMessageQueue::CSNMPMessageQueueElt::TestId(const unsigned lon
 
 //----[ CSNMPMessageQueue class ]--------------------------------------
 
+// initial number of id hash buckets and heap slots, both are doubled
+// when the number of outstanding messages reaches their size
+#define MSGQUEUE_INITIAL_SIZE 64
+
 CSNMPMessageQueue::CSNMPMessageQueue(EventListHolder *holder, Snmp *session)
-  : m_head(0, 0, 0), m_msgCount(0), my_holder(holder), m_snmpSession(session)
+  : m_head(0, 0, 0), m_msgCount(0), my_holder(holder), m_snmpSession(session),
+    m_bucketMask(MSGQUEUE_INITIAL_SIZE - 1),
+    m_heapCapacity(MSGQUEUE_INITIAL_SIZE),
+    m_socketCount(0), m_socketCapacity(2)
 {
+  m_buckets = new CSNMPMessageQueueElt*[MSGQUEUE_INITIAL_SIZE];
+  memset(m_buckets, 0, MSGQUEUE_INITIAL_SIZE * sizeof(CSNMPMessageQueueElt*));
+  m_heap = new CSNMPMessageQueueElt*[MSGQUEUE_INITIAL_SIZE];
+  m_sockets = new SocketCount[m_socketCapacity];
 }
 
 CSNMPMessageQueue::~CSNMPMessageQueue()
@@ -351,9 +363,13 @@ CSNMPMessageQueue::~CSNMPMessageQueue()
       lock();
     }
     else
-      delete leftOver;
+      RemoveElt(leftOver);
   }
   unlock();
+
+  delete [] m_buckets;
+  delete [] m_heap;
+  delete [] m_sockets;
 }
 
 CSNMPMessage * CSNMPMessageQueue::AddEntry(unsigned long id,
@@ -380,9 +396,35 @@ CSNMPMessage * CSNMPMessageQueue::AddEntry(unsigned long id,
 
   lock();
   // Insert entry at head of list, done automatically by the
-  // constructor function, so don't use the return value.
-  (void) new CSNMPMessageQueueElt(newMsg, m_head.GetNext(), &m_head);
+  // constructor function.
+  CSNMPMessageQueueElt *newElt =
+    new CSNMPMessageQueueElt(newMsg, m_head.GetNext(), &m_head);
+
+  if (m_msgCount > (int)m_bucketMask)
+    GrowBuckets(); // chains all elts of the list including the new one
+  else
+  {
+    unsigned int bucket = Bucket(id);
+    newElt->m_hashNext = m_buckets[bucket];
+    m_buckets[bucket] = newElt;
+  }
+
+  if (m_msgCount == m_heapCapacity)
+  {
+    CSNMPMessageQueueElt **newHeap =
+      new CSNMPMessageQueueElt*[m_heapCapacity * 2];
+    memcpy(newHeap, m_heap, m_msgCount * sizeof(CSNMPMessageQueueElt*));
+    delete [] m_heap;
+    m_heap = newHeap;
+    m_heapCapacity *= 2;
+  }
+  newElt->m_heapPos = m_msgCount;
+  m_heap[m_msgCount] = newElt;
   ++m_msgCount;
+  HeapUpdate(newElt);
+
+  AddSocket(socket);
+
   int count = m_msgCount;
   unlock();
   
@@ -395,58 +437,187 @@ CSNMPMessage * CSNMPMessageQueue::AddEntry(unsigned long id,
   return newMsg;
 }
 
+CSNMPMessageQueue::CSNMPMessageQueueElt *
+CSNMPMessageQueue::FindElt(const unsigned long uniqueId) const
+{
+  CSNMPMessageQueueElt *msgEltPtr = m_buckets[Bucket(uniqueId)];
 
-CSNMPMessage *CSNMPMessageQueue::GetEntry(const unsigned long uniqueId)
+  while (msgEltPtr)
+  {
+    if (msgEltPtr->TestId(uniqueId))
+      return msgEltPtr;
+    msgEltPtr = msgEltPtr->m_hashNext;
+  }
+  return 0;
+}
+
+void CSNMPMessageQueue::GrowBuckets()
 {
-  CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
+  unsigned int size = (m_bucketMask + 1) * 2;
+
+  delete [] m_buckets;
+  m_buckets = new CSNMPMessageQueueElt*[size];
+  memset(m_buckets, 0, size * sizeof(CSNMPMessageQueueElt*));
+  m_bucketMask = size - 1;
 
+  CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
   while (msgEltPtr)
   {
-    CSNMPMessage *returnVal = msgEltPtr->TestId(uniqueId);
-    if (returnVal)
-      return returnVal;
+    unsigned int bucket = Bucket(msgEltPtr->GetMessage()->GetId());
+    msgEltPtr->m_hashNext = m_buckets[bucket];
+    m_buckets[bucket] = msgEltPtr;
     msgEltPtr = msgEltPtr->GetNext();
   }
-  return 0;
 }
 
-int CSNMPMessageQueue::DeleteEntry(const unsigned long uniqueId)
+void CSNMPMessageQueue::RemoveElt(CSNMPMessageQueueElt *elt)
 {
-  bool loopAgain;
-  do
+  CSNMPMessage *msg = elt->GetMessage();
+
+  // unchain from the id hash
+  CSNMPMessageQueueElt **link = &m_buckets[Bucket(msg->GetId())];
+  while (*link && (*link != elt))
+    link = &(*link)->m_hashNext;
+  if (*link)
+    *link = elt->m_hashNext;
+
+  // move the last heap elt into the free position
+  int pos = elt->m_heapPos;
+  --m_msgCount;
+  if (pos != m_msgCount)
   {
-    loopAgain = false;
-    CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
+    HeapSwap(pos, m_msgCount);
+    HeapUpdate(m_heap[pos]);
+  }
+
+  RemoveSocket(msg->GetSocket());
 
-    while (msgEltPtr)
+  delete elt;
+}
+
+bool CSNMPMessageQueue::HeapLess(const int pos1, const int pos2) const
+{
+  msec sendTime1, sendTime2;
+
+  m_heap[pos1]->GetMessage()->GetSendTime(sendTime1);
+  m_heap[pos2]->GetMessage()->GetSendTime(sendTime2);
+
+  return sendTime1 < sendTime2;
+}
+
+void CSNMPMessageQueue::HeapSwap(const int pos1, const int pos2)
+{
+  CSNMPMessageQueueElt *tmp = m_heap[pos1];
+
+  m_heap[pos1] = m_heap[pos2];
+  m_heap[pos2] = tmp;
+  m_heap[pos1]->m_heapPos = pos1;
+  m_heap[pos2]->m_heapPos = pos2;
+}
+
+void CSNMPMessageQueue::HeapUpdate(CSNMPMessageQueueElt *elt)
+{
+  int pos = elt->m_heapPos;
+
+  while ((pos > 0) && HeapLess(pos, (pos - 1) / 2))
+  {
+    HeapSwap(pos, (pos - 1) / 2);
+    pos = (pos - 1) / 2;
+  }
+
+  for (;;)
+  {
+    int child = 2 * pos + 1;
+    if (child >= m_msgCount)
+      break;
+    if ((child + 1 < m_msgCount) && HeapLess(child + 1, child))
+      child++;
+    if (!HeapLess(child, pos))
+      break;
+    HeapSwap(pos, child);
+    pos = child;
+  }
+}
+
+void CSNMPMessageQueue::AddSocket(const SnmpSocket socket)
+{
+  for (int i = 0; i < m_socketCount; i++)
+    if (m_sockets[i].socket == socket)
     {
-      if (msgEltPtr->TestId(uniqueId))
-      {
-        if (msgEltPtr->GetMessage())
-        {
-          if (msgEltPtr->GetMessage()->IsLocked())
-          {
-            unlock();
-            // TODO: should we sleep here?
-            lock();
-            loopAgain = true;
-          }
-        }
-
-        if (!loopAgain)
-        {
-          delete msgEltPtr;
-          m_msgCount--;
-          LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
-          LOG("MsgQueue: Removed entry (req id)");
-          LOG(uniqueId);
-          LOG_END;
-          return SNMP_CLASS_SUCCESS;
-        }
-      }
-      msgEltPtr = msgEltPtr->GetNext();
+      m_sockets[i].count++;
+      return;
     }
-  } while (loopAgain);
+
+  if (m_socketCount == m_socketCapacity)
+  {
+    SocketCount *newSockets = new SocketCount[m_socketCapacity * 2];
+    memcpy(newSockets, m_sockets, m_socketCount * sizeof(SocketCount));
+    delete [] m_sockets;
+    m_sockets = newSockets;
+    m_socketCapacity *= 2;
+  }
+  m_sockets[m_socketCount].socket = socket;
+  m_sockets[m_socketCount].count = 1;
+  m_socketCount++;
+
+#ifdef HAVE_EPOLL_SYSCALL
+  my_holder->AddFd(socket, this);
+#endif
+}
+
+void CSNMPMessageQueue::RemoveSocket(const SnmpSocket socket)
+{
+  for (int i = 0; i < m_socketCount; i++)
+    if (m_sockets[i].socket == socket)
+    {
+      if (--m_sockets[i].count > 0)
+        return;
+
+      m_sockets[i] = m_sockets[--m_socketCount];
+#ifdef HAVE_EPOLL_SYSCALL
+      my_holder->RemoveFd(socket);
+#endif
+      return;
+    }
+}
+
+bool CSNMPMessageQueue::HasSocket(const SnmpSocket socket) const
+{
+  for (int i = 0; i < m_socketCount; i++)
+    if (m_sockets[i].socket == socket)
+      return true;
+  return false;
+}
+
+CSNMPMessage *CSNMPMessageQueue::GetEntry(const unsigned long uniqueId)
+{
+  CSNMPMessageQueueElt *msgEltPtr = FindElt(uniqueId);
+
+  return msgEltPtr ? msgEltPtr->GetMessage() : 0;
+}
+
+int CSNMPMessageQueue::DeleteEntry(const unsigned long uniqueId)
+{
+  CSNMPMessageQueueElt *msgEltPtr;
+
+  while ((msgEltPtr = FindElt(uniqueId)))
+  {
+    if (msgEltPtr->GetMessage()->IsLocked())
+    {
+      unlock();
+      // TODO: should we sleep here?
+      lock();
+      // the elt may have been deleted meanwhile, so look it up again
+      continue;
+    }
+
+    RemoveElt(msgEltPtr);
+    LOG_BEGIN(loggerModuleName, DEBUG_LOG | 10);
+    LOG("MsgQueue: Removed entry (req id)");
+    LOG(uniqueId);
+    LOG_END;
+    return SNMP_CLASS_SUCCESS;
+  }
   return SNMP_CLASS_INVALID_REQID;
 }
 
@@ -474,7 +645,7 @@ void CSNMPMessageQueue::DeleteSocketEntry(const SnmpSocket socket)
         CSNMPMessageQueueElt *tmp_msgEltPtr = msgEltPtr;
         msgEltPtr = tmp_msgEltPtr->GetNext();
         // delete the entry
-        delete tmp_msgEltPtr;
+        RemoveElt(tmp_msgEltPtr);
       }
     }
     else
@@ -485,28 +656,10 @@ void CSNMPMessageQueue::DeleteSocketEntry(const SnmpSocket socket)
 
 CSNMPMessage * CSNMPMessageQueue::GetNextTimeoutEntry()
 {
-  CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
-  msec bestTime;
-  msec sendTime(bestTime);
-  CSNMPMessage *msg;
-  CSNMPMessage *bestmsg = NULL;
-
-  if (msgEltPtr) {
-    bestmsg = msgEltPtr->GetMessage();
-    bestmsg->GetSendTime(bestTime);
-  }
-
-  // This would be much simpler if the queue was an ordered list!
-  while (msgEltPtr){
-    msg = msgEltPtr->GetMessage();
-    msg->GetSendTime(sendTime);
-    if (bestTime  > sendTime) {
-      bestTime = sendTime;
-      bestmsg = msg;
-    }
-    msgEltPtr = msgEltPtr->GetNext();
-  }
-  return bestmsg;
+  // the heap keeps the message with the earliest send time on top
+  if (m_msgCount == 0)
+    return NULL;
+  return m_heap[0]->GetMessage();
 }
 
 int CSNMPMessageQueue::GetNextTimeout(msec &sendTime)
@@ -525,67 +678,21 @@ int CSNMPMessageQueue::GetFdCount()
 {
   SnmpSynchronize _synchronize(*this); // instead of REENTRANT()
 
-  CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
-
-  if (!msgEltPtr) return 0;
-
-#ifndef SNMP_PP_IPv6
-  // we have at least one message in the queue and Snmp class
-  // can only have one socket, so
-  return 1;
-#else
-  // we can have max 2 sockets
-  SnmpSocket firstSocket = msgEltPtr->GetMessage()->GetSocket();
-
-  msgEltPtr = msgEltPtr->GetNext();
-
-  while (msgEltPtr)
-  {
-      if (msgEltPtr->GetMessage()->GetSocket() != firstSocket)
-          return 2;
-      msgEltPtr = msgEltPtr->GetNext();
-  }
-  return 1;
-#endif
+  return m_socketCount;
 }
 
 bool CSNMPMessageQueue::GetFdArray(struct pollfd *readfds, int &remaining)
 {
   SnmpSynchronize _synchronize(*this); // instead of REENTRANT()
 
-  CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
-  if (!msgEltPtr) return true;
-
-  if (remaining <= 0) return false;
-
-  SnmpSocket firstSocket = msgEltPtr->GetMessage()->GetSocket();
-  readfds[0].fd = firstSocket;
-  readfds[0].events = POLLIN;
-  remaining--;
-
-#ifndef SNMP_PP_IPv6
-  // we have at least one message in the queue and Snmp class
-  // can only have one socket, so we are done
-  return true;
-#else
-  // we can have max 2 sockets
-  msgEltPtr = msgEltPtr->GetNext();
-
-  while (msgEltPtr)
+  for (int i = 0; i < m_socketCount; i++)
   {
-    if (msgEltPtr->GetMessage()->GetSocket() != firstSocket)
-    {
-      if (remaining <= 0) return false;
-      readfds[1].fd = msgEltPtr->GetMessage()->GetSocket();
-      readfds[1].events = POLLIN;
-      remaining--;
-
-      return true;
-    }
-    msgEltPtr = msgEltPtr->GetNext();
+    if (remaining <= 0) return false;
+    readfds[i].fd = m_sockets[i].socket;
+    readfds[i].events = POLLIN;
+    remaining--;
   }
   return true;
-#endif
 }
 
 int CSNMPMessageQueue::HandleEvents(const struct pollfd *readfds,
@@ -594,100 +701,7 @@ int CSNMPMessageQueue::HandleEvents(const struct pollfd *readfds,
   for (int i=0; i < fds ; i++)
   {
     if (readfds[i].revents & POLLIN)
-    {
-      UdpAddress fromaddress;
-      Pdu tmppdu;
-      int status;
-      int recv_status;
-      OctetStr engine_id;
-
-      tmppdu.set_request_id(0);
-
-      // get the response and put it into a Pdu
-      recv_status = receive_snmp_response(readfds[i].fd, *m_snmpSession,
-                                          tmppdu, fromaddress, engine_id);
-
-      unsigned long temp_req_id = tmppdu.get_request_id();
-      if (!temp_req_id)
-        continue;
-
-      CSNMPMessage *msg = 0;
-      bool redoGetEntry;
-      do
-      {
-	redoGetEntry = false;
-        lock();
-        // find the corresponding msg in the message queue
-        msg = GetEntry(temp_req_id);
-        if (msg && msg->IsLocked())
-        {
-          unlock();
-          // TODO: Should we sleep here?
-          redoGetEntry = true;
-        }
-      } while (redoGetEntry);
-
-      if (!msg)
-      {
-        unlock();
-        LOG_BEGIN(loggerModuleName, INFO_LOG | 7);
-        LOG("MsgQueue: Ignore received message without outstanding request (req id)");
-        LOG(tmppdu.get_request_id());
-        LOG_END;
-        // the sent message is gone! probably was canceled, ignore it
-        continue;
-      }
-
-      // save pdu back into the message
-      status = msg->SetPdu(recv_status, tmppdu, fromaddress);
-
-      if (status)
-      {
-        // received pdu does not match
-        // @todo if version is SNMPv3 we must return a report
-        //       unknown pdu handler!
-        unlock();
-        continue;
-      }
-
-#ifdef _SNMPv3
-      if (engine_id.len() > 0)
-      {
-        SnmpTarget *target = msg->GetTarget();
-        if ((target->get_type() == SnmpTarget::type_utarget) &&
-            (target->get_version() == version3))
-        {
-          UdpAddress addr = target->get_address();
-
-	    LOG_BEGIN(loggerModuleName, DEBUG_LOG | 14);
-          LOG("MsgQueue: Adding engine id to table (addr) (id)");
-          LOG(addr.get_printable());
-          LOG(engine_id.get_printable());
-          LOG_END;
-
-          m_snmpSession->get_mpv3()->add_to_engine_id_table(engine_id,
-                                          (char*)addr.IpAddress::get_printable(),
-                                          addr.get_port());
-        }
-      }
-#endif
-
-      // Do the callback
-      msg->SetLocked(true);
-      unlock();
-      status = msg->Callback(SNMP_CLASS_ASYNC_RESPONSE);
-      lock();
-      msg->SetLocked(false);
-
-      if (!status)
-      {
-        // this is an asynch response and the callback is done.
-        // no need to keep this message around;
-        // Dequeue the message
-        DeleteEntry(temp_req_id);
-      }
-      unlock();
-    }
+      HandleEvent(readfds[i].fd);
   }
   return SNMP_CLASS_SUCCESS;
 }
@@ -698,15 +712,13 @@ void CSNMPMessageQueue::GetFdSets(int &maxfds, fd_set &readfds,
                                   fd_set &, fd_set &)
 {
   SnmpSynchronize _synchronize(*this); // REENTRANT
-  CSNMPMessageQueueElt *msgEltPtr = m_head.GetNext();
 
-  while (msgEltPtr)
+  for (int i = 0; i < m_socketCount; i++)
   {
-    SnmpSocket sock = msgEltPtr->GetMessage()->GetSocket();
+    SnmpSocket sock = m_sockets[i].socket;
     FD_SET(sock, &readfds);
     if (maxfds < SAFE_INT_CAST(sock+1))
       maxfds = SAFE_INT_CAST(sock+1);
-    msgEltPtr = msgEltPtr->GetNext();
   }
 }
 
@@ -715,130 +727,134 @@ int CSNMPMessageQueue::HandleEvents(const int maxfds,
                                     const fd_set &,
                                     const fd_set &)
 {
-  fd_set snmp_readfds, snmp_writefds, snmp_errfds;
-  int tmp_maxfds = maxfds;
+  for (int fd = 0; fd < maxfds; fd++)
+  {
+    if (FD_ISSET(fd, (fd_set*)&readfds))
+      HandleEvent(fd);
+  }
+  return SNMP_CLASS_SUCCESS;
+}
+
+#endif // HAVE_POLL_SYSCALL
 
+int CSNMPMessageQueue::HandleEvent(const SnmpSocket fd)
+{
   // Only read from our own fds
-  FD_ZERO(&snmp_readfds);
-  FD_ZERO(&snmp_writefds);
-  FD_ZERO(&snmp_errfds);
-  GetFdSets(tmp_maxfds, snmp_readfds, snmp_writefds, snmp_errfds);
+  lock();
+  bool ownSocket = HasSocket(fd);
+  unlock();
+  if (!ownSocket)
+    return SNMP_CLASS_SUCCESS;
 
-  for (int fd = 0; fd < maxfds; fd++)
-  {
-    if ((FD_ISSET(fd, &snmp_readfds)) &&
-        (FD_ISSET(fd, (fd_set*)&readfds)))
-    {
-      UdpAddress fromaddress;
-      Pdu tmppdu;
-      int status;
-      int recv_status;
-      OctetStr engine_id;
+  UdpAddress fromaddress;
+  Pdu tmppdu;
+  int status;
+  int recv_status;
+  OctetStr engine_id;
 
-      tmppdu.set_request_id(0);
+  tmppdu.set_request_id(0);
 
-      // get the response and put it into a Pdu
-      recv_status = receive_snmp_response(fd, *m_snmpSession,
-                                          tmppdu, fromaddress, engine_id);
+  // get the response and put it into a Pdu
+  recv_status = receive_snmp_response(fd, *m_snmpSession,
+                                      tmppdu, fromaddress, engine_id);
 
-      unsigned long temp_req_id = tmppdu.get_request_id();
-      if (!temp_req_id)
-        continue;
+  unsigned long temp_req_id = tmppdu.get_request_id();
+  if (!temp_req_id)
+    return SNMP_CLASS_SUCCESS;
 
-      CSNMPMessage *msg = 0;
-      bool redoGetEntry;
-      do
-      {
-        redoGetEntry = false;
-        lock();
-        // find the corresponding msg in the message queue
-        msg = GetEntry(temp_req_id);
-        if (msg && msg->IsLocked())
-        {
-          unlock();
-          // TODO: Should we sleep here?
-          redoGetEntry = true;
-        }
-      } while (redoGetEntry);
-
-      if (!msg)
-      {
-        unlock();
-        LOG_BEGIN(loggerModuleName, INFO_LOG | 7);
-        LOG("MsgQueue: Ignore received message without outstanding request (req id)");
-        LOG(tmppdu.get_request_id());
-        LOG_END;
-        // the sent message is gone! probably was canceled, ignore it
-        continue;
-      }
+  CSNMPMessage *msg = 0;
+  bool redoGetEntry;
+  do
+  {
+    redoGetEntry = false;
+    lock();
+    // find the corresponding msg in the message queue
+    msg = GetEntry(temp_req_id);
+    if (msg && msg->IsLocked())
+    {
+      unlock();
+      // TODO: Should we sleep here?
+      redoGetEntry = true;
+    }
+  } while (redoGetEntry);
 
-      // save pdu back into the message
-      status = msg->SetPdu(recv_status, tmppdu, fromaddress);
+  if (!msg)
+  {
+    unlock();
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 7);
+    LOG("MsgQueue: Ignore received message without outstanding request (req id)");
+    LOG(tmppdu.get_request_id());
+    LOG_END;
+    // the sent message is gone! probably was canceled, ignore it
+    return SNMP_CLASS_SUCCESS;
+  }
 
-      if (status)
-      {
-        // received pdu does not match
-        // @todo if version is SNMPv3 we must return a report
-        //       unknown pdu handler!
-        unlock();
-        continue;
-      }
+  // save pdu back into the message
+  status = msg->SetPdu(recv_status, tmppdu, fromaddress);
+
+  if (status)
+  {
+    // received pdu does not match
+    // @todo if version is SNMPv3 we must return a report
+    //       unknown pdu handler!
+    unlock();
+    return SNMP_CLASS_SUCCESS;
+  }
 
 #ifdef _SNMPv3
-      if (engine_id.len() > 0)
-      {
-        SnmpTarget *target = msg->GetTarget();
-        if ((target->get_type() == SnmpTarget::type_utarget) &&
-            (target->get_version() == version3))
-        {
-          if (tmppdu.get_type() == sNMP_PDU_REPORT || 
-              tmppdu.get_type() == sNMP_PDU_RESPONSE) {
-              
-            UdpAddress addr = target->get_address();
-
-            LOG_BEGIN(loggerModuleName, DEBUG_LOG | 14);
-            LOG("MsgQueue: Adding engine id to table (addr) (id)");
-            LOG(addr.get_printable());
-            LOG(engine_id.get_printable());
-            LOG_END;
-            m_snmpSession->get_mpv3()->add_to_engine_id_table(engine_id,
-                                         (char*)addr.IpAddress::get_printable(),
-                                          addr.get_port());
-          }
-        }
+  if (engine_id.len() > 0)
+  {
+    SnmpTarget *target = msg->GetTarget();
+    if ((target->get_type() == SnmpTarget::type_utarget) &&
+        (target->get_version() == version3))
+    {
+      if (tmppdu.get_type() == sNMP_PDU_REPORT || 
+          tmppdu.get_type() == sNMP_PDU_RESPONSE) {
+          
+        UdpAddress addr = target->get_address();
+
+        LOG_BEGIN(loggerModuleName, DEBUG_LOG | 14);
+        LOG("MsgQueue: Adding engine id to table (addr) (id)");
+        LOG(addr.get_printable());
+        LOG(engine_id.get_printable());
+        LOG_END;
+        m_snmpSession->get_mpv3()->add_to_engine_id_table(engine_id,
+                                     (char*)addr.IpAddress::get_printable(),
+                                      addr.get_port());
       }
+    }
+  }
 #endif
 
-      // Do the callback
-      msg->SetLocked(true);
-      unlock();
-      status = msg->Callback(SNMP_CLASS_ASYNC_RESPONSE);
-      lock();
-      msg->SetLocked(false);
+  // Do the callback
+  msg->SetLocked(true);
+  unlock();
+  status = msg->Callback(SNMP_CLASS_ASYNC_RESPONSE);
+  lock();
+  msg->SetLocked(false);
 
-      if (!status)
-      {
-        // this is an asynch response and the callback is done.
-        // no need to keep this message around;
-        // Dequeue the message
-        DeleteEntry(temp_req_id);
-      }
-      unlock();
-    } // if socket has data
-  } // for all sockets
+  if (!status)
+  {
+    // this is an asynch response and the callback is done.
+    // no need to keep this message around;
+    // Dequeue the message
+    DeleteEntry(temp_req_id);
+  }
+  unlock();
   return SNMP_CLASS_SUCCESS;
 }
 
-#endif // HAVE_POLL_SYSCALL
-
 int CSNMPMessageQueue::DoRetries(const msec &now)
 {
+  CSNMPMessageQueueElt *msgEltPtr;
   CSNMPMessage *msg;
   msec sendTime(0, 0);
   int status = SNMP_CLASS_SUCCESS;
   lock();
-  while ((msg = GetNextTimeoutEntry()))
+  while (m_msgCount > 0)
   {
+    msgEltPtr = m_heap[0];
+    msg = msgEltPtr->GetMessage();
     msg->GetSendTime(sendTime);
 
     if (sendTime > now)
@@ -856,6 +872,9 @@ int CSNMPMessageQueue::DoRetries(const msec &now)
     status = msg->ResendMessage();
     lock();
     msg->SetLocked(false);
+    // the send time has been moved, the elt may also have moved
+    // within the heap while the queue was unlocked
+    HeapUpdate(msgEltPtr);
     if (status != 0)
     {
       if (status == SNMP_CLASS_TIMEOUT)
@@ -558,6 +558,10 @@ int CNotifyEventQueue::AddEntry(Snmp *snmp,
       return SNMP_CLASS_TL_UNSUPPORTED;
 #endif
     } // not is_v4_address
+
+#ifdef HAVE_EPOLL_SYSCALL
+    my_holder->AddFd(m_notify_fd, this);
+#endif
   }
 
   CNotifyEvent *newEvent = new CNotifyEvent(snmp, trapids, targets);
@@ -576,6 +580,9 @@ void CNotifyEventQueue::cleanup()
 {
   if (m_notify_fd != INVALID_SOCKET)
   {
+#ifdef HAVE_EPOLL_SYSCALL
+    my_holder->RemoveFd(m_notify_fd);
+#endif
     close(m_notify_fd);
     m_notify_fd = INVALID_SOCKET;
   }
@@ -616,6 +623,9 @@ void CNotifyEventQueue::DeleteEntry(Snmp *snmp)
     {
       debugprintf(3, "Closing notifications port %s, fd %d.",
                   m_notify_addr.get_printable(), m_notify_fd);
+#ifdef HAVE_EPOLL_SYSCALL
+      my_holder->RemoveFd(m_notify_fd);
+#endif
       close(m_notify_fd);
       m_notify_fd = INVALID_SOCKET;
     }
@@ -652,46 +662,14 @@ bool CNotifyEventQueue::GetFdArray(struct pollfd *readfds,
 int CNotifyEventQueue::HandleEvents(const struct pollfd *readfds,
                                     const int fds)
 {
-  SnmpSynchronize _synchronize(*this); // instead of REENTRANT()
-
   int status = SNMP_CLASS_SUCCESS;
 
-  if (m_notify_fd == INVALID_SOCKET)
-    return status;
-
   for (int i=0; i < fds; i++)
   {
-    Pdu pdu;
-    SnmpTarget *target = NULL;
-
     if ((readfds[i].revents & POLLIN) == 0)
       continue; // nothing to receive
 
-    if (readfds[i].fd != m_notify_fd)
-      continue; // not our socket
-
-    status = receive_snmp_notification(m_notify_fd, *m_snmpSession,
-                                       pdu, &target);
-
-    if ((SNMP_CLASS_SUCCESS == status) ||
-        (SNMP_CLASS_TL_FAILED == status))
-    {
-      // If we have transport layer failure, the app will want to
-      // know about it.
-      // Go through each snmp object and check the filters, making
-      // callbacks as necessary
-      if (!target) target = new SnmpTarget();
-
-      CNotifyEventQueueElt *notifyEltPtr = m_head.GetNext();
-      while (notifyEltPtr)
-      {
-        notifyEltPtr->GetNotifyEvent()->Callback(*target, pdu,
-                                                 m_notify_fd, status);
-        notifyEltPtr = notifyEltPtr->GetNext();
-      } // for each snmp object
-    }
-    if (target) // receive_snmp_notification calls new
-      delete target;
+    status = HandleEvent(readfds[i].fd);
   }
 
   return status;
@@ -719,47 +697,59 @@ int CNotifyEventQueue::HandleEvents(const int /*maxfds*/,
                                     const fd_set &/*exceptfds*/)
 {
   SnmpSynchronize _synchronize(*this); // REENTRANT
-  int status = SNMP_CLASS_SUCCESS;
 
   if (m_notify_fd == INVALID_SOCKET)
-    return status;
+    return SNMP_CLASS_SUCCESS;
+
+  // pull the notifiaction off the socket
+  if (FD_ISSET(m_notify_fd, (fd_set*)&readfds))
+    return HandleEvent(m_notify_fd);
+
+  return SNMP_CLASS_SUCCESS;
+}
+
+#endif // HAVE_POLL_SYSCALL
+
+int CNotifyEventQueue::HandleEvent(const SnmpSocket fd)
+{
+  SnmpSynchronize _synchronize(*this); // REENTRANT
+  int status = SNMP_CLASS_SUCCESS;
+
+  if ((m_notify_fd == INVALID_SOCKET) || (fd != m_notify_fd))
+    return status; // not our socket
 
   Pdu pdu;
   SnmpTarget *target = NULL;
 
-  // pull the notifiaction off the socket
-  if (FD_ISSET(m_notify_fd, (fd_set*)&readfds)) {
-    status = receive_snmp_notification(m_notify_fd, *m_snmpSession,
-                                       pdu, &target);
+  status = receive_snmp_notification(m_notify_fd, *m_snmpSession,
+                                     pdu, &target);
 
-    if ((SNMP_CLASS_SUCCESS == status) ||
-        (SNMP_CLASS_TL_FAILED == status))
-    {
-      // If we have transport layer failure, the app will want to
-      // know about it.
-      // Go through each snmp object and check the filters, making
-      // callbacks as necessary
+  if ((SNMP_CLASS_SUCCESS == status) ||
+      (SNMP_CLASS_TL_FAILED == status))
+  {
+    // If we have transport layer failure, the app will want to
+    // know about it.
+    // Go through each snmp object and check the filters, making
+    // callbacks as necessary
 
-      // On failure target will be NULL
-      if (!target)
-        target = new SnmpTarget();
+    // On failure target will be NULL
+    if (!target)
+      target = new SnmpTarget();
 
-      CNotifyEventQueueElt *notifyEltPtr = m_head.GetNext();
-      while (notifyEltPtr)
-      {
-        notifyEltPtr->GetNotifyEvent()->Callback(*target, pdu,
-                                                 m_notify_fd, status);
-        notifyEltPtr = notifyEltPtr->GetNext();
-      } // for each snmp object
-    }
-    if (target) // receive_snmp_notification calls new
-      delete target;
+    CNotifyEventQueueElt *notifyEltPtr = m_head.GetNext();
+    while (notifyEltPtr)
+    {
+      notifyEltPtr->GetNotifyEvent()->Callback(*target, pdu,
+                                               m_notify_fd, status);
+      notifyEltPtr = notifyEltPtr->GetNext();
+    } // for each snmp object
   }
+  if (target) // receive_snmp_notification calls new
+    delete target;
+
   return status;
 }
 
-#endif // HAVE_POLL_SYSCALL
-
 #ifdef SNMP_PP_NAMESPACE
 } // end of namespace Snmp_pp
 #endif
@@ -55,6 +55,8 @@ char octet_cpp_version[]="@(#) SNMP++ $Id$";
 
 #include <libsnmp.h>
 
+#include <atomic>
+
 #include "snmp_pp/octet.h"    // include definition for octet class
 
 #ifdef SNMP_PP_NAMESPACE
@@ -74,7 +76,8 @@ char OctetStr::nonprintable_char = '.';
 
 //============[ constructor using no arguments ]======================
 OctetStr::OctetStr()
-  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true)
+  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true),
+    payload(0)
 {
   smival.syntax = sNMP_SYNTAX_OCTETS;
   smival.value.string.ptr = 0;
@@ -83,7 +86,8 @@ OctetStr::OctetStr()
 
 //============[ constructor using a  string ]=========================
 OctetStr::OctetStr(const char *str)
-  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true)
+  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true),
+    payload(0)
 {
   smival.syntax = sNMP_SYNTAX_OCTETS;
   smival.value.string.ptr = 0;
@@ -110,7 +114,8 @@ OctetStr::OctetStr(const char *str)
 
 //============[ constructor using an unsigned char * ]================
 OctetStr::OctetStr(const unsigned char *str, unsigned long len)
-  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true)
+  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true),
+    payload(0)
 {
   smival.syntax = sNMP_SYNTAX_OCTETS;
   smival.value.string.ptr = 0;
@@ -132,7 +137,8 @@ OctetStr::OctetStr(const unsigned char *str, unsigned long len)
 
 //============[ constructor using another octet object ]==============
 OctetStr::OctetStr(const OctetStr &octet)
-  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true)
+  : output_buffer(0), output_buffer_len(0), m_changed(true), validity(true),
+    payload(0)
 {
   smival.syntax = sNMP_SYNTAX_OCTETS;
   smival.value.string.ptr = 0;
@@ -147,6 +153,13 @@ OctetStr::OctetStr(const OctetStr &octet)
     return;
   }
 
+  // share an immutable payload instead of copying it
+  if (octet.payload)
+  {
+    attach(octet);
+    return;
+  }
+
   // get the mem needed
   smival.value.string.ptr = (SmiLPBYTE) new unsigned char[octet.smival.value.string.len];
 
@@ -165,9 +178,8 @@ OctetStr::OctetStr(const OctetStr &octet)
 OctetStr::~OctetStr()
 {
   // if not empty, free it up
-  if (smival.value.string.ptr) delete [] smival.value.string.ptr;
+  release_data();
   smival.value.string.len = 0;
-  smival.value.string.ptr = 0;
   if (output_buffer)           delete [] output_buffer;
   output_buffer = 0;
   output_buffer_len = 0;
@@ -178,11 +190,7 @@ OctetStr::~OctetStr()
 void OctetStr::set_data(const unsigned char *str, unsigned long len)
 {
   // free up already used space
-  if (smival.value.string.ptr)
-  {
-    delete [] smival.value.string.ptr;
-    smival.value.string.ptr = 0;
-  }
+  release_data();
   smival.value.string.len = 0;
   m_changed = true;
 
@@ -220,7 +228,10 @@ OctetStr& OctetStr::operator=(const OctetStr &octet)
 
   if (!octet.validity) return *this; // don't assign from invalid objs
 
-  set_data(octet.smival.value.string.ptr, octet.smival.value.string.len);
+  if (octet.payload)
+    attach(octet);
+  else
+    set_data(octet.smival.value.string.ptr, octet.smival.value.string.len);
 
   return *this;		       // return self reference
 }
@@ -347,8 +358,7 @@ OctetStr& OctetStr::operator+=(const char *a)
     // copy in the string
     memcpy(tmp + smival.value.string.len, a, slen);
     // delete the original
-    if (smival.value.string.ptr)
-      delete [] smival.value.string.ptr;
+    release_data();
     // point to the new one
     smival.value.string.ptr = tmp;
     smival.value.string.len = SAFE_INT_CAST(nlen);
@@ -378,8 +388,7 @@ OctetStr& OctetStr::operator+=(const OctetStr& octet)
     // copy in the string
     memcpy(tmp + smival.value.string.len, octet.data(), slen);
     // delete the original
-    if (smival.value.string.ptr )
-      delete [] smival.value.string.ptr;
+    release_data();
     // point to the new one
     smival.value.string.ptr = tmp;
     smival.value.string.len = SAFE_INT_CAST(nlen);
@@ -403,8 +412,7 @@ OctetStr& OctetStr::operator+=(const unsigned char c)
     memcpy(tmp, smival.value.string.ptr, smival.value.string.len);
     tmp[smival.value.string.len] = c; 	// assign in new byte
 
-    if (smival.value.string.ptr)	// delete the original
-      delete [] smival.value.string.ptr;
+    release_data();			// delete the original
 
     smival.value.string.ptr = tmp;	// point to new one
     smival.value.string.len++;	   	// up the len
@@ -563,19 +571,27 @@ SnmpSyntax& OctetStr::operator=(const SnmpSyntax &val)
   if (this == &val) return *this;  // protect against assignment from self
 
   // blow away the old value
-  if (smival.value.string.ptr)
-  {
-    delete [] smival.value.string.ptr;
-    smival.value.string.ptr = 0;
-  }
+  release_data();
   smival.value.string.len = 0;
   validity = false;
 
   if (val.valid()){
     switch (val.get_syntax()){
       case sNMP_SYNTAX_OPAQUE:
-      case sNMP_SYNTAX_BITS:
       case sNMP_SYNTAX_OCTETS:
+      {
+	// addresses report sNMP_SYNTAX_OCTETS too, but have no payload
+	const OctetStr *other = dynamic_cast<const OctetStr *>(&val);
+	if (other && other->payload)
+	{
+	  attach(*other);
+	  break;
+	}
+	set_data(((OctetStr &)val).smival.value.string.ptr,
+		 ((OctetStr &)val).smival.value.string.len);
+	break;
+      }
+      case sNMP_SYNTAX_BITS:
       case sNMP_SYNTAX_IPADDR:
 	set_data(((OctetStr &)val).smival.value.string.ptr,
 		 ((OctetStr &)val).smival.value.string.len);
@@ -741,7 +757,13 @@ const char *OctetStr::get_printable_hex() const
 //==============[ Null out the contents of the string ]===================
 void OctetStr::clear()
 {
-  if (smival.value.string.len > 0)
+  if (payload)
+  {
+    // never overwrite a shared payload
+    release_data();
+    smival.value.string.len = 0;
+  }
+  else if (smival.value.string.len > 0)
   {
     memset(smival.value.string.ptr, 0, smival.value.string.len);
     smival.value.string.len = 0;
@@ -786,10 +808,7 @@ bool OctetStr::set_len(const unsigned long new_len)
     m_changed = true;
 
     if (new_len == 0)
-    {
-      if (smival.value.string.ptr) delete [] smival.value.string.ptr;
-      smival.value.string.ptr = 0;
-    }
+      release_data();
 
     validity = true;
     return true;
@@ -801,8 +820,7 @@ bool OctetStr::set_len(const unsigned long new_len)
   if (smival.value.string.ptr)
     memcpy(tmp, smival.value.string.ptr, smival.value.string.len);
   memset(tmp + smival.value.string.len, 0, new_len - smival.value.string.len);
-  if (smival.value.string.ptr)
-    delete [] smival.value.string.ptr;
+  release_data();
   smival.value.string.ptr = tmp;
   smival.value.string.len = new_len;
 
@@ -812,6 +830,64 @@ bool OctetStr::set_len(const unsigned long new_len)
   return true;
 }
 
+//==============[ reference counted, immutable payload ]===============
+struct OctetStr::Payload
+{
+  Payload(unsigned char *d) : refs(1), data(d) {}
+  ~Payload() { delete [] data; }
+
+  std::atomic<unsigned long> refs;
+  unsigned char *data;
+};
+
+OctetStr& OctetStr::share()
+{
+  if (payload || !smival.value.string.ptr)
+    return *this;
+
+  // take over the buffer, no need to copy
+  payload = new Payload(smival.value.string.ptr);
+  return *this;
+}
+
+void OctetStr::attach(const OctetStr &octet)
+{
+  // reference first, octet may share our own payload
+  octet.payload->refs++;
+  release_data();
+  payload = octet.payload;
+  smival.value.string.ptr = octet.smival.value.string.ptr;
+  smival.value.string.len = octet.smival.value.string.len;
+  validity = true;
+  m_changed = true;
+}
+
+void OctetStr::detach()
+{
+  if (!payload)
+    return;
+
+  unsigned char *tmp = new unsigned char[smival.value.string.len];
+  memcpy(tmp, smival.value.string.ptr, smival.value.string.len);
+  unsigned long len = smival.value.string.len;
+  release_data();
+  smival.value.string.ptr = tmp;
+  smival.value.string.len = len;
+}
+
+void OctetStr::release_data()
+{
+  if (payload)
+  {
+    if (--payload->refs == 0)
+      delete payload;
+    payload = 0;
+  }
+  else if (smival.value.string.ptr)
+    delete [] smival.value.string.ptr;
+  smival.value.string.ptr = 0;
+}
+
 #ifdef SNMP_PP_NAMESPACE
 } // end of namespace Snmp_pp
 #endif
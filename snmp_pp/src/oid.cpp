@@ -145,12 +145,9 @@ Oid& Oid::operator+=(const char *a)
 void Oid::set_data(const unsigned long *raw_oid,
                    const unsigned int oid_len)
 {
-  if (smival.value.oid.len < oid_len)
+  if (oid_capacity() < oid_len)
   {
-    delete_oid_ptr();
-
-    smival.value.oid.ptr = (SmiLPUINT32) new unsigned long[oid_len];
-    if (!smival.value.oid.ptr) return;
+    if (!alloc_oid_ptr(oid_len)) return;
   }
   memcpy((SmiLPBYTE) smival.value.oid.ptr,
          (SmiLPBYTE) raw_oid,
@@ -162,12 +159,9 @@ void Oid::set_data(const unsigned long *raw_oid,
 // Set the data from raw form.
 void Oid::set_data(const char *str, const unsigned int str_len)
 {
-  if (smival.value.oid.len < str_len)
+  if (oid_capacity() < str_len)
   {
-    delete_oid_ptr();
-
-    smival.value.oid.ptr = (SmiLPUINT32) new unsigned long[str_len];
-    if (!smival.value.oid.ptr) return;
+    if (!alloc_oid_ptr(str_len)) return;
   }
 
   if ((!str) || (str_len == 0))
@@ -180,6 +174,52 @@ void Oid::set_data(const char *str, const unsigned int str_len)
   m_changed = true;
 }
 
+//===============[Oid::append_oid_ptr ]====================================
+// append subids, reuse the inline storage as long as they fit
+void Oid::append_oid_ptr(const SmiUINT32 *data, const unsigned long n)
+{
+  SmiLPUINT32 old_oid = smival.value.oid.ptr;
+  unsigned long old_len = smival.value.oid.len;
+  unsigned long new_len = old_len + n;
+
+  if ((old_oid == iv_inline) && (new_len <= SNMP_PP_OID_INLINE_LEN))
+  {
+    // data may point to iv_inline, but never beyond old_len
+    MEMCPY((SmiLPBYTE) &iv_inline[old_len],
+           (SmiLPBYTE) data, (size_t) (n*sizeof(SmiUINT32)));
+    smival.value.oid.len = new_len;
+    m_changed = true;
+    return;
+  }
+
+  SmiLPUINT32 new_oid;
+  if (new_len <= SNMP_PP_OID_INLINE_LEN)
+    new_oid = iv_inline;
+  else
+    new_oid = (SmiLPUINT32) new unsigned long[new_len];
+
+  if (new_oid == 0)
+  {
+    delete_oid_ptr();
+    return;
+  }
+
+  // copy old and appended values before releasing the old buffer
+  if (old_oid)
+    MEMCPY((SmiLPBYTE) new_oid, (SmiLPBYTE) old_oid,
+           (size_t) (old_len*sizeof(SmiUINT32)));
+  MEMCPY((SmiLPBYTE) &new_oid[old_len],
+         (SmiLPBYTE) data, (size_t) (n*sizeof(SmiUINT32)));
+
+  if (old_oid && (old_oid != iv_inline))
+    delete [] old_oid;
+
+  // out with the old, in with the new...
+  smival.value.oid.ptr = new_oid;
+  smival.value.oid.len = new_len;
+  m_changed = true;
+}
+
 //==============[Oid::get_printable(unsigned int start, n) ]=============
 // return a dotted string starting at start,
 // going n positions to the left
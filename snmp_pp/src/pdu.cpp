@@ -449,6 +449,13 @@ int Pdu::get_asn1_length() const
   for (int i = 0; i < vb_count; ++i)
     length += vbs[i]->get_asn1_length();
 
+  return get_asn1_length_for_vbs(length);
+}
+
+int Pdu::get_asn1_length_for_vbs(const int vbs_length) const
+{
+  int length = vbs_length;
+
   // header for vbs
   if      (length < 0x80)      length += 2;
   else if (length <= 0xFF)     length += 3;
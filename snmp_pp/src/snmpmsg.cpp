@@ -188,6 +188,124 @@ void freeSmivalDescriptor(SmiVALUE *smival)
   smival->syntax = sNMP_SYNTAX_NULL;
 }
 
+// Argument of rbuild_pdu_vbs
+struct PduVbEncoderArg
+{
+  const Pdu *pdu;
+  bool null_values;    // encode all values as NULL
+  int status;          // error of an unsupported value
+};
+
+// Encode the value of a Vb back to front in front of data
+static unsigned char *rbuild_vb_value(const Vb &vb,
+                                      unsigned char *data, int *datalength,
+                                      int &status)
+{
+  SmiUINT32 syntax = vb.get_syntax();
+  const SnmpSyntax *value = vb.get_value_ptr();
+
+  switch (syntax) {
+
+  case sNMP_SYNTAX_NULL:
+  case sNMP_SYNTAX_NOSUCHOBJECT:
+  case sNMP_SYNTAX_NOSUCHINSTANCE:
+  case sNMP_SYNTAX_ENDOFMIBVIEW:
+    return asn_rbuild_null(data, datalength, (unsigned char)syntax);
+
+  case sNMP_SYNTAX_INT:
+    {
+      long l = 0;
+      vb.get_value(l);
+      return asn_rbuild_int(data, datalength, (unsigned char)syntax, &l);
+    }
+
+  case sNMP_SYNTAX_GAUGE32:
+  case sNMP_SYNTAX_CNTR32:
+  case sNMP_SYNTAX_TIMETICKS:
+    {
+      unsigned long ul = 0;
+      vb.get_value(ul);
+      return asn_rbuild_unsigned_int(data, datalength,
+                                     (unsigned char)syntax, &ul);
+    }
+
+  case sNMP_SYNTAX_CNTR64:
+    {
+      const Counter64 *c64 = (const Counter64 *)value;
+      struct counter64 c;
+      c.high = c64->high();
+      c.low = c64->low();
+      return asn_rbuild_unsigned_int64(data, datalength,
+                                       (unsigned char)syntax, &c);
+    }
+
+  case sNMP_SYNTAX_OCTETS:
+  case sNMP_SYNTAX_OPAQUE:
+    {
+      // encoded directly from the value, without copying it; addresses
+      // report sNMP_SYNTAX_OCTETS too, so they are copied into an OctetStr
+      const OctetStr *os = dynamic_cast<const OctetStr *>(value);
+      if (os)
+        return asn_rbuild_string(data, datalength, (unsigned char)syntax,
+                                 os->data(), (int)os->len());
+      OctetStr copy;
+      vb.get_value(copy);
+      return asn_rbuild_string(data, datalength, (unsigned char)syntax,
+                               copy.data(), (int)copy.len());
+    }
+
+  case sNMP_SYNTAX_BITS:
+  case sNMP_SYNTAX_IPADDR:
+    {
+      OctetStr os;
+      vb.get_value(os);
+      if (syntax == sNMP_SYNTAX_BITS)
+        return asn_rbuild_bitstring(data, datalength, (unsigned char)syntax,
+                                    os.data(), (int)os.len());
+      return asn_rbuild_string(data, datalength, (unsigned char)syntax,
+                               os.data(), (int)os.len());
+    }
+
+  case sNMP_SYNTAX_OID:
+    {
+      const SmiOID *oid = ((const Oid *)value)->oidval();
+      return asn_rbuild_objid(data, datalength, (unsigned char)syntax,
+                              oid->ptr, (int)oid->len);
+    }
+
+  default:
+    status = SNMP_CLASS_INTERNAL_ERROR;
+    return 0;
+  }
+}
+
+// Encode the Vbs of a Pdu back to front (see snmp_vb_encoder)
+static unsigned char *rbuild_pdu_vbs(void *arg,
+                                     unsigned char *data, int *datalength)
+{
+  PduVbEncoderArg *encoder = (PduVbEncoderArg *)arg;
+
+  for (int z = encoder->pdu->get_vb_count() - 1; (z >= 0) && data; z--)
+  {
+    const Vb &vb = encoder->pdu->get_vb(z);
+    int end = *datalength;
+
+    if (encoder->null_values)
+      data = asn_rbuild_null(data, datalength, sNMP_SYNTAX_NULL);
+    else
+      data = rbuild_vb_value(vb, data, datalength, encoder->status);
+    if (!data) break;
+
+    const SmiOID *oid = vb.get_oid().oidval();
+    data = asn_rbuild_objid(data, datalength, ASN_UNI_PRIM | ASN_OBJECT_ID,
+                            oid->ptr, (int)oid->len);
+    if (!data) break;
+
+    data = asn_rbuild_header(data, datalength, ASN_SEQ_CON, end - *datalength);
+  }
+  return data;
+}
+
 #ifdef _SNMPv3
 
 int SnmpMessage::unloadv3(Pdu &pdu,                // Pdu returned
@@ -392,36 +510,16 @@ int SnmpMessage::load(
 
     pdu = &temppdu;          // reassign the pdu to the temp one
   }
-  // load up the payload
-  // for all Vbs in list, add them to the pdu
-  int vb_count;
-  Vb tempvb;
-  Oid tempoid;
-  SmiLPOID smioid;
-  SmiVALUE smival;
-
-  vb_count = pdu->get_vb_count();
-  for (int z=0;z<vb_count;z++) {
-    pdu->get_vb(tempvb,z);
-    tempvb.get_oid(tempoid);
-    smioid = tempoid.oidval();
-    // clear the value portion, in case its
-    // not already been done so by the app writer
-    // only do it in the case its a get,next or bulk
-    if ((raw_pdu->command == sNMP_PDU_GET) ||
-        (raw_pdu->command == sNMP_PDU_GETNEXT) ||
-        (raw_pdu->command == sNMP_PDU_GETBULK))
-      tempvb.set_null();
-    status = convertVbToSmival(tempvb, &smival);
-    if (status != SNMP_CLASS_SUCCESS) {
-      snmp_free_pdu(raw_pdu);
-      return status;
-    }
-    // add the vb to the raw pdu
-    snmp_add_var(raw_pdu, smioid->ptr, (int) smioid->len, &smival);
-
-    freeSmivalDescriptor(&smival);
-  }
+  // the vbs are encoded directly from the pdu when the message is
+  // built, the values of get, getnext and getbulk requests as NULL
+  PduVbEncoderArg vb_encoder_arg;
+  vb_encoder_arg.pdu = pdu;
+  vb_encoder_arg.null_values = ((raw_pdu->command == sNMP_PDU_GET) ||
+                                (raw_pdu->command == sNMP_PDU_GETNEXT) ||
+                                (raw_pdu->command == sNMP_PDU_GETBULK));
+  vb_encoder_arg.status = SNMP_CLASS_SUCCESS;
+  raw_pdu->vb_encoder = rbuild_pdu_vbs;
+  raw_pdu->vb_encoder_arg = &vb_encoder_arg;
 
   // ASN1 encode the pdu
 #ifdef _SNMPv3
@@ -492,6 +590,8 @@ int SnmpMessage::load(
       raw_pdu->enterprise_length=0;
     }
     snmp_free_pdu(raw_pdu);
+    if (vb_encoder_arg.status != SNMP_CLASS_SUCCESS)
+      return vb_encoder_arg.status;
 #ifdef _SNMPv3
     if (version == version3)
       return status;
@@ -550,7 +650,11 @@ int SnmpMessage::unload(Pdu &pdu,                 // Pdu object
   if (!valid_flag)
     return SNMP_CLASS_INVALID;
 
-  snmp_pdu *raw_pdu = snmp_pdu_create(0); // free with snmp_free_pdu(raw_pdu)
+  // free with snmp_free_pdu(raw_pdu)
+  snmp_pdu *raw_pdu = (decode_arena ? snmp_pdu_create_in(decode_arena, 0)
+                                    : snmp_pdu_create(0));
+  if (!raw_pdu)
+    return SNMP_CLASS_RESOURCE_UNAVAIL;
   int status;
 
 #ifdef _SNMPv3
@@ -75,6 +75,163 @@ struct UsmKeyUpdate
   int type;
 };
 
+/* ------------------------- USMTableIndex -------------------------*/
+
+/**
+ * Hash index over the positions of one of the USM tables.
+ *
+ * The tables keep their entries in a plain array, so iterating
+ * through peek_first()/peek_next() and get_entry(number) stays
+ * as it is. Lookups by name or engine id walk only the chain of
+ * one bucket instead of the whole array. The owning table has to
+ * report every position that is added, removed or moved.
+ */
+class USMTableIndex
+{
+public:
+  USMTableIndex()
+    : buckets(0), chain(0), hashes(0), mask(0) {};
+
+  ~USMTableIndex()
+  {
+    if (buckets) delete [] buckets;
+    if (chain)   delete [] chain;
+    if (hashes)  delete [] hashes;
+  };
+
+  /**
+   * Make room for new_capacity positions. The positions
+   * 0...count-1 are kept in the index.
+   *
+   * @return - false if out of memory, the old index is unchanged then
+   */
+  bool reserve(const int new_capacity, const int count);
+
+  /**
+   * Add the entry at position pos with the given hash value.
+   */
+  void add(const int pos, const unsigned int hash);
+
+  /**
+   * Remove the entry at position pos.
+   */
+  void remove(const int pos);
+
+  /**
+   * The entry at position from has been moved to position to,
+   * which must have been removed before.
+   */
+  void move(const int from, const int to);
+
+  /**
+   * Get the first position in the chain of the given hash value, or
+   * -1. The chain may contain entries with other hash values.
+   */
+  int first(const unsigned int hash) const
+    { return (buckets ? buckets[hash & mask] : -1); };
+
+  /**
+   * Get the next position in the same chain, or -1.
+   */
+  int next(const int pos) const { return chain[pos]; };
+
+  /**
+   * Get the hash value of the entry at position pos.
+   */
+  unsigned int hash_of(const int pos) const { return hashes[pos]; };
+
+  /**
+   * FNV-1a hash, pass the result of a previous call as start value
+   * to hash a composite key.
+   */
+  static unsigned int hash(const unsigned char *data, const long len,
+			   unsigned int h = 2166136261U)
+  {
+    for (long i = 0; i < len; ++i)
+      h = (h ^ data[i]) * 16777619U;
+    return h;
+  };
+
+private:
+  int *buckets;          ///< first position of each chain or -1
+  int *chain;            ///< next position in the chain or -1
+  unsigned int *hashes;  ///< hash value of each position
+  unsigned int mask;     ///< number of buckets - 1
+};
+
+bool USMTableIndex::reserve(const int new_capacity, const int count)
+{
+  unsigned int size = 16;
+  while (size < (unsigned int)new_capacity)
+    size <<= 1;
+
+  int *new_buckets = new int[size];
+  int *new_chain = new int[new_capacity];
+  unsigned int *new_hashes = new unsigned int[new_capacity];
+  if (!new_buckets || !new_chain || !new_hashes)
+  {
+    if (new_buckets) delete [] new_buckets;
+    if (new_chain)   delete [] new_chain;
+    if (new_hashes)  delete [] new_hashes;
+    return false;
+  }
+  if (hashes)
+    memcpy(new_hashes, hashes, count * sizeof(unsigned int));
+
+  if (buckets) delete [] buckets;
+  if (chain)   delete [] chain;
+  if (hashes)  delete [] hashes;
+
+  buckets  = new_buckets;
+  chain    = new_chain;
+  hashes   = new_hashes;
+  mask     = size - 1;
+
+  for (unsigned int b = 0; b < size; ++b)
+    buckets[b] = -1;
+  for (int i = count - 1; i >= 0; --i)
+    add(i, hashes[i]);
+
+  return true;
+}
+
+void USMTableIndex::add(const int pos, const unsigned int hash)
+{
+  hashes[pos] = hash;
+  chain[pos] = buckets[hash & mask];
+  buckets[hash & mask] = pos;
+}
+
+void USMTableIndex::remove(const int pos)
+{
+  int *link = &buckets[hashes[pos] & mask];
+  while (*link != -1)
+  {
+    if (*link == pos)
+    {
+      *link = chain[pos];
+      return;
+    }
+    link = &chain[*link];
+  }
+}
+
+void USMTableIndex::move(const int from, const int to)
+{
+  int *link = &buckets[hashes[from] & mask];
+  while (*link != -1)
+  {
+    if (*link == from)
+    {
+      *link = to;
+      chain[to] = chain[from];
+      hashes[to] = hashes[from];
+      return;
+    }
+    link = &chain[*link];
+  }
+}
+
 /* ------------------------- UsmTimeTable --------------------------*/
 
 /**
@@ -203,10 +360,18 @@ private:
     long int latest_received_time;
   };
 
+  /**
+   * Get the position of the entry for the given engine id.
+   *
+   * @return - the position or -1 if not found
+   */
+  int find(const OctetStr &engine_id) const;
+
   struct Entry_T *table; ///< Array of entries
   const USM *usm;  ///< Pointer to the USM, this table belongs to
   int max_entries; ///< the maximum number of entries
   int entries;     ///< the current amount of entries
+  USMTableIndex index; ///< engine_id -> position in table
 };
 
 
@@ -341,10 +506,34 @@ public:
   const UsmUserNameTableEntry *peek_next(const UsmUserNameTableEntry *e) const;
 
 private:
+  /**
+   * Get the position of the entry with the given userName.
+   *
+   * @return - the position or -1 if not found
+   */
+  int find_user_name(const unsigned char *user_name,
+		     const long int user_name_len) const;
+
+  /**
+   * Get the position of an entry with the given securityName.
+   *
+   * @return - the position or -1 if not found
+   */
+  int find_security_name(const unsigned char *security_name,
+			 const long int security_name_len) const;
+
+  /**
+   * Remove the entry at position i from the indexes and move the last
+   * entry to this position. The passwords must have been freed.
+   */
+  void remove_entry(const int i);
+
   struct UsmUserNameTableEntry *table;
 
   int max_entries; ///< the maximum number of entries
   int entries;     ///< the current amount of entries
+  USMTableIndex user_name_index; ///< usmUserName -> position
+  USMTableIndex sec_name_index;  ///< usmUserSecurityName -> position
 };
 
 
@@ -356,7 +545,7 @@ private:
 class USMUserTable : public SnmpSynchronized
 {
 public:
-  USMUserTable(int &result);
+  USMUserTable(AuthPriv *ap, int &result);
 
   ~USMUserTable();
 
@@ -558,10 +747,37 @@ public:
 private:
   void delete_entry(const int nr);
 
+  /**
+   * Get the position of an entry through one of the indexes. The
+   * userName indexes compare the userName, the others the securityName.
+   *
+   * @param index         - the index to use
+   * @param engine_id     - the engine id or NULL for the name only indexes
+   * @param engine_id_len - length of the engine id
+   * @param name          - the userName or securityName to search for
+   * @param name_len      - length of the name
+   *
+   * @return - the position or -1 if not found
+   */
+  int find(const USMTableIndex &index,
+	   const unsigned char *engine_id, const long engine_id_len,
+	   const unsigned char *name, const long name_len) const;
+
+  /**
+   * Add the entry at position i to all indexes.
+   */
+  void index_entry(const int i);
+
+  AuthPriv *auth_priv; ///< used to precompute the HMAC key states
   struct UsmUserTableEntry *table;
 
   int max_entries; ///< the maximum number of entries
   int entries;     ///< the current amount of entries
+
+  USMTableIndex engine_sec_index;  ///< (engineID, securityName) -> position
+  USMTableIndex engine_user_index; ///< (engineID, userName) -> position
+  USMTableIndex sec_index;         ///< securityName -> position
+  USMTableIndex user_index;        ///< userName -> position
 };
 
 
@@ -589,6 +805,7 @@ struct SecurityStateReference
   unsigned char *securityEngineID;                int securityEngineIDLength;
   int authProtocol;
   unsigned char* authKey;                         int authKeyLength;
+  const AuthKeyState *authKeyState;
   int privProtocol;
   unsigned char* privKey;                         int privKeyLength;
   int securityLevel;
@@ -599,50 +816,38 @@ struct SecurityStateReference
 
 void USM::inc_stats_unsupported_sec_levels()
 {
-  if (usmStatsUnsupportedSecLevels == MAXUINT32)
-    usmStatsUnsupportedSecLevels = 0;
-  else
-    usmStatsUnsupportedSecLevels++;
+  // wraps from MAXUINT32 to 0
+  usmStatsUnsupportedSecLevels.fetch_add(1, std::memory_order_relaxed);
 }
 
 void USM::inc_stats_not_in_time_windows()
 {
-  if (usmStatsNotInTimeWindows == MAXUINT32)
-    usmStatsNotInTimeWindows = 0;
-  else
-    usmStatsNotInTimeWindows++;
+  // wraps from MAXUINT32 to 0
+  usmStatsNotInTimeWindows.fetch_add(1, std::memory_order_relaxed);
 }
 
 void USM::inc_stats_unknown_user_names()
 {
-  if (usmStatsUnknownUserNames == MAXUINT32)
-    usmStatsUnknownUserNames = 0;
-  else
-    usmStatsUnknownUserNames++;
+  // wraps from MAXUINT32 to 0
+  usmStatsUnknownUserNames.fetch_add(1, std::memory_order_relaxed);
 }
 
 void USM::inc_stats_unknown_engine_ids()
 {
-  if (usmStatsUnknownEngineIDs == MAXUINT32)
-    usmStatsUnknownEngineIDs = 0;
-  else
-    usmStatsUnknownEngineIDs++;
+  // wraps from MAXUINT32 to 0
+  usmStatsUnknownEngineIDs.fetch_add(1, std::memory_order_relaxed);
 }
 
 void USM::inc_stats_wrong_digests()
 {
-  if (usmStatsWrongDigests == MAXUINT32)
-    usmStatsWrongDigests = 0;
-  else
-    usmStatsWrongDigests++;
+  // wraps from MAXUINT32 to 0
+  usmStatsWrongDigests.fetch_add(1, std::memory_order_relaxed);
 }
 
 void USM::inc_stats_decryption_errors()
 {
-  if (usmStatsDecryptionErrors == MAXUINT32)
-    usmStatsDecryptionErrors = 0;
-  else
-    usmStatsDecryptionErrors++;
+  // wraps from MAXUINT32 to 0
+  usmStatsDecryptionErrors.fetch_add(1, std::memory_order_relaxed);
 }
 
 
@@ -658,6 +863,7 @@ void USM::delete_sec_state_reference(struct SecurityStateReference *ssr)
       memset(ssr->authKey, 0, ssr->authKeyLength);
       delete [] ssr->authKey;
     }
+    AuthKeyState::unref(ssr->authKeyState);
     if (ssr->privKey)
     {
       memset(ssr->privKey, 0, ssr->privKeyLength);
@@ -705,7 +911,7 @@ USM::USM(unsigned int engine_boots, const OctetStr &engine_id,
   if (result != SNMPv3_USM_OK)
     return;
 
-  usm_user_table = new USMUserTable(result);
+  usm_user_table = new USMUserTable(auth_priv, result);
   if (result != SNMPv3_USM_OK)
     return;
 
@@ -753,7 +959,7 @@ int USM::remove_all_users() {
   if (result != SNMPv3_USM_OK)
     return result;
 
-  usm_user_table = new USMUserTable(result);
+  usm_user_table = new USMUserTable(auth_priv, result);
   return result;  
 }
 
@@ -1000,6 +1206,7 @@ struct UsmUser *USM::get_user(const OctetStr &engine_id,
         res->securityNameLength = entry->usmUserSecurityNameLength;
         res->authProtocol = SNMP_AUTHPROTOCOL_NONE;
         res->authKey = 0;        res->authKeyLength = 0;
+        res->authKeyState = 0;
         res->privProtocol = SNMP_PRIVPROTOCOL_NONE;
         res->privKey = 0;        res->privKeyLength = 0;
 
@@ -1038,6 +1245,7 @@ struct UsmUser *USM::get_user(const OctetStr &engine_id,
       res->authProtocol       = SNMP_AUTHPROTOCOL_NONE;
       res->authKey            = 0;
       res->authKeyLength      = 0;
+      res->authKeyState       = 0;
       res->privProtocol       = SNMP_PRIVPROTOCOL_NONE;
       res->privKey            = 0;
       res->privKeyLength      = 0;
@@ -1131,6 +1339,7 @@ struct UsmUser *USM::get_user(const OctetStr &engine_id,
   res->authProtocol       = user_table_entry->usmUserAuthProtocol;
   res->authKey            = user_table_entry->usmUserAuthKey;
   res->authKeyLength      = user_table_entry->usmUserAuthKeyLength;
+  res->authKeyState       = user_table_entry->usmUserAuthKeyState;
   res->privProtocol       = user_table_entry->usmUserPrivProtocol;
   res->privKey            = user_table_entry->usmUserPrivKey;
   res->privKeyLength      = user_table_entry->usmUserPrivKeyLength;
@@ -1139,6 +1348,7 @@ struct UsmUser *USM::get_user(const OctetStr &engine_id,
   user_table_entry->usmUserName = 0;
   user_table_entry->usmUserSecurityName = 0;
   user_table_entry->usmUserAuthKey = 0;
+  user_table_entry->usmUserAuthKeyState = 0;
   user_table_entry->usmUserPrivKey = 0;
 
   usm_user_table->delete_cloned_entry(user_table_entry);
@@ -1160,6 +1370,7 @@ void USM::free_user(struct UsmUser *&user)
     memset(user->authKey, 0, user->authKeyLength);
     delete [] user->authKey;
   }
+  AuthKeyState::unref(user->authKeyState);
 
   if (user->privKey)
   {
@@ -1653,6 +1864,7 @@ int USM::generate_msg(
     user->authProtocol       = securityStateReference->authProtocol;
     user->authKey            = securityStateReference->authKey;
     user->authKeyLength      = securityStateReference->authKeyLength;
+    user->authKeyState       = securityStateReference->authKeyState;
     user->privProtocol       = securityStateReference->privProtocol;
     user->privKeyLength      = securityStateReference->privKeyLength;
     user->privKey            = securityStateReference->privKey;
@@ -1831,10 +2043,16 @@ int USM::generate_msg(
     }
     *wholeMsgLength = SAFE_INT_CAST(wholeMsgPtr - wholeMsg);
 
-    rc = auth_priv->auth_out_msg(user->authProtocol,
-                                 user->authKey,
-                                 wholeMsg, *wholeMsgLength,
-                                 wholeMsg + startAuthPar);
+    if (user->authKeyState)
+      rc = auth_priv->auth_out_msg(user->authProtocol,
+                                   user->authKeyState,
+                                   wholeMsg, *wholeMsgLength,
+                                   wholeMsg + startAuthPar);
+    else
+      rc = auth_priv->auth_out_msg(user->authProtocol,
+                                   user->authKey,
+                                   wholeMsg, *wholeMsgLength,
+                                   wholeMsg + startAuthPar);
 
     if (rc!=SNMPv3_USM_OK)
     {
@@ -2018,6 +2236,7 @@ int USM::process_msg(
   securityStateReference->authProtocol = 1;
   securityStateReference->privProtocol = 1;
   securityStateReference->authKey = NULL;
+  securityStateReference->authKeyState = NULL;
   securityStateReference->privKey = NULL;
 
   // in case we return with error,
@@ -2098,11 +2317,18 @@ int USM::process_msg(
 
   if (securityLevel > SNMP_SECURITY_LEVEL_NOAUTH_NOPRIV)
   {
-    rc = auth_priv->auth_inc_msg(user->authProtocol,
-                                 user->authKey,
-                                 wholeMsg, wholeMsgLength,
-                                 wholeMsg + authParametersPosition,
-				 authParamLength);
+    if (user->authKeyState)
+      rc = auth_priv->auth_inc_msg(user->authProtocol,
+                                   user->authKeyState,
+                                   wholeMsg, wholeMsgLength,
+                                   wholeMsg + authParametersPosition,
+                                   authParamLength);
+    else
+      rc = auth_priv->auth_inc_msg(user->authProtocol,
+                                   user->authKey,
+                                   wholeMsg, wholeMsgLength,
+                                   wholeMsg + authParametersPosition,
+                                   authParamLength);
     if (rc != SNMPv3_USM_OK)
     {
       switch (rc)
@@ -2132,11 +2358,13 @@ int USM::process_msg(
 
       securityStateReference->authKeyLength = user->authKeyLength;
       securityStateReference->authKey = user->authKey;
+      securityStateReference->authKeyState = user->authKeyState;
 
       securityStateReference->privKeyLength = user->privKeyLength;
       securityStateReference->privKey = user->privKey;
 
       user->authKey = 0;
+      user->authKeyState = 0;
       user->privKey = 0;
 
       free_user(user);
@@ -2231,11 +2459,13 @@ int USM::process_msg(
 
   securityStateReference->authKeyLength = user->authKeyLength;
   securityStateReference->authKey = user->authKey;
+  securityStateReference->authKeyState = user->authKeyState;
 
   securityStateReference->privKeyLength = user->privKeyLength;
   securityStateReference->privKey = user->privKey;
 
   user->authKey = 0;
+  user->authKeyState = 0;
   user->privKey = 0;
 
   free_user(user);
@@ -2462,6 +2692,8 @@ inline void USM::delete_user_ptr(struct UsmUser *user)
     delete [] user->authKey;
     user->authKey = NULL;
   }
+  AuthKeyState::unref(user->authKeyState);
+  user->authKeyState = NULL;
   if (user->privKey) {
     memset(user->privKey, 0, user->privKeyLength);
     delete [] user->privKey;
@@ -2551,12 +2783,17 @@ USMTimeTable::USMTimeTable(const USM *owner,
 
   table = new struct Entry_T[5];
 
-  if (!table)
+  if (!table || !index.reserve(5, 0))
   {
     LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
     LOG("USMTimeTable: error constructing table.");
     LOG_END;
 
+    if (table)
+    {
+      delete [] table;
+      table = NULL;
+    }
     result = SNMPv3_USM_ERROR;
     return;
   }
@@ -2572,6 +2809,8 @@ USMTimeTable::USMTimeTable(const USM *owner,
 			       MAXLENGTH_ENGINEID);
   memcpy(table[0].engine_id, usm->get_local_engine_id().data(),
 	 table[0].engine_id_len);
+  index.add(0, USMTableIndex::hash(table[0].engine_id,
+				   table[0].engine_id_len));
 
   entries = 1;
   max_entries = 5;
@@ -2614,6 +2853,12 @@ int USMTimeTable::add_entry(const OctetStr &engine_id,
     if (!tmp)
       return SNMPv3_USM_ERROR;
 
+    if (!index.reserve(4 * max_entries, entries))
+    {
+      delete [] tmp;
+      return SNMPv3_USM_ERROR;
+    }
+
     memcpy(tmp, table, entries * sizeof(Entry_T));
 
     struct Entry_T *victim = table;
@@ -2634,6 +2879,8 @@ int USMTimeTable::add_entry(const OctetStr &engine_id,
                                      MAXLENGTH_ENGINEID);
   memcpy(table[entries].engine_id,
 	 engine_id.data(), table[entries].engine_id_len);
+  index.add(entries, USMTableIndex::hash(table[entries].engine_id,
+					 table[entries].engine_id_len));
 
   entries++;
 
@@ -2653,21 +2900,35 @@ int USMTimeTable::delete_entry(const OctetStr &engine_id)
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=1; i < entries; i++) /* start from 1 */
-    if (unsignedCharCompare(table[i].engine_id, table[i].engine_id_len,
-                            engine_id.data(), engine_id.len()))
+  int i = find(engine_id);
+  if (i > 0) /* never delete the local engine id at position 0 */
+  {
+    index.remove(i);
+    if (i != entries - 1)
     {
-      if (i != entries - 1)
-	table[i] = table[entries - 1];
-
-      entries--;
-
-      return SNMPv3_USM_OK;
+      table[i] = table[entries - 1];
+      index.move(entries - 1, i);
     }
 
+    entries--;
+  }
+
   return SNMPv3_USM_OK;
 }
 
+int USMTimeTable::find(const OctetStr &engine_id) const
+{
+  unsigned int h = USMTableIndex::hash(engine_id.data(), engine_id.len());
+
+  for (int i = index.first(h); i >= 0; i = index.next(i))
+    if ((index.hash_of(i) == h) &&
+	unsignedCharCompare(table[i].engine_id, table[i].engine_id_len,
+			    engine_id.data(), engine_id.len()))
+      return i;
+
+  return -1;
+}
+
 unsigned long USMTimeTable::get_local_time()
 {
   if (!table)
@@ -2712,26 +2973,25 @@ int USMTimeTable::get_time(const OctetStr &engine_id,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i < entries; i++)
-    if (unsignedCharCompare(table[i].engine_id, table[i].engine_id_len,
-                            engine_id.data(), engine_id.len()))
-    {
-      /* Entry found */
-      time_t now;
-      time(&now);
+  int i = find(engine_id);
+  if (i >= 0)
+  {
+    /* Entry found */
+    time_t now;
+    time(&now);
 
-      engine_boots = table[i].engine_boots;
-      engine_time  = table[i].time_diff + SAFE_ULONG_CAST(now);
+    engine_boots = table[i].engine_boots;
+    engine_time  = table[i].time_diff + SAFE_ULONG_CAST(now);
 
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 4);
-      LOG("USMTimeTable: Returning time (engine id) (boot) (time)");
-      LOG(engine_id.get_printable());
-      LOG(engine_boots);
-      LOG(engine_time);
-      LOG_END;
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 4);
+    LOG("USMTimeTable: Returning time (engine id) (boot) (time)");
+    LOG(engine_id.get_printable());
+    LOG(engine_boots);
+    LOG(engine_time);
+    LOG_END;
 
-      return SNMPv3_USM_OK;
-    }
+    return SNMPv3_USM_OK;
+  }
 
   /* no entry */
   engine_boots = 0;
@@ -2758,9 +3018,10 @@ int USMTimeTable::check_time(const OctetStr &engine_id,
   time_t now;
   time(&now);
 
+  int i = find(engine_id);
+
   /* table[0] contains the local engine_id and time */
-  if (unsignedCharCompare(table[0].engine_id, table[0].engine_id_len,
-                          engine_id.data(), engine_id.len()))
+  if (i == 0)
   {
     /* Entry found, we are authoritative */
     if ((table[0].engine_boots == 2147483647) ||
@@ -2787,43 +3048,41 @@ int USMTimeTable::check_time(const OctetStr &engine_id,
     }
   }
 
-  for (int i=1; i < entries; i++)
-    if (unsignedCharCompare(table[i].engine_id, table[i].engine_id_len,
-                            engine_id.data(), engine_id.len()))
+  if (i > 0)
+  {
+    /* Entry found we are not authoritative */
+    if ((engine_boots < table[i].engine_boots) ||
+	((engine_boots == table[i].engine_boots) &&
+	 (table[i].time_diff + now > engine_time + 150)) ||
+	(table[i].engine_boots == 2147483647))
     {
-      /* Entry found we are not authoritative */
-      if ((engine_boots < table[i].engine_boots) ||
-          ((engine_boots == table[i].engine_boots) &&
-           (table[i].time_diff + now > engine_time + 150)) ||
-          (table[i].engine_boots == 2147483647))
-      {
-	LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
-	LOG("USMTimeTable: Check time failed, not authoritative (id)");
-	LOG(engine_id.get_printable());
-	LOG_END;
+      LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
+      LOG("USMTimeTable: Check time failed, not authoritative (id)");
+      LOG(engine_id.get_printable());
+      LOG_END;
 
-        return SNMPv3_USM_NOT_IN_TIME_WINDOW;
-      }
-      else
+      return SNMPv3_USM_NOT_IN_TIME_WINDOW;
+    }
+    else
+    {
+      if ((engine_boots > table[i].engine_boots) ||
+	  ((engine_boots == table[i].engine_boots) &&
+	   (engine_time > table[i].latest_received_time)))
       {
-        if ((engine_boots > table[i].engine_boots) ||
-            ((engine_boots == table[i].engine_boots) &&
-             (engine_time > table[i].latest_received_time)))
-        {
-          /* time ok, update values */
-          table[i].engine_boots = engine_boots;
-          table[i].latest_received_time  = engine_time;
-          table[i].time_diff = engine_time - SAFE_ULONG_CAST(now);
-        }
+	/* time ok, update values */
+	table[i].engine_boots = engine_boots;
+	table[i].latest_received_time  = engine_time;
+	table[i].time_diff = engine_time - SAFE_ULONG_CAST(now);
+      }
 
-	LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
-	LOG("USMTimeTable: Check time ok, not authoritative, updated (id)");
-	LOG(engine_id.get_printable());
-	LOG_END;
+      LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
+      LOG("USMTimeTable: Check time ok, not authoritative, updated (id)");
+      LOG(engine_id.get_printable());
+      LOG_END;
 
-        return SNMPv3_USM_OK;
-      }
+      return SNMPv3_USM_OK;
     }
+  }
 
   LOG_BEGIN(loggerModuleName, DEBUG_LOG | 9);
   LOG("USMTimeTable: Check time, engine id not found");
@@ -2843,10 +3102,8 @@ int USMTimeTable::check_engine_id(const OctetStr &engine_id)
     // Begin reentrant code block
     BEGIN_REENTRANT_CODE_BLOCK;
 
-    for (int i=0; i < entries; i++)
-      if (unsignedCharCompare(table[i].engine_id, table[i].engine_id_len,
-			      engine_id.data(), engine_id.len()))
-	return SNMPv3_USM_OK;
+    if (find(engine_id) >= 0)
+      return SNMPv3_USM_OK;
   }
 
   /* if in discovery mode:  accept all EngineID's (rfc2264 page 26) */
@@ -2869,8 +3126,14 @@ USMUserNameTable::USMUserNameTable(int &result)
 {
   /* init Table */
   table = new struct UsmUserNameTableEntry[10];
-  if (!table)
+  if (!table ||
+      !user_name_index.reserve(10, 0) || !sec_name_index.reserve(10, 0))
   {
+    if (table)
+    {
+      delete [] table;
+      table = NULL;
+    }
     result = SNMPv3_USM_ERROR;
     return;
   }
@@ -2916,19 +3179,15 @@ int USMUserNameTable::add_entry(const OctetStr& user_name,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  int found=0;
-  int i;
-  for (i = 0; i < entries; i++)
-    if (table[i].usmUserName == user_name)
-    {
-      found=1;
-      break;
-    }
+  int i = find_user_name(user_name.data(), user_name.len());
 
-  if (found)
+  if (i >= 0)
   {
     /* replace user */
+    sec_name_index.remove(i);
     table[i].usmUserSecurityName = security_name;
+    sec_name_index.add(i, USMTableIndex::hash(security_name.data(),
+					      security_name.len()));
     table[i].usmUserAuthProtocol = auth_proto;
     table[i].usmUserPrivProtocol = priv_proto;
 
@@ -2957,6 +3216,12 @@ int USMUserNameTable::add_entry(const OctetStr& user_name,
       tmp = new struct UsmUserNameTableEntry[4 * max_entries];
       if (!tmp)
         return SNMPv3_USM_ERROR;
+      if (!user_name_index.reserve(4 * max_entries, entries) ||
+          !sec_name_index.reserve(4 * max_entries, entries))
+      {
+        delete [] tmp;
+        return SNMPv3_USM_ERROR;
+      }
       for (i=0; i < entries; i++)
         tmp[i] = table[i];
 
@@ -2982,6 +3247,10 @@ int USMUserNameTable::add_entry(const OctetStr& user_name,
     if (!table[entries].privPassword)
       return SNMPv3_USM_ERROR;
 
+    user_name_index.add(entries, USMTableIndex::hash(user_name.data(),
+						     user_name.len()));
+    sec_name_index.add(entries, USMTableIndex::hash(security_name.data(),
+						    security_name.len()));
     entries++;
   }
 
@@ -2995,30 +3264,68 @@ int USMUserNameTable::delete_security_name(const OctetStr& security_name)
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++)
-    if (table[i].usmUserSecurityName == security_name)
-    {
-      memset(table[i].authPassword, 0, table[i].authPasswordLength);
-      delete [] table[i].authPassword;
-      memset(table[i].privPassword, 0, table[i].privPasswordLength);
-      delete [] table[i].privPassword;
-      entries--;
-      if (entries > i)
-        table[i] = table[entries];
-      break;
-    }
+  int i = find_security_name(security_name.data(), security_name.len());
+  if (i >= 0)
+  {
+    memset(table[i].authPassword, 0, table[i].authPasswordLength);
+    delete [] table[i].authPassword;
+    memset(table[i].privPassword, 0, table[i].privPasswordLength);
+    delete [] table[i].privPassword;
+    remove_entry(i);
+  }
   return SNMPv3_USM_OK;
 }
 
+void USMUserNameTable::remove_entry(const int i)
+{
+  user_name_index.remove(i);
+  sec_name_index.remove(i);
+  entries--;
+  if (entries > i)
+  {
+    table[i] = table[entries];
+    user_name_index.move(entries, i);
+    sec_name_index.move(entries, i);
+  }
+}
+
+int USMUserNameTable::find_user_name(const unsigned char *user_name,
+				     const long int user_name_len) const
+{
+  unsigned int h = USMTableIndex::hash(user_name, user_name_len);
+
+  for (int i = user_name_index.first(h); i >= 0; i = user_name_index.next(i))
+    if ((user_name_index.hash_of(i) == h) &&
+	unsignedCharCompare(table[i].usmUserName.data(),
+			    table[i].usmUserName.len(),
+			    user_name, user_name_len))
+      return i;
+  return -1;
+}
+
+int USMUserNameTable::find_security_name(const unsigned char *security_name,
+					 const long int security_name_len) const
+{
+  unsigned int h = USMTableIndex::hash(security_name, security_name_len);
+
+  for (int i = sec_name_index.first(h); i >= 0; i = sec_name_index.next(i))
+    if ((sec_name_index.hash_of(i) == h) &&
+	unsignedCharCompare(table[i].usmUserSecurityName.data(),
+			    table[i].usmUserSecurityName.len(),
+			    security_name, security_name_len))
+      return i;
+  return -1;
+}
+
 const struct UsmUserNameTableEntry* USMUserNameTable::get_entry(
                                           const OctetStr &security_name)
 {
   if (!table)
     return NULL;
 
-  for (int i = 0; i < entries; i++)
-    if (table[i].usmUserSecurityName == security_name)
-      return &table[i];
+  int i = find_security_name(security_name.data(), security_name.len());
+  if (i >= 0)
+    return &table[i];
   return NULL;
 }
 
@@ -3086,21 +3393,19 @@ int USMUserNameTable::get_security_name(const unsigned char *user_name,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserName.data(),
-			    table[i].usmUserName.len(),
-                            user_name, user_name_len))
-    {
-      security_name = table[i].usmUserSecurityName;
+  int i = find_user_name(user_name, user_name_len);
+  if (i >= 0)
+  {
+    security_name = table[i].usmUserSecurityName;
 
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
-      LOG("USMUserNameTable: Translated (user name) to (security name)");
-      LOG(table[i].usmUserName.get_printable());
-      LOG(security_name.get_printable());
-      LOG_END;
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
+    LOG("USMUserNameTable: Translated (user name) to (security name)");
+    LOG(table[i].usmUserName.get_printable());
+    LOG(security_name.get_printable());
+    LOG_END;
 
-      return SNMPv3_USM_OK;
-    }
+    return SNMPv3_USM_OK;
+  }
 
   if (user_name_len != 0)
   {
@@ -3125,33 +3430,30 @@ int USMUserNameTable::get_user_name(unsigned char *user_name,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++) {
-    if (unsignedCharCompare(table[i].usmUserSecurityName.data(),
-                            table[i].usmUserSecurityName.len(),
-                            security_name, security_name_len))
+  int i = find_security_name(security_name, security_name_len);
+  if (i >= 0)
+  {
+    if (buf_len < table[i].usmUserName.len())
     {
-      if (buf_len < table[i].usmUserName.len())
-      {
-          LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
-          LOG("USMUserNameTable: Buffer for user name too small (is) (should)");
-          LOG(buf_len);
-          LOG(table[i].usmUserName.len());
-          LOG_END;
-
-        return SNMPv3_USM_ERROR;
-      }
-      *user_name_len = table[i].usmUserName.len();
-      memcpy(user_name, table[i].usmUserName.data(),
-	     table[i].usmUserName.len());
-
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
-      LOG("USMUserNameTable: Translated (security name) to (user name)");
-      LOG(table[i].usmUserSecurityName.get_printable());
-      LOG(table[i].usmUserName.get_printable());
+      LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+      LOG("USMUserNameTable: Buffer for user name too small (is) (should)");
+      LOG(buf_len);
+      LOG(table[i].usmUserName.len());
       LOG_END;
 
-      return SNMPv3_USM_OK;
+      return SNMPv3_USM_ERROR;
     }
+    *user_name_len = table[i].usmUserName.len();
+    memcpy(user_name, table[i].usmUserName.data(),
+	   table[i].usmUserName.len());
+
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
+    LOG("USMUserNameTable: Translated (security name) to (user name)");
+    LOG(table[i].usmUserSecurityName.get_printable());
+    LOG(table[i].usmUserName.get_printable());
+    LOG_END;
+
+    return SNMPv3_USM_OK;
   }
   if (security_name_len != 0)
   {
@@ -3448,19 +3750,79 @@ const UsmUserNameTableEntry *USMUserNameTable::peek_next(
 
 /* ---------------------------- USMUserTable ------------------- */
 
-USMUserTable::USMUserTable(int &result)
+USMUserTable::USMUserTable(AuthPriv *ap, int &result)
+  : auth_priv(ap)
 {
   entries = 0;
 
   table = new struct UsmUserTableEntry[10];
-  if (!table)
+  if (!table ||
+      !engine_sec_index.reserve(10, 0) || !engine_user_index.reserve(10, 0) ||
+      !sec_index.reserve(10, 0) || !user_index.reserve(10, 0))
   {
+    if (table)
+    {
+      delete [] table;
+      table = NULL;
+    }
     result = SNMPv3_USM_ERROR;
     return;
   }
   max_entries = 10;
 }
 
+int USMUserTable::find(const USMTableIndex &index,
+		       const unsigned char *engine_id,
+		       const long engine_id_len,
+		       const unsigned char *name, const long name_len) const
+{
+  unsigned int h = USMTableIndex::hash(name, name_len,
+				       (engine_id
+					? USMTableIndex::hash(engine_id,
+							      engine_id_len)
+					: 2166136261U));
+  bool user_name = ((&index == &engine_user_index) || (&index == &user_index));
+
+  for (int i = index.first(h); i >= 0; i = index.next(i))
+  {
+    if (index.hash_of(i) != h)
+      continue;
+    if (user_name)
+    {
+      if (!unsignedCharCompare(table[i].usmUserName,
+			       table[i].usmUserNameLength, name, name_len))
+	continue;
+    }
+    else if (!unsignedCharCompare(table[i].usmUserSecurityName,
+				  table[i].usmUserSecurityNameLength,
+				  name, name_len))
+      continue;
+    if (engine_id &&
+	!unsignedCharCompare(table[i].usmUserEngineID,
+			     table[i].usmUserEngineIDLength,
+			     engine_id, engine_id_len))
+      continue;
+    return i;
+  }
+  return -1;
+}
+
+void USMUserTable::index_entry(const int i)
+{
+  unsigned int e = USMTableIndex::hash(table[i].usmUserEngineID,
+				       table[i].usmUserEngineIDLength);
+
+  engine_sec_index.add(i, USMTableIndex::hash(table[i].usmUserSecurityName,
+					      table[i].usmUserSecurityNameLength,
+					      e));
+  engine_user_index.add(i, USMTableIndex::hash(table[i].usmUserName,
+					       table[i].usmUserNameLength, e));
+  sec_index.add(i, USMTableIndex::hash(table[i].usmUserSecurityName,
+				       table[i].usmUserSecurityNameLength));
+  user_index.add(i, USMTableIndex::hash(table[i].usmUserName,
+					table[i].usmUserNameLength));
+}
+
 USMUserTable::~USMUserTable()
 {
   if (table)
@@ -3478,6 +3840,7 @@ USMUserTable::~USMUserTable()
 	memset(table[i].usmUserAuthKey, 0, table[i].usmUserAuthKeyLength);
 	delete [] table[i].usmUserAuthKey;
       }
+      AuthKeyState::unref(table[i].usmUserAuthKeyState);
       if (table[i].usmUserPrivKey)
       {
 	memset(table[i].usmUserPrivKey, 0, table[i].usmUserPrivKeyLength);
@@ -3505,32 +3868,29 @@ int USMUserTable::get_user_name(unsigned char       *user_name,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i < entries; i++) {
-    if (unsignedCharCompare(table[i].usmUserSecurityName,
-			    table[i].usmUserSecurityNameLength,
-			    sec_name, sec_name_len))
+  int i = find(sec_index, NULL, 0, sec_name, sec_name_len);
+  if (i >= 0)
+  {
+    if (buf_len < table[i].usmUserNameLength)
     {
-      if (buf_len < table[i].usmUserNameLength)
-      {
-	LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
-	LOG("USMUserTable: Buffer for user name too small (is) (should)");
-	LOG(buf_len);
-	LOG(table[i].usmUserNameLength);
-	LOG_END;
-
-	return SNMPv3_USM_ERROR;
-      }
-      *user_name_len = table[i].usmUserNameLength;
-      memcpy(user_name, table[i].usmUserName, table[i].usmUserNameLength);
-
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
-      LOG("USMUserTable: Translated (security name) to (user name)");
-      LOG(OctetStr(sec_name, sec_name_len).get_printable());
-      LOG(OctetStr(table[i].usmUserName, table[i].usmUserNameLength).get_printable());
+      LOG_BEGIN(loggerModuleName, ERROR_LOG | 1);
+      LOG("USMUserTable: Buffer for user name too small (is) (should)");
+      LOG(buf_len);
+      LOG(table[i].usmUserNameLength);
       LOG_END;
 
-      return SNMPv3_USM_OK;
+      return SNMPv3_USM_ERROR;
     }
+    *user_name_len = table[i].usmUserNameLength;
+    memcpy(user_name, table[i].usmUserName, table[i].usmUserNameLength);
+
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
+    LOG("USMUserTable: Translated (security name) to (user name)");
+    LOG(OctetStr(sec_name, sec_name_len).get_printable());
+    LOG(OctetStr(table[i].usmUserName, table[i].usmUserNameLength).get_printable());
+    LOG_END;
+
+    return SNMPv3_USM_OK;
   }
   if (sec_name_len != 0)
   {
@@ -3551,20 +3911,18 @@ int USMUserTable::get_security_name(const unsigned char *user_name,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i=0; i < entries; i++) {
-    if (unsignedCharCompare(table[i].usmUserName, table[i].usmUserNameLength,
-			    user_name, user_name_len))
-    {
-      sec_name.set_data(table[i].usmUserSecurityName,
-			table[i].usmUserSecurityNameLength);
-      LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
-      LOG("USMUserTable: Translated (user name) to (security name)");
-      LOG(OctetStr(table[i].usmUserName, table[i].usmUserNameLength).get_printable());
-      LOG(sec_name.get_printable());
-      LOG_END;
+  int i = find(user_index, NULL, 0, user_name, user_name_len);
+  if (i >= 0)
+  {
+    sec_name.set_data(table[i].usmUserSecurityName,
+		      table[i].usmUserSecurityNameLength);
+    LOG_BEGIN(loggerModuleName, INFO_LOG | 9);
+    LOG("USMUserTable: Translated (user name) to (security name)");
+    LOG(OctetStr(table[i].usmUserName, table[i].usmUserNameLength).get_printable());
+    LOG(sec_name.get_printable());
+    LOG_END;
 
-      return SNMPv3_USM_OK;
-    }
+    return SNMPv3_USM_OK;
   }
 
   LOG_BEGIN(loggerModuleName, INFO_LOG | 5);
@@ -3582,14 +3940,10 @@ int USMUserTable::delete_entries(const OctetStr& user_name)
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserName, table[i].usmUserNameLength,
-			    user_name.data(), user_name.len()))
-    {
-      /* delete this entry and recheck this position */
-      delete_entry(i);
-      i--;
-    }
+  int i;
+  while ((i = find(user_index, NULL, 0,
+		   user_name.data(), user_name.len())) >= 0)
+    delete_entry(i);
   return SNMPv3_USM_OK;
 }
 
@@ -3621,17 +3975,10 @@ int USMUserTable::delete_entry(const OctetStr& engine_id,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserName, table[i].usmUserNameLength,
-			    user_name.data(), user_name.len()))
-      if (unsignedCharCompare(table[i].usmUserEngineID,
-			      table[i].usmUserEngineIDLength,
-			      engine_id.data(), engine_id.len()))
-      {
-	/* delete this entry and recheck this position*/
-	delete_entry(i);
-	i--;
-      }
+  int i;
+  while ((i = find(engine_user_index, engine_id.data(), engine_id.len(),
+		   user_name.data(), user_name.len())) >= 0)
+    delete_entry(i);
   return SNMPv3_USM_OK;
 }
 
@@ -3649,14 +3996,10 @@ const struct UsmUserTableEntry *USMUserTable::get_entry(const OctetStr &engine_i
   if (!table)
     return NULL;
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserSecurityName,
-			    table[i].usmUserSecurityNameLength,
-			    sec_name.data(), sec_name.len()))
-      if (unsignedCharCompare(table[i].usmUserEngineID,
-			      table[i].usmUserEngineIDLength,
-			      engine_id.data(), engine_id.len()))
-	return &table[i];
+  int i = find(engine_sec_index, engine_id.data(), engine_id.len(),
+	       sec_name.data(), sec_name.len());
+  if (i >= 0)
+    return &table[i];
   return NULL;
 }
 
@@ -3688,6 +4031,9 @@ struct UsmUserTableEntry *USMUserTable::get_cloned_entry(
     res->usmUserAuthKey        = v3strcpy(e->usmUserAuthKey,
 					  e->usmUserAuthKeyLength);
     res->usmUserAuthKeyLength  = e->usmUserAuthKeyLength;
+    res->usmUserAuthKeyState   = e->usmUserAuthKeyState;
+    if (res->usmUserAuthKeyState)
+      res->usmUserAuthKeyState->ref();
     res->usmUserPrivProtocol   = e->usmUserPrivProtocol;
     res->usmUserPrivKey        = v3strcpy(e->usmUserPrivKey,
 					  e->usmUserPrivKeyLength);
@@ -3720,6 +4066,7 @@ void USMUserTable::delete_cloned_entry(struct UsmUserTableEntry* &entry)
     memset(entry->usmUserAuthKey, 0, entry->usmUserAuthKeyLength);
     delete [] entry->usmUserAuthKey;
   }
+  AuthKeyState::unref(entry->usmUserAuthKeyState);
 
   if (entry->usmUserPrivKey)
   {
@@ -3738,11 +4085,9 @@ const struct UsmUserTableEntry *USMUserTable::get_entry(const OctetStr &sec_name
   if (!table)
     return NULL;
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserSecurityName,
-			    table[i].usmUserSecurityNameLength,
-			    sec_name.data(), sec_name.len()))
-      return &table[i];
+  int i = find(sec_index, NULL, 0, sec_name.data(), sec_name.len());
+  if (i >= 0)
+    return &table[i];
   return NULL;
 }
 
@@ -3771,6 +4116,14 @@ int USMUserTable::add_entry(
     struct UsmUserTableEntry *tmp;
     tmp = new struct UsmUserTableEntry[4 * max_entries];
     if (!tmp) return SNMPv3_USM_ERROR;
+    if (!engine_sec_index.reserve(4 * max_entries, entries) ||
+	!engine_user_index.reserve(4 * max_entries, entries) ||
+	!sec_index.reserve(4 * max_entries, entries) ||
+	!user_index.reserve(4 * max_entries, entries))
+    {
+      delete [] tmp;
+      return SNMPv3_USM_ERROR;
+    }
     for (int i = 0; i < entries; i++)
       tmp[i] = table[i];
     delete [] table;
@@ -3778,17 +4131,10 @@ int USMUserTable::add_entry(
     max_entries *= 4;
   }
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserName, table[i].usmUserNameLength,
-			    user_name.data(), user_name.len()))
-      if (unsignedCharCompare(table[i].usmUserEngineID,
-			      table[i].usmUserEngineIDLength,
-			      engine_id.data(), engine_id.len()))
-      {
-	/* delete this entry */
-	delete_entry(i);
-	break;
-      }
+  int i = find(engine_user_index, engine_id.data(), engine_id.len(),
+	       user_name.data(), user_name.len());
+  if (i >= 0)
+    delete_entry(i); /* delete this entry */
 
   /* add user at the last position */
   table[entries].usmUserEngineIDLength = engine_id.len();
@@ -3804,10 +4150,14 @@ int USMUserTable::add_entry(
   table[entries].usmUserAuthKeyLength  = auth_key.len();
   table[entries].usmUserAuthKey        = v3strcpy(auth_key.data(),
 						  auth_key.len());
+  table[entries].usmUserAuthKeyState   = auth_priv->new_key_state(auth_proto,
+						  auth_key.data(),
+						  auth_key.len());
   table[entries].usmUserPrivProtocol   = priv_proto;
   table[entries].usmUserPrivKeyLength  = priv_key.len();
   table[entries].usmUserPrivKey        = v3strcpy(priv_key.data(),
 						  priv_key.len());
+  index_entry(entries);
   entries++;
   return SNMPv3_USM_OK;
 }
@@ -3829,57 +4179,58 @@ int USMUserTable::update_key(const OctetStr &user_name,
 
   BEGIN_REENTRANT_CODE_BLOCK;
 
-  for (int i = 0; i < entries; i++)
-    if (unsignedCharCompare(table[i].usmUserName, table[i].usmUserNameLength,
-			    user_name.data(), user_name.len()))
-      if (unsignedCharCompare(table[i].usmUserEngineID,
-			      table[i].usmUserEngineIDLength,
-			      engine_id.data(), engine_id.len()))
-      {
-	LOG_BEGIN(loggerModuleName, DEBUG_LOG | 15);
-	LOG("USMUserTable: New key");
-	LOG(new_key.get_printable());
-	LOG_END;
+  int i = find(engine_user_index, engine_id.data(), engine_id.len(),
+	       user_name.data(), user_name.len());
+  if (i >= 0)
+  {
+    LOG_BEGIN(loggerModuleName, DEBUG_LOG | 15);
+    LOG("USMUserTable: New key");
+    LOG(new_key.get_printable());
+    LOG_END;
 
-	/* update key: */
-	switch (key_type)
+    /* update key: */
+    switch (key_type)
+    {
+      case AUTHKEY:
+      case OWNAUTHKEY:
+      {
+	if (table[i].usmUserAuthKey)
+	{
+	  memset(table[i].usmUserAuthKey, 0,
+		 table[i].usmUserAuthKeyLength);
+	  delete [] table[i].usmUserAuthKey;
+	}
+	AuthKeyState::unref(table[i].usmUserAuthKeyState);
+	table[i].usmUserAuthKeyLength = new_key.len();
+	table[i].usmUserAuthKey = v3strcpy(new_key.data(), new_key.len());
+	table[i].usmUserAuthKeyState = auth_priv->new_key_state(
+					 table[i].usmUserAuthProtocol,
+					 new_key.data(), new_key.len());
+	return SNMPv3_USM_OK;
+      }
+      case PRIVKEY:
+      case OWNPRIVKEY:
+      {
+	if (table[i].usmUserPrivKey)
 	{
-	  case AUTHKEY:
-	  case OWNAUTHKEY:
-	  {
-	    if (table[i].usmUserAuthKey)
-	    {
-	      memset(table[i].usmUserAuthKey, 0,
-		     table[i].usmUserAuthKeyLength);
-	      delete [] table[i].usmUserAuthKey;
-	    }
-	    table[i].usmUserAuthKeyLength = new_key.len();
-	    table[i].usmUserAuthKey = v3strcpy(new_key.data(), new_key.len());
-	    return SNMPv3_USM_OK;
-	  }
-	  case PRIVKEY:
-	  case OWNPRIVKEY:
-	  {
-	    if (table[i].usmUserPrivKey)
-	    {
-	      memset(table[i].usmUserPrivKey, 0,
-		     table[i].usmUserPrivKeyLength);
-	      delete [] table[i].usmUserPrivKey;
-	    }
-	    table[i].usmUserPrivKeyLength = new_key.len();
-	    table[i].usmUserPrivKey = v3strcpy(new_key.data(), new_key.len());
-	    return SNMPv3_USM_OK;
-	  }
-	  default:
-	  {
-	    LOG_BEGIN(loggerModuleName, WARNING_LOG | 3);
-	    LOG("USMUserTable: setting new key failed (wrong type).");
-	    LOG_END;
-
-	    return SNMPv3_USM_ERROR;
-	  }
+	  memset(table[i].usmUserPrivKey, 0,
+		 table[i].usmUserPrivKeyLength);
+	  delete [] table[i].usmUserPrivKey;
 	}
+	table[i].usmUserPrivKeyLength = new_key.len();
+	table[i].usmUserPrivKey = v3strcpy(new_key.data(), new_key.len());
+	return SNMPv3_USM_OK;
       }
+      default:
+      {
+	LOG_BEGIN(loggerModuleName, WARNING_LOG | 3);
+	LOG("USMUserTable: setting new key failed (wrong type).");
+	LOG_END;
+
+	return SNMPv3_USM_ERROR;
+      }
+    }
+  }
 
   LOG_BEGIN(loggerModuleName, INFO_LOG | 7);
   LOG("USMUserTable: setting new key failed (user) not found");
@@ -3903,12 +4254,18 @@ void USMUserTable::delete_entry(const int nr)
     memset(table[nr].usmUserAuthKey, 0, table[nr].usmUserAuthKeyLength);
     delete [] table[nr].usmUserAuthKey;
   }
+  AuthKeyState::unref(table[nr].usmUserAuthKeyState);
   if (table[nr].usmUserPrivKey)
   {
     memset(table[nr].usmUserPrivKey, 0, table[nr].usmUserPrivKeyLength);
     delete [] table[nr].usmUserPrivKey;
   }
 
+  engine_sec_index.remove(nr);
+  engine_user_index.remove(nr);
+  sec_index.remove(nr);
+  user_index.remove(nr);
+
   /* We have now one entry less */
   entries--;
 
@@ -3916,6 +4273,10 @@ void USMUserTable::delete_entry(const int nr)
   {
     /* move the last entry to the deleted position */
     table[nr] = table[entries];
+    engine_sec_index.move(entries, nr);
+    engine_user_index.move(entries, nr);
+    sec_index.move(entries, nr);
+    user_index.move(entries, nr);
   }
 }
 
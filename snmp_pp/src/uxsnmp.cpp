@@ -204,6 +204,32 @@ bool setCloseOnExecFlag(SnmpSocket fd)
 #endif
 }
 
+bool setReusePortFlag(SnmpSocket fd)
+{
+#ifdef SO_REUSEPORT
+    // allow other sockets to bind to the same address and port, the
+    // kernel then distributes incoming datagrams among them
+    int enable_reuse = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+                   (char*)&enable_reuse, sizeof(enable_reuse)) < 0)
+    {
+        LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+        LOG("Snmp: Could not set SO_REUSEPORT for socket (errno)");
+        LOG(errno);
+        LOG_END;
+
+        return false;
+    }
+    return true;
+#else
+    LOG_BEGIN(loggerModuleName, WARNING_LOG | 1);
+    LOG("Snmp: SO_REUSEPORT is not supported on this platform");
+    LOG_END;
+
+    return false;
+#endif
+}
+
 //--------[ make the pdu request id ]-----------------------------------
 // return a unique rid, clock can be too slow , so use current_rid
 long Snmp::MyMakeReqId()
@@ -664,7 +690,8 @@ void Snmp::map_action_to_async(unsigned short pdu_action, unsigned short &action
 
 //------[ Snmp Class Constructor ]--------------------------------------
 
-Snmp::Snmp(int &status, const unsigned short port, const bool bind_ipv6)
+Snmp::Snmp(int &status, const unsigned short port, const bool bind_ipv6,
+           const bool reuse_port)
     : SnmpSynchronized(),
 #ifdef _SNMPv3
       mpv3(v3MP::I),
@@ -680,7 +707,7 @@ Snmp::Snmp(int &status, const unsigned short port, const bool bind_ipv6)
     addresses[0] = NULL;
     addresses[1] = &listen_address;
 
-    init(status, addresses, 0, port);
+    init(status, addresses, 0, port, reuse_port);
   }
   else
   {
@@ -689,12 +716,12 @@ Snmp::Snmp(int &status, const unsigned short port, const bool bind_ipv6)
     addresses[0] = &listen_address;
     addresses[1] = NULL;
 
-    init(status, addresses, port, 0);
+    init(status, addresses, port, 0, reuse_port);
   }
 
 }
 
-Snmp::Snmp( int &status, const UdpAddress& addr)
+Snmp::Snmp( int &status, const UdpAddress& addr, const bool reuse_port)
     : SnmpSynchronized(),
 #ifdef _SNMPv3
       mpv3(v3MP::I),
@@ -709,13 +736,13 @@ Snmp::Snmp( int &status, const UdpAddress& addr)
   {
     addresses[0] = &listen_address;
     addresses[1] = NULL;
-    init(status, addresses, addr.get_port(), 0);
+    init(status, addresses, addr.get_port(), 0, reuse_port);
   }
   else
   {
     addresses[0] = NULL;
     addresses[1] = &listen_address;
-    init(status, addresses, 0, addr.get_port());
+    init(status, addresses, 0, addr.get_port(), reuse_port);
   }
 }
 
@@ -755,7 +782,8 @@ void Snmp::socket_cleanup()
 
 void Snmp::init(int& status, IpAddress *addresses[2],
                 const unsigned short port_v4,
-                const unsigned short port_v6)
+                const unsigned short port_v6,
+                const bool reuse_port)
 {
 #ifdef _THREADS
 #ifdef WIN32
@@ -821,6 +849,8 @@ void Snmp::init(int& status, IpAddress *addresses[2],
 #endif
 
       setCloseOnExecFlag(iv_snmp_session);
+      if (reuse_port)
+        setReusePortFlag(iv_snmp_session);
 
       // bind the socket
       if (bind(iv_snmp_session, (struct sockaddr*)&mgr_addr,
@@ -940,6 +970,8 @@ void Snmp::init(int& status, IpAddress *addresses[2],
       mgr_addr.sin6_family = AF_INET6;
       mgr_addr.sin6_port = htons( port_v6);
       mgr_addr.sin6_scope_id = scope;
+      if (reuse_port)
+        setReusePortFlag(iv_snmp_session_ipv6);
       // bind the socket
       if (bind(iv_snmp_session_ipv6, (struct sockaddr*) &mgr_addr,
                sizeof(mgr_addr)) < 0)